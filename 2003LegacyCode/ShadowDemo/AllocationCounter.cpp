@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <new>
+#include "AllocationCounter.h"
+#include "Platform.h"
+
+// a variable each thread has its own copy of
+#ifdef _WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// the running totals, updated by the operators below on every thread
+static volatile long numAllocations = 0;
+static volatile long numFrees = 0;
+static volatile long bytesAllocated = 0;
+
+// the allocations made by each thread
+static THREAD_LOCAL unsigned long threadAllocations = 0;
+
+#ifdef SML_COUNT_ALLOCATIONS
+//-----------------------------------------------------------------------------
+/**
+   Count an allocation and get the memory from malloc
+  */
+static void* countedAllocate(size_t size)
+{
+   SML_CORE::atomicAdd(&numAllocations, 1);
+   SML_CORE::atomicAdd(&bytesAllocated, (long)size);
+   threadAllocations++;
+   void *memory = malloc(size ? size : 1);
+   if (!memory)
+      throw std::bad_alloc();
+   return memory;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Count a free and give the memory back to free
+  */
+static void countedFree(void *memory)
+{
+   if (!memory)
+      return;
+   SML_CORE::atomicAdd(&numFrees, 1);
+   free(memory);
+}
+
+void* operator new(size_t size) throw(std::bad_alloc) {return countedAllocate(size);}
+void* operator new[](size_t size) throw(std::bad_alloc) {return countedAllocate(size);}
+void operator delete(void *memory) throw() {countedFree(memory);}
+void operator delete[](void *memory) throw() {countedFree(memory);}
+#endif
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Find out if allocations are being counted in this build
+
+  @return true if SML_COUNT_ALLOCATIONS was defined
+  */
+bool AllocationCounter::isEnabled()
+{
+#ifdef SML_COUNT_ALLOCATIONS
+   return true;
+#else
+   return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @return The number of calls to operator new (and new[]) so far, on every
+  thread
+  */
+unsigned long AllocationCounter::getNumAllocations()
+{
+   return numAllocations;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @return The number of calls to operator new (and new[]) made so far by
+  the thread that calls this
+  */
+unsigned long AllocationCounter::getThreadAllocations()
+{
+   return threadAllocations;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @return The number of calls to operator delete (and delete[]) so far
+  */
+unsigned long AllocationCounter::getNumFrees()
+{
+   return numFrees;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @return The total number of bytes asked for so far
+  */
+unsigned long AllocationCounter::getBytesAllocated()
+{
+   return bytesAllocated;
+}
+}
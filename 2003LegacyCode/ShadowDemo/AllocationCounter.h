@@ -0,0 +1,33 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+//-----------------------------------------------------------------------------
+
+namespace SML_CORE
+{
+/**
+  This class counts heap allocations so we can check that a part of the
+  program (the frame loop) doesn't make any.  The counting is done by
+  replacing the global operator new and delete, which only happens when
+  SML_COUNT_ALLOCATIONS is defined (the debug build defines it).  In other
+  builds the counts stay at zero and isEnabled returns false.
+
+  The totals are counted for every thread with atomic adds, and each
+  thread also counts its own allocations, so the thread that draws can be
+  checked while the simulation and worker threads allocate as they like.
+  Take the count before and after the code being checked:
+
+     unsigned long before = AllocationCounter::getThreadAllocations();
+     theScene->render();
+     unsigned long frameAllocations = AllocationCounter::getThreadAllocations() - before;
+*/
+class AllocationCounter
+{
+public:
+   static bool isEnabled();
+   static unsigned long getNumAllocations();
+   static unsigned long getThreadAllocations();
+   static unsigned long getNumFrees();
+   static unsigned long getBytesAllocated();
+};
+}
+#endif
@@ -0,0 +1,307 @@
+#include <math.h>
+#include <GL/glut.h>
+#include "BillboardRenderer.h"
+#include "StreamBuffer.h"
+#include "RenderStateCache.h"
+#include "GLExtensions.h"
+
+namespace SML_CORE
+{
+// the width (and height) of the blob shadow texture
+static const int BLOB_TEXTURE_SIZE = 32;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+  */
+BillboardRenderer::BillboardRenderer() :
+vertices(0),
+texCoords(0),
+numQuads(0),
+blobTexture(0),
+streamBuffer(0),
+quadVertices(0),
+streamOffset(0),
+streaming(false)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+BillboardRenderer::~BillboardRenderer()
+{
+   if (blobTexture)
+      glDeleteTextures(1, &blobTexture);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw a camera facing quad for each visible point.  The texture, color and
+   blending must already be set.
+
+  @param x The x components of the points
+  @param y The y components of the points
+  @param z The z components of the points
+  @param radius The half width of each quad
+  @param visible 0 for each point to skip, may be 0 to draw them all
+  @param count The number of points
+  @param viewMatrix The column major modelview matrix of the camera
+  @return The number of quads drawn
+  */
+int BillboardRenderer::drawBillboards(const float *x, const float *y, const float *z, const float *radius,
+                                      const unsigned char *visible, int count, const float *viewMatrix)
+{
+   // the camera's right and up axes in the world are the first two rows of
+   // the view rotation
+   float cameraRight[3] = {viewMatrix[0], viewMatrix[4], viewMatrix[8]};
+   float cameraUp[3] = {viewMatrix[1], viewMatrix[5], viewMatrix[9]};
+
+   reserveQuads(count);
+   numQuads = 0;
+   for (int index = 0; index < count; index++)
+   {
+      if (visible && !visible[index])
+         continue;
+      float size = radius[index];
+      float right[3] = {cameraRight[0] * size, cameraRight[1] * size, cameraRight[2] * size};
+      float up[3] = {cameraUp[0] * size, cameraUp[1] * size, cameraUp[2] * size};
+      addQuad(x[index], y[index], z[index], right, up);
+   }
+
+   int numDrawn = numQuads;
+   flush();
+   return numDrawn;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw a soft round shadow on a plane for each point.  Points on the far
+   side of the plane, or above the light, throw no shadow.  The blob grows
+   with the distance from the point to the plane relative to its distance
+   from the light, like a real shadow would.  The blob texture (see
+   getBlobTexture), the color (the shadow darkness) and blending must
+   already be set.
+
+  @param x The x components of the points
+  @param y The y components of the points
+  @param z The z components of the points
+  @param radius The radius of each point
+  @param count The number of points
+  @param plane The receiver plane (a,b,c,d)
+  @param lightPosition The position of the point light
+  @return The number of blobs drawn
+  */
+int BillboardRenderer::drawBlobShadows(const float *x, const float *y, const float *z, const float *radius,
+                                       int count, const float *plane, const Vector3D &lightPosition)
+{
+   // the light must be in front of the plane to cast anything onto it
+   float lightDistance = plane[0] * lightPosition.x + plane[1] * lightPosition.y +
+                         plane[2] * lightPosition.z + plane[3];
+   if (lightDistance <= 0.0)
+      return 0;
+
+   // two unit axes lying in the plane
+   float normalLength = (float)sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+   float normal[3] = {plane[0] / normalLength, plane[1] / normalLength, plane[2] / normalLength};
+   float axisU[3];
+   if (fabs(normal[0]) < 0.9)
+   {
+      // normal x (1,0,0)
+      axisU[0] = 0.0;
+      axisU[1] = normal[2];
+      axisU[2] = -normal[1];
+   }
+   else
+   {
+      // normal x (0,1,0)
+      axisU[0] = -normal[2];
+      axisU[1] = 0.0;
+      axisU[2] = normal[0];
+   }
+   float length = (float)sqrt(axisU[0] * axisU[0] + axisU[1] * axisU[1] + axisU[2] * axisU[2]);
+   axisU[0] /= length;
+   axisU[1] /= length;
+   axisU[2] /= length;
+   float axisV[3] =
+   {
+      normal[1] * axisU[2] - normal[2] * axisU[1],
+      normal[2] * axisU[0] - normal[0] * axisU[2],
+      normal[0] * axisU[1] - normal[1] * axisU[0]
+   };
+
+   reserveQuads(count);
+   numQuads = 0;
+   for (int index = 0; index < count; index++)
+   {
+      float pointDistance = plane[0] * x[index] + plane[1] * y[index] + plane[2] * z[index] + plane[3];
+      if (pointDistance <= 0.0 || pointDistance >= lightDistance)
+         continue;
+
+      // follow the line from the light through the point onto the plane
+      float t = lightDistance / (lightDistance - pointDistance);
+      float shadowX = lightPosition.x + (x[index] - lightPosition.x) * t;
+      float shadowY = lightPosition.y + (y[index] - lightPosition.y) * t;
+      float shadowZ = lightPosition.z + (z[index] - lightPosition.z) * t;
+
+      float size = radius[index] * t;
+      float right[3] = {axisU[0] * size, axisU[1] * size, axisU[2] * size};
+      float up[3] = {axisV[0] * size, axisV[1] * size, axisV[2] * size};
+      addQuad(shadowX, shadowY, shadowZ, right, up);
+   }
+
+   int numDrawn = numQuads;
+   flush();
+   return numDrawn;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find room for a number of quads: in the stream buffer if there is one
+   with space left this frame, otherwise in our own vertex array.  The
+   arrays only ever grow, a steady frame loop doesn't allocate.
+
+  @param count The number of quads needed
+  */
+void BillboardRenderer::reserveQuads(int count)
+{
+   streaming = false;
+   if (streamBuffer && count > 0)
+   {
+      quadVertices = (float*)streamBuffer->allocate(count * 12 * sizeof(float), streamOffset);
+      streaming = quadVertices != 0;
+   }
+   if (!streaming)
+   {
+      if (vertices.size() < count * 12)
+         vertices.resize(count * 12);
+      quadVertices = vertices.empty() ? 0 : &vertices[0];
+   }
+
+   int oldCount = texCoords.size() / 8;
+   if (count <= oldCount)
+      return;
+
+   texCoords.resize(count * 8);
+
+   // every quad uses the same texture coordinates, fill them in once
+   for (int quad = oldCount; quad < count; quad++)
+   {
+      float *coords = &texCoords[quad * 8];
+      coords[0] = 0.0; coords[1] = 0.0;
+      coords[2] = 1.0; coords[3] = 0.0;
+      coords[4] = 1.0; coords[5] = 1.0;
+      coords[6] = 0.0; coords[7] = 1.0;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a quad centered on a point to the vertex array
+
+  @param right Half the width of the quad along its x axis
+  @param up Half the height of the quad along its y axis
+  */
+void BillboardRenderer::addQuad(float x, float y, float z, const float *right, const float *up)
+{
+   float *vertex = &quadVertices[numQuads * 12];
+   vertex[0] = x - right[0] - up[0];
+   vertex[1] = y - right[1] - up[1];
+   vertex[2] = z - right[2] - up[2];
+   vertex[3] = x + right[0] - up[0];
+   vertex[4] = y + right[1] - up[1];
+   vertex[5] = z + right[2] - up[2];
+   vertex[6] = x + right[0] + up[0];
+   vertex[7] = y + right[1] + up[1];
+   vertex[8] = z + right[2] + up[2];
+   vertex[9] = x - right[0] + up[0];
+   vertex[10] = y - right[1] + up[1];
+   vertex[11] = z - right[2] + up[2];
+   numQuads++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the quads in the vertex array with one call
+  */
+void BillboardRenderer::flush()
+{
+   if (numQuads == 0)
+      return;
+
+   glEnableClientState(GL_VERTEX_ARRAY);
+   glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+   if (streaming)
+   {
+      // the pointer is an offset into the buffer bound when it is set
+      GLExtensions::bindBuffer(GL_ARRAY_BUFFER, streamBuffer->getBufferId());
+      glVertexPointer(3, GL_FLOAT, 0, (const char*)0 + streamOffset);
+      GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+   }
+   else
+   {
+      glVertexPointer(3, GL_FLOAT, 0, quadVertices);
+   }
+   glTexCoordPointer(2, GL_FLOAT, 0, &texCoords[0]);
+   glDrawArrays(GL_QUADS, 0, numQuads * 4);
+   glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   glDisableClientState(GL_VERTEX_ARRAY);
+   numQuads = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Get the texture used for blob shadows, it is made the first time it is
+   needed (there must be an openGL context by then).
+
+  @param renderState The scene's state cache, making the texture binds it
+  @return The openGL texture name
+  */
+unsigned int BillboardRenderer::getBlobTexture(RenderStateCache &renderState)
+{
+   if (!blobTexture)
+      createBlobTexture(renderState);
+   return blobTexture;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make a white texture whose alpha falls off smoothly from the center to
+   the edge.  It is bound through the state cache, so the cache still knows
+   which texture is bound afterwards.
+
+  @param renderState The scene's state cache
+  */
+void BillboardRenderer::createBlobTexture(RenderStateCache &renderState)
+{
+   unsigned char texels[BLOB_TEXTURE_SIZE * BLOB_TEXTURE_SIZE * 4];
+   float center = (BLOB_TEXTURE_SIZE - 1) * 0.5;
+   for (int row = 0; row < BLOB_TEXTURE_SIZE; row++)
+   {
+      for (int column = 0; column < BLOB_TEXTURE_SIZE; column++)
+      {
+         float dx = (column - center) / center;
+         float dy = (row - center) / center;
+         float falloff = 1.0 - (dx * dx + dy * dy);
+         if (falloff < 0.0)
+            falloff = 0.0;
+         unsigned char *texel = &texels[(row * BLOB_TEXTURE_SIZE + column) * 4];
+         texel[0] = 255;
+         texel[1] = 255;
+         texel[2] = 255;
+         texel[3] = (unsigned char)(falloff * falloff * 255.0);
+      }
+   }
+
+   glGenTextures(1, &blobTexture);
+   renderState.setTexture(blobTexture);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BLOB_TEXTURE_SIZE, BLOB_TEXTURE_SIZE, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, texels);
+}
+}
@@ -0,0 +1,55 @@
+#ifndef BILLBOARDRENDERER_H
+#define BILLBOARDRENDERER_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "Vector3D.h"
+
+namespace SML_CORE
+{
+// forward declarations
+class StreamBuffer;
+class RenderStateCache;
+
+/**
+  This class draws large numbers of small round things (projectiles,
+  particles) as textured quads.  Each frame the quads for every point are
+  written into one vertex array and submitted with a single glDrawArrays
+  call, so a volley of thousands costs one draw and four vertices each.
+
+  Billboards face the camera.  Blob shadows are flat quads lying on a
+  receiver plane under each point, where the line from the light through
+  the point meets the plane, drawn with a soft round texture.
+
+  Given a StreamBuffer the quads are written straight into this frame's
+  region of it and drawn from there, otherwise (or when the region is full)
+  from a vertex array of its own.
+*/
+class BillboardRenderer
+{
+private:
+   std::vector<float> vertices;
+   std::vector<float> texCoords;
+   int numQuads;
+   unsigned int blobTexture;
+   StreamBuffer *streamBuffer;
+   float *quadVertices;
+   int streamOffset;
+   bool streaming;
+
+   void reserveQuads(int count);
+   void addQuad(float x, float y, float z, const float *right, const float *up);
+   void flush();
+   void createBlobTexture(RenderStateCache &renderState);
+
+public:
+   BillboardRenderer();
+   virtual ~BillboardRenderer();
+   int drawBillboards(const float *x, const float *y, const float *z, const float *radius,
+                      const unsigned char *visible, int count, const float *viewMatrix);
+   int drawBlobShadows(const float *x, const float *y, const float *z, const float *radius,
+                       int count, const float *plane, const Vector3D &lightPosition);
+   unsigned int getBlobTexture(RenderStateCache &renderState);
+   void setStreamBuffer(StreamBuffer *buffer) {streamBuffer = buffer;};
+};
+}
+#endif
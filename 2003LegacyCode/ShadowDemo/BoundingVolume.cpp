@@ -0,0 +1,59 @@
+#include <math.h>
+#include "BoundingVolume.h"
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+      Constructor, an empty volume at the origin
+  */
+BoundingVolume::BoundingVolume() :
+minimum(0,0,0),
+maximum(0,0,0),
+center(0,0,0),
+radius(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+      Constructor
+
+  @param minimum The smallest corner of the box
+  @param maximum The largest corner of the box
+  */
+BoundingVolume::BoundingVolume(Vector3D minimum, Vector3D maximum)
+{
+   setBox(minimum, maximum);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+BoundingVolume::~BoundingVolume()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the box and fit the sphere around it
+
+  @param newMinimum The smallest corner of the box
+  @param newMaximum The largest corner of the box
+  */
+void BoundingVolume::setBox(Vector3D newMinimum, Vector3D newMaximum)
+{
+   minimum = newMinimum;
+   maximum = newMaximum;
+   center.x = (minimum.x + maximum.x) * 0.5f;
+   center.y = (minimum.y + maximum.y) * 0.5f;
+   center.z = (minimum.z + maximum.z) * 0.5f;
+   float dx = maximum.x - center.x;
+   float dy = maximum.y - center.y;
+   float dz = maximum.z - center.z;
+   radius = (float)sqrt(dx*dx + dy*dy + dz*dz);
+}
+}
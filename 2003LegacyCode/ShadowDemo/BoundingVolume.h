@@ -0,0 +1,27 @@
+#ifndef BOUNDINGVOLUME_H
+#define BOUNDINGVOLUME_H
+//-----------------------------------------------------------------------------
+#include "Vector3D.h"
+
+namespace SML_CORE
+{
+/**
+   This class holds an axis aligned bounding box and the bounding sphere
+   around that box.  It is used to quickly test if a model can be seen.
+  */
+class BoundingVolume
+{
+public:
+   Vector3D minimum;
+   Vector3D maximum;
+   Vector3D center;
+   float radius;
+
+public:
+   BoundingVolume();
+   BoundingVolume(Vector3D minimum, Vector3D maximum);
+   virtual ~BoundingVolume();
+   void setBox(Vector3D minimum, Vector3D maximum);
+};
+}
+#endif
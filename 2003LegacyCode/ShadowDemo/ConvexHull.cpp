@@ -0,0 +1,447 @@
+#include <math.h>
+#include "ConvexHull.h"
+
+using std::vector;
+
+namespace SML_CORE
+{
+// how far (as a part of the size of the points) a point has to be past a
+// face to be outside it, so points on a face don't make slivers
+static const float HULL_EPSILON = 1.0e-5;
+
+// the faces of the starting tetrahedron, as corners of it
+static const int TETRAHEDRON_FACES[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor, the hull is empty until it is built
+  */
+ConvexHull::ConvexHull() :
+error(0.0),
+volume(0.0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+ConvexHull::~ConvexHull()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the signed distance from a face's plane to a point (positive is
+   outside)
+  */
+float ConvexHull::findDistance(const HullFace &face, const float *point)
+{
+   return face.normal[0] * point[0] + face.normal[1] * point[1] + face.normal[2] * point[2] + face.offset;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make a face from three points, its normal is the way its winding faces
+
+  @param points The points (three floats each)
+  @param face Set to the face
+  @return false if the points are in a line (the face has no normal)
+  */
+bool ConvexHull::makeFace(const float *points, int one, int two, int three, HullFace &face)
+{
+   face.vertex[0] = one;
+   face.vertex[1] = two;
+   face.vertex[2] = three;
+   face.outside.clear();
+   face.removed = false;
+
+   const float *a = points + one * 3;
+   const float *b = points + two * 3;
+   const float *c = points + three * 3;
+   float edge0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+   float edge1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+   face.normal[0] = edge0[1] * edge1[2] - edge0[2] * edge1[1];
+   face.normal[1] = edge0[2] * edge1[0] - edge0[0] * edge1[2];
+   face.normal[2] = edge0[0] * edge1[1] - edge0[1] * edge1[0];
+   float length = (float)sqrt(face.normal[0] * face.normal[0] + face.normal[1] * face.normal[1] +
+      face.normal[2] * face.normal[2]);
+   if (length == 0.0)
+   {
+      face.offset = 0.0;
+      return false;
+   }
+   face.normal[0] /= length;
+   face.normal[1] /= length;
+   face.normal[2] /= length;
+   face.offset = -(face.normal[0] * a[0] + face.normal[1] * a[1] + face.normal[2] * a[2]);
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Note which face each of a face's edges belongs to, an edge is known by
+   the vertices it runs from and to
+
+  @param faceIndex The face's index
+  @param face The face
+  @param edgeFaces The faces of the edges
+  */
+void ConvexHull::addEdges(int faceIndex, const HullFace &face, EdgeMap &edgeFaces)
+{
+   for (int side = 0; side < 3; side++)
+      edgeFaces[EdgeKey(face.vertex[side], face.vertex[(side + 1) % 3])] = faceIndex;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Give each point to the first face it is outside of, points not outside
+   any face are inside the hull and dropped
+
+  @param points The points (three floats each)
+  @param candidates The points to give out
+  @param faces The faces
+  @param firstFace The first face that can take points
+  @param epsilon How far past a face a point has to be
+  */
+void ConvexHull::assignPoints(const float *points, const vector<int> &candidates,
+                              vector<HullFace> &faces, int firstFace, float epsilon)
+{
+   for (int index = 0; index < candidates.size(); index++)
+   {
+      const float *point = points + candidates[index] * 3;
+      for (int face = firstFace; face < faces.size(); face++)
+      {
+         if (!faces[face].removed && findDistance(faces[face], point) > epsilon)
+         {
+            faces[face].outside.push_back(candidates[index]);
+            break;
+         }
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find four points far apart to start the hull from: the farthest apart of
+   the points at the ends of each axis, the point farthest from the line
+   through them and the point farthest from the plane through all three
+
+  @param points The points (three floats each)
+  @param count The number of points
+  @param epsilon How far apart the points have to be
+  @param start Set to the four points
+  @return false if the points are flat (they have no volume to hull)
+  */
+bool ConvexHull::findStart(const float *points, int count, float epsilon, int *start)
+{
+   int extremes[6] = {0, 0, 0, 0, 0, 0};
+   int index;
+   int axis;
+   for (index = 1; index < count; index++)
+   {
+      for (axis = 0; axis < 3; axis++)
+      {
+         if (points[index * 3 + axis] < points[extremes[axis * 2] * 3 + axis])
+            extremes[axis * 2] = index;
+         if (points[index * 3 + axis] > points[extremes[axis * 2 + 1] * 3 + axis])
+            extremes[axis * 2 + 1] = index;
+      }
+   }
+
+   float farthest = 0.0;
+   for (int first = 0; first < 6; first++)
+   {
+      for (int second = first + 1; second < 6; second++)
+      {
+         const float *a = points + extremes[first] * 3;
+         const float *b = points + extremes[second] * 3;
+         float distance = (b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1]) +
+            (b[2] - a[2]) * (b[2] - a[2]);
+         if (distance > farthest)
+         {
+            farthest = distance;
+            start[0] = extremes[first];
+            start[1] = extremes[second];
+         }
+      }
+   }
+   if (farthest <= epsilon * epsilon)
+      return false;
+
+   // farthest from the line, by the area of the triangle it makes
+   const float *a = points + start[0] * 3;
+   const float *b = points + start[1] * 3;
+   float line[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+   float lineLength = (float)sqrt(farthest);
+   farthest = 0.0;
+   for (index = 0; index < count; index++)
+   {
+      const float *point = points + index * 3;
+      float offset[3] = {point[0] - a[0], point[1] - a[1], point[2] - a[2]};
+      float cross[3] =
+      {
+         line[1] * offset[2] - line[2] * offset[1],
+         line[2] * offset[0] - line[0] * offset[2],
+         line[0] * offset[1] - line[1] * offset[0]
+      };
+      float distance = (float)sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]) / lineLength;
+      if (distance > farthest)
+      {
+         farthest = distance;
+         start[2] = index;
+      }
+   }
+   if (farthest <= epsilon)
+      return false;
+
+   HullFace base;
+   makeFace(points, start[0], start[1], start[2], base);
+   farthest = 0.0;
+   for (index = 0; index < count; index++)
+   {
+      float distance = (float)fabs(findDistance(base, points + index * 3));
+      if (distance > farthest)
+      {
+         farthest = distance;
+         start[3] = index;
+      }
+   }
+   return farthest > epsilon;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Build the hull of the points.
+
+  @param points The points (three floats each)
+  @param count The number of points
+  @param maxVertices The most vertices the hull can have, 0 for no limit
+  @return false if the points are flat or too few to hull (the hull is left
+          empty)
+  */
+bool ConvexHull::build(const float *points, int count, int maxVertices)
+{
+   vertices.clear();
+   triangles.clear();
+   error = 0.0;
+   volume = 0.0;
+   if (count < 4)
+      return false;
+
+   float minimum[3] = {points[0], points[1], points[2]};
+   float maximum[3] = {points[0], points[1], points[2]};
+   int index;
+   int axis;
+   for (index = 1; index < count; index++)
+   {
+      for (axis = 0; axis < 3; axis++)
+      {
+         if (points[index * 3 + axis] < minimum[axis]) minimum[axis] = points[index * 3 + axis];
+         if (points[index * 3 + axis] > maximum[axis]) maximum[axis] = points[index * 3 + axis];
+      }
+   }
+   float size = 0.0;
+   for (axis = 0; axis < 3; axis++)
+   {
+      if (maximum[axis] - minimum[axis] > size)
+         size = maximum[axis] - minimum[axis];
+   }
+   float epsilon = size * HULL_EPSILON;
+
+   int start[4];
+   if (!findStart(points, count, epsilon, start))
+      return false;
+
+   // the starting tetrahedron, each face wound away from its middle
+   float middle[3] = {0.0, 0.0, 0.0};
+   for (index = 0; index < 4; index++)
+   {
+      for (axis = 0; axis < 3; axis++)
+         middle[axis] += points[start[index] * 3 + axis] * 0.25;
+   }
+   vector<HullFace> faces(4);
+   for (index = 0; index < 4; index++)
+   {
+      HullFace &face = faces[index];
+      makeFace(points, start[TETRAHEDRON_FACES[index][0]], start[TETRAHEDRON_FACES[index][1]],
+         start[TETRAHEDRON_FACES[index][2]], face);
+      if (findDistance(face, middle) > 0.0)
+      {
+         makeFace(points, face.vertex[0], face.vertex[2], face.vertex[1], face);
+      }
+   }
+
+   vector<int> candidates;
+   for (index = 0; index < count; index++)
+   {
+      if (index != start[0] && index != start[1] && index != start[2] && index != start[3])
+         candidates.push_back(index);
+   }
+   assignPoints(points, candidates, faces, 0, epsilon);
+
+   EdgeMap edgeFaces;
+   for (index = 0; index < 4; index++)
+      addEdges(index, faces[index], edgeFaces);
+
+   int numVertices = 4;
+   vector<int> visible;
+   vector<int> horizon;
+   vector<unsigned char> visited;
+   for (;;)
+   {
+      // the point farthest outside the first face with any
+      int face;
+      for (face = 0; face < faces.size(); face++)
+      {
+         if (!faces[face].removed && !faces[face].outside.empty())
+            break;
+      }
+      if (face == faces.size())
+         break;
+
+      int apex = faces[face].outside[0];
+      float farthest = findDistance(faces[face], points + apex * 3);
+      for (index = 1; index < faces[face].outside.size(); index++)
+      {
+         float distance = findDistance(faces[face], points + faces[face].outside[index] * 3);
+         if (distance > farthest)
+         {
+            farthest = distance;
+            apex = faces[face].outside[index];
+         }
+      }
+
+      if (maxVertices > 0 && numVertices >= maxVertices)
+      {
+         // out of vertices, note how far the points left out reach
+         for (face = 0; face < faces.size(); face++)
+         {
+            for (index = 0; index < faces[face].outside.size(); index++)
+            {
+               const float *point = points + faces[face].outside[index] * 3;
+               for (int other = 0; other < faces.size(); other++)
+               {
+                  if (faces[other].removed)
+                     continue;
+                  float distance = findDistance(faces[other], point);
+                  if (distance > error)
+                     error = distance;
+               }
+            }
+         }
+         break;
+      }
+
+      // the faces the point can see, spreading out from this one, and the
+      // edge of them (the horizon) where they meet the faces it can't
+      visible.clear();
+      horizon.clear();
+      visible.push_back(face);
+      visited.resize(faces.size(), 0);
+      visited[face] = 1;
+      for (index = 0; index < visible.size(); index++)
+      {
+         const HullFace &seen = faces[visible[index]];
+         for (int side = 0; side < 3; side++)
+         {
+            int from = seen.vertex[side];
+            int to = seen.vertex[(side + 1) % 3];
+            int neighbor = edgeFaces[EdgeKey(to, from)];
+            if (visited[neighbor])
+            {
+               if (visited[neighbor] == 2)
+               {
+                  horizon.push_back(from);
+                  horizon.push_back(to);
+               }
+               continue;
+            }
+            if (findDistance(faces[neighbor], points + apex * 3) > epsilon)
+            {
+               visited[neighbor] = 1;
+               visible.push_back(neighbor);
+            }
+            else
+            {
+               visited[neighbor] = 2;
+               horizon.push_back(from);
+               horizon.push_back(to);
+            }
+         }
+      }
+
+      // the points outside the faces being replaced need new faces
+      candidates.clear();
+      for (index = 0; index < visible.size(); index++)
+      {
+         HullFace &seen = faces[visible[index]];
+         for (int point = 0; point < seen.outside.size(); point++)
+         {
+            if (seen.outside[point] != apex)
+               candidates.push_back(seen.outside[point]);
+         }
+         seen.outside.clear();
+         seen.removed = true;
+         for (int side = 0; side < 3; side++)
+            edgeFaces.erase(EdgeKey(seen.vertex[side], seen.vertex[(side + 1) % 3]));
+      }
+      for (index = 0; index < visited.size(); index++)
+         visited[index] = 0;
+
+      // each horizon edge gets a face up to the point, keeping its winding
+      int firstNew = faces.size();
+      for (index = 0; index < horizon.size(); index += 2)
+      {
+         HullFace newFace;
+         makeFace(points, horizon[index], horizon[index + 1], apex, newFace);
+         faces.push_back(newFace);
+         addEdges(faces.size() - 1, newFace, edgeFaces);
+      }
+      assignPoints(points, candidates, faces, firstNew, epsilon);
+      numVertices++;
+   }
+
+   compact(points, faces);
+   for (index = 0; index < triangles.size(); index += 3)
+   {
+      const float *a = &vertices[triangles[index] * 3];
+      const float *b = &vertices[triangles[index + 1] * 3];
+      const float *c = &vertices[triangles[index + 2] * 3];
+      volume += (a[0] * (b[1] * c[2] - b[2] * c[1]) + a[1] * (b[2] * c[0] - b[0] * c[2]) +
+         a[2] * (b[0] * c[1] - b[1] * c[0])) / 6.0;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Keep the faces still on the hull and the points they use
+
+  @param points The points (three floats each)
+  @param faces The faces
+  */
+void ConvexHull::compact(const float *points, const vector<HullFace> &faces)
+{
+   vector<int> remap;
+   for (int face = 0; face < faces.size(); face++)
+   {
+      if (faces[face].removed)
+         continue;
+      for (int corner = 0; corner < 3; corner++)
+      {
+         int point = faces[face].vertex[corner];
+         if (point >= remap.size())
+            remap.resize(point + 1, -1);
+         if (remap[point] == -1)
+         {
+            remap[point] = vertices.size() / 3;
+            vertices.insert(vertices.end(), points + point * 3, points + point * 3 + 3);
+         }
+         triangles.push_back(remap[point]);
+      }
+   }
+}
+}
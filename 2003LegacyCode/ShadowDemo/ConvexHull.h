@@ -0,0 +1,64 @@
+#ifndef CONVEXHULL_H
+#define CONVEXHULL_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <map>
+
+namespace SML_CORE
+{
+/**
+   This class builds the convex hull of a set of points with quickhull.  The
+   hull starts as a tetrahedron of extreme points and each step adds the
+   point farthest outside one of its faces, replacing the faces that point
+   can see (found by spreading across the edges from that face) with a fan
+   of faces from their edge up to the point.  The build can stop at a vertex budget, the hull is then inside
+   the true hull and getError says how far the points left out reach past
+   it.
+
+   The hull's triangles are wound so they face out, it is closed and can be
+   drawn as it is.
+  */
+class ConvexHull
+{
+private:
+   /** A face of the hull being built and the points outside it */
+   class HullFace
+   {
+   public:
+      int vertex[3];
+      float normal[3];
+      float offset;
+      std::vector<int> outside;
+      bool removed;
+   };
+
+   /** An edge, from a vertex to a vertex, and the face it belongs to */
+   typedef std::pair<int, int> EdgeKey;
+   typedef std::map<EdgeKey, int> EdgeMap;
+
+   std::vector<float> vertices;
+   std::vector<int> triangles;
+   float error;
+   float volume;
+
+   static float findDistance(const HullFace &face, const float *point);
+   static bool makeFace(const float *points, int one, int two, int three, HullFace &face);
+   static void addEdges(int faceIndex, const HullFace &face, EdgeMap &edgeFaces);
+   static void assignPoints(const float *points, const std::vector<int> &candidates,
+                            std::vector<HullFace> &faces, int firstFace, float epsilon);
+   bool findStart(const float *points, int count, float epsilon, int *start);
+   void compact(const float *points, const std::vector<HullFace> &faces);
+
+public:
+   ConvexHull();
+   virtual ~ConvexHull();
+   bool build(const float *points, int count, int maxVertices);
+   const float* getVertices() const {return vertices.empty() ? 0 : &vertices[0];};
+   int getNumVertices() const {return vertices.size() / 3;};
+   const int* getTriangles() const {return triangles.empty() ? 0 : &triangles[0];};
+   int getNumTriangles() const {return triangles.size() / 3;};
+   float getError() const {return error;};
+   float getVolume() const {return volume;};
+};
+}
+#endif
@@ -0,0 +1,316 @@
+#include <algorithm>
+#include "EdgeMesh.h"
+#include "Model3D.h"
+
+#ifdef SML_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+using std::vector;
+
+namespace SML_CORE
+{
+/** A mesh vertex in model space, sorted to find the duplicates */
+class WeldVertex
+{
+public:
+   float x;
+   float y;
+   float z;
+   int index;
+};
+
+//-----------------------------------------------------------------------------
+/**
+   The order vertices are welded in, by position
+  */
+static bool isWeldVertexBefore(const WeldVertex &first, const WeldVertex &second)
+{
+   if (first.x != second.x) return first.x < second.x;
+   if (first.y != second.y) return first.y < second.y;
+   return first.z < second.z;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor, the mesh is empty until it is built
+  */
+EdgeMesh::EdgeMesh() :
+numOpenEdges(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+EdgeMesh::~EdgeMesh()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Build the mesh from a model's mesh data.  The vertices are put through
+   the model's mesh transform so they match its display list.  A model with
+   no mesh data (a display list built by hand) gives an empty mesh.
+
+  @param aModel The model
+  */
+void EdgeMesh::build(Model3D *aModel)
+{
+   vertices.clear();
+   triangles.clear();
+   vector<int> welded;
+   weldVertices(aModel, welded);
+
+   // quads are split into two triangles
+   const vector<Face> &faceList = aModel->getVertexFaceList();
+   for (int index = 0; index < faceList.size(); index++)
+   {
+      const Face &face = faceList[index];
+      if (face.numIndices != 3 && face.numIndices != 4)
+         continue;
+      addTriangle(welded[face.one], welded[face.two], welded[face.three]);
+      if (face.numIndices == 4)
+         addTriangle(welded[face.one], welded[face.three], welded[face.four]);
+   }
+
+   findPlanes();
+   findEdges();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a triangle, unless welding has collapsed it to a line or a point
+  */
+void EdgeMesh::addTriangle(int one, int two, int three)
+{
+   if (one == two || two == three || three == one)
+      return;
+   triangles.push_back(one);
+   triangles.push_back(two);
+   triangles.push_back(three);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Copy the model's vertices in, each position once
+
+  @param aModel The model
+  @param welded Set to the welded vertex each of the model's vertices became
+  */
+void EdgeMesh::weldVertices(Model3D *aModel, vector<int> &welded)
+{
+   const vector<Vector3D> &vertList = aModel->getVertList();
+   FTM meshTransform = aModel->getMeshTransform();
+   vector<WeldVertex> sorted(vertList.size());
+   int index;
+   for (index = 0; index < vertList.size(); index++)
+   {
+      Vector3D point = meshTransform.transformPoint(vertList[index]);
+      sorted[index].x = point.x;
+      sorted[index].y = point.y;
+      sorted[index].z = point.z;
+      sorted[index].index = index;
+   }
+
+   std::sort(sorted.begin(), sorted.end(), isWeldVertexBefore);
+   welded.resize(vertList.size());
+   for (index = 0; index < sorted.size(); index++)
+   {
+      if (index == 0 || isWeldVertexBefore(sorted[index - 1], sorted[index]))
+      {
+         vertices.push_back(sorted[index].x);
+         vertices.push_back(sorted[index].y);
+         vertices.push_back(sorted[index].z);
+      }
+      welded[sorted[index].index] = vertices.size() / 3 - 1;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the plane of each triangle, its normal is the way its winding faces
+  */
+void EdgeMesh::findPlanes()
+{
+   int numTriangles = getNumTriangles();
+   planeA.resize(numTriangles);
+   planeB.resize(numTriangles);
+   planeC.resize(numTriangles);
+   planeD.resize(numTriangles);
+   facing.resize(numTriangles);
+   for (int index = 0; index < numTriangles; index++)
+   {
+      const float *a = &vertices[triangles[index * 3] * 3];
+      const float *b = &vertices[triangles[index * 3 + 1] * 3];
+      const float *c = &vertices[triangles[index * 3 + 2] * 3];
+      float edge0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+      float edge1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+      planeA[index] = edge0[1] * edge1[2] - edge0[2] * edge1[1];
+      planeB[index] = edge0[2] * edge1[0] - edge0[0] * edge1[2];
+      planeC[index] = edge0[0] * edge1[1] - edge0[1] * edge1[0];
+      planeD[index] = -(planeA[index] * a[0] + planeB[index] * a[1] + planeC[index] * a[2]);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the volume the mesh holds, from the tetrahedrons each triangle makes
+   with the origin.  Only a closed mesh has a volume.
+
+  @return The volume, 0 if the mesh isn't closed
+  */
+float EdgeMesh::getVolume() const
+{
+   if (!isClosed())
+      return 0.0;
+   float volume = 0.0;
+   for (int index = 0; index < getNumTriangles(); index++)
+   {
+      // the plane's normal is the cross product of two edges from the first
+      // corner, so its d is the triple product of the corners
+      volume -= planeD[index] / 6.0;
+   }
+   return volume;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The order half edges are sorted in, so the two sides of an edge are next
+   to each other
+  */
+bool EdgeMesh::isHalfEdgeBefore(const HalfEdge &first, const HalfEdge &second)
+{
+   if (first.low != second.low) return first.low < second.low;
+   return first.high < second.high;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Pair up the triangles' edges.  An edge is matched with one running the
+   other way between the same vertices, edges left without a match are open
+   (the mesh has a hole there, or more than two triangles share the edge).
+  */
+void EdgeMesh::findEdges()
+{
+   int numTriangles = getNumTriangles();
+   vector<HalfEdge> halfEdges(numTriangles * 3);
+   int index;
+   for (index = 0; index < numTriangles; index++)
+   {
+      for (int side = 0; side < 3; side++)
+      {
+         HalfEdge &halfEdge = halfEdges[index * 3 + side];
+         int from = triangles[index * 3 + side];
+         int to = triangles[index * 3 + (side + 1) % 3];
+         halfEdge.low = from < to ? from : to;
+         halfEdge.high = from < to ? to : from;
+         halfEdge.from = from;
+         halfEdge.triangle = index;
+      }
+   }
+   std::sort(halfEdges.begin(), halfEdges.end(), isHalfEdgeBefore);
+
+   edges.clear();
+   numOpenEdges = 0;
+   vector<unsigned char> matched(halfEdges.size(), 0);
+   for (index = 0; index < halfEdges.size(); index++)
+   {
+      if (matched[index])
+         continue;
+
+      const HalfEdge &halfEdge = halfEdges[index];
+      Edge edge;
+      edge.from = halfEdge.from;
+      edge.to = halfEdge.from == halfEdge.low ? halfEdge.high : halfEdge.low;
+      edge.leftTriangle = halfEdge.triangle;
+      edge.rightTriangle = -1;
+      for (int other = index + 1; other < halfEdges.size() &&
+           !isHalfEdgeBefore(halfEdge, halfEdges[other]); other++)
+      {
+         if (!matched[other] && halfEdges[other].from != halfEdge.from)
+         {
+            edge.rightTriangle = halfEdges[other].triangle;
+            matched[other] = 1;
+            break;
+         }
+      }
+      if (edge.rightTriangle == -1)
+         numOpenEdges++;
+      edges.push_back(edge);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find which triangles face a light.  With SSE four triangles are done at
+   once.
+
+  @param light The light in model space
+  @return The number of triangles that face the light
+  */
+int EdgeMesh::classifyTriangles(const float *light)
+{
+   int numTriangles = getNumTriangles();
+   int numLit = 0;
+   int index = 0;
+
+#ifdef SML_SIMD_SSE
+   __m128 lightX = _mm_set1_ps(light[0]);
+   __m128 lightY = _mm_set1_ps(light[1]);
+   __m128 lightZ = _mm_set1_ps(light[2]);
+   for (; index + 4 <= numTriangles; index += 4)
+   {
+      __m128 distance = _mm_add_ps(
+         _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&planeA[index]), lightX), _mm_mul_ps(_mm_loadu_ps(&planeB[index]), lightY)),
+         _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&planeC[index]), lightZ), _mm_loadu_ps(&planeD[index])));
+      int mask = _mm_movemask_ps(_mm_cmpgt_ps(distance, _mm_setzero_ps()));
+      for (int lane = 0; lane < 4; lane++)
+      {
+         facing[index + lane] = (mask & (1 << lane)) ? 1 : 0;
+         numLit += facing[index + lane];
+      }
+   }
+#endif
+
+   // whatever is left over (or everything without SSE)
+   for (; index < numTriangles; index++)
+   {
+      float distance = planeA[index] * light[0] + planeB[index] * light[1] +
+         planeC[index] * light[2] + planeD[index];
+      facing[index] = distance > 0.0 ? 1 : 0;
+      numLit += facing[index];
+   }
+   return numLit;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the silhouette of the mesh from a light.  The triangles are faced
+   against the light first, getFacing has the result afterwards.
+
+  @param light The light in model space
+  @param silhouette Filled with a from and a to vertex for each edge, in the
+                    winding of the lit triangle
+  @return The number of silhouette edges
+  */
+int EdgeMesh::findSilhouette(const float *light, vector<int> &silhouette)
+{
+   silhouette.clear();
+   classifyTriangles(light);
+   for (int index = 0; index < edges.size(); index++)
+   {
+      const Edge &edge = edges[index];
+      bool leftLit = facing[edge.leftTriangle] != 0;
+      bool rightLit = edge.rightTriangle != -1 && facing[edge.rightTriangle] != 0;
+      if (leftLit == rightLit)
+         continue;
+      silhouette.push_back(leftLit ? edge.from : edge.to);
+      silhouette.push_back(leftLit ? edge.to : edge.from);
+   }
+   return silhouette.size() / 2;
+}
+}
@@ -0,0 +1,84 @@
+#ifndef EDGEMESH_H
+#define EDGEMESH_H
+//-----------------------------------------------------------------------------
+#include <vector>
+
+#if defined(SML_USE_SSE) || defined(__SSE__)
+#define SML_SIMD_SSE
+#endif
+
+namespace SML_CORE
+{
+// forward declare
+class Model3D;
+
+/**
+   This class holds the connectivity of a model's mesh for finding its
+   silhouette from a light.  The mesh is welded (the file repeats a vertex
+   for each of its texture coordinates), split into triangles, and every
+   edge knows the two triangles on either side of it.  The triangles' planes
+   are kept a component to an array so they can be faced against a light
+   four at a time when SSE is available.
+
+   A silhouette edge has a triangle facing the light on one side and one
+   facing away (or no triangle) on the other.  The edges are given in the
+   winding of the lit triangle, so they run the same way round the outline.
+  */
+class EdgeMesh
+{
+public:
+   /** An edge, from and to are in the winding of the left triangle, the
+       right triangle (-1 if there isn't one) has them the other way */
+   class Edge
+   {
+   public:
+      int from;
+      int to;
+      int leftTriangle;
+      int rightTriangle;
+   };
+
+private:
+   /** A triangle's edge, sorted to find the triangle on its other side */
+   class HalfEdge
+   {
+   public:
+      int low;
+      int high;
+      int from;
+      int triangle;
+   };
+
+   std::vector<float> vertices;
+   std::vector<int> triangles;
+   std::vector<float> planeA;
+   std::vector<float> planeB;
+   std::vector<float> planeC;
+   std::vector<float> planeD;
+   std::vector<Edge> edges;
+   std::vector<unsigned char> facing;
+   int numOpenEdges;
+
+   void weldVertices(Model3D *aModel, std::vector<int> &welded);
+   void addTriangle(int one, int two, int three);
+   void findPlanes();
+   void findEdges();
+   static bool isHalfEdgeBefore(const HalfEdge &first, const HalfEdge &second);
+
+public:
+   EdgeMesh();
+   virtual ~EdgeMesh();
+   void build(Model3D *aModel);
+   int classifyTriangles(const float *light);
+   int findSilhouette(const float *light, std::vector<int> &silhouette);
+   const float* getVertices() const {return vertices.empty() ? 0 : &vertices[0];};
+   int getNumVertices() const {return vertices.size() / 3;};
+   const int* getTriangles() const {return triangles.empty() ? 0 : &triangles[0];};
+   int getNumTriangles() const {return triangles.size() / 3;};
+   const unsigned char* getFacing() const {return facing.empty() ? 0 : &facing[0];};
+   const std::vector<Edge>& getEdges() const {return edges;};
+   bool isClosed() const {return numOpenEdges == 0;};
+   float getVolume() const;
+};
+}
+#endif
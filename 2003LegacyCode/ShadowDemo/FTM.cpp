@@ -1,68 +1,161 @@
-#include "FTM.h"
-
-namespace SML_CORE
-{
-//-----------------------------------------------------------------------------
-/**
-   Construct
-*/
-FTM::FTM()
-{
-   loadIdentity();
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Destroy
-*/
-FTM::~FTM()
-{
-
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Transform this matrix by the argument matrix
-
-  @param matrix The transformation matrix
-  @return The newly transformed matrix
-*/
-FTM FTM::multMatrix(FTM matrix)
-{
-   FTM temp;
-   temp._00 = _00*matrix._00 + _01*matrix._10 + _02*matrix._20 + _03*matrix._30;
-   temp._01 = _00*matrix._01 + _01*matrix._11 + _02*matrix._21 + _03*matrix._31;
-   temp._02 = _00*matrix._02 + _01*matrix._12 + _02*matrix._22 + _03*matrix._32;
-   temp._03 = _00*matrix._03 + _01*matrix._13 + _02*matrix._23 + _03*matrix._33;
-
-   temp._10 = _10*matrix._00 + _11*matrix._10 + _12*matrix._20 + _13*matrix._30;
-   temp._11 = _10*matrix._01 + _11*matrix._11 + _12*matrix._21 + _13*matrix._31;
-   temp._12 = _10*matrix._02 + _11*matrix._12 + _12*matrix._22 + _13*matrix._32;
-   temp._13 = _10*matrix._03 + _11*matrix._13 + _12*matrix._23 + _13*matrix._33;
-
-   temp._20 = _20*matrix._00 + _21*matrix._10 + _22*matrix._20 + _23*matrix._30;
-   temp._21 = _20*matrix._01 + _21*matrix._11 + _22*matrix._21 + _23*matrix._31;
-   temp._22 = _20*matrix._02 + _21*matrix._12 + _22*matrix._22 + _23*matrix._32;
-   temp._23 = _20*matrix._03 + _21*matrix._13 + _22*matrix._23 + _23*matrix._33;
-
-   temp._30 = _30*matrix._00 + _31*matrix._10 + _32*matrix._20 + _33*matrix._30;
-   temp._31 = _30*matrix._01 + _31*matrix._11 + _32*matrix._21 + _33*matrix._31;
-   temp._32 = _30*matrix._02 + _31*matrix._12 + _32*matrix._22 + _33*matrix._32;
-   temp._33 = _30*matrix._03 + _31*matrix._13 + _32*matrix._23 + _33*matrix._33;
-  
-   return temp;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the matrix to the identity matrix
-*/
-void FTM::loadIdentity()
-{
-   // Setup the default matrix
-   _00 = 1; _01 = 0; _02 = 0; _03 = 0;
-   _10 = 0; _11 = 1; _12 = 0; _13 = 0;
-   _20 = 0; _21 = 0; _22 = 1; _23 = 0;
-   _30 = 0; _31 = 0; _32 = 0; _33 = 1;
-}
+#include <math.h>
+#include "FTM.h"
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Construct
+*/
+FTM::FTM()
+{
+   loadIdentity();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destroy
+*/
+FTM::~FTM()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Transform this matrix by the argument matrix
+
+  @param matrix The transformation matrix
+  @return The newly transformed matrix
+*/
+FTM FTM::multMatrix(FTM matrix)
+{
+   FTM temp;
+   temp._00 = _00*matrix._00 + _01*matrix._10 + _02*matrix._20 + _03*matrix._30;
+   temp._01 = _00*matrix._01 + _01*matrix._11 + _02*matrix._21 + _03*matrix._31;
+   temp._02 = _00*matrix._02 + _01*matrix._12 + _02*matrix._22 + _03*matrix._32;
+   temp._03 = _00*matrix._03 + _01*matrix._13 + _02*matrix._23 + _03*matrix._33;
+
+   temp._10 = _10*matrix._00 + _11*matrix._10 + _12*matrix._20 + _13*matrix._30;
+   temp._11 = _10*matrix._01 + _11*matrix._11 + _12*matrix._21 + _13*matrix._31;
+   temp._12 = _10*matrix._02 + _11*matrix._12 + _12*matrix._22 + _13*matrix._32;
+   temp._13 = _10*matrix._03 + _11*matrix._13 + _12*matrix._23 + _13*matrix._33;
+
+   temp._20 = _20*matrix._00 + _21*matrix._10 + _22*matrix._20 + _23*matrix._30;
+   temp._21 = _20*matrix._01 + _21*matrix._11 + _22*matrix._21 + _23*matrix._31;
+   temp._22 = _20*matrix._02 + _21*matrix._12 + _22*matrix._22 + _23*matrix._32;
+   temp._23 = _20*matrix._03 + _21*matrix._13 + _22*matrix._23 + _23*matrix._33;
+
+   temp._30 = _30*matrix._00 + _31*matrix._10 + _32*matrix._20 + _33*matrix._30;
+   temp._31 = _30*matrix._01 + _31*matrix._11 + _32*matrix._21 + _33*matrix._31;
+   temp._32 = _30*matrix._02 + _31*matrix._12 + _32*matrix._22 + _33*matrix._32;
+   temp._33 = _30*matrix._03 + _31*matrix._13 + _32*matrix._23 + _33*matrix._33;
+  
+   return temp;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the matrix to the identity matrix
+*/
+void FTM::loadIdentity()
+{
+   // Setup the default matrix
+   _00 = 1; _01 = 0; _02 = 0; _03 = 0;
+   _10 = 0; _11 = 1; _12 = 0; _13 = 0;
+   _20 = 0; _21 = 0; _22 = 1; _23 = 0;
+   _30 = 0; _31 = 0; _32 = 0; _33 = 1;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the matrix to a rotation about an axis, the same matrix glRotatef
+   makes
+
+  @param degrees Amount to rotate
+  @param x X component of the axis
+  @param y Y component of the axis
+  @param z Z component of the axis
+*/
+void FTM::loadRotation(float degrees, float x, float y, float z)
+{
+   loadIdentity();
+   float length = (float)sqrt(x * x + y * y + z * z);
+   if (length == 0.0)
+      return;
+   x /= length;
+   y /= length;
+   z /= length;
+
+   float radians = degrees * 3.14159265f / 180.0f;
+   float c = (float)cos(radians);
+   float s = (float)sin(radians);
+   float t = 1.0f - c;
+   _00 = x*x*t + c;   _01 = y*x*t + z*s; _02 = x*z*t - y*s;
+   _10 = x*y*t - z*s; _11 = y*y*t + c;   _12 = y*z*t + x*s;
+   _20 = x*z*t + y*s; _21 = y*z*t - x*s; _22 = z*z*t + c;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the matrix to a translation, the same matrix glTranslatef makes
+
+  @param x Amount to move along x
+  @param y Amount to move along y
+  @param z Amount to move along z
+*/
+void FTM::loadTranslation(float x, float y, float z)
+{
+   loadIdentity();
+   _30 = x; _31 = y; _32 = z;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Transform a point by this matrix (the matrix is stored column by column
+   the way openGL expects, so _30,_31,_32 is the translation)
+
+  @param point The point to transform
+  @return The transformed point
+*/
+Vector3D FTM::transformPoint(const Vector3D &point) const
+{
+   return Vector3D(
+      _00*point.x + _10*point.y + _20*point.z + _30,
+      _01*point.x + _11*point.y + _21*point.z + _31,
+      _02*point.x + _12*point.y + _22*point.z + _32);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Transform a direction by this matrix (no translation)
+
+  @param vector The direction to transform
+  @return The transformed direction
+*/
+Vector3D FTM::transformVector(const Vector3D &vector) const
+{
+   return Vector3D(
+      _00*vector.x + _10*vector.y + _20*vector.z,
+      _01*vector.x + _11*vector.y + _21*vector.z,
+      _02*vector.x + _12*vector.y + _22*vector.z);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the largest amount this matrix scales a length by (the length of
+   its longest axis)
+
+  @return The largest axis scale
+*/
+float FTM::getMaxScale() const
+{
+   float scaleX = _00*_00 + _01*_01 + _02*_02;
+   float scaleY = _10*_10 + _11*_11 + _12*_12;
+   float scaleZ = _20*_20 + _21*_21 + _22*_22;
+   float maxScale = scaleX;
+   if (scaleY > maxScale) maxScale = scaleY;
+   if (scaleZ > maxScale) maxScale = scaleZ;
+   return (float)sqrt(maxScale);
+}
 }
\ No newline at end of file
@@ -1,24 +1,31 @@
-#ifndef FTM_H
-#define FTM_H
-//-----------------------------------------------------------------------------
-namespace SML_CORE
-{
-/**
-  This class holds data that represents a frame transformation matrix.
-*/
-class FTM  
-{
-public:
-   float _00,_01,_02,_03;
-   float _10,_11,_12,_13;
-   float _20,_21,_22,_23;
-   float _30,_31,_32,_33;
-
-public:
-	FTM();
-	virtual ~FTM();
-   FTM multMatrix(FTM martix);
-   void loadIdentity();
-};
-}
-#endif
+#ifndef FTM_H
+#define FTM_H
+//-----------------------------------------------------------------------------
+#include "Vector3D.h"
+
+namespace SML_CORE
+{
+/**
+  This class holds data that represents a frame transformation matrix.
+*/
+class FTM  
+{
+public:
+   float _00,_01,_02,_03;
+   float _10,_11,_12,_13;
+   float _20,_21,_22,_23;
+   float _30,_31,_32,_33;
+
+public:
+	FTM();
+	virtual ~FTM();
+   FTM multMatrix(FTM martix);
+   void loadIdentity();
+   void loadRotation(float degrees, float x, float y, float z);
+   void loadTranslation(float x, float y, float z);
+   Vector3D transformPoint(const Vector3D &point) const;
+   Vector3D transformVector(const Vector3D &vector) const;
+   float getMaxScale() const;
+};
+}
+#endif
@@ -1,12 +1,12 @@
-#include "Face.h"
-
-
-Face::Face()
-{
-
-}
-
-Face::~Face()
-{
-
-}
+#include "Face.h"
+
+
+Face::Face()
+{
+
+}
+
+Face::~Face()
+{
+
+}
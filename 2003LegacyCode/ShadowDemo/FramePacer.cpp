@@ -0,0 +1,213 @@
+#include "FramePacer.h"
+#include "Platform.h"
+
+namespace SML_CORE
+{
+// how long one wait on a fence lasts before it is tried again (nanoseconds)
+static const GLtime FENCE_WAIT_STEP = 1000000;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor.  Nothing is made until the first frame, when there is a
+   context.
+
+  @param framesInFlight How many frames the CPU may get ahead of the GPU
+  @param streamBytesPerFrame The size of each frame's region of the stream
+                             buffer (0 for no stream buffer)
+  */
+FramePacer::FramePacer(int framesInFlight, int streamBytesPerFrame) :
+framesInFlight(1),
+streamBytesPerFrame(streamBytesPerFrame),
+initialized(false),
+frameNumber(0),
+slot(0),
+cpuWaitTime(0.0),
+gpuWaitTime(0.0),
+gpuFrameTime(0.0),
+lastGpuEnd(0)
+{
+   for (int index = 0; index < MAX_FRAMES_IN_FLIGHT; index++)
+   {
+      slots[index].fence = 0;
+      slots[index].startQuery = 0;
+      slots[index].endQuery = 0;
+      slots[index].timed = false;
+   }
+   setFramesInFlight(framesInFlight);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor, waits for the GPU to finish the frames in flight
+  */
+FramePacer::~FramePacer()
+{
+   if (!initialized)
+      return;
+
+   drain();
+   for (int index = 0; index < MAX_FRAMES_IN_FLIGHT; index++)
+   {
+      if (slots[index].startQuery)
+      {
+         GLExtensions::deleteQueries(1, &slots[index].startQuery);
+         GLExtensions::deleteQueries(1, &slots[index].endQuery);
+      }
+   }
+   streamBuffer.destroy();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make the queries and the stream buffer, the first time there is a context
+  */
+void FramePacer::initialize()
+{
+   initialized = true;
+   GLExtensions::load();
+   if (GLExtensions::hasTimerQueries)
+   {
+      for (int index = 0; index < MAX_FRAMES_IN_FLIGHT; index++)
+      {
+         GLExtensions::genQueries(1, &slots[index].startQuery);
+         GLExtensions::genQueries(1, &slots[index].endQuery);
+      }
+   }
+   if (streamBytesPerFrame > 0)
+      streamBuffer.create(framesInFlight, streamBytesPerFrame);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start a frame: wait until the GPU is done with the frame that last used
+   this frame's slot, then hand the slot's stream buffer region over.  Call
+   this before any drawing.
+  */
+void FramePacer::beginFrame()
+{
+   if (!initialized)
+      initialize();
+
+   slot = frameNumber % framesInFlight;
+   waitForSlot(slot);
+   readTimes(slot);
+   streamBuffer.beginFrame(slot);
+
+   if (GLExtensions::hasTimerQueries)
+      GLExtensions::queryCounter(slots[slot].startQuery, GL_TIMESTAMP);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   End a frame: fence off everything it drew and send it to the GPU.  Call
+   this after the last drawing, before the buffers are swapped.
+  */
+void FramePacer::endFrame()
+{
+   FrameSlot &frame = slots[slot];
+   if (GLExtensions::hasTimerQueries)
+   {
+      GLExtensions::queryCounter(frame.endQuery, GL_TIMESTAMP);
+      frame.timed = true;
+   }
+   if (GLExtensions::hasFences)
+      frame.fence = GLExtensions::fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+   // the fence must reach the GPU or a wait on it could never finish
+   glFlush();
+   frameNumber++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Wait for every frame in flight to be drawn, after this the GPU isn't
+   using any slot
+  */
+void FramePacer::drain()
+{
+   if (!initialized)
+      return;
+   for (int offset = 0; offset < framesInFlight; offset++)
+   {
+      int index = (frameNumber + offset) % framesInFlight;
+      waitForSlot(index);
+      readTimes(index);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Change how many frames the CPU may get ahead of the GPU.  The frames in
+   flight are drained first and the stream buffer is remade for the new
+   number of slots.
+
+  @param count The frames in flight (1 to MAX_FRAMES_IN_FLIGHT)
+  */
+void FramePacer::setFramesInFlight(int count)
+{
+   if (count < 1)
+      count = 1;
+   if (count > MAX_FRAMES_IN_FLIGHT)
+      count = MAX_FRAMES_IN_FLIGHT;
+
+   drain();
+   framesInFlight = count;
+   frameNumber = 0;
+   if (initialized && streamBytesPerFrame > 0)
+      streamBuffer.create(framesInFlight, streamBytesPerFrame);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Block until a slot's fence is passed, timing how long it took
+
+  @param index The slot
+  */
+void FramePacer::waitForSlot(int index)
+{
+   cpuWaitTime = 0.0;
+   FrameSlot &frame = slots[index];
+   if (!frame.fence)
+      return;
+
+   double startTime = getPreciseMilliseconds();
+   GLenum result = GLExtensions::clientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+   while (result == GL_TIMEOUT_EXPIRED)
+      result = GLExtensions::clientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_STEP);
+   cpuWaitTime = (float)(getPreciseMilliseconds() - startTime);
+
+   GLExtensions::deleteSync(frame.fence);
+   frame.fence = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read the GPU timestamps of a slot's last frame, if it has been drawn.
+   The frames are read in the order they were drawn so the gap before each
+   one is the time the GPU had nothing to do.
+
+  @param index The slot
+  */
+void FramePacer::readTimes(int index)
+{
+   FrameSlot &frame = slots[index];
+   if (!frame.timed)
+      return;
+
+   // without a fence to wait on the result may not be in yet
+   GLint available = 0;
+   GLExtensions::getQueryObjectiv(frame.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+   if (!available)
+      return;
+
+   GLtime start = 0;
+   GLtime end = 0;
+   GLExtensions::getQueryObjectui64v(frame.startQuery, GL_QUERY_RESULT, &start);
+   GLExtensions::getQueryObjectui64v(frame.endQuery, GL_QUERY_RESULT, &end);
+   frame.timed = false;
+
+   gpuFrameTime = end > start ? (float)((GLtimeSpan)(end - start) / 1.0e6) : 0.0f;
+   gpuWaitTime = lastGpuEnd != 0 && start > lastGpuEnd ? (float)((GLtimeSpan)(start - lastGpuEnd) / 1.0e6) : 0.0f;
+   lastGpuEnd = end;
+}
+}
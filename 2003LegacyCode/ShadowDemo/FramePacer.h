@@ -0,0 +1,75 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+//-----------------------------------------------------------------------------
+#include "GLExtensions.h"
+#include "StreamBuffer.h"
+
+namespace SML_CORE
+{
+/**
+  This class lets the CPU build frames ahead of the GPU drawing them, up to
+  a set number of frames in flight.  Each frame in flight has a slot: a
+  fence put in after its last command, a pair of GPU timestamps and a
+  region of the stream buffer.  Starting a frame reuses the oldest slot, so
+  it waits on that slot's fence, which only blocks when the GPU has fallen
+  more than the frames in flight behind.
+
+  Two waits are measured each frame.  The CPU wait is how long beginFrame
+  blocked on the fence (the GPU was the bottleneck).  The GPU wait is how
+  long the GPU sat idle between finishing one frame and starting the next
+  (the CPU was the bottleneck), taken from the timestamps once the frame
+  has been drawn, so it lags by the frames in flight.
+
+  Drivers without fences aren't paced (the driver queues what it likes)
+  and drivers without timer queries report no GPU times.
+*/
+class FramePacer
+{
+public:
+   /** the most frames that can be in flight */
+   enum {MAX_FRAMES_IN_FLIGHT = 4};
+
+private:
+   /** What is kept for a frame that may still be on the GPU */
+   class FrameSlot
+   {
+   public:
+      GLfence fence;
+      unsigned int startQuery;
+      unsigned int endQuery;
+      bool timed;
+   };
+
+   int framesInFlight;
+   int streamBytesPerFrame;
+   bool initialized;
+   unsigned long frameNumber;
+   int slot;
+   FrameSlot slots[MAX_FRAMES_IN_FLIGHT];
+   StreamBuffer streamBuffer;
+   float cpuWaitTime;
+   float gpuWaitTime;
+   float gpuFrameTime;
+   GLtime lastGpuEnd;
+
+   void initialize();
+   void waitForSlot(int index);
+   void readTimes(int index);
+
+public:
+   FramePacer(int framesInFlight=2, int streamBytesPerFrame=0);
+   virtual ~FramePacer();
+   void beginFrame();
+   void endFrame();
+   void drain();
+   void setFramesInFlight(int count);
+   int getFramesInFlight() const {return framesInFlight;};
+   int getSlot() const {return slot;};
+   bool isPaced() const {return GLExtensions::hasFences;};
+   float getCpuWaitTime() const {return cpuWaitTime;};
+   float getGpuWaitTime() const {return gpuWaitTime;};
+   float getGpuFrameTime() const {return gpuFrameTime;};
+   StreamBuffer& getStreamBuffer() {return streamBuffer;};
+};
+}
+#endif
@@ -0,0 +1,239 @@
+#include <math.h>
+#include <GL/glut.h>
+#include "Frustum.h"
+
+#ifdef SML_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+      Constructor, an empty frustum (everything is inside)
+  */
+Frustum::Frustum() :
+numPlanes(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+Frustum::~Frustum()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Extract the view frustum from the current openGL projection and modelview
+   matrices.  The planes are in the space the modelview matrix transforms
+   from (world space when it only holds the camera).
+  */
+void Frustum::extractFromOpenGL()
+{
+   float projection[16];
+   float modelview[16];
+   glGetFloatv(GL_PROJECTION_MATRIX, projection);
+   glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+   extractFromMatrices(projection, modelview);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Extract the view frustum from the argument (column major, openGL style)
+   projection and modelview matrices.  The planes are the rows of the combined
+   clip matrix added to or subtracted from its last row.
+
+  @param projection The projection matrix
+  @param modelview The modelview matrix
+  */
+void Frustum::extractFromMatrices(const float* projection, const float* modelview)
+{
+   // clip = projection * modelview
+   float clip[16];
+   for (int column = 0; column < 4; column++)
+   {
+      for (int row = 0; row < 4; row++)
+      {
+         clip[column*4 + row] =
+            projection[0*4 + row] * modelview[column*4 + 0] +
+            projection[1*4 + row] * modelview[column*4 + 1] +
+            projection[2*4 + row] * modelview[column*4 + 2] +
+            projection[3*4 + row] * modelview[column*4 + 3];
+      }
+   }
+
+   numPlanes = 0;
+   addPlane(clip[3] + clip[0], clip[7] + clip[4], clip[11] + clip[8],  clip[15] + clip[12]); // left
+   addPlane(clip[3] - clip[0], clip[7] - clip[4], clip[11] - clip[8],  clip[15] - clip[12]); // right
+   addPlane(clip[3] + clip[1], clip[7] + clip[5], clip[11] + clip[9],  clip[15] + clip[13]); // bottom
+   addPlane(clip[3] - clip[1], clip[7] - clip[5], clip[11] - clip[9],  clip[15] - clip[13]); // top
+   addPlane(clip[3] + clip[2], clip[7] + clip[6], clip[11] + clip[10], clip[15] + clip[14]); // near
+   addPlane(clip[3] - clip[2], clip[7] - clip[6], clip[11] - clip[10], clip[15] - clip[14]); // far
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a plane to the volume, the plane is normalized so distances are in
+   world units.
+
+  @return false if the frustum is already full
+  */
+bool Frustum::addPlane(float a, float b, float c, float d)
+{
+   if (numPlanes == MAX_PLANES)
+      return false;
+
+   float length = (float)sqrt(a*a + b*b + c*c);
+   if (length > 0.0f)
+   {
+      a /= length;
+      b /= length;
+      c /= length;
+      d /= length;
+   }
+   planeA[numPlanes] = a;
+   planeB[numPlanes] = b;
+   planeC[numPlanes] = c;
+   planeD[numPlanes] = d;
+   numPlanes++;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the signed distance from a plane to a point (positive is inside)
+  */
+float Frustum::getPlaneDistance(int plane, float x, float y, float z) const
+{
+   return planeA[plane]*x + planeB[plane]*y + planeC[plane]*z + planeD[plane];
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test a single sphere against the volume
+
+  @return true if any part of the sphere may be inside
+  */
+bool Frustum::isSphereVisible(float x, float y, float z, float radius) const
+{
+   for (int plane = 0; plane < numPlanes; plane++)
+   {
+      if (getPlaneDistance(plane, x, y, z) < -radius)
+         return false;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test an axis aligned box against the volume.  For each plane only the
+   corner furthest along the plane normal (and the one furthest against it)
+   needs to be checked.
+
+  @return OUTSIDE, INTERSECTING or INSIDE
+  */
+int Frustum::classifyBox(float minX, float minY, float minZ, float maxX, float maxY, float maxZ) const
+{
+   int result = INSIDE;
+   for (int plane = 0; plane < numPlanes; plane++)
+   {
+      float a = planeA[plane];
+      float b = planeB[plane];
+      float c = planeC[plane];
+      float d = planeD[plane];
+
+      // the corner most inside this plane
+      float farthest = a * (a >= 0 ? maxX : minX) + b * (b >= 0 ? maxY : minY) + c * (c >= 0 ? maxZ : minZ) + d;
+      if (farthest < 0)
+         return OUTSIDE;
+
+      // the corner most outside this plane
+      float nearest = a * (a >= 0 ? minX : maxX) + b * (b >= 0 ? minY : maxY) + c * (c >= 0 ? minZ : maxZ) + d;
+      if (nearest < 0)
+         result = INTERSECTING;
+   }
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test a batch of spheres against the volume.  With SSE four spheres are
+   tested against each plane at once.
+
+  @param centerX The x components of the sphere centers
+  @param centerY The y components of the sphere centers
+  @param centerZ The z components of the sphere centers
+  @param radius The sphere radii
+  @param count The number of spheres
+  @param visible Set to 1 for each sphere that may be inside, 0 otherwise
+  @return The number of spheres that may be inside
+  */
+int Frustum::cullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+                         const float* radius, int count, unsigned char* visible) const
+{
+   int numVisible = 0;
+   int index = 0;
+
+#ifdef SML_SIMD_SSE
+   for (; index + 4 <= count; index += 4)
+   {
+      __m128 x = _mm_loadu_ps(centerX + index);
+      __m128 y = _mm_loadu_ps(centerY + index);
+      __m128 z = _mm_loadu_ps(centerZ + index);
+      __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + index));
+
+      // a lane is culled once it is outside any plane
+      __m128 outside = _mm_setzero_ps();
+      for (int plane = 0; plane < numPlanes; plane++)
+      {
+         __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planeA[plane])), _mm_mul_ps(y, _mm_set1_ps(planeB[plane]))),
+            _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(planeC[plane])), _mm_set1_ps(planeD[plane])));
+         outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+      }
+
+      int mask = _mm_movemask_ps(outside);
+      for (int lane = 0; lane < 4; lane++)
+      {
+         visible[index + lane] = (mask & (1 << lane)) ? 0 : 1;
+         numVisible += visible[index + lane];
+      }
+   }
+#endif
+
+   // whatever is left over (or everything without SSE)
+   for (; index < count; index++)
+   {
+      visible[index] = isSphereVisible(centerX[index], centerY[index], centerZ[index], radius[index]) ? 1 : 0;
+      numVisible += visible[index];
+   }
+   return numVisible;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Build the volume used to cull shadow casters for a point light.  Only the
+   planes the light is inside of are kept: a caster outside such a plane is
+   on the far side from the light, so its shadow (which falls away from the
+   light) can't come back into the view.  Casters outside the other planes
+   may still throw a shadow into view, so those planes are dropped.
+
+  @param lightPosition The position of the point light
+  @return A (possibly looser) volume to test casters against
+  */
+Frustum Frustum::getCasterFrustum(Vector3D lightPosition) const
+{
+   Frustum casterFrustum;
+   for (int plane = 0; plane < numPlanes; plane++)
+   {
+      if (getPlaneDistance(plane, lightPosition.x, lightPosition.y, lightPosition.z) >= 0.0f)
+         casterFrustum.addPlane(planeA[plane], planeB[plane], planeC[plane], planeD[plane]);
+   }
+   return casterFrustum;
+}
+}
@@ -0,0 +1,68 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+//-----------------------------------------------------------------------------
+#include "Vector3D.h"
+
+#if defined(SML_USE_SSE) || defined(__SSE__)
+#define SML_SIMD_SSE
+#endif
+
+namespace SML_CORE
+{
+/**
+   This class holds a convex volume as a set of planes (ax + by + cz + d >= 0
+   is inside).  It is normally extracted from the openGL projection and
+   modelview matrices so it holds the six planes of the view frustum.  Spheres
+   are tested against it four at a time when SSE is available.
+  */
+class Frustum
+{
+public:
+   /** the most planes a volume can hold */
+   enum {MAX_PLANES = 12};
+
+   /** the planes extracted from the openGL matrices */
+   enum FrustumPlane
+   {
+      LEFT_PLANE = 0,
+      RIGHT_PLANE,
+      BOTTOM_PLANE,
+      TOP_PLANE,
+      NEAR_PLANE,
+      FAR_PLANE,
+      NUM_VIEW_PLANES  //this must be the last element
+   };
+
+   /** the result of testing a box against the volume */
+   enum BoxClassification
+   {
+      OUTSIDE = 0,
+      INTERSECTING,
+      INSIDE
+   };
+
+private:
+   int numPlanes;
+   // the planes are stored component by component for the batched tests
+   float planeA[MAX_PLANES];
+   float planeB[MAX_PLANES];
+   float planeC[MAX_PLANES];
+   float planeD[MAX_PLANES];
+
+public:
+   Frustum();
+   virtual ~Frustum();
+   void extractFromOpenGL();
+   void extractFromMatrices(const float* projection, const float* modelview);
+   bool addPlane(float a, float b, float c, float d);
+   void clear() {numPlanes = 0;};
+   int getNumPlanes() const {return numPlanes;};
+   float getPlaneDistance(int plane, float x, float y, float z) const;
+   bool isSphereVisible(float x, float y, float z, float radius) const;
+   int classifyBox(float minX, float minY, float minZ, float maxX, float maxY, float maxZ) const;
+   int cullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+                   const float* radius, int count, unsigned char* visible) const;
+   Frustum getCasterFrustum(Vector3D lightPosition) const;
+};
+}
+#endif
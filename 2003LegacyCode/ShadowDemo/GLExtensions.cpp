@@ -0,0 +1,273 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <GL/glx.h>
+#endif
+#include <string.h>
+#include "GLExtensions.h"
+
+namespace SML_CORE
+{
+// static members defined
+bool GLExtensions::loaded = false;
+int GLExtensions::majorVersion = 1;
+int GLExtensions::minorVersion = 1;
+bool GLExtensions::hasBufferObjects = false;
+bool GLExtensions::hasPersistentMapping = false;
+bool GLExtensions::hasFences = false;
+bool GLExtensions::hasTimerQueries = false;
+GenBuffersFunction GLExtensions::genBuffers = 0;
+DeleteBuffersFunction GLExtensions::deleteBuffers = 0;
+BindBufferFunction GLExtensions::bindBuffer = 0;
+BufferDataFunction GLExtensions::bufferData = 0;
+MapBufferRangeFunction GLExtensions::mapBufferRange = 0;
+UnmapBufferFunction GLExtensions::unmapBuffer = 0;
+BufferStorageFunction GLExtensions::bufferStorage = 0;
+FenceSyncFunction GLExtensions::fenceSync = 0;
+ClientWaitSyncFunction GLExtensions::clientWaitSync = 0;
+DeleteSyncFunction GLExtensions::deleteSync = 0;
+GenQueriesFunction GLExtensions::genQueries = 0;
+DeleteQueriesFunction GLExtensions::deleteQueries = 0;
+QueryCounterFunction GLExtensions::queryCounter = 0;
+GetQueryObjectivFunction GLExtensions::getQueryObjectiv = 0;
+GetQueryObjectui64vFunction GLExtensions::getQueryObjectui64v = 0;
+bool GLExtensions::hasTextureUnits = false;
+bool GLExtensions::hasShaders = false;
+bool GLExtensions::hasFramebufferObjects = false;
+bool GLExtensions::hasStencilWrap = false;
+bool GLExtensions::hasSeparateStencil = false;
+bool GLExtensions::hasFloatTextures = false;
+ActiveTextureFunction GLExtensions::activeTexture = 0;
+CreateShaderFunction GLExtensions::createShader = 0;
+ShaderSourceFunction GLExtensions::shaderSource = 0;
+CompileShaderFunction GLExtensions::compileShader = 0;
+GetShaderivFunction GLExtensions::getShaderiv = 0;
+GetShaderInfoLogFunction GLExtensions::getShaderInfoLog = 0;
+DeleteShaderFunction GLExtensions::deleteShader = 0;
+CreateProgramFunction GLExtensions::createProgram = 0;
+AttachShaderFunction GLExtensions::attachShader = 0;
+LinkProgramFunction GLExtensions::linkProgram = 0;
+GetProgramivFunction GLExtensions::getProgramiv = 0;
+GetProgramInfoLogFunction GLExtensions::getProgramInfoLog = 0;
+UseProgramFunction GLExtensions::useProgram = 0;
+DeleteProgramFunction GLExtensions::deleteProgram = 0;
+GetUniformLocationFunction GLExtensions::getUniformLocation = 0;
+Uniform1iFunction GLExtensions::uniform1i = 0;
+Uniform1fFunction GLExtensions::uniform1f = 0;
+Uniform1fvFunction GLExtensions::uniform1fv = 0;
+Uniform2fFunction GLExtensions::uniform2f = 0;
+Uniform3fFunction GLExtensions::uniform3f = 0;
+Uniform4fFunction GLExtensions::uniform4f = 0;
+UniformMatrix4fvFunction GLExtensions::uniformMatrix4fv = 0;
+StencilOpSeparateFunction GLExtensions::stencilOpSeparate = 0;
+GenFramebuffersFunction GLExtensions::genFramebuffers = 0;
+DeleteFramebuffersFunction GLExtensions::deleteFramebuffers = 0;
+BindFramebufferFunction GLExtensions::bindFramebuffer = 0;
+FramebufferTexture2DFunction GLExtensions::framebufferTexture2D = 0;
+FramebufferRenderbufferFunction GLExtensions::framebufferRenderbuffer = 0;
+CheckFramebufferStatusFunction GLExtensions::checkFramebufferStatus = 0;
+GenRenderbuffersFunction GLExtensions::genRenderbuffers = 0;
+DeleteRenderbuffersFunction GLExtensions::deleteRenderbuffers = 0;
+BindRenderbufferFunction GLExtensions::bindRenderbuffer = 0;
+RenderbufferStorageFunction GLExtensions::renderbufferStorage = 0;
+
+//-----------------------------------------------------------------------------
+/**
+   Look up every call the driver has.  Only the first call does anything,
+   it must be made with a current context.
+  */
+void GLExtensions::load()
+{
+   if (loaded)
+      return;
+   loaded = true;
+
+   // the version string starts "major.minor"
+   const char *version = (const char*)glGetString(GL_VERSION);
+   if (version)
+   {
+      majorVersion = 0;
+      while (*version >= '0' && *version <= '9')
+         majorVersion = majorVersion * 10 + *version++ - '0';
+      minorVersion = 0;
+      if (*version == '.')
+         version++;
+      while (*version >= '0' && *version <= '9')
+         minorVersion = minorVersion * 10 + *version++ - '0';
+   }
+
+   if (hasVersion(1, 5))
+   {
+      genBuffers = (GenBuffersFunction)getProcAddress("glGenBuffers");
+      deleteBuffers = (DeleteBuffersFunction)getProcAddress("glDeleteBuffers");
+      bindBuffer = (BindBufferFunction)getProcAddress("glBindBuffer");
+      bufferData = (BufferDataFunction)getProcAddress("glBufferData");
+      genQueries = (GenQueriesFunction)getProcAddress("glGenQueries");
+      deleteQueries = (DeleteQueriesFunction)getProcAddress("glDeleteQueries");
+      getQueryObjectiv = (GetQueryObjectivFunction)getProcAddress("glGetQueryObjectiv");
+      hasBufferObjects = genBuffers && deleteBuffers && bindBuffer && bufferData;
+   }
+
+   if (hasBufferObjects &&
+       (hasVersion(4, 4) || (isSupported("GL_ARB_buffer_storage") &&
+       (hasVersion(3, 0) || isSupported("GL_ARB_map_buffer_range")))))
+   {
+      mapBufferRange = (MapBufferRangeFunction)getProcAddress("glMapBufferRange");
+      unmapBuffer = (UnmapBufferFunction)getProcAddress("glUnmapBuffer");
+      bufferStorage = (BufferStorageFunction)getProcAddress("glBufferStorage");
+      hasPersistentMapping = mapBufferRange && unmapBuffer && bufferStorage;
+   }
+
+   if (hasVersion(3, 2) || isSupported("GL_ARB_sync"))
+   {
+      fenceSync = (FenceSyncFunction)getProcAddress("glFenceSync");
+      clientWaitSync = (ClientWaitSyncFunction)getProcAddress("glClientWaitSync");
+      deleteSync = (DeleteSyncFunction)getProcAddress("glDeleteSync");
+      hasFences = fenceSync && clientWaitSync && deleteSync;
+   }
+
+   if (genQueries && (hasVersion(3, 3) || isSupported("GL_ARB_timer_query")))
+   {
+      queryCounter = (QueryCounterFunction)getProcAddress("glQueryCounter");
+      getQueryObjectui64v = (GetQueryObjectui64vFunction)getProcAddress("glGetQueryObjectui64v");
+      hasTimerQueries = queryCounter && getQueryObjectui64v && deleteQueries && getQueryObjectiv;
+   }
+
+   if (hasVersion(1, 3))
+   {
+      activeTexture = (ActiveTextureFunction)getProcAddress("glActiveTexture");
+      hasTextureUnits = activeTexture != 0;
+   }
+
+   // the wrapping stencil ops are only enums, there are no calls to find
+   hasStencilWrap = hasVersion(1, 4) || isSupported("GL_EXT_stencil_wrap");
+
+   // so are the float texture formats
+   hasFloatTextures = hasVersion(3, 0) || isSupported("GL_ARB_texture_float");
+
+   if (hasVersion(2, 0))
+   {
+      createShader = (CreateShaderFunction)getProcAddress("glCreateShader");
+      shaderSource = (ShaderSourceFunction)getProcAddress("glShaderSource");
+      compileShader = (CompileShaderFunction)getProcAddress("glCompileShader");
+      getShaderiv = (GetShaderivFunction)getProcAddress("glGetShaderiv");
+      getShaderInfoLog = (GetShaderInfoLogFunction)getProcAddress("glGetShaderInfoLog");
+      deleteShader = (DeleteShaderFunction)getProcAddress("glDeleteShader");
+      createProgram = (CreateProgramFunction)getProcAddress("glCreateProgram");
+      attachShader = (AttachShaderFunction)getProcAddress("glAttachShader");
+      linkProgram = (LinkProgramFunction)getProcAddress("glLinkProgram");
+      getProgramiv = (GetProgramivFunction)getProcAddress("glGetProgramiv");
+      getProgramInfoLog = (GetProgramInfoLogFunction)getProcAddress("glGetProgramInfoLog");
+      useProgram = (UseProgramFunction)getProcAddress("glUseProgram");
+      deleteProgram = (DeleteProgramFunction)getProcAddress("glDeleteProgram");
+      getUniformLocation = (GetUniformLocationFunction)getProcAddress("glGetUniformLocation");
+      uniform1i = (Uniform1iFunction)getProcAddress("glUniform1i");
+      uniform1f = (Uniform1fFunction)getProcAddress("glUniform1f");
+      uniform1fv = (Uniform1fvFunction)getProcAddress("glUniform1fv");
+      uniform2f = (Uniform2fFunction)getProcAddress("glUniform2f");
+      uniform3f = (Uniform3fFunction)getProcAddress("glUniform3f");
+      uniform4f = (Uniform4fFunction)getProcAddress("glUniform4f");
+      uniformMatrix4fv = (UniformMatrix4fvFunction)getProcAddress("glUniformMatrix4fv");
+      hasShaders = createShader && shaderSource && compileShader && getShaderiv &&
+         getShaderInfoLog && deleteShader && createProgram && attachShader &&
+         linkProgram && getProgramiv && getProgramInfoLog && useProgram &&
+         deleteProgram && getUniformLocation && uniform1i && uniform1f &&
+         uniform1fv && uniform2f && uniform3f && uniform4f && uniformMatrix4fv;
+      stencilOpSeparate = (StencilOpSeparateFunction)getProcAddress("glStencilOpSeparate");
+      hasSeparateStencil = stencilOpSeparate != 0;
+   }
+
+   // the older extension has the same calls and enums with an EXT ending
+   const char *suffix = 0;
+   if (hasVersion(3, 0) || isSupported("GL_ARB_framebuffer_object"))
+      suffix = "";
+   else if (isSupported("GL_EXT_framebuffer_object"))
+      suffix = "EXT";
+   if (suffix)
+   {
+      genFramebuffers = (GenFramebuffersFunction)getProcAddress("glGenFramebuffers", suffix);
+      deleteFramebuffers = (DeleteFramebuffersFunction)getProcAddress("glDeleteFramebuffers", suffix);
+      bindFramebuffer = (BindFramebufferFunction)getProcAddress("glBindFramebuffer", suffix);
+      framebufferTexture2D = (FramebufferTexture2DFunction)getProcAddress("glFramebufferTexture2D", suffix);
+      framebufferRenderbuffer = (FramebufferRenderbufferFunction)getProcAddress("glFramebufferRenderbuffer", suffix);
+      checkFramebufferStatus = (CheckFramebufferStatusFunction)getProcAddress("glCheckFramebufferStatus", suffix);
+      genRenderbuffers = (GenRenderbuffersFunction)getProcAddress("glGenRenderbuffers", suffix);
+      deleteRenderbuffers = (DeleteRenderbuffersFunction)getProcAddress("glDeleteRenderbuffers", suffix);
+      bindRenderbuffer = (BindRenderbufferFunction)getProcAddress("glBindRenderbuffer", suffix);
+      renderbufferStorage = (RenderbufferStorageFunction)getProcAddress("glRenderbufferStorage", suffix);
+      hasFramebufferObjects = genFramebuffers && deleteFramebuffers && bindFramebuffer &&
+         framebufferTexture2D && framebufferRenderbuffer && checkFramebufferStatus &&
+         genRenderbuffers && deleteRenderbuffers && bindRenderbuffer && renderbufferStorage;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find out if the driver lists an extension
+
+  @param extension The full name of the extension ("GL_ARB_sync")
+  @return true if it is in the extension string
+  */
+bool GLExtensions::isSupported(const char *extension)
+{
+   const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+   if (!extensions)
+      return false;
+
+   // the names are separated by spaces, a match must be a whole name
+   int length = strlen(extension);
+   const char *found = strstr(extensions, extension);
+   while (found)
+   {
+      bool startsName = found == extensions || found[-1] == ' ';
+      bool endsName = found[length] == ' ' || found[length] == '\0';
+      if (startsName && endsName)
+         return true;
+      found = strstr(found + length, extension);
+   }
+   return false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @return true if the driver's version is at least major.minor
+  */
+bool GLExtensions::hasVersion(int major, int minor)
+{
+   return majorVersion > major || (majorVersion == major && minorVersion >= minor);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Ask the driver where one of its calls is
+
+  @param name The name of the call
+  @return The call, 0 if the driver doesn't have it
+  */
+void* GLExtensions::getProcAddress(const char *name)
+{
+#ifdef _WIN32
+   return (void*)wglGetProcAddress(name);
+#else
+   return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Ask the driver where one of an extension's calls is
+
+  @param name The name of the call without its ending
+  @param suffix The extension's ending ("EXT", "" for the core call)
+  @return The call, 0 if the driver doesn't have it
+  */
+void* GLExtensions::getProcAddress(const char *name, const char *suffix)
+{
+   char fullName[MAX_NAME_LENGTH];
+   if (strlen(name) + strlen(suffix) >= MAX_NAME_LENGTH)
+      return 0;
+   strcpy(fullName, name);
+   strcat(fullName, suffix);
+   return getProcAddress(fullName);
+}
+}
@@ -0,0 +1,271 @@
+#ifndef GLEXTENSIONS_H
+#define GLEXTENSIONS_H
+//-----------------------------------------------------------------------------
+#include <stddef.h>
+#include <GL/glut.h>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// the enums of the calls below, for headers older than them
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER                  0x8892
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW                   0x88E0
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT                 0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT            0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT              0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE    0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT       0x00000001
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED              0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED               0x911B
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED           0x911C
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED                   0x911D
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP                     0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT                  0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE        0x8867
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE                 0x812F
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0                      0x84C0
+#endif
+#ifndef GL_TEXTURE_CUBE_MAP
+#define GL_TEXTURE_CUBE_MAP              0x8513
+#endif
+#ifndef GL_TEXTURE_CUBE_MAP_POSITIVE_X
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_X   0x8515
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER               0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER                 0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS                0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS                   0x8B82
+#endif
+#ifndef GL_INFO_LOG_LENGTH
+#define GL_INFO_LOG_LENGTH               0x8B84
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER                   0x8D40
+#endif
+#ifndef GL_RENDERBUFFER
+#define GL_RENDERBUFFER                  0x8D41
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0             0x8CE0
+#endif
+#ifndef GL_DEPTH_ATTACHMENT
+#define GL_DEPTH_ATTACHMENT              0x8D00
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE          0x8CD5
+#endif
+#ifndef GL_INCR_WRAP
+#define GL_INCR_WRAP                     0x8507
+#endif
+#ifndef GL_DECR_WRAP
+#define GL_DECR_WRAP                     0x8508
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24             0x81A6
+#endif
+#ifndef GL_RGBA32F_ARB
+#define GL_RGBA32F_ARB                   0x8814
+#endif
+#ifndef GL_LUMINANCE32F_ARB
+#define GL_LUMINANCE32F_ARB              0x8818
+#endif
+#ifndef GL_LUMINANCE_ALPHA32F_ARB
+#define GL_LUMINANCE_ALPHA32F_ARB        0x8819
+#endif
+
+namespace SML_CORE
+{
+// the types of the calls below, named so they can't clash with a newer header
+#ifdef _MSC_VER
+typedef unsigned __int64 GLtime;
+typedef __int64 GLtimeSpan;
+#else
+typedef unsigned long long GLtime;
+typedef long long GLtimeSpan;
+#endif
+typedef struct GLfenceObject *GLfence;
+typedef ptrdiff_t GLbufferSize;
+typedef ptrdiff_t GLbufferOffset;
+
+// buffer objects (1.5)
+typedef void (APIENTRY *GenBuffersFunction)(GLsizei count, GLuint *buffers);
+typedef void (APIENTRY *DeleteBuffersFunction)(GLsizei count, const GLuint *buffers);
+typedef void (APIENTRY *BindBufferFunction)(GLenum target, GLuint buffer);
+typedef void (APIENTRY *BufferDataFunction)(GLenum target, GLbufferSize size, const void *data, GLenum usage);
+// persistent mapping (3.0 and 4.4 or ARB_map_buffer_range and ARB_buffer_storage)
+typedef void* (APIENTRY *MapBufferRangeFunction)(GLenum target, GLbufferOffset offset, GLbufferSize length, GLbitfield access);
+typedef GLboolean (APIENTRY *UnmapBufferFunction)(GLenum target);
+typedef void (APIENTRY *BufferStorageFunction)(GLenum target, GLbufferSize size, const void *data, GLbitfield flags);
+// fences (3.2 or ARB_sync)
+typedef GLfence (APIENTRY *FenceSyncFunction)(GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRY *ClientWaitSyncFunction)(GLfence fence, GLbitfield flags, GLtime timeout);
+typedef void (APIENTRY *DeleteSyncFunction)(GLfence fence);
+// gpu timestamps (3.3 or ARB_timer_query)
+typedef void (APIENTRY *GenQueriesFunction)(GLsizei count, GLuint *queries);
+typedef void (APIENTRY *DeleteQueriesFunction)(GLsizei count, const GLuint *queries);
+typedef void (APIENTRY *QueryCounterFunction)(GLuint query, GLenum target);
+typedef void (APIENTRY *GetQueryObjectivFunction)(GLuint query, GLenum name, GLint *value);
+typedef void (APIENTRY *GetQueryObjectui64vFunction)(GLuint query, GLenum name, GLtime *value);
+// texture units (1.3)
+typedef void (APIENTRY *ActiveTextureFunction)(GLenum unit);
+// shaders (2.0)
+typedef GLuint (APIENTRY *CreateShaderFunction)(GLenum type);
+typedef void (APIENTRY *ShaderSourceFunction)(GLuint shader, GLsizei count, const char **strings, const GLint *lengths);
+typedef void (APIENTRY *CompileShaderFunction)(GLuint shader);
+typedef void (APIENTRY *GetShaderivFunction)(GLuint shader, GLenum name, GLint *value);
+typedef void (APIENTRY *GetShaderInfoLogFunction)(GLuint shader, GLsizei size, GLsizei *length, char *log);
+typedef void (APIENTRY *DeleteShaderFunction)(GLuint shader);
+typedef GLuint (APIENTRY *CreateProgramFunction)();
+typedef void (APIENTRY *AttachShaderFunction)(GLuint program, GLuint shader);
+typedef void (APIENTRY *LinkProgramFunction)(GLuint program);
+typedef void (APIENTRY *GetProgramivFunction)(GLuint program, GLenum name, GLint *value);
+typedef void (APIENTRY *GetProgramInfoLogFunction)(GLuint program, GLsizei size, GLsizei *length, char *log);
+typedef void (APIENTRY *UseProgramFunction)(GLuint program);
+typedef void (APIENTRY *DeleteProgramFunction)(GLuint program);
+typedef GLint (APIENTRY *GetUniformLocationFunction)(GLuint program, const char *name);
+typedef void (APIENTRY *Uniform1iFunction)(GLint location, GLint value);
+typedef void (APIENTRY *Uniform1fFunction)(GLint location, GLfloat value);
+typedef void (APIENTRY *Uniform1fvFunction)(GLint location, GLsizei count, const GLfloat *values);
+typedef void (APIENTRY *Uniform2fFunction)(GLint location, GLfloat x, GLfloat y);
+typedef void (APIENTRY *Uniform3fFunction)(GLint location, GLfloat x, GLfloat y, GLfloat z);
+typedef void (APIENTRY *Uniform4fFunction)(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+typedef void (APIENTRY *UniformMatrix4fvFunction)(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
+typedef void (APIENTRY *StencilOpSeparateFunction)(GLenum face, GLenum fail, GLenum zFail, GLenum zPass);
+// framebuffer objects (3.0 or ARB_framebuffer_object or EXT_framebuffer_object)
+typedef void (APIENTRY *GenFramebuffersFunction)(GLsizei count, GLuint *framebuffers);
+typedef void (APIENTRY *DeleteFramebuffersFunction)(GLsizei count, const GLuint *framebuffers);
+typedef void (APIENTRY *BindFramebufferFunction)(GLenum target, GLuint framebuffer);
+typedef void (APIENTRY *FramebufferTexture2DFunction)(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level);
+typedef void (APIENTRY *FramebufferRenderbufferFunction)(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer);
+typedef GLenum (APIENTRY *CheckFramebufferStatusFunction)(GLenum target);
+typedef void (APIENTRY *GenRenderbuffersFunction)(GLsizei count, GLuint *renderbuffers);
+typedef void (APIENTRY *DeleteRenderbuffersFunction)(GLsizei count, const GLuint *renderbuffers);
+typedef void (APIENTRY *BindRenderbufferFunction)(GLenum target, GLuint renderbuffer);
+typedef void (APIENTRY *RenderbufferStorageFunction)(GLenum target, GLenum format, GLsizei width, GLsizei height);
+
+/**
+  This class finds the openGL calls newer than the 1.1 headers the project
+  is built with.  They are looked up from the driver at run time (there
+  must be a current context), each group is only loaded if the driver's
+  version or extension string says it has it, so check the has* flag of a
+  group before using its calls.
+*/
+class GLExtensions
+{
+private:
+   /** the longest call name that can be looked up with an ending */
+   enum {MAX_NAME_LENGTH = 64};
+
+   static bool loaded;
+   static int majorVersion;
+   static int minorVersion;
+
+   static void* getProcAddress(const char *name);
+   static void* getProcAddress(const char *name, const char *suffix);
+   static bool hasVersion(int major, int minor);
+
+public:
+   static bool hasBufferObjects;
+   static bool hasPersistentMapping;
+   static bool hasFences;
+   static bool hasTimerQueries;
+   static bool hasTextureUnits;
+   static bool hasShaders;
+   static bool hasFramebufferObjects;
+   static bool hasStencilWrap;
+   static bool hasSeparateStencil;
+   static bool hasFloatTextures;
+
+   static GenBuffersFunction genBuffers;
+   static DeleteBuffersFunction deleteBuffers;
+   static BindBufferFunction bindBuffer;
+   static BufferDataFunction bufferData;
+   static MapBufferRangeFunction mapBufferRange;
+   static UnmapBufferFunction unmapBuffer;
+   static BufferStorageFunction bufferStorage;
+   static FenceSyncFunction fenceSync;
+   static ClientWaitSyncFunction clientWaitSync;
+   static DeleteSyncFunction deleteSync;
+   static GenQueriesFunction genQueries;
+   static DeleteQueriesFunction deleteQueries;
+   static QueryCounterFunction queryCounter;
+   static GetQueryObjectivFunction getQueryObjectiv;
+   static GetQueryObjectui64vFunction getQueryObjectui64v;
+   static ActiveTextureFunction activeTexture;
+   static CreateShaderFunction createShader;
+   static ShaderSourceFunction shaderSource;
+   static CompileShaderFunction compileShader;
+   static GetShaderivFunction getShaderiv;
+   static GetShaderInfoLogFunction getShaderInfoLog;
+   static DeleteShaderFunction deleteShader;
+   static CreateProgramFunction createProgram;
+   static AttachShaderFunction attachShader;
+   static LinkProgramFunction linkProgram;
+   static GetProgramivFunction getProgramiv;
+   static GetProgramInfoLogFunction getProgramInfoLog;
+   static UseProgramFunction useProgram;
+   static DeleteProgramFunction deleteProgram;
+   static GetUniformLocationFunction getUniformLocation;
+   static Uniform1iFunction uniform1i;
+   static Uniform1fFunction uniform1f;
+   static Uniform1fvFunction uniform1fv;
+   static Uniform2fFunction uniform2f;
+   static Uniform3fFunction uniform3f;
+   static Uniform4fFunction uniform4f;
+   static UniformMatrix4fvFunction uniformMatrix4fv;
+   static StencilOpSeparateFunction stencilOpSeparate;
+   static GenFramebuffersFunction genFramebuffers;
+   static DeleteFramebuffersFunction deleteFramebuffers;
+   static BindFramebufferFunction bindFramebuffer;
+   static FramebufferTexture2DFunction framebufferTexture2D;
+   static FramebufferRenderbufferFunction framebufferRenderbuffer;
+   static CheckFramebufferStatusFunction checkFramebufferStatus;
+   static GenRenderbuffersFunction genRenderbuffers;
+   static DeleteRenderbuffersFunction deleteRenderbuffers;
+   static BindRenderbufferFunction bindRenderbuffer;
+   static RenderbufferStorageFunction renderbufferStorage;
+
+   static void load();
+   static bool isSupported(const char *extension);
+};
+}
+#endif
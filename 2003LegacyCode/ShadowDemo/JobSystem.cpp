@@ -0,0 +1,519 @@
+#include "JobSystem.h"
+#include "Platform.h"
+
+using std::vector;
+
+namespace SML_CORE
+{
+// the index of the worker the current thread is (-1 if it isn't one)
+#ifdef _MSC_VER
+static __declspec(thread) int currentWorker = -1;
+#else
+static __thread int currentWorker = -1;
+#endif
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor, starts the worker threads
+
+  @param numThreads The number of threads to run jobs on (counting the
+                    thread creating the system), 0 for one per core
+  */
+JobSystem::JobSystem(int numThreads) :
+numThreads(numThreads),
+quitting(false),
+jobs(MAX_JOBS),
+links(MAX_LINKS),
+firstFreeJob(0),
+firstFreeLink(0),
+queues(0),
+threads(0),
+workerStarts(0)
+{
+   if (this->numThreads < 1)
+      this->numThreads = getNumProcessors();
+
+   // chain the job and link pools into free lists
+   int index;
+   for (index = 0; index < MAX_JOBS; index++)
+   {
+      jobs[index].generation = 0;
+      jobs[index].nextFree = index + 1 < MAX_JOBS ? index + 1 : -1;
+   }
+   for (index = 0; index < MAX_LINKS; index++)
+      links[index].next = index + 1 < MAX_LINKS ? index + 1 : -1;
+
+   jobLock = createLock();
+   workAvailable = createSemaphore();
+
+   queues.resize(this->numThreads);
+   for (index = 0; index < this->numThreads; index++)
+   {
+      queues[index].lock = createLock();
+      queues[index].jobs.resize(MAX_JOBS);
+      queues[index].head = 0;
+      queues[index].count = 0;
+   }
+   mainQueue.lock = createLock();
+   mainQueue.jobs.resize(MAX_JOBS);
+   mainQueue.head = 0;
+   mainQueue.count = 0;
+
+   // this thread is worker 0 (the main thread), start the others
+   currentWorker = 0;
+   workerStarts.resize(this->numThreads);
+   for (index = 1; index < this->numThreads; index++)
+   {
+      workerStarts[index].system = this;
+      workerStarts[index].worker = index;
+      threads.push_back(startThread(workerMain, &workerStarts[index]));
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor, stops the worker threads.  Jobs that haven't been run are
+   dropped, so wait for the work you need first.
+  */
+JobSystem::~JobSystem()
+{
+   quitting = true;
+   int index;
+   for (index = 0; index < threads.size(); index++)
+      signalSemaphore(workAvailable);
+   for (index = 0; index < threads.size(); index++)
+      joinThread(threads[index]);
+
+   for (index = 0; index < queues.size(); index++)
+      destroyLock(queues[index].lock);
+   destroyLock(mainQueue.lock);
+   destroySemaphore(workAvailable);
+   destroyLock(jobLock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Create a job that can run on any thread.  The job doesn't run until it
+   is submitted, so dependencies can be added first.
+
+  @param function What the job does
+  @param data Passed to the function
+  @param begin The first item for the function to do
+  @param end One past the last item for the function to do
+  @return The new job
+  */
+JobId JobSystem::createJob(JobFunction function, void *data, int begin, int end)
+{
+   return allocateJob(function, data, begin, end, false);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Create a job that must run on the main thread (it makes openGL calls).
+   See createJob.
+  */
+JobId JobSystem::createMainThreadJob(JobFunction function, void *data, int begin, int end)
+{
+   return allocateJob(function, data, begin, end, true);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Take a job from the pool.  If the pool is empty this thread runs jobs
+   until one is given back.
+  */
+JobId JobSystem::allocateJob(JobFunction function, void *data, int begin, int end, bool mainThread)
+{
+   lockMutex(jobLock);
+   while (firstFreeJob < 0)
+   {
+      unlockMutex(jobLock);
+      if (!runNextJob())
+         yieldThread();
+      lockMutex(jobLock);
+   }
+
+   int index = firstFreeJob;
+   Job &job = jobs[index];
+   firstFreeJob = job.nextFree;
+   job.function = function;
+   job.data = data;
+   job.begin = begin;
+   job.end = end;
+   job.pendingCount = 1;  // held until it is submitted
+   job.firstDependent = -1;
+   job.mainThread = mainThread;
+
+   JobId id;
+   id.index = index;
+   id.generation = job.generation;
+   unlockMutex(jobLock);
+   return id;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make a job wait for another job to finish before it runs.  Must be
+   called before the job is submitted.
+
+  @param job The job that waits
+  @param prerequisite The job that must finish first
+  */
+void JobSystem::addDependency(JobId job, JobId prerequisite)
+{
+   if (job.isNull() || prerequisite.isNull())
+      return;
+
+   lockMutex(jobLock);
+   while (firstFreeLink < 0)
+   {
+      unlockMutex(jobLock);
+      if (!runNextJob())
+         yieldThread();
+      lockMutex(jobLock);
+   }
+
+   // nothing to wait for if the prerequisite is already done
+   Job &before = jobs[prerequisite.index];
+   if (before.generation == prerequisite.generation)
+   {
+      int link = firstFreeLink;
+      firstFreeLink = links[link].next;
+      links[link].job = job.index;
+      links[link].next = before.firstDependent;
+      before.firstDependent = link;
+      jobs[job.index].pendingCount++;
+   }
+   unlockMutex(jobLock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Let a job run, it is queued as soon as the jobs it depends on are done.
+
+  @param job The job to submit
+  */
+void JobSystem::submit(JobId job)
+{
+   if (job.isNull())
+      return;
+
+   lockMutex(jobLock);
+   if (--jobs[job.index].pendingCount == 0)
+      enqueue(job.index);
+   unlockMutex(jobLock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Create and submit a job (see createJob)
+  */
+JobId JobSystem::run(JobFunction function, void *data, int begin, int end)
+{
+   JobId job = createJob(function, data, begin, end);
+   submit(job);
+   return job;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Create and submit a main thread job (see createMainThreadJob)
+  */
+JobId JobSystem::runOnMainThread(JobFunction function, void *data, int begin, int end)
+{
+   JobId job = createMainThreadJob(function, data, begin, end);
+   submit(job);
+   return job;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @param job The job to check
+  @return true if the job has run
+  */
+bool JobSystem::isFinished(JobId job)
+{
+   if (job.isNull())
+      return true;
+
+   lockMutex(jobLock);
+   bool finished = jobs[job.index].generation != job.generation;
+   unlockMutex(jobLock);
+   return finished;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Wait for a job to finish, running other jobs in the meantime.
+
+  @param job The job to wait for
+  */
+void JobSystem::wait(JobId job)
+{
+   while (!isFinished(job))
+   {
+      if (!runNextJob())
+         yieldThread();
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Split a loop over count items into jobs.  The chunks are at least
+   grainSize items, but there are no more than a few per thread.
+
+  @param function Called with each chunk's range
+  @param data Passed to the function
+  @param count The number of items
+  @param grainSize The fewest items worth making a job for
+  @param prerequisite A job that must finish before the loop starts
+  @return A job that finishes when the whole loop is done
+  */
+JobId JobSystem::parallelForAsync(JobFunction function, void *data, int count, int grainSize, JobId prerequisite)
+{
+   if (grainSize < 1)
+      grainSize = 1;
+   int maxChunks = numThreads * 4;
+   if ((count + grainSize - 1) / grainSize > maxChunks)
+      grainSize = (count + maxChunks - 1) / maxChunks;
+
+   JobId done = createJob(0, 0, 0, 0);
+   addDependency(done, prerequisite);
+   for (int begin = 0; begin < count; begin += grainSize)
+   {
+      int end = begin + grainSize;
+      if (end > count)
+         end = count;
+      JobId chunk = createJob(function, data, begin, end);
+      addDependency(chunk, prerequisite);
+      addDependency(done, chunk);
+      submit(chunk);
+   }
+   submit(done);
+   return done;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Run a loop over count items on every thread and wait for it to finish.
+   A loop too small to split is just called on this thread.
+
+  @param function Called with each chunk's range
+  @param data Passed to the function
+  @param count The number of items
+  @param grainSize The fewest items worth making a job for
+  */
+void JobSystem::parallelFor(JobFunction function, void *data, int count, int grainSize)
+{
+   if (numThreads == 1 || count <= grainSize)
+   {
+      if (count > 0)
+         function(data, 0, count);
+      return;
+   }
+   wait(parallelForAsync(function, data, count, grainSize));
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Run the main thread jobs that are ready.  Call this from the thread that
+   owns the openGL context once a frame.
+
+  @return The number of jobs run
+  */
+int JobSystem::runMainThreadJobs()
+{
+   int numRun = 0;
+   int jobIndex;
+   while (popJob(mainQueue, false, jobIndex))
+   {
+      execute(jobIndex);
+      numRun++;
+   }
+   return numRun;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Put a ready job on a queue: the main thread queue, or the queue of the
+   worker that made it ready.  Called with the job lock held.
+  */
+void JobSystem::enqueue(int jobIndex)
+{
+   if (jobs[jobIndex].mainThread)
+   {
+      pushJob(mainQueue, jobIndex);
+      return;
+   }
+
+   int worker = getCurrentWorker();
+   pushJob(queues[worker < numThreads ? worker : 0], jobIndex);
+   signalSemaphore(workAvailable);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Run a job, then release the jobs that were waiting for it and give it
+   back to the pool.
+  */
+void JobSystem::execute(int jobIndex)
+{
+   Job &job = jobs[jobIndex];
+   if (job.function)
+      job.function(job.data, job.begin, job.end);
+   release(jobIndex);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Finish a job: queue the dependents that are now ready and put the job
+   and its links back in their pools.
+  */
+void JobSystem::release(int jobIndex)
+{
+   lockMutex(jobLock);
+   Job &job = jobs[jobIndex];
+   int link = job.firstDependent;
+   while (link >= 0)
+   {
+      int next = links[link].next;
+      int dependent = links[link].job;
+      if (--jobs[dependent].pendingCount == 0)
+         enqueue(dependent);
+      links[link].next = firstFreeLink;
+      firstFreeLink = link;
+      link = next;
+   }
+
+   job.generation++;
+   job.nextFree = firstFreeJob;
+   firstFreeJob = jobIndex;
+   unlockMutex(jobLock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find a job and run it: the main thread takes its openGL jobs first, then
+   a worker takes the newest job from its own queue, then it steals the
+   oldest job from the other queues.
+
+  @return false if there was nothing to do
+  */
+bool JobSystem::runNextJob()
+{
+   int worker = getCurrentWorker();
+   int jobIndex;
+   if (currentWorker == 0 && popJob(mainQueue, false, jobIndex))
+   {
+      execute(jobIndex);
+      return true;
+   }
+
+   if (worker >= numThreads)
+      worker = 0;
+   if (popJob(queues[worker], true, jobIndex))
+   {
+      execute(jobIndex);
+      return true;
+   }
+   for (int offset = 1; offset < numThreads; offset++)
+   {
+      if (popJob(queues[(worker + offset) % numThreads], false, jobIndex))
+      {
+         execute(jobIndex);
+         return true;
+      }
+   }
+   return false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Take a job off a queue
+
+  @param queue The queue
+  @param newest true to take the newest job (the owner), false to take the
+                oldest (a thief)
+  @param jobIndex Set to the job taken
+  @return false if the queue was empty
+  */
+bool JobSystem::popJob(WorkQueue &queue, bool newest, int &jobIndex)
+{
+   lockMutex(queue.lock);
+   if (queue.count == 0)
+   {
+      unlockMutex(queue.lock);
+      return false;
+   }
+
+   int size = queue.jobs.size();
+   if (newest)
+   {
+      jobIndex = queue.jobs[(queue.head + queue.count - 1) % size];
+   }
+   else
+   {
+      jobIndex = queue.jobs[queue.head];
+      queue.head = (queue.head + 1) % size;
+   }
+   queue.count--;
+   unlockMutex(queue.lock);
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a job to the newest end of a queue.  A queue can hold every job in
+   the pool so it never fills.
+  */
+void JobSystem::pushJob(WorkQueue &queue, int jobIndex)
+{
+   lockMutex(queue.lock);
+   queue.jobs[(queue.head + queue.count) % queue.jobs.size()] = jobIndex;
+   queue.count++;
+   unlockMutex(queue.lock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Run jobs until the system is destroyed, sleeping when there are none
+  */
+void JobSystem::workerLoop(int worker)
+{
+   currentWorker = worker;
+   while (!quitting)
+   {
+      if (!runNextJob())
+         waitSemaphore(workAvailable);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @return The current thread's worker index, threads that aren't workers
+          share the main thread's queue
+  */
+int JobSystem::getCurrentWorker()
+{
+   return currentWorker < 0 ? 0 : currentWorker;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The entry point of the worker threads
+  */
+void JobSystem::workerMain(void *start)
+{
+   WorkerStart *workerStart = (WorkerStart*)start;
+   workerStart->system->workerLoop(workerStart->worker);
+}
+
+//-----------------------------------------------------------------------------
+/**
+  @return The number of processors in the machine
+  */
+int JobSystem::getNumProcessors()
+{
+   return SML_CORE::getNumProcessors();
+}
+}
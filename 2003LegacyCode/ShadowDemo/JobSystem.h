@@ -0,0 +1,134 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+//-----------------------------------------------------------------------------
+#include <vector>
+
+namespace SML_CORE
+{
+/** The work done by a job, it is called with the range of items to do */
+typedef void (*JobFunction)(void *data, int begin, int end);
+
+/**
+  This class names a job in a JobSystem.  A job's slot is reused once it
+  finishes, the generation tells an old id from the slot's new job (an old
+  id is always finished).
+*/
+class JobId
+{
+public:
+   int index;
+   unsigned int generation;
+
+   JobId() : index(-1), generation(0) {};
+   bool isNull() const {return index < 0;};
+};
+
+/**
+  This class is a work stealing job scheduler.  It starts a worker thread
+  for each core (the thread that creates it is the first worker), each
+  worker has its own queue of jobs.  A worker takes the newest job from its
+  own queue and when that is empty it steals the oldest job from another
+  worker's queue.
+
+  Jobs can depend on other jobs, a job is only queued once every job it
+  depends on has finished, so a frame can be written as a graph of jobs.
+  A thread that waits for a job runs other jobs while it waits.
+
+  openGL calls must stay on the thread that owns the context, so jobs can
+  be created as main thread jobs.  They go in a separate queue that is only
+  run by the main thread, in runMainThreadJobs or while it waits.
+
+  Jobs come from a fixed pool that is allocated up front, so creating jobs
+  doesn't touch the heap.
+*/
+class JobSystem
+{
+private:
+   /** A job and its place in the dependency graph */
+   class Job
+   {
+   public:
+      JobFunction function;
+      void *data;
+      int begin;
+      int end;
+      int pendingCount;
+      int firstDependent;
+      unsigned int generation;
+      int nextFree;
+      bool mainThread;
+   };
+
+   /** An entry in a job's list of jobs that depend on it */
+   class DependencyLink
+   {
+   public:
+      int job;
+      int next;
+   };
+
+   /** A locked double ended queue of job indices */
+   class WorkQueue
+   {
+   public:
+      void *lock;
+      std::vector<int> jobs;
+      int head;
+      int count;
+   };
+
+   /** What a worker thread is started with */
+   class WorkerStart
+   {
+   public:
+      JobSystem *system;
+      int worker;
+   };
+
+   int numThreads;
+   volatile bool quitting;
+   void *jobLock;
+   void *workAvailable;
+   std::vector<Job> jobs;
+   std::vector<DependencyLink> links;
+   int firstFreeJob;
+   int firstFreeLink;
+   std::vector<WorkQueue> queues;
+   WorkQueue mainQueue;
+   std::vector<void*> threads;
+   std::vector<WorkerStart> workerStarts;
+
+   JobId allocateJob(JobFunction function, void *data, int begin, int end, bool mainThread);
+   void enqueue(int jobIndex);
+   void release(int jobIndex);
+   void execute(int jobIndex);
+   bool runNextJob();
+   bool popJob(WorkQueue &queue, bool newest, int &jobIndex);
+   void pushJob(WorkQueue &queue, int jobIndex);
+   void workerLoop(int worker);
+   static int getCurrentWorker();
+
+   static void workerMain(void *start);
+
+public:
+   /** the most jobs (and dependencies) that can be waiting at once */
+   enum {MAX_JOBS = 4096, MAX_LINKS = 8192};
+
+   JobSystem(int numThreads=0);
+   virtual ~JobSystem();
+   JobId createJob(JobFunction function, void *data, int begin=0, int end=1);
+   JobId createMainThreadJob(JobFunction function, void *data, int begin=0, int end=1);
+   void addDependency(JobId job, JobId prerequisite);
+   void submit(JobId job);
+   JobId run(JobFunction function, void *data, int begin=0, int end=1);
+   JobId runOnMainThread(JobFunction function, void *data, int begin=0, int end=1);
+   bool isFinished(JobId job);
+   void wait(JobId job);
+   JobId parallelForAsync(JobFunction function, void *data, int count, int grainSize, JobId prerequisite=JobId());
+   void parallelFor(JobFunction function, void *data, int count, int grainSize);
+   int runMainThreadJobs();
+   int getNumThreads() const {return numThreads;};
+   static int getNumProcessors();
+};
+}
+#endif
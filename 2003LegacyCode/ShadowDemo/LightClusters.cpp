@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "LightClusters.h"
+#include "JobSystem.h"
+#include "Frustum.h"
+
+#ifdef SML_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+using std::vector;
+using std::pair;
+
+namespace SML_CORE
+{
+// the fewest lights worth giving to a thread, the slices are given out one
+// at a time
+static const int BOUND_GRAIN_SIZE = 64;
+static const int SLICE_GRAIN_SIZE = 1;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor, every cluster starts empty
+  */
+LightClusters::LightClusters() :
+lightX(0),
+lightY(0),
+lightZ(0),
+lightRadii(0),
+numLights(0),
+nearDepth(1.0),
+farDepth(2.0),
+sliceScale(1.0),
+tangentX(1.0),
+tangentY(1.0),
+clusterCounts(NUM_CLUSTERS, 0),
+clusterOffsets(NUM_CLUSTERS, 0),
+lightsInView(0),
+clustersUsed(0),
+mostClusterLights(0),
+lightsLeftOut(0)
+{
+   for (int index = 0; index < 16; index++)
+      viewMatrix[index] = index % 5 == 0 ? 1.0 : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+LightClusters::~LightClusters()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Sort the lights into the clusters of a view.  The lights are read from
+   the arrays while the clusters are built, they must not change until
+   findSignificantLights is done with them.
+
+  @param view The camera's view matrix
+  @param projection The camera's perspective projection matrix
+  @param x The x of each light's position
+  @param y The y of each light's position
+  @param z The z of each light's position
+  @param radii How far each light reaches
+  @param count The lights
+  @param jobs The threads to build the clusters on, 0 to build them on this one
+  */
+void LightClusters::build(const float *view, const float *projection, const float *x, const float *y,
+                          const float *z, const float *radii, int count, JobSystem *jobs)
+{
+   lightX = x;
+   lightY = y;
+   lightZ = z;
+   lightRadii = radii;
+   numLights = count;
+   memcpy(viewMatrix, view, 16 * sizeof(float));
+
+   // the near and far planes and the size of the view at a depth of one
+   // come out of the projection
+   nearDepth = projection[14] / (projection[10] - 1.0);
+   farDepth = projection[14] / (projection[10] + 1.0);
+   sliceScale = CLUSTERS_Z / (float)log(farDepth / nearDepth);
+   tangentX = 1.0 / projection[0];
+   tangentY = 1.0 / projection[5];
+
+   // each light's range of clusters, then each slice's clusters
+   viewX.resize(count);
+   viewY.resize(count);
+   viewDepth.resize(count);
+   tileBounds.resize(count * 4);
+   lightRanges.resize(count * 6);
+   if (jobs)
+      jobs->parallelFor(boundLightsJob, this, count, BOUND_GRAIN_SIZE);
+   else
+      boundLightsJob(this, 0, count);
+
+   clusterCounts.assign(NUM_CLUSTERS, 0);
+   clusterLights.resize(NUM_CLUSTERS * MAX_CLUSTER_LIGHTS);
+   if (jobs)
+      jobs->parallelFor(fillSlicesJob, this, CLUSTERS_Z, SLICE_GRAIN_SIZE);
+   else
+      fillSlicesJob(this, 0, CLUSTERS_Z);
+
+   // pack the lists one after another, a full cluster counted the lights
+   // it had no room for
+   int offset = 0;
+   clustersUsed = 0;
+   mostClusterLights = 0;
+   lightsLeftOut = 0;
+   int cluster;
+   for (cluster = 0; cluster < NUM_CLUSTERS; cluster++)
+   {
+      int lights = clusterCounts[cluster];
+      if (lights > MAX_CLUSTER_LIGHTS)
+      {
+         lightsLeftOut += lights - MAX_CLUSTER_LIGHTS;
+         lights = MAX_CLUSTER_LIGHTS;
+         clusterCounts[cluster] = lights;
+      }
+      clusterOffsets[cluster] = offset;
+      offset += lights;
+      if (lights > 0)
+         clustersUsed++;
+      if (lights > mostClusterLights)
+         mostClusterLights = lights;
+   }
+   lightIndices.resize(offset);
+   for (cluster = 0; cluster < NUM_CLUSTERS; cluster++)
+   {
+      if (clusterCounts[cluster] > 0)
+         memcpy(&lightIndices[clusterOffsets[cluster]], &clusterLights[cluster * MAX_CLUSTER_LIGHTS],
+            clusterCounts[cluster] * sizeof(int));
+   }
+
+   lightsInView = 0;
+   for (int light = 0; light < count; light++)
+   {
+      if (lightRanges[light * 6 + 4] <= lightRanges[light * 6 + 5])
+         lightsInView++;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Take a range of lights into the view's space and find the tiles their
+   spheres cover, as fractions of tiles.  A sphere's bounds on the screen
+   are found from the box around it: the widest it can be is at the nearest
+   or furthest depth of the box (no nearer than the near plane).
+
+  @param begin The first light
+  @param end One past the last light
+  */
+void LightClusters::boundLights(int begin, int end)
+{
+   if (begin >= end)
+      return;
+   const float *m = viewMatrix;
+   float halfX = 0.5 * CLUSTERS_X;
+   float halfY = 0.5 * CLUSTERS_Y;
+   float *lowX = &tileBounds[0];
+   float *highX = lowX + numLights;
+   float *lowY = highX + numLights;
+   float *highY = lowY + numLights;
+   int index = begin;
+
+#ifdef SML_SIMD_SSE
+   __m128 nearest = _mm_set1_ps(nearDepth);
+   __m128 scaleX = _mm_set1_ps(tangentX);
+   __m128 scaleY = _mm_set1_ps(tangentY);
+   __m128 tileX = _mm_set1_ps(halfX);
+   __m128 tileY = _mm_set1_ps(halfY);
+   for (; index + 4 <= end; index += 4)
+   {
+      __m128 x = _mm_loadu_ps(lightX + index);
+      __m128 y = _mm_loadu_ps(lightY + index);
+      __m128 z = _mm_loadu_ps(lightZ + index);
+      __m128 radius = _mm_loadu_ps(lightRadii + index);
+      __m128 eyeX = _mm_add_ps(
+         _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m[0])), _mm_mul_ps(y, _mm_set1_ps(m[4]))),
+         _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m[8])), _mm_set1_ps(m[12])));
+      __m128 eyeY = _mm_add_ps(
+         _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m[1])), _mm_mul_ps(y, _mm_set1_ps(m[5]))),
+         _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m[9])), _mm_set1_ps(m[13])));
+      __m128 depth = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(
+         _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m[2])), _mm_mul_ps(y, _mm_set1_ps(m[6]))),
+         _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m[10])), _mm_set1_ps(m[14]))));
+      _mm_storeu_ps(&viewX[index], eyeX);
+      _mm_storeu_ps(&viewY[index], eyeY);
+      _mm_storeu_ps(&viewDepth[index], depth);
+
+      __m128 closest = _mm_max_ps(_mm_sub_ps(depth, radius), nearest);
+      __m128 furthest = _mm_max_ps(_mm_add_ps(depth, radius), nearest);
+      __m128 closestX = _mm_div_ps(tileX, _mm_mul_ps(closest, scaleX));
+      __m128 furthestX = _mm_div_ps(tileX, _mm_mul_ps(furthest, scaleX));
+      __m128 closestY = _mm_div_ps(tileY, _mm_mul_ps(closest, scaleY));
+      __m128 furthestY = _mm_div_ps(tileY, _mm_mul_ps(furthest, scaleY));
+      __m128 left = _mm_sub_ps(eyeX, radius);
+      __m128 right = _mm_add_ps(eyeX, radius);
+      __m128 bottom = _mm_sub_ps(eyeY, radius);
+      __m128 top = _mm_add_ps(eyeY, radius);
+      _mm_storeu_ps(lowX + index, _mm_add_ps(tileX,
+         _mm_min_ps(_mm_mul_ps(left, closestX), _mm_mul_ps(left, furthestX))));
+      _mm_storeu_ps(highX + index, _mm_add_ps(tileX,
+         _mm_max_ps(_mm_mul_ps(right, closestX), _mm_mul_ps(right, furthestX))));
+      _mm_storeu_ps(lowY + index, _mm_add_ps(tileY,
+         _mm_min_ps(_mm_mul_ps(bottom, closestY), _mm_mul_ps(bottom, furthestY))));
+      _mm_storeu_ps(highY + index, _mm_add_ps(tileY,
+         _mm_max_ps(_mm_mul_ps(top, closestY), _mm_mul_ps(top, furthestY))));
+   }
+#endif
+
+   // whatever is left over (or everything without SSE)
+   for (; index < end; index++)
+   {
+      float x = lightX[index];
+      float y = lightY[index];
+      float z = lightZ[index];
+      float radius = lightRadii[index];
+      float eyeX = x * m[0] + y * m[4] + z * m[8] + m[12];
+      float eyeY = x * m[1] + y * m[5] + z * m[9] + m[13];
+      float depth = -(x * m[2] + y * m[6] + z * m[10] + m[14]);
+      viewX[index] = eyeX;
+      viewY[index] = eyeY;
+      viewDepth[index] = depth;
+
+      float closest = depth - radius > nearDepth ? depth - radius : nearDepth;
+      float furthest = depth + radius > nearDepth ? depth + radius : nearDepth;
+      float closestX = halfX / (closest * tangentX);
+      float furthestX = halfX / (furthest * tangentX);
+      float closestY = halfY / (closest * tangentY);
+      float furthestY = halfY / (furthest * tangentY);
+      float left[2] = {(eyeX - radius) * closestX, (eyeX - radius) * furthestX};
+      float right[2] = {(eyeX + radius) * closestX, (eyeX + radius) * furthestX};
+      float bottom[2] = {(eyeY - radius) * closestY, (eyeY - radius) * furthestY};
+      float top[2] = {(eyeY + radius) * closestY, (eyeY + radius) * furthestY};
+      lowX[index] = halfX + (left[0] < left[1] ? left[0] : left[1]);
+      highX[index] = halfX + (right[0] > right[1] ? right[0] : right[1]);
+      lowY[index] = halfY + (bottom[0] < bottom[1] ? bottom[0] : bottom[1]);
+      highY[index] = halfY + (top[0] > top[1] ? top[0] : top[1]);
+   }
+
+   for (index = begin; index < end; index++)
+      findLightRanges(index);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn a light's bounds into the first and last cluster it reaches across,
+   up and into the view.  A light out of the view gets a first slice past
+   its last.
+
+  @param light The light
+  */
+void LightClusters::findLightRanges(int light)
+{
+   int *range = &lightRanges[light * 6];
+   float depth = viewDepth[light];
+   float radius = lightRadii[light];
+   float lowX = tileBounds[light];
+   float highX = tileBounds[numLights + light];
+   float lowY = tileBounds[numLights * 2 + light];
+   float highY = tileBounds[numLights * 3 + light];
+   if (depth + radius < nearDepth || depth - radius > farDepth ||
+       highX < 0.0 || lowX >= CLUSTERS_X || highY < 0.0 || lowY >= CLUSTERS_Y)
+   {
+      range[4] = 1;
+      range[5] = 0;
+      return;
+   }
+
+   range[0] = lowX < 0.0 ? 0 : (int)lowX;
+   range[1] = highX >= CLUSTERS_X ? CLUSTERS_X - 1 : (int)highX;
+   range[2] = lowY < 0.0 ? 0 : (int)lowY;
+   range[3] = highY >= CLUSTERS_Y ? CLUSTERS_Y - 1 : (int)highY;
+   range[4] = findSlice(depth - radius);
+   range[5] = findSlice(depth + radius);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the slice a depth falls in, depths outside the view are put in the
+   first or last slice
+
+  @param depth The distance in front of the camera
+  @return The slice
+  */
+int LightClusters::findSlice(float depth) const
+{
+   if (depth <= nearDepth)
+      return 0;
+   int slice = (int)(log(depth / nearDepth) * sliceScale);
+   return slice < CLUSTERS_Z ? slice : CLUSTERS_Z - 1;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Fill the clusters of a range of slices with the lights that reach them,
+   in the order of the lights.  No other thread touches these clusters.
+
+  @param begin The first slice
+  @param end One past the last slice
+  */
+void LightClusters::fillSlices(int begin, int end)
+{
+   for (int slice = begin; slice < end; slice++)
+   {
+      for (int light = 0; light < numLights; light++)
+      {
+         const int *range = &lightRanges[light * 6];
+         if (slice < range[4] || slice > range[5])
+            continue;
+         for (int row = range[2]; row <= range[3]; row++)
+         {
+            int cluster = (slice * CLUSTERS_Y + row) * CLUSTERS_X + range[0];
+            for (int column = range[0]; column <= range[1]; column++, cluster++)
+            {
+               int &count = clusterCounts[cluster];
+               if (count < MAX_CLUSTER_LIGHTS)
+                  clusterLights[cluster * MAX_CLUSTER_LIGHTS + count] = light;
+               count++;
+            }
+         }
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The job that bounds a range of lights
+
+  @param data The LightClusters
+  @param begin The first light
+  @param end One past the last light
+  */
+void LightClusters::boundLightsJob(void *data, int begin, int end)
+{
+   ((LightClusters*)data)->boundLights(begin, end);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The job that fills a range of slices
+
+  @param data The LightClusters
+  @param begin The first slice
+  @param end One past the last slice
+  */
+void LightClusters::fillSlicesJob(void *data, int begin, int end)
+{
+   ((LightClusters*)data)->fillSlices(begin, end);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Order the lights, the most significant first (the lower index first
+   when they are as significant)
+  */
+bool LightClusters::isMoreSignificant(const pair<float, int> &first, const pair<float, int> &second)
+{
+   if (first.first != second.first)
+      return first.first > second.first;
+   return first.second < second.second;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the lights that are among the most significant in some cluster,
+   the most significant first.  A light's significance at a cluster is its
+   intensity, falling off with the square of the distance from the light
+   to the cluster's center past the light's reach.  Only the clusters built
+   last are looked at.
+
+  @param perCluster How many of the most significant lights to take from
+                    each cluster
+  @param intensities The brightness of each light
+  @param lights Filled with the lights, each light only once
+  */
+void LightClusters::findSignificantLights(int perCluster, const float *intensities, vector<int> &lights)
+{
+   lights.clear();
+   if (perCluster < 1 || numLights == 0)
+      return;
+   if (perCluster > MAX_CLUSTER_LIGHTS)
+      perCluster = MAX_CLUSTER_LIGHTS;
+
+   significance.assign(numLights, 0.0);
+   float bestScores[MAX_CLUSTER_LIGHTS];
+   int bestLights[MAX_CLUSTER_LIGHTS];
+   int cluster = 0;
+   for (int slice = 0; slice < CLUSTERS_Z; slice++)
+   {
+      float depth = nearDepth * (float)exp((slice + 0.5) / sliceScale);
+      for (int row = 0; row < CLUSTERS_Y; row++)
+      {
+         float centerY = ((row + 0.5) * 2.0 / CLUSTERS_Y - 1.0) * depth * tangentY;
+         for (int column = 0; column < CLUSTERS_X; column++, cluster++)
+         {
+            int count = clusterCounts[cluster];
+            if (count == 0)
+               continue;
+            float centerX = ((column + 0.5) * 2.0 / CLUSTERS_X - 1.0) * depth * tangentX;
+
+            // keep the best few in order, the rest fall off the end
+            int numBest = 0;
+            const int *clusterList = &lightIndices[clusterOffsets[cluster]];
+            for (int index = 0; index < count; index++)
+            {
+               int light = clusterList[index];
+               float offsetX = viewX[light] - centerX;
+               float offsetY = viewY[light] - centerY;
+               float offsetZ = viewDepth[light] - depth;
+               float reach = lightRadii[light] * lightRadii[light];
+               float score = intensities[light] * reach /
+                  (reach + offsetX * offsetX + offsetY * offsetY + offsetZ * offsetZ);
+               int place = numBest < perCluster ? numBest++ : perCluster;
+               while (place > 0 && bestScores[place - 1] < score)
+               {
+                  if (place < perCluster)
+                  {
+                     bestScores[place] = bestScores[place - 1];
+                     bestLights[place] = bestLights[place - 1];
+                  }
+                  place--;
+               }
+               if (place < perCluster)
+               {
+                  bestScores[place] = score;
+                  bestLights[place] = light;
+               }
+            }
+            for (int best = 0; best < numBest; best++)
+            {
+               if (bestScores[best] > significance[bestLights[best]])
+                  significance[bestLights[best]] = bestScores[best];
+            }
+         }
+      }
+   }
+
+   ranked.clear();
+   for (int light = 0; light < numLights; light++)
+   {
+      if (significance[light] > 0.0)
+         ranked.push_back(pair<float, int>(significance[light], light));
+   }
+   std::sort(ranked.begin(), ranked.end(), isMoreSignificant);
+   for (int index = 0; index < ranked.size(); index++)
+      lights.push_back(ranked[index].second);
+}
+}
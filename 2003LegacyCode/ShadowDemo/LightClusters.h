@@ -0,0 +1,96 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <utility>
+
+namespace SML_CORE
+{
+// forward declarations
+class JobSystem;
+
+/**
+  This class sorts the point lights into the clusters of the view frustum,
+  so a point in the view only has to look at the lights that can reach its
+  cluster.  The frustum is cut into CLUSTERS_X by CLUSTERS_Y tiles across
+  the screen and CLUSTERS_Z slices into the view, the slices getting
+  deeper with distance (each is the same share of the log of the depth) so
+  the clusters stay about as deep as they are wide.
+
+  Each frame the lights are taken into the view's space four at a time
+  with SSE (when it is available) and each is given the range of clusters
+  its sphere can touch, on every thread.  Then each slice's clusters are
+  filled on a thread of their own, and the lists are packed one after
+  another: a cluster has an offset and a count into the light indices.
+  Filling a cluster costs the lights that reach it, the lights that can't
+  are passed over by their ranges.
+
+  The lights that matter most in a cluster (the brightest at its center)
+  can be picked out, the scene shadows those and lights the rest without
+  shadows.
+*/
+class LightClusters
+{
+public:
+   /** the clusters across the screen, up it and into the view */
+   enum {CLUSTERS_X = 16, CLUSTERS_Y = 8, CLUSTERS_Z = 24};
+   enum {NUM_CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z};
+   /** the most lights a cluster holds, lights past this are left out */
+   enum {MAX_CLUSTER_LIGHTS = 64};
+
+private:
+   const float *lightX;
+   const float *lightY;
+   const float *lightZ;
+   const float *lightRadii;
+   int numLights;
+   float viewMatrix[16];
+   float nearDepth;
+   float farDepth;
+   float sliceScale;
+   float tangentX;
+   float tangentY;
+   std::vector<float> viewX;
+   std::vector<float> viewY;
+   std::vector<float> viewDepth;
+   std::vector<float> tileBounds;
+   std::vector<int> lightRanges;
+   std::vector<int> clusterLights;
+   std::vector<int> clusterCounts;
+   std::vector<int> clusterOffsets;
+   std::vector<int> lightIndices;
+   std::vector<float> significance;
+   std::vector<std::pair<float, int> > ranked;
+   int lightsInView;
+   int clustersUsed;
+   int mostClusterLights;
+   int lightsLeftOut;
+
+   void boundLights(int begin, int end);
+   void findLightRanges(int light);
+   int findSlice(float depth) const;
+   void fillSlices(int begin, int end);
+   static void boundLightsJob(void *data, int begin, int end);
+   static void fillSlicesJob(void *data, int begin, int end);
+   static bool isMoreSignificant(const std::pair<float, int> &first, const std::pair<float, int> &second);
+
+public:
+   LightClusters();
+   virtual ~LightClusters();
+   void build(const float *view, const float *projection, const float *x, const float *y,
+              const float *z, const float *radii, int count, JobSystem *jobs);
+   void findSignificantLights(int perCluster, const float *intensities, std::vector<int> &lights);
+   int getCount(int cluster) const {return clusterCounts[cluster];};
+   int getOffset(int cluster) const {return clusterOffsets[cluster];};
+   const std::vector<int>& getCounts() const {return clusterCounts;};
+   const std::vector<int>& getOffsets() const {return clusterOffsets;};
+   const std::vector<int>& getLightIndices() const {return lightIndices;};
+   float getNearDepth() const {return nearDepth;};
+   float getSliceScale() const {return sliceScale;};
+   int getLightsInView() const {return lightsInView;};
+   int getClustersUsed() const {return clustersUsed;};
+   int getMostClusterLights() const {return mostClusterLights;};
+   int getLightsLeftOut() const {return lightsLeftOut;};
+};
+}
+#endif
@@ -0,0 +1,115 @@
+#include <string.h>
+#include "LinearArena.h"
+
+namespace SML_CORE
+{
+// every allocation starts on this boundary (enough for SSE data)
+static const int ARENA_ALIGNMENT = 16;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor.  No memory is taken until the first allocation.
+
+  @param size The size of each block of memory
+  */
+LinearArena::LinearArena(int size) :
+blocks(0),
+blockSize(size),
+currentBlock(0),
+offset(0),
+bytesUsed(0),
+highWater(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+LinearArena::~LinearArena()
+{
+   release();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Get a piece of memory from the arena.  It stays valid until the next
+   reset (or release).
+
+  @param size The number of bytes needed
+  @return The memory, aligned to 16 bytes
+  */
+void* LinearArena::allocate(int size)
+{
+   // round up so the next allocation stays aligned
+   size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+   // move on to the next block big enough, making one if there is none
+   while (currentBlock < blocks.size() && offset + size > blocks[currentBlock].size)
+   {
+      currentBlock++;
+      offset = 0;
+   }
+   if (currentBlock == blocks.size())
+   {
+      ArenaBlock block;
+      block.size = size > blockSize ? size : blockSize;
+
+      // over allocate so the start of the block can be aligned
+      block.memory = new char[block.size + ARENA_ALIGNMENT];
+      blocks.push_back(block);
+      offset = 0;
+   }
+
+   char *memory = blocks[currentBlock].memory;
+   char *aligned = memory + ((ARENA_ALIGNMENT - ((size_t)memory & (ARENA_ALIGNMENT - 1))) & (ARENA_ALIGNMENT - 1));
+   void *result = aligned + offset;
+   offset += size;
+   bytesUsed += size;
+   if (bytesUsed > highWater)
+      highWater = bytesUsed;
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Copy a piece of text into the arena as a null terminated string
+
+  @param begin The first character to copy
+  @param end One past the last character to copy
+  @return The copy
+  */
+char* LinearArena::copyString(const char *begin, const char *end)
+{
+   int length = end - begin;
+   char *copy = (char*)allocate(length + 1);
+   memcpy(copy, begin, length);
+   copy[length] = 0;
+   return copy;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Free everything allocated from the arena at once.  The blocks are kept
+   for the next round of allocations.
+  */
+void LinearArena::reset()
+{
+   currentBlock = 0;
+   offset = 0;
+   bytesUsed = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Free everything and give the blocks back to the heap
+  */
+void LinearArena::release()
+{
+   for (int index = 0; index < blocks.size(); index++)
+      delete [] blocks[index].memory;
+   blocks.clear();
+   reset();
+}
+}
@@ -0,0 +1,49 @@
+#ifndef LINEARARENA_H
+#define LINEARARENA_H
+//-----------------------------------------------------------------------------
+#include <vector>
+
+namespace SML_CORE
+{
+/**
+  This class hands out scratch memory that is all freed at once.  Memory
+  comes from large blocks, an allocation just moves an offset forward, and
+  reset() moves the offset back to the start.  The blocks are kept after a
+  reset, so once an arena has grown to the size a frame (or a file load)
+  needs it never goes back to the heap.
+
+  Nothing allocated from an arena has its destructor called, only plain
+  data (floats, chars, structs of them) should live here.
+*/
+class LinearArena
+{
+private:
+   /** A block of memory the arena hands out pieces of */
+   class ArenaBlock
+   {
+   public:
+      char* memory;
+      int size;
+   };
+
+   std::vector<ArenaBlock> blocks;
+   int blockSize;
+   int currentBlock;
+   int offset;
+   int bytesUsed;
+   int highWater;
+
+public:
+   LinearArena(int blockSize=65536);
+   virtual ~LinearArena();
+   void* allocate(int size);
+   float* allocateFloats(int count) {return (float*)allocate(count * sizeof(float));};
+   char* copyString(const char *begin, const char *end);
+   void reset();
+   void release();
+   int getBytesUsed() const {return bytesUsed;};
+   int getHighWater() const {return highWater;};
+   int getNumBlocks() const {return blocks.size();};
+};
+}
+#endif
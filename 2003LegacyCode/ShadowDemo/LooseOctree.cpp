@@ -0,0 +1,561 @@
+#include <math.h>
+#include "LooseOctree.h"
+
+using std::vector;
+
+namespace SML_CORE
+{
+// the node index used for objects that live outside the tree
+static const int OVERFLOW_NODE = -1;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+
+  @param center The center of the root cell
+  @param halfSize Half the width of the root cell
+  @param maxDepth The deepest level nodes are created at
+  */
+LooseOctree::LooseOctree(Vector3D center, float halfSize, int maxDepth) :
+nodes(0),
+objects(0)
+{
+   reset(center, halfSize, maxDepth);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+LooseOctree::~LooseOctree()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Empty the tree and change its bounds.  All object ids become invalid.
+
+  @param center The center of the root cell
+  @param halfSize Half the width of the root cell
+  @param depth The deepest level nodes are created at
+  */
+void LooseOctree::reset(Vector3D center, float halfSize, int depth)
+{
+   nodes.clear();
+   objects.clear();
+   overflowObjects = ObjectList();
+   firstFreeObject = INVALID_ID;
+   numObjects = 0;
+   maxDepth = depth;
+   lastTestCount = 0;
+   createNode(center.x, center.y, center.z, halfSize, 0, -1);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a node to the tree
+
+  @return The index of the new node
+  */
+int LooseOctree::createNode(float x, float y, float z, float halfSize, int depth, int parent)
+{
+   OctreeNode node;
+   node.centerX = x;
+   node.centerY = y;
+   node.centerZ = z;
+   node.halfSize = halfSize;
+   node.depth = depth;
+   node.parent = parent;
+   for (int child = 0; child < 8; child++)
+      node.children[child] = -1;
+   node.subtreeCount = 0;
+   node.split = false;
+   nodes.push_back(node);
+   return nodes.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find (creating it if needed) the deepest node that can hold a sphere.
+   Going down stops at a node that hasn't been split or when the child
+   cells are smaller than the radius.
+
+  @return The node index, or OVERFLOW_NODE if the sphere doesn't fit the root
+  */
+int LooseOctree::findNode(float x, float y, float z, float radius)
+{
+   if (!fitsInNode(0, x, y, z, radius))
+      return OVERFLOW_NODE;
+
+   int node = 0;
+   while (nodes[node].split)
+   {
+      float childHalfSize = nodes[node].halfSize * 0.5f;
+      if (radius > childHalfSize)
+         break;
+
+      int octant = 0;
+      if (x >= nodes[node].centerX) octant |= 1;
+      if (y >= nodes[node].centerY) octant |= 2;
+      if (z >= nodes[node].centerZ) octant |= 4;
+
+      int child = nodes[node].children[octant];
+      if (child == -1)
+      {
+         // careful, creating the node can move the node list
+         child = createNode(
+            nodes[node].centerX + ((octant & 1) ? childHalfSize : -childHalfSize),
+            nodes[node].centerY + ((octant & 2) ? childHalfSize : -childHalfSize),
+            nodes[node].centerZ + ((octant & 4) ? childHalfSize : -childHalfSize),
+            childHalfSize, nodes[node].depth + 1, node);
+         nodes[node].children[octant] = child;
+      }
+      node = child;
+   }
+   return node;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Put an object in the deepest node that can hold it, and split the node
+   if that leaves it holding too many
+  */
+void LooseOctree::placeObject(int id)
+{
+   const OctreeObject &anObject = objects[id];
+   int node = findNode(anObject.x, anObject.y, anObject.z, anObject.radius);
+   linkObject(id, node);
+   if (node != OVERFLOW_NODE && !nodes[node].split && nodes[node].depth < maxDepth &&
+       nodes[node].objects.ids.size() > SPLIT_COUNT)
+      splitNode(node);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Split a node: the objects that fit in a child cell are moved down into
+   it (the children can split in turn), the rest stay
+  */
+void LooseOctree::splitNode(int node)
+{
+   nodes[node].split = true;
+   vector<int> ids(nodes[node].objects.ids);
+   for (int index = 0; index < ids.size(); index++)
+   {
+      const OctreeObject &anObject = objects[ids[index]];
+      if (findNode(anObject.x, anObject.y, anObject.z, anObject.radius) == node)
+         continue;
+      unlinkObject(ids[index]);
+      placeObject(ids[index]);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   A sphere fits in a node when its center is in the node's cell and its
+   radius is no bigger than the cell's half size, which keeps it inside the
+   loose (doubled) bounds of the node.
+  */
+bool LooseOctree::fitsInNode(int node, float x, float y, float z, float radius)
+{
+   const OctreeNode &aNode = nodes[node];
+   return radius <= aNode.halfSize &&
+          fabs(x - aNode.centerX) <= aNode.halfSize &&
+          fabs(y - aNode.centerY) <= aNode.halfSize &&
+          fabs(z - aNode.centerZ) <= aNode.halfSize;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Return the list of objects held by a node (or the overflow list)
+  */
+LooseOctree::ObjectList& LooseOctree::getObjectList(int node)
+{
+   if (node == OVERFLOW_NODE)
+      return overflowObjects;
+   return nodes[node].objects;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Put an object in a node and count it in all the nodes above
+  */
+void LooseOctree::linkObject(int id, int node)
+{
+   ObjectList &list = getObjectList(node);
+   const OctreeObject &anObject = objects[id];
+   objects[id].node = node;
+   objects[id].slot = list.ids.size();
+   list.ids.push_back(id);
+   list.models.push_back(anObject.model);
+   list.flags.push_back(anObject.flags);
+   list.x.push_back(anObject.x);
+   list.y.push_back(anObject.y);
+   list.z.push_back(anObject.z);
+   list.radius.push_back(anObject.radius);
+
+   for (int parent = node; parent != -1; parent = nodes[parent].parent)
+      nodes[parent].subtreeCount++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Take an object out of its node.  The last object of the node takes its
+   slot so the removal doesn't shift the list.
+  */
+void LooseOctree::unlinkObject(int id)
+{
+   int node = objects[id].node;
+   ObjectList &list = getObjectList(node);
+   int slot = objects[id].slot;
+   int lastId = list.ids.back();
+   list.ids[slot] = lastId;
+   list.models[slot] = list.models.back();
+   list.flags[slot] = list.flags.back();
+   list.x[slot] = list.x.back();
+   list.y[slot] = list.y.back();
+   list.z[slot] = list.z.back();
+   list.radius[slot] = list.radius.back();
+   objects[lastId].slot = slot;
+   list.ids.pop_back();
+   list.models.pop_back();
+   list.flags.pop_back();
+   list.x.pop_back();
+   list.y.pop_back();
+   list.z.pop_back();
+   list.radius.pop_back();
+
+   for (int parent = node; parent != -1; parent = nodes[parent].parent)
+      nodes[parent].subtreeCount--;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add an object to the tree
+
+  @param model The payload returned by the queries
+  @param flags Query mask bits for this object
+  @param x The x component of the bounding sphere center
+  @param y The y component of the bounding sphere center
+  @param z The z component of the bounding sphere center
+  @param radius The bounding sphere radius
+  @return The id used to update and remove the object
+  */
+int LooseOctree::insert(Model3D *model, unsigned int flags, float x, float y, float z, float radius)
+{
+   int id;
+   if (firstFreeObject != INVALID_ID)
+   {
+      id = firstFreeObject;
+      firstFreeObject = objects[id].nextFree;
+   }
+   else
+   {
+      id = objects.size();
+      objects.push_back(OctreeObject());
+   }
+
+   OctreeObject &anObject = objects[id];
+   anObject.model = model;
+   anObject.flags = flags;
+   anObject.x = x;
+   anObject.y = y;
+   anObject.z = z;
+   anObject.radius = radius;
+   anObject.nextFree = INVALID_ID;
+   placeObject(id);
+   numObjects++;
+   return id;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Move an object.  The object only changes nodes when it has left the
+   loose bounds of its current node.
+
+  @param id The id returned by insert
+  */
+void LooseOctree::update(int id, float x, float y, float z, float radius)
+{
+   OctreeObject &anObject = objects[id];
+   anObject.x = x;
+   anObject.y = y;
+   anObject.z = z;
+   anObject.radius = radius;
+
+   int node = anObject.node;
+   if (node != OVERFLOW_NODE && fitsInNode(node, x, y, z, radius))
+   {
+      ObjectList &list = nodes[node].objects;
+      int slot = anObject.slot;
+      list.x[slot] = x;
+      list.y[slot] = y;
+      list.z[slot] = z;
+      list.radius[slot] = radius;
+      return;
+   }
+
+   // the overflow list's copy of the sphere is brought up to date by
+   // relinking it, even when it stays there
+   unlinkObject(id);
+   placeObject(id);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Take an object out of the tree, its id may be handed out again
+
+  @param id The id returned by insert
+  */
+void LooseOctree::remove(int id)
+{
+   unlinkObject(id);
+   objects[id].model = 0;
+   objects[id].nextFree = firstFreeObject;
+   firstFreeObject = id;
+   numObjects--;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the objects whose bounding spheres may be inside a frustum.  Nodes
+   whose loose bounds are completely inside add all their objects without
+   testing them.
+
+  @param frustum The volume to search
+  @param mask Only objects with one of these flags are returned
+  @param results The objects found are added to this list
+  */
+void LooseOctree::queryFrustum(const Frustum &frustum, unsigned int mask, vector<Model3D*> &results)
+{
+   lastTestCount = 0;
+   cullObjectList(overflowObjects, frustum, mask, results);
+   queryFrustumNode(0, frustum, mask, false, results);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Search a node and its children for objects inside a frustum
+  */
+void LooseOctree::queryFrustumNode(int node, const Frustum &frustum, unsigned int mask, bool fullyInside, vector<Model3D*> &results)
+{
+   const OctreeNode &aNode = nodes[node];
+   if (aNode.subtreeCount == 0)
+      return;
+
+   if (!fullyInside)
+   {
+      float looseSize = aNode.halfSize * 2.0f;
+      int classification = frustum.classifyBox(
+         aNode.centerX - looseSize, aNode.centerY - looseSize, aNode.centerZ - looseSize,
+         aNode.centerX + looseSize, aNode.centerY + looseSize, aNode.centerZ + looseSize);
+      if (classification == Frustum::OUTSIDE)
+         return;
+      fullyInside = (classification == Frustum::INSIDE);
+   }
+
+   if (fullyInside)
+      addObjectList(aNode.objects, mask, results);
+   else
+      cullObjectList(aNode.objects, frustum, mask, results);
+
+   for (int child = 0; child < 8; child++)
+   {
+      if (aNode.children[child] != -1)
+         queryFrustumNode(aNode.children[child], frustum, mask, fullyInside, results);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test the objects of a list against a frustum in one batch, straight from
+   the list's spheres.  Objects outside the mask are tested too, it costs
+   less than packing the rest.
+  */
+void LooseOctree::cullObjectList(const ObjectList &list, const Frustum &frustum, unsigned int mask, vector<Model3D*> &results)
+{
+   int count = list.ids.size();
+   if (count == 0)
+      return;
+   if (scratchResults.size() < count)
+      scratchResults.resize(count);
+
+   frustum.cullSpheres(&list.x[0], &list.y[0], &list.z[0], &list.radius[0], count, &scratchResults[0]);
+   lastTestCount += count;
+   for (int index = 0; index < count; index++)
+   {
+      if (scratchResults[index] && (list.flags[index] & mask))
+         results.push_back(list.models[index]);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add all the objects of a list that match the mask
+  */
+void LooseOctree::addObjectList(const ObjectList &list, unsigned int mask, vector<Model3D*> &results)
+{
+   for (int index = 0; index < list.ids.size(); index++)
+   {
+      if (list.flags[index] & mask)
+         results.push_back(list.models[index]);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the objects whose bounding spheres overlap a sphere
+
+  @param center The center of the search sphere
+  @param radius The radius of the search sphere
+  @param mask Only objects with one of these flags are returned
+  @param results The objects found are added to this list
+  */
+void LooseOctree::querySphere(Vector3D center, float radius, unsigned int mask, vector<Model3D*> &results)
+{
+   lastTestCount = 0;
+   testSphereList(overflowObjects, center.x, center.y, center.z, radius, mask, results);
+   querySphereNode(0, center.x, center.y, center.z, radius, mask, results);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Search a node and its children for objects overlapping a sphere
+  */
+void LooseOctree::querySphereNode(int node, float x, float y, float z, float radius, unsigned int mask, vector<Model3D*> &results)
+{
+   const OctreeNode &aNode = nodes[node];
+   if (aNode.subtreeCount == 0)
+      return;
+
+   // distance from the sphere to the loose box
+   float looseSize = aNode.halfSize * 2.0f;
+   float dx = (float)fabs(x - aNode.centerX) - looseSize;
+   float dy = (float)fabs(y - aNode.centerY) - looseSize;
+   float dz = (float)fabs(z - aNode.centerZ) - looseSize;
+   float distanceSquared = 0;
+   if (dx > 0) distanceSquared += dx*dx;
+   if (dy > 0) distanceSquared += dy*dy;
+   if (dz > 0) distanceSquared += dz*dz;
+   if (distanceSquared > radius*radius)
+      return;
+
+   testSphereList(aNode.objects, x, y, z, radius, mask, results);
+   for (int child = 0; child < 8; child++)
+   {
+      if (aNode.children[child] != -1)
+         querySphereNode(aNode.children[child], x, y, z, radius, mask, results);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test the objects of a list against a sphere
+  */
+void LooseOctree::testSphereList(const ObjectList &list, float x, float y, float z, float radius, unsigned int mask, vector<Model3D*> &results)
+{
+   for (int index = 0; index < list.ids.size(); index++)
+   {
+      const OctreeObject &anObject = objects[list.ids[index]];
+      if (!(anObject.flags & mask))
+         continue;
+      lastTestCount++;
+      float dx = anObject.x - x;
+      float dy = anObject.y - y;
+      float dz = anObject.z - z;
+      float reach = anObject.radius + radius;
+      if (dx*dx + dy*dy + dz*dz <= reach*reach)
+         results.push_back(anObject.model);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the objects whose bounding spheres are hit by a ray (in no
+   particular order)
+
+  @param origin Where the ray starts
+  @param direction The (unit length) direction of the ray
+  @param maxDistance How far along the ray to search
+  @param mask Only objects with one of these flags are returned
+  @param results The objects found are added to this list
+  */
+void LooseOctree::queryRay(Vector3D origin, Vector3D direction, float maxDistance, unsigned int mask, vector<Model3D*> &results)
+{
+   lastTestCount = 0;
+   testRayList(overflowObjects, origin, direction, maxDistance, mask, results);
+   queryRayNode(0, origin, direction, maxDistance, mask, results);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Search a node and its children for objects hit by a ray.  The loose box
+   of the node is tested with the slab method first.
+  */
+void LooseOctree::queryRayNode(int node, const Vector3D &origin, const Vector3D &direction, float maxDistance, unsigned int mask, vector<Model3D*> &results)
+{
+   const OctreeNode &aNode = nodes[node];
+   if (aNode.subtreeCount == 0)
+      return;
+
+   float looseSize = aNode.halfSize * 2.0f;
+   float boxMin[3] = {aNode.centerX - looseSize, aNode.centerY - looseSize, aNode.centerZ - looseSize};
+   float boxMax[3] = {aNode.centerX + looseSize, aNode.centerY + looseSize, aNode.centerZ + looseSize};
+   float rayOrigin[3] = {origin.x, origin.y, origin.z};
+   float rayDirection[3] = {direction.x, direction.y, direction.z};
+   float nearest = 0;
+   float farthest = maxDistance;
+   for (int axis = 0; axis < 3; axis++)
+   {
+      if (fabs(rayDirection[axis]) < 1.0e-8f)
+      {
+         // parallel to this slab, it must start inside it
+         if (rayOrigin[axis] < boxMin[axis] || rayOrigin[axis] > boxMax[axis])
+            return;
+         continue;
+      }
+      float t0 = (boxMin[axis] - rayOrigin[axis]) / rayDirection[axis];
+      float t1 = (boxMax[axis] - rayOrigin[axis]) / rayDirection[axis];
+      if (t0 > t1) {float temp = t0; t0 = t1; t1 = temp;}
+      if (t0 > nearest) nearest = t0;
+      if (t1 < farthest) farthest = t1;
+      if (nearest > farthest)
+         return;
+   }
+
+   testRayList(aNode.objects, origin, direction, maxDistance, mask, results);
+   for (int child = 0; child < 8; child++)
+   {
+      if (aNode.children[child] != -1)
+         queryRayNode(aNode.children[child], origin, direction, maxDistance, mask, results);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test the objects of a list against a ray
+  */
+void LooseOctree::testRayList(const ObjectList &list, const Vector3D &origin, const Vector3D &direction, float maxDistance, unsigned int mask, vector<Model3D*> &results)
+{
+   for (int index = 0; index < list.ids.size(); index++)
+   {
+      const OctreeObject &anObject = objects[list.ids[index]];
+      if (!(anObject.flags & mask))
+         continue;
+      lastTestCount++;
+
+      // closest approach of the ray to the sphere center
+      float toX = anObject.x - origin.x;
+      float toY = anObject.y - origin.y;
+      float toZ = anObject.z - origin.z;
+      float along = toX*direction.x + toY*direction.y + toZ*direction.z;
+      if (along < 0) along = 0;
+      if (along > maxDistance) along = maxDistance;
+      float dx = toX - direction.x*along;
+      float dy = toY - direction.y*along;
+      float dz = toZ - direction.z*along;
+      if (dx*dx + dy*dy + dz*dz <= anObject.radius*anObject.radius)
+         results.push_back(anObject.model);
+   }
+}
+}
@@ -0,0 +1,124 @@
+#ifndef LOOSEOCTREE_H
+#define LOOSEOCTREE_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "Vector3D.h"
+#include "Frustum.h"
+
+namespace SML_CORE
+{
+// forward declarations
+class Model3D;
+
+/**
+  This class is a loose octree spatial index for the models in a scene.
+  Each node's bounds are loosened to twice the size of its cell, so an
+  object is stored in the deepest node whose cell holds its center and whose
+  half size is at least the object's radius.  Moving objects only need to be
+  relinked when they leave the loose bounds of their node, so most updates
+  just store the new bounding sphere.
+
+  A node holds its objects until it has more than SPLIT_COUNT, then it is
+  split and the objects that fit a child are moved down into it.  Nodes
+  are only created as they are split into and each keeps a count of the
+  objects below it so empty branches are skipped by the queries.  A small
+  crowd stays in the root, where a query tests it in one batch.  Objects
+  outside the root bounds (or too big for it) are kept in an overflow list
+  that every query tests.
+
+  Each node keeps its objects' bounding spheres side by side (an array of
+  centers for each axis and one of radii) along with their payloads and
+  flags, so a frustum query tests a node's list in one batch and collects
+  the results straight from the node.
+
+  Objects carry flags (bit masks), queries only return objects whose flags
+  share a bit with the query mask.
+*/
+class LooseOctree
+{
+private:
+   /** The objects of a node (or the overflow list) and their bounding
+       spheres, an object's slot is its place in each array */
+   class ObjectList
+   {
+   public:
+      std::vector<int> ids;
+      std::vector<Model3D*> models;
+      std::vector<unsigned int> flags;
+      std::vector<float> x;
+      std::vector<float> y;
+      std::vector<float> z;
+      std::vector<float> radius;
+   };
+
+   /** A node of the tree, a cube centered on (centerX,centerY,centerZ) */
+   class OctreeNode
+   {
+   public:
+      float centerX, centerY, centerZ;
+      float halfSize;
+      int depth;
+      int parent;
+      int children[8];
+      int subtreeCount;
+      bool split;
+      ObjectList objects;
+   };
+
+   /** An object stored in the tree (a bounding sphere and a payload) */
+   class OctreeObject
+   {
+   public:
+      Model3D* model;
+      unsigned int flags;
+      float x, y, z, radius;
+      int node;
+      int slot;
+      int nextFree;
+   };
+
+   std::vector<OctreeNode> nodes;
+   std::vector<OctreeObject> objects;
+   ObjectList overflowObjects;
+   int firstFreeObject;
+   int numObjects;
+   int maxDepth;
+   int lastTestCount;
+   std::vector<unsigned char> scratchResults;
+
+   int createNode(float x, float y, float z, float halfSize, int depth, int parent);
+   int findNode(float x, float y, float z, float radius);
+   void placeObject(int id);
+   void splitNode(int node);
+   bool fitsInNode(int node, float x, float y, float z, float radius);
+   void linkObject(int id, int node);
+   void unlinkObject(int id);
+   ObjectList& getObjectList(int node);
+   void queryFrustumNode(int node, const Frustum &frustum, unsigned int mask, bool fullyInside, std::vector<Model3D*> &results);
+   void cullObjectList(const ObjectList &list, const Frustum &frustum, unsigned int mask, std::vector<Model3D*> &results);
+   void addObjectList(const ObjectList &list, unsigned int mask, std::vector<Model3D*> &results);
+   void querySphereNode(int node, float x, float y, float z, float radius, unsigned int mask, std::vector<Model3D*> &results);
+   void testSphereList(const ObjectList &list, float x, float y, float z, float radius, unsigned int mask, std::vector<Model3D*> &results);
+   void queryRayNode(int node, const Vector3D &origin, const Vector3D &direction, float maxDistance, unsigned int mask, std::vector<Model3D*> &results);
+   void testRayList(const ObjectList &list, const Vector3D &origin, const Vector3D &direction, float maxDistance, unsigned int mask, std::vector<Model3D*> &results);
+
+public:
+   /** returned when an object can't be found */
+   enum {INVALID_ID = -1};
+   /** the most objects a node holds before it is split */
+   enum {SPLIT_COUNT = 256};
+
+   LooseOctree(Vector3D center=Vector3D(0,0,0), float halfSize=1024.0, int maxDepth=8);
+   virtual ~LooseOctree();
+   void reset(Vector3D center, float halfSize, int maxDepth);
+   int insert(Model3D *model, unsigned int flags, float x, float y, float z, float radius);
+   void update(int id, float x, float y, float z, float radius);
+   void remove(int id);
+   int getNumObjects() const {return numObjects;};
+   int getLastTestCount() const {return lastTestCount;};
+   void queryFrustum(const Frustum &frustum, unsigned int mask, std::vector<Model3D*> &results);
+   void querySphere(Vector3D center, float radius, unsigned int mask, std::vector<Model3D*> &results);
+   void queryRay(Vector3D origin, Vector3D direction, float maxDistance, unsigned int mask, std::vector<Model3D*> &results);
+};
+}
+#endif
@@ -1,327 +1,524 @@
-#include <GL/glut.h>
-#include <iostream>
-#include "Model3D.h"
-
-using namespace std;
-
-namespace SML_CORE
-{
-//-----------------------------------------------------------------------------
-/**
-      Constructor
-  */
-Model3D::Model3D(string aName, int callListid, Vector3D position, bool useLight) :
-   textureLoaded(false),   
-   useLighting(useLight), 
-   displayListCreated(false),
-   myName(aName),
-   callListId(callListid),
-   textureIndex(-1),
-   red(1.0), blue(1.0), green(1.0),
-   modelPosition(position),
-   transformMatrix()
-{
-
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Destructor
-  */
-Model3D::~Model3D()
-{
-
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Return a vector of the position
-
-  @return The position of this model in the world
-  */
-Vector3D Model3D::getPosition()
-{
-   return modelPosition;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Return a FTM copy of this model's transform matrix
-
-  @return A copy of the material properties
-  */
-FTM Model3D::getFTM()
-{
-   return transformMatrix;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Return a material copy of this model's material properties
-
-  @return A copy of the material properties
-  */
-Material Model3D::getMaterial()
-{
-   return materialProps;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the position of the model
-
-  @param x X component of new position
-  @param y Y component of new position
-  @param z Z component of new position
-  */
-void Model3D::setPosition(float x, float y, float z)
-{
-   modelPosition.x = x;
-   modelPosition.y = y;
-   modelPosition.z = z;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the position of the model
-
-  @param newPosition The new x,y,z position of the model
-  */
-void Model3D::setPosition(Vector3D newPosition)
-{
-   modelPosition = newPosition;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the color of the model if it's not textured
-
-  @param red Component of color
-  @param green Component of color
-  @param blue Component of color
-  */
-void Model3D::setColor(float redC, float greenC, float blueC)
-{
-   red = redC;
-   green = greenC;
-   blue = blueC;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the material properties of this model
-
-  @param newMaterial The new material properties
-  */
-void Model3D::setMaterial(Material newMaterial)
-{
-   materialProps = newMaterial;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the FTM of this model
-
-  @param newMatrix The new FTM
-  */
-void Model3D::setTransformMatrix(FTM newMatrix)
-{
-   transformMatrix = newMatrix;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the FTM to be used when creating the openGL display list
-
-  @param newMatrix The new initial transform
-  */
-void Model3D::setInitialTransform(FTM newMatrix)
-{
-   initialTransform = newMatrix;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Set the texture id.  This assumes that the texture has been loaded into 
-   memory and has an index created.
-
-  @param id index into the texture array
-  */
-void Model3D::setTexture(int index, unsigned int* textureList)
-{
-   textureLoaded = true;
-   textureIndex = index;
-   textureListPtr = textureList;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   This operation loads the vert and face data into an openGL display list.  It also
-   properly sets the normals for the surface and applys a texture if one has been specified.
-
-  @param listId The id of the display list being created
-  @return true if display list creation successful, false otherwise
-*/
-bool Model3D::createOpenGLDisplayList()
-{   
- 	glNewList(callListId, GL_COMPILE);
-      glPushMatrix();
-		glPushAttrib(GL_ALL_ATTRIB_BITS);
-
-      // apply our local transformation matrix
-      float tempMatrix[] = 
-      { 
-         initialTransform._00,initialTransform._01,initialTransform._02,initialTransform._03,
-         initialTransform._10,initialTransform._11,initialTransform._12,initialTransform._13,
-         initialTransform._20,initialTransform._21,initialTransform._22,initialTransform._23,
-         initialTransform._30,initialTransform._31,initialTransform._32,initialTransform._33,
-      };
-      glMultMatrixf(tempMatrix);
-
-      //KLUDGE - Align the axis here to fit with my hardcoded "Y is up" world
-      /// \todo replace this with a dynamic method of orienting the model to my world.
-      // Assuming 1x-0y-1z model, since thats all I have right now
-      //translate to center the model
-      glTranslatef(0,1.5,-7);
-      // rotate axis
-      glRotatef(-90,0,1,0);
-      glRotatef(-90,1,0,0);
-      // END KLUDGE
-
-      // test to see if normals match up with the verts
-      if (vertsFaceList.size() == normalsFaceList.size())
-      {
-         if (textureLoaded) glEnable(GL_TEXTURE_2D);
-         // Loop through the face list and draw a triangle or a 4 sided polygon
-         // also map the texture coord list to each vertex
-         for (int faceIndex=0; faceIndex<vertsFaceList.size(); faceIndex++)
-         {
-            Face currentFace = vertsFaceList[faceIndex];
-            Face normalFace = normalsFaceList[faceIndex];
-            if (textureLoaded) glBindTexture(GL_TEXTURE_2D, textureListPtr[textureIndex]);
-            glBegin(GL_POLYGON);
-               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
-               {
-                  glNormal3f(normalList[normalFace.one].x, normalList[normalFace.one].y, normalList[normalFace.one].z);
-                  glTexCoord2f(uvList[currentFace.one].u,uvList[currentFace.one].v);
-                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
-                  glNormal3f(normalList[normalFace.two].x, normalList[normalFace.two].y, normalList[normalFace.two].z);
-                  glTexCoord2f(uvList[currentFace.two].u,uvList[currentFace.two].v);
-                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
-                  glNormal3f(normalList[normalFace.three].x, normalList[normalFace.three].y, normalList[normalFace.three].z);
-                  glTexCoord2f(uvList[currentFace.three].u,uvList[currentFace.three].v);
-                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
-                  if (currentFace.numIndices == 4)
-                  {
-                     glNormal3f(normalList[normalFace.four].x, normalList[normalFace.four].y, normalList[normalFace.four].z);
-                     glTexCoord2f(uvList[currentFace.four].u,uvList[currentFace.four].v);
-                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
-                  }
-               }
-		      glEnd();
-         }
-         if (textureLoaded) glDisable(GL_TEXTURE_2D);
-      }
-      // else we have an invalid set of normals, just do the verts
-      else
-      {
-         for (int faceIndex=0; faceIndex<vertsFaceList.size(); faceIndex++)
-         {
-            Face currentFace = vertsFaceList[faceIndex];
-            glBegin(GL_POLYGON);
-               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
-               {
-                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
-                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
-                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
-                  if (currentFace.numIndices == 4)
-                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
-               }
-		      glEnd();
-         }
-      }
-
-		glPopAttrib();
-		glPopMatrix();
-	glEndList();  
-   displayListCreated = true;
-   return true;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   This operation rotates the local model transform matrix.  We load the models
-   transform matrix, and then we rotate it, and then we get the matrix and set
-   the transform matrix to that rotated version.
-
-  Note: there's got to be a better way to do this
-
-  @param degrees Amount to rotate
-  @param xAxis rotate along this axis
-  @param yAxis rotate along this axis
-  @param ZAxis rotate along this axis
-*/
-void Model3D::rotateModel(int degrees, int xAxis, int yAxis, int zAxis)
-{
-   glPushMatrix();
-   float tempMatrix[] = 
-   { 
-      transformMatrix._00,transformMatrix._01,transformMatrix._02,transformMatrix._03,
-      transformMatrix._10,transformMatrix._11,transformMatrix._12,transformMatrix._13,
-      transformMatrix._20,transformMatrix._21,transformMatrix._22,transformMatrix._23,
-      transformMatrix._30,transformMatrix._31,transformMatrix._32,transformMatrix._33,
-   };
-   // load the models matrix and rotate it
-   glLoadIdentity();
-   glMultMatrixf(tempMatrix);
-   glRotatef(degrees, xAxis, yAxis, zAxis);
-
-   // now get the resultant matrix and load it into the models matrix
-   float matrix[16];
-   glGetFloatv(GL_MODELVIEW_MATRIX, matrix);
-   transformMatrix._00 = matrix[0]; transformMatrix._01 = matrix[1]; transformMatrix._02 = matrix[2]; transformMatrix._03 = matrix[3];
-   transformMatrix._10 = matrix[4]; transformMatrix._11 = matrix[5]; transformMatrix._12 = matrix[6]; transformMatrix._13 = matrix[7];
-   transformMatrix._20 = matrix[8]; transformMatrix._21 = matrix[9]; transformMatrix._22 = matrix[10]; transformMatrix._23 = matrix[11];
-   transformMatrix._30 = matrix[12]; transformMatrix._31 = matrix[13]; transformMatrix._32 = matrix[14]; transformMatrix._33 = matrix[15];   
-
-   glPopMatrix();
-}
-
-//-----------------------------------------------------------------------------
-/**
-   This operation moves the local model transform matrix.  We load the models
-   transform matrix, and then we translate it, and then we get the matrix and set
-   the transform matrix to that translated version.
-
-   \todo Update the models position instead of just translating the local axis
-
-  @param xAmount Amount to move along axis
-  @param yAmount Amount to move along axis
-  @param zAmount Amount to move along axis
-*/
-void Model3D::moveModel(float xAmount, float yAmount, float zAmount)
-{
-   glPushMatrix();
-   float tempMatrix[] = 
-   { 
-      transformMatrix._00,transformMatrix._01,transformMatrix._02,transformMatrix._03,
-      transformMatrix._10,transformMatrix._11,transformMatrix._12,transformMatrix._13,
-      transformMatrix._20,transformMatrix._21,transformMatrix._22,transformMatrix._23,
-      transformMatrix._30,transformMatrix._31,transformMatrix._32,transformMatrix._33,
-   };
-   // load the models matrix and move it
-   glLoadIdentity();
-   glMultMatrixf(tempMatrix);
-   glTranslatef(xAmount, yAmount, zAmount);
-
-   // now get the resultant matrix and load it into the models matrix
-   float matrix[16];
-   glGetFloatv(GL_MODELVIEW_MATRIX, matrix);
-   transformMatrix._00 = matrix[0]; transformMatrix._01 = matrix[1]; transformMatrix._02 = matrix[2]; transformMatrix._03 = matrix[3];
-   transformMatrix._10 = matrix[4]; transformMatrix._11 = matrix[5]; transformMatrix._12 = matrix[6]; transformMatrix._13 = matrix[7];
-   transformMatrix._20 = matrix[8]; transformMatrix._21 = matrix[9]; transformMatrix._22 = matrix[10]; transformMatrix._23 = matrix[11];
-   transformMatrix._30 = matrix[12]; transformMatrix._31 = matrix[13]; transformMatrix._32 = matrix[14]; transformMatrix._33 = matrix[15];   
-
-   glPopMatrix();
-}
+#include <GL/glut.h>
+#include <iostream>
+#include "Model3D.h"
+#include "SceneStore.h"
+
+using namespace std;
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+      Constructor
+  */
+Model3D::Model3D(string aName, int callListid, Vector3D position, bool useLight) :
+   textureLoaded(false),   
+   useLighting(useLight), 
+   displayListCreated(false),
+   myName(aName),
+   callListId(callListid),
+   textureIndex(-1),
+   red(1.0), blue(1.0), green(1.0),
+   modelPosition(position),
+   transformMatrix(),
+   boundsSet(false),
+   shadowProxyAllowed(true),
+   store(0),
+   storeId(-1)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+Model3D::~Model3D()
+{
+   detach();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Move this model's per frame data into a scene store.  From now on the
+   accessors read and write the store.
+
+  @param newStore The store to attach to
+  */
+void Model3D::attach(SceneStore *newStore)
+{
+   detach();
+   storeId = newStore->add(this);
+   store = newStore;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Copy this model's data back out of its scene store and leave the store.
+  */
+void Model3D::detach()
+{
+   if (!store)
+      return;
+
+   modelPosition = store->getPosition(storeId);
+   transformMatrix = store->getOrientation(storeId);
+   store->getColor(storeId, red, green, blue);
+   materialProps = store->getMaterial(storeId);
+   callListId = store->getMeshId(storeId);
+   useLighting = store->isLit(storeId);
+
+   store->remove(storeId);
+   store = 0;
+   storeId = -1;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Return the id of the display list that draws this model
+
+  @return The display list id
+  */
+int Model3D::getCallListId()
+{
+   if (store)
+      return store->getMeshId(storeId);
+   return callListId;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find out if this model is drawn with lighting (and its material) or
+   with its color.
+
+  @return true if the model is lit
+  */
+bool Model3D::isLit()
+{
+   if (store)
+      return store->isLit(storeId);
+   return useLighting;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Return the color components used when the model isn't lit
+  */
+float Model3D::getRed()
+{
+   if (store)
+   {
+      float r, g, b;
+      store->getColor(storeId, r, g, b);
+      return r;
+   }
+   return red;
+}
+
+float Model3D::getGreen()
+{
+   if (store)
+   {
+      float r, g, b;
+      store->getColor(storeId, r, g, b);
+      return g;
+   }
+   return green;
+}
+
+float Model3D::getBlue()
+{
+   if (store)
+   {
+      float r, g, b;
+      store->getColor(storeId, r, g, b);
+      return b;
+   }
+   return blue;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Return a vector of the position
+
+  @return The position of this model in the world
+  */
+Vector3D Model3D::getPosition()
+{
+   if (store)
+      return store->getPosition(storeId);
+   return modelPosition;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Return a FTM copy of this model's transform matrix
+
+  @return A copy of the material properties
+  */
+FTM Model3D::getFTM()
+{
+   if (store)
+      return store->getOrientation(storeId);
+   return transformMatrix;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Return a material copy of this model's material properties
+
+  @return A copy of the material properties
+  */
+Material Model3D::getMaterial()
+{
+   if (store)
+      return store->getMaterial(storeId);
+   return materialProps;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the position of the model
+
+  @param x X component of new position
+  @param y Y component of new position
+  @param z Z component of new position
+  */
+void Model3D::setPosition(float x, float y, float z)
+{
+   if (store)
+   {
+      store->setPosition(storeId, x, y, z);
+      return;
+   }
+   modelPosition.x = x;
+   modelPosition.y = y;
+   modelPosition.z = z;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the position of the model
+
+  @param newPosition The new x,y,z position of the model
+  */
+void Model3D::setPosition(Vector3D newPosition)
+{
+   setPosition(newPosition.x, newPosition.y, newPosition.z);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the color of the model if it's not textured
+
+  @param red Component of color
+  @param green Component of color
+  @param blue Component of color
+  */
+void Model3D::setColor(float redC, float greenC, float blueC)
+{
+   if (store)
+   {
+      store->setColor(storeId, redC, greenC, blueC);
+      return;
+   }
+   red = redC;
+   green = greenC;
+   blue = blueC;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the material properties of this model
+
+  @param newMaterial The new material properties
+  */
+void Model3D::setMaterial(Material newMaterial)
+{
+   if (store)
+   {
+      store->setMaterial(storeId, newMaterial);
+      return;
+   }
+   materialProps = newMaterial;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the FTM of this model
+
+  @param newMatrix The new FTM
+  */
+void Model3D::setTransformMatrix(FTM newMatrix)
+{
+   if (store)
+   {
+      store->setOrientation(storeId, newMatrix);
+      return;
+   }
+   transformMatrix = newMatrix;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the FTM to be used when creating the openGL display list
+
+  @param newMatrix The new initial transform
+  */
+void Model3D::setInitialTransform(FTM newMatrix)
+{
+   initialTransform = newMatrix;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the texture id.  This assumes that the texture has been loaded into 
+   memory and has an index created.
+
+  @param id index into the texture array
+  */
+void Model3D::setTexture(int index, unsigned int* textureList)
+{
+   textureLoaded = true;
+   textureIndex = index;
+   textureListPtr = textureList;
+   if (store)
+      store->setTextureId(storeId, getTextureId());
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Return the openGL texture name used to draw this model.
+
+  @return The texture name, or 0 if the model isn't textured
+  */
+unsigned int Model3D::getTextureId()
+{
+   if (!textureLoaded)
+      return 0;
+   return textureListPtr[textureIndex];
+}
+
+//-----------------------------------------------------------------------------
+/**
+   This operation loads the vert and face data into an openGL display list.  It also
+   properly sets the normals for the surface and the texture coordinates.  The
+   texture itself is bound by the scene before the list is called (see
+   getTextureId), so the list doesn't change any openGL state.
+
+  @param listId The id of the display list being created
+  @return true if display list creation successful, false otherwise
+*/
+bool Model3D::createOpenGLDisplayList()
+{   
+ 	glNewList(callListId, GL_COMPILE);
+      glPushMatrix();
+
+      // apply our local transformation matrix
+      float tempMatrix[] = 
+      { 
+         initialTransform._00,initialTransform._01,initialTransform._02,initialTransform._03,
+         initialTransform._10,initialTransform._11,initialTransform._12,initialTransform._13,
+         initialTransform._20,initialTransform._21,initialTransform._22,initialTransform._23,
+         initialTransform._30,initialTransform._31,initialTransform._32,initialTransform._33,
+      };
+      glMultMatrixf(tempMatrix);
+
+      //KLUDGE - Align the axis here to fit with my hardcoded "Y is up" world
+      /// \todo replace this with a dynamic method of orienting the model to my world.
+      // Assuming 1x-0y-1z model, since thats all I have right now
+      //translate to center the model
+      glTranslatef(0,1.5,-7);
+      // rotate axis
+      glRotatef(-90,0,1,0);
+      glRotatef(-90,1,0,0);
+      // END KLUDGE
+
+      // test to see if normals match up with the verts
+      if (vertsFaceList.size() == normalsFaceList.size())
+      {
+         // Loop through the face list and draw a triangle or a 4 sided polygon
+         // also map the texture coord list to each vertex
+         for (int faceIndex=0; faceIndex<vertsFaceList.size(); faceIndex++)
+         {
+            Face currentFace = vertsFaceList[faceIndex];
+            Face normalFace = normalsFaceList[faceIndex];
+            glBegin(GL_POLYGON);
+               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
+               {
+                  glNormal3f(normalList[normalFace.one].x, normalList[normalFace.one].y, normalList[normalFace.one].z);
+                  glTexCoord2f(uvList[currentFace.one].u,uvList[currentFace.one].v);
+                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
+                  glNormal3f(normalList[normalFace.two].x, normalList[normalFace.two].y, normalList[normalFace.two].z);
+                  glTexCoord2f(uvList[currentFace.two].u,uvList[currentFace.two].v);
+                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
+                  glNormal3f(normalList[normalFace.three].x, normalList[normalFace.three].y, normalList[normalFace.three].z);
+                  glTexCoord2f(uvList[currentFace.three].u,uvList[currentFace.three].v);
+                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
+                  if (currentFace.numIndices == 4)
+                  {
+                     glNormal3f(normalList[normalFace.four].x, normalList[normalFace.four].y, normalList[normalFace.four].z);
+                     glTexCoord2f(uvList[currentFace.four].u,uvList[currentFace.four].v);
+                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
+                  }
+               }
+		      glEnd();
+         }
+      }
+      // else we have an invalid set of normals, just do the verts
+      else
+      {
+         for (int faceIndex=0; faceIndex<vertsFaceList.size(); faceIndex++)
+         {
+            Face currentFace = vertsFaceList[faceIndex];
+            glBegin(GL_POLYGON);
+               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
+               {
+                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
+                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
+                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
+                  if (currentFace.numIndices == 4)
+                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
+               }
+		      glEnd();
+         }
+      }
+
+		glPopMatrix();
+	glEndList();  
+   displayListCreated = true;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   This operation rotates the local model transform matrix, the rotation is
+   applied in the model's own frame the way glRotatef would apply it.  The
+   math is done on the CPU, this is called on the simulation thread which
+   has no openGL context.
+
+  @param degrees Amount to rotate
+  @param xAxis rotate along this axis
+  @param yAxis rotate along this axis
+  @param ZAxis rotate along this axis
+*/
+void Model3D::rotateModel(int degrees, int xAxis, int yAxis, int zAxis)
+{
+   FTM rotation;
+   rotation.loadRotation(degrees, xAxis, yAxis, zAxis);
+   setTransformMatrix(rotation.multMatrix(getFTM()));
+}
+
+//-----------------------------------------------------------------------------
+/**
+   This operation moves the local model transform matrix, along the model's
+   own axes the way glTranslatef would.  The math is done on the CPU, this
+   is called on the simulation thread which has no openGL context.
+
+   \todo Update the models position instead of just translating the local axis
+
+  @param xAmount Amount to move along axis
+  @param yAmount Amount to move along axis
+  @param zAmount Amount to move along axis
+*/
+void Model3D::moveModel(float xAmount, float yAmount, float zAmount)
+{
+   FTM translation;
+   translation.loadTranslation(xAmount, yAmount, zAmount);
+   setTransformMatrix(translation.multMatrix(getFTM()));
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Build the matrix the display list applies to the mesh data: the initial
+   (frame) transform followed by the axis alignment kludge in
+   createOpenGLDisplayList.  The kludge translates by (0,1.5,-7) and rotates
+   -90 degrees about y and then x, which takes a mesh point (x,y,z) to
+   (y, z+1.5, x-7).
+
+  @return The mesh to model space transform
+*/
+FTM Model3D::getMeshTransform()
+{
+   FTM axisKludge;
+   axisKludge._00 = 0; axisKludge._01 = 0; axisKludge._02 = 1; axisKludge._03 = 0;
+   axisKludge._10 = 1; axisKludge._11 = 0; axisKludge._12 = 0; axisKludge._13 = 0;
+   axisKludge._20 = 0; axisKludge._21 = 1; axisKludge._22 = 0; axisKludge._23 = 0;
+   axisKludge._30 = 0; axisKludge._31 = 1.5; axisKludge._32 = -7; axisKludge._33 = 1;
+
+   // the kludge is applied to the verts first, then the initial transform
+   return axisKludge.multMatrix(initialTransform);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Fit the bounding volume around the mesh vertices (in model space, so
+   after the mesh transform).  Models without mesh data (display lists built
+   by hand) should call setBounds instead.
+*/
+void Model3D::computeBounds()
+{
+   if (vertList.empty())
+      return;
+
+   FTM meshTransform = getMeshTransform();
+   Vector3D first = meshTransform.transformPoint(vertList[0]);
+   Vector3D minimum = first;
+   Vector3D maximum = first;
+   for (int vertIndex = 1; vertIndex < vertList.size(); vertIndex++)
+   {
+      Vector3D point = meshTransform.transformPoint(vertList[vertIndex]);
+      if (point.x < minimum.x) minimum.x = point.x;
+      if (point.y < minimum.y) minimum.y = point.y;
+      if (point.z < minimum.z) minimum.z = point.z;
+      if (point.x > maximum.x) maximum.x = point.x;
+      if (point.y > maximum.y) maximum.y = point.y;
+      if (point.z > maximum.z) maximum.z = point.z;
+   }
+   setBounds(BoundingVolume(minimum, maximum));
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the model space bounding volume by hand
+
+  @param bounds The bounding volume of the model
+*/
+void Model3D::setBounds(const BoundingVolume &bounds)
+{
+   localBounds = bounds;
+   boundsSet = true;
+   if (store)
+      store->setBounds(storeId, bounds.center, bounds.radius);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the bounding sphere of the model in the world.  A model with no
+   bounds gets a huge sphere so that it is never culled.
+
+  @param x Set to the x component of the sphere center
+  @param y Set to the y component of the sphere center
+  @param z Set to the z component of the sphere center
+  @param radius Set to the radius of the sphere
+*/
+void Model3D::getWorldBoundingSphere(float &x, float &y, float &z, float &radius)
+{
+   Vector3D position = getPosition();
+   if (!boundsSet)
+   {
+      x = position.x;
+      y = position.y;
+      z = position.z;
+      radius = 1.0e30f;
+      return;
+   }
+
+   FTM orientation = getFTM();
+   Vector3D center = orientation.transformPoint(localBounds.center);
+   x = position.x + center.x;
+   y = position.y + center.y;
+   z = position.z + center.z;
+   radius = localBounds.radius * orientation.getMaxScale();
+}
 }
\ No newline at end of file
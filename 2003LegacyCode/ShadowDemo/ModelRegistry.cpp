@@ -0,0 +1,199 @@
+#include "ModelRegistry.h"
+#include "Model3D.h"
+
+using std::string;
+using std::vector;
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+
+  @param numLists The number of dense model lists to keep
+  */
+ModelRegistry::ModelRegistry(int numLists) :
+slots(0),
+denseModels(numLists),
+denseSlots(numLists),
+firstFreeSlot(-1),
+numModels(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+ModelRegistry::~ModelRegistry()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a model to the end of one of the lists
+
+  @param model The model to add, the registry doesn't own it
+  @param list The list to add it to
+  @return The handle of the model
+  */
+ModelHandle ModelRegistry::add(Model3D *model, int list)
+{
+   // reuse a free slot if there is one
+   int index = firstFreeSlot;
+   if (index >= 0)
+   {
+      firstFreeSlot = slots[index].nextFree;
+   }
+   else
+   {
+      ModelSlot newSlot;
+      newSlot.generation = 0;
+      slots.push_back(newSlot);
+      index = slots.size() - 1;
+   }
+
+   ModelSlot &slot = slots[index];
+   slot.model = model;
+   slot.list = list;
+   slot.denseIndex = denseModels[list].size();
+   slot.generation++;
+   slot.nextFree = -1;
+
+   denseModels[list].push_back(model);
+   denseSlots[list].push_back(index);
+   numModels++;
+   return ModelHandle(index, slot.generation);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Remove a model.  The last model of its list takes its place.
+
+  @param handle The handle of the model
+  @return The model removed, 0 if the handle is stale
+  */
+Model3D* ModelRegistry::remove(ModelHandle handle)
+{
+   if (!isValid(handle))
+      return 0;
+
+   ModelSlot &slot = slots[handle.index];
+   vector<Model3D*> &models = denseModels[slot.list];
+   vector<int> &modelSlots = denseSlots[slot.list];
+
+   // move the last model of the list into the hole
+   int lastIndex = models.size() - 1;
+   models[slot.denseIndex] = models[lastIndex];
+   modelSlots[slot.denseIndex] = modelSlots[lastIndex];
+   slots[modelSlots[slot.denseIndex]].denseIndex = slot.denseIndex;
+   models.pop_back();
+   modelSlots.pop_back();
+
+   // a later add bumps the generation, so this handle goes stale
+   Model3D *model = slot.model;
+   slot.model = 0;
+   slot.denseIndex = -1;
+   slot.nextFree = firstFreeSlot;
+   firstFreeSlot = handle.index;
+   numModels--;
+   return model;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find out if a handle still refers to a model in the registry
+
+  @param handle The handle to test
+  @return true if the model has not been removed
+  */
+bool ModelRegistry::isValid(ModelHandle handle) const
+{
+   if (handle.index < 0 || handle.index >= slots.size())
+      return false;
+   const ModelSlot &slot = slots[handle.index];
+   return slot.generation == handle.generation && slot.denseIndex >= 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find a model from its handle
+
+  @param handle The handle of the model
+  @return The model, 0 if the handle is stale
+  */
+Model3D* ModelRegistry::getModel(ModelHandle handle) const
+{
+   if (!isValid(handle))
+      return 0;
+   return slots[handle.index].model;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find which list a model is in
+
+  @param handle The handle of the model
+  @return The list, -1 if the handle is stale
+  */
+int ModelRegistry::getList(ModelHandle handle) const
+{
+   if (!isValid(handle))
+      return -1;
+   return slots[handle.index].list;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the handle of a model from its place in a list
+
+  @param list The list the model is in
+  @param index The position of the model in the list
+  @return The handle of the model
+  */
+ModelHandle ModelRegistry::getHandle(int list, int index) const
+{
+   int slotIndex = denseSlots[list][index];
+   return ModelHandle(slotIndex, slots[slotIndex].generation);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find a model by its name.  Names are only kept for debugging, this
+   searches every list and should not be used in the frame loop.
+
+  @param name The name of the model
+  @return The handle of the first model with the name, a null handle if
+          there isn't one
+  */
+ModelHandle ModelRegistry::findByName(string name) const
+{
+   for (int list = 0; list < denseModels.size(); list++)
+   {
+      for (int index = 0; index < denseModels[list].size(); index++)
+      {
+         if (denseModels[list][index]->getName() == name)
+            return getHandle(list, index);
+      }
+   }
+   return ModelHandle();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Remove every model.  Handles given out before are all stale afterwards.
+  */
+void ModelRegistry::clear()
+{
+   for (int list = 0; list < denseModels.size(); list++)
+   {
+      for (int index = denseSlots[list].size() - 1; index >= 0; index--)
+      {
+         int slotIndex = denseSlots[list][index];
+         remove(ModelHandle(slotIndex, slots[slotIndex].generation));
+      }
+   }
+}
+}
@@ -0,0 +1,77 @@
+#ifndef MODELREGISTRY_H
+#define MODELREGISTRY_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <string>
+
+namespace SML_CORE
+{
+// forward declarations
+class Model3D;
+
+/**
+   A handle to a model held by a ModelRegistry.  The index names a slot in
+   the registry and the generation tells apart the models that have used
+   that slot, so a handle to a removed model never finds its replacement.
+  */
+class ModelHandle
+{
+public:
+   int index;
+   unsigned int generation;
+
+public:
+   ModelHandle() : index(-1), generation(0) {};
+   ModelHandle(int index, unsigned int generation) : index(index), generation(generation) {};
+   bool isNull() const {return index < 0;};
+   bool operator==(const ModelHandle &other) const {return index == other.index && generation == other.generation;};
+   bool operator!=(const ModelHandle &other) const {return !(*this == other);};
+};
+
+/**
+  This class keeps track of the models in a scene.  Models are added to one
+  of several dense lists (the scene uses one per shadow mode) that can be
+  walked quickly each frame, and are found again through a ModelHandle.
+  Adding, removing and looking up a model are all constant time: removing
+  moves the last model of its list into the hole it leaves, so the order of
+  a list changes as models come and go.
+
+  Slots of removed models are reused, each reuse bumps the slot generation.
+*/
+class ModelRegistry
+{
+private:
+   /** What a handle points at */
+   class ModelSlot
+   {
+   public:
+      Model3D* model;
+      int list;
+      int denseIndex;
+      unsigned int generation;
+      int nextFree;
+   };
+
+   std::vector<ModelSlot> slots;
+   std::vector< std::vector<Model3D*> > denseModels;
+   std::vector< std::vector<int> > denseSlots;
+   int firstFreeSlot;
+   int numModels;
+
+public:
+   ModelRegistry(int numLists=1);
+   virtual ~ModelRegistry();
+   ModelHandle add(Model3D *model, int list);
+   Model3D* remove(ModelHandle handle);
+   bool isValid(ModelHandle handle) const;
+   Model3D* getModel(ModelHandle handle) const;
+   int getList(ModelHandle handle) const;
+   ModelHandle getHandle(int list, int index) const;
+   ModelHandle findByName(std::string name) const;
+   const std::vector<Model3D*>& getModels(int list) const {return denseModels[list];};
+   int getNumLists() const {return denseModels.size();};
+   int getNumModels() const {return numModels;};
+   void clear();
+};
+}
+#endif
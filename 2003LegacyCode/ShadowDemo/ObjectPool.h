@@ -0,0 +1,120 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <new>
+
+namespace SML_CORE
+{
+/**
+  This class keeps the memory for objects of one type.  The memory comes
+  from blocks of several objects and freed objects go on a free list, so
+  creating and destroying objects in a steady state doesn't touch the heap
+  and objects of the same type sit close together.
+
+  Objects are built in the pool's memory with placement new and must be
+  given back with destroy:
+
+     Model3D *model = new (modelPool.allocate()) Model3D(...);
+     ...
+     modelPool.destroy(model);
+
+  The pool must outlive its objects.
+*/
+template <class T>
+class ObjectPool
+{
+private:
+   /** The memory for one object, or a link in the free list */
+   union PoolSlot
+   {
+      PoolSlot* nextFree;
+      double alignment;
+      char storage[sizeof(T)];
+   };
+
+   std::vector<PoolSlot*> blocks;
+   PoolSlot* firstFree;
+   int objectsPerBlock;
+   int numLive;
+
+   //--------------------------------------------------------------------------
+   /**
+      Add a block of free slots to the pool
+     */
+   void grow()
+   {
+      PoolSlot *block = new PoolSlot[objectsPerBlock];
+      blocks.push_back(block);
+      for (int index = objectsPerBlock - 1; index >= 0; index--)
+      {
+         block[index].nextFree = firstFree;
+         firstFree = &block[index];
+      }
+   }
+
+public:
+   //--------------------------------------------------------------------------
+   /**
+      Constructor.  No memory is taken until the first allocation.
+
+     @param blockSize The number of objects in each block
+     */
+   ObjectPool(int blockSize=64) :
+   blocks(0),
+   firstFree(0),
+   objectsPerBlock(blockSize),
+   numLive(0)
+   {
+
+   }
+
+   //--------------------------------------------------------------------------
+   /**
+      Destructor.  Any objects still alive are not destroyed, their memory
+      is just freed.
+     */
+   virtual ~ObjectPool()
+   {
+      for (int index = 0; index < blocks.size(); index++)
+         delete [] blocks[index];
+   }
+
+   //--------------------------------------------------------------------------
+   /**
+      Get the memory for one object
+
+     @return Memory to build a T in with placement new
+     */
+   void* allocate()
+   {
+      if (!firstFree)
+         grow();
+      PoolSlot *slot = firstFree;
+      firstFree = slot->nextFree;
+      numLive++;
+      return slot->storage;
+   }
+
+   //--------------------------------------------------------------------------
+   /**
+      Destroy an object made in this pool and free its memory
+
+     @param object The object, may be 0
+     */
+   void destroy(T *object)
+   {
+      if (!object)
+         return;
+      object->~T();
+      PoolSlot *slot = (PoolSlot*)object;
+      slot->nextFree = firstFree;
+      firstFree = slot;
+      numLive--;
+   }
+
+   int getNumLive() const {return numLive;};
+   int getCapacity() const {return blocks.size() * objectsPerBlock;};
+};
+}
+#endif
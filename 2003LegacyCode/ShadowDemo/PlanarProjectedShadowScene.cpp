@@ -1,204 +1,1171 @@
-#include <GL/glut.h>
-#include "PlanarProjectedShadowScene.h"
-#include "Model3D.h"
-
-using std::vector;
-
-namespace SML_CORE
-{
-//-----------------------------------------------------------------------------
-/**
-   Constructor
-  */
-PlanarProjectedShadowScene::PlanarProjectedShadowScene() : ShadowableScene()
-{
-   // setup the stencil buffer for our shadowing (used when blending)
-   glStencilFunc(GL_ALWAYS, 1, 0xffffffff);
-   glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-
-   // set the polygon offset values (factor, units)
-   glPolygonOffset(-1.0, -2.0);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Destructor
-  */
-PlanarProjectedShadowScene::~PlanarProjectedShadowScene()
-{
-
-}
-
-//-----------------------------------------------------------------------------
-/**
-  Render the model list to the screen
-*/
-void PlanarProjectedShadowScene::renderModelListAsShadows(const vector<Model3D*> &modelList, FTM shadowMatrix)
-{
-   Model3D *aModel;
-   glDisable(GL_LIGHTING);
-   for (int index = 0; index < modelList.size(); index++)
-   {
-      aModel = modelList[index];
-      glPushMatrix();
- 
-      // Transform the model onto the calculated receiver plane
-      float tempShadowMatrix[] = 
-      { 
-         shadowMatrix._00,shadowMatrix._01,shadowMatrix._02,shadowMatrix._03,
-         shadowMatrix._10,shadowMatrix._11,shadowMatrix._12,shadowMatrix._13,
-         shadowMatrix._20,shadowMatrix._21,shadowMatrix._22,shadowMatrix._23,
-         shadowMatrix._30,shadowMatrix._31,shadowMatrix._32,shadowMatrix._33,
-      };
-      glMultMatrixf(tempShadowMatrix);
-
-      // Position the model
-      Vector3D position(aModel->getPosition());
-      glTranslatef(position.x, position.y, position.z);
-      
-      // Orient the model
-      FTM rotations(aModel->getFTM());
-      float tempMatrix[] = 
-      { 
-         rotations._00,rotations._01,rotations._02,rotations._03,
-         rotations._10,rotations._11,rotations._12,rotations._13,
-         rotations._20,rotations._21,rotations._22,rotations._23,
-         rotations._30,rotations._31,rotations._32,rotations._33,
-      };
-      glMultMatrixf(tempMatrix);
-
-      // draw the model
-      glCallList(aModel->getCallListId());
-
-      glPopMatrix();
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   A implmentation of drawShadows uses a planar projection technique to draw
-   stencil buffer shadows on a flat plane.
-*/
-void PlanarProjectedShadowScene::drawShadows()
-{
-   // loop through each receiver and draw shadows on it
-   for (int index = 0; index < shadowReceiverList.size(); index++)
-   {
-      Model3D* aModel = shadowReceiverList[index];
-
-      // calculate plane from points
-      /// \todo get the plane from the model
-      float p0[4] = {0.0, 0.0, 0.0};
-      float p1[4] = {0.0, 0.0, 200.0};
-      float p2[4] = {200.0, 0.0, 200.0};
-      float *tempPlane = calculatePlaneFromPoints(p0,p1,p2);
-
-      // draw shadows onto this receiver
-      glPushAttrib(GL_ALL_ATTRIB_BITS);
-      glEnable(GL_STENCIL_TEST);
-
-      // this will make sure the shadow drawing doesn't conflict with the actual scene polygons
-      glEnable(GL_POLYGON_OFFSET_FILL);
-
-      // uncomment these lines to enable shadow blending
-      //glEnable(GL_BLEND);
-      //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-      glDisable(GL_LIGHTING);
-      glColor4f(0.0, 0.0, 0.0, 0.8);
-
-      // draw a shadow for each light on this plane
-      for (int lightIndex = 0; lightIndex < pointLightList.size(); lightIndex++)
-      {
-         float tempLight[4] = {
-            pointLightList[lightIndex].x,
-            pointLightList[lightIndex].y,
-            pointLightList[lightIndex].z,
-            1.0
-         };
-         // transform by our shadow matrix calculation and draw
-         FTM shadowMatrix = calculateShadowTransformation(tempPlane, tempLight);
-         renderModelListAsShadows(shadowCasterList, shadowMatrix);
-      }
-
-      glEnable(GL_LIGHTING);
-      glDisable(GL_POLYGON_OFFSET_FILL);
-      glDisable(GL_STENCIL_TEST);
-      glPopAttrib();
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-  Calculate a plane that transforms objects onto the argument plane
-  We also pass in a 4D light position.
-
-  @param projectionPlane The plane to project onto
-  @param lightPosition The position we are projecting
-  @return Shadow frame transformation matrix
-*/
-FTM PlanarProjectedShadowScene::calculateShadowTransformation(float* projectionPlane, float* lightPosition)
-{
-   float dotProduct =
-      projectionPlane[0] * lightPosition[0] +
-      projectionPlane[1] * lightPosition[1] +
-      projectionPlane[2] * lightPosition[2] +
-      projectionPlane[3] * lightPosition[3];
-
-   FTM shadowMatrix;
-
-   shadowMatrix._00 = dotProduct - lightPosition[0] * projectionPlane[0];
-   shadowMatrix._10 = 0.0 - lightPosition[0] * projectionPlane[1];
-   shadowMatrix._20 = 0.0 - lightPosition[0] * projectionPlane[2];
-   shadowMatrix._30 = 0.0 - lightPosition[0] * projectionPlane[3];
-
-   shadowMatrix._01 = 0.0 - lightPosition[1] * projectionPlane[0];
-   shadowMatrix._11 = dotProduct - lightPosition[1] * projectionPlane[1];
-   shadowMatrix._21 = 0.0 - lightPosition[1] * projectionPlane[2];
-   shadowMatrix._31 = 0.0 - lightPosition[1] * projectionPlane[3];
-
-   shadowMatrix._02 = 0.0 - lightPosition[2] * projectionPlane[0];
-   shadowMatrix._12 = 0.0 - lightPosition[2] * projectionPlane[1];
-   shadowMatrix._22 = dotProduct - lightPosition[2] * projectionPlane[2];
-   shadowMatrix._32 = 0.0 - lightPosition[2] * projectionPlane[3];
-
-   shadowMatrix._03 = 0.0 - lightPosition[3] * projectionPlane[0];
-   shadowMatrix._13 = 0.0 - lightPosition[3] * projectionPlane[1];
-   shadowMatrix._23 = 0.0 - lightPosition[3] * projectionPlane[2];
-   shadowMatrix._33 = dotProduct - lightPosition[3] * projectionPlane[3];
-
-   return shadowMatrix;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Find the equation of a plane from 3 points
-
-   Note: this operation has a memory leak (we loose plane), we need to
-   either pass in a pointer to a plane, or create a Plane class.
-
-  @return The plane formed by the argument points
-*/
-float* PlanarProjectedShadowScene::calculatePlaneFromPoints(float p0[3], float p1[3], float p2[3])
-{
-  // get vector between point1 and point0
-  float vector0[3];
-  vector0[0] = p1[0] - p0[0];
-  vector0[1] = p1[1] - p0[1];
-  vector0[2] = p1[2] - p0[2];
-
-  // get vector between point2 and point0
-  float vector1[3];
-  vector1[0] = p2[0] - p0[0];
-  vector1[1] = p2[1] - p0[1];
-  vector1[2] = p2[2] - p0[2];
-
-  // the cross product of the vectors gives us a plane
-  float* plane = new GLfloat[4];
-  plane[0] = vector0[1] * vector1[2] - vector0[2] * vector1[1];
-  plane[1] = -(vector0[0] * vector1[2] - vector0[2] * vector1[0]);
-  plane[2] = vector0[0] * vector1[1] - vector0[1] * vector1[0];
-  plane[3] = -(plane[0] * p0[0] + plane[1] * p0[1] + plane[2] * p0[2]);
-
-  return plane;
-}
-}
\ No newline at end of file
+#include <GL/glut.h>
+#include "PlanarProjectedShadowScene.h"
+#include "Model3D.h"
+#include "EdgeMesh.h"
+#include "ConvexHull.h"
+#include "GLExtensions.h"
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+using std::vector;
+using std::cout;
+using std::endl;
+
+namespace SML_CORE
+{
+// the stencil buffer is split up: the receiver a pixel shows, a mark for the
+// pixels in shadow, and the count of outline edges over a pixel
+static const unsigned int RECEIVER_ID_MASK = 0xf0;
+static const int RECEIVER_ID_SHIFT = 4;
+static const unsigned int SHADOWED_MASK = 0x08;
+static const unsigned int COUNT_MASK = 0x07;
+static const int MAX_RECEIVER_IDS = 15;
+static const int STENCIL_BITS_NEEDED = 8;
+
+// how far past its box (as a part of its size) a receiver is taken to reach
+// when testing shadow footprints, for the error in projecting onto it
+static const float RECEIVER_BOX_SLACK = 0.01;
+
+// a caster or receiver that has gone this many updates without moving is
+// static, its shadows can be cached
+static const int STATIC_UPDATES = 30;
+
+// the size of the textures the static shadows are cached in
+static const int SHADOW_CACHE_SIZE = 512;
+
+// how far either side of a receiver plane the cached shadows are drawn from
+static const float SHADOW_CACHE_DEPTH = 1.0e6;
+
+// a receiver mesh whose triangle normals add up to less than this part of
+// their total length has no average plane (it is closed, or nearly), its
+// plane is taken from its bounds instead
+static const float FLAT_RECEIVER_TOLERANCE = 0.01;
+
+// how dark a shadowed pixel is made (the alpha of the black laid over it)
+static const float SHADOW_ALPHA = 0.6;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+  */
+PlanarProjectedShadowScene::PlanarProjectedShadowScene() : ShadowableScene(),
+initialized(false),
+stencilSupported(false),
+outlinesSupported(false),
+matricesRebuilt(0),
+cachingSupported(false),
+cacheFramebufferId(0),
+cachesBaked(0)
+{
+   // set the polygon offset values (factor, units)
+   renderState.setPolygonOffset(-1.0, -2.0);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+PlanarProjectedShadowScene::~PlanarProjectedShadowScene()
+{
+   for (int index = 0; index < shadowCaches.size(); index++)
+   {
+      if (shadowCaches[index].textureId)
+         glDeleteTextures(1, &shadowCaches[index].textureId);
+   }
+   if (cacheFramebufferId)
+      GLExtensions::deleteFramebuffers(1, &cacheFramebufferId);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Check the shadows can be clipped to their receivers, and the outlines
+   filled, the first time shadows are drawn.  The count of outline edges
+   over a pixel goes up and down so the stencil buffer has to wrap.  Without
+   a stencil buffer the shadows are drawn straight onto the screen.
+  */
+void PlanarProjectedShadowScene::initialize()
+{
+   initialized = true;
+   GLExtensions::load();
+
+   GLint stencilBits = 0;
+   glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+   stencilSupported = stencilBits >= STENCIL_BITS_NEEDED;
+   outlinesSupported = stencilSupported && GLExtensions::hasStencilWrap;
+   cachingSupported = stencilSupported && GLExtensions::hasFramebufferObjects;
+   if (cachingSupported)
+      GLExtensions::genFramebuffers(1, &cacheFramebufferId);
+   if (!stencilSupported)
+      cout << "ERROR: planar shadows need an 8 bit stencil buffer to stay on their receivers" << endl;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Render the model list to the screen.  With a stencil buffer nothing is
+  drawn, the pixels of the receiver the shadows fall on are marked as
+  shadowed (see darkenShadows).
+
+  @param modelList The casters
+  @param shadowMatrix The matrix that projects onto the receiver plane
+  @param lightIndex The light the shadows are cast from
+  @param receiverId The receiver's stencil id
+*/
+void PlanarProjectedShadowScene::renderModelListAsShadows(const vector<Model3D*> &modelList, const float *shadowMatrix,
+                                                          int lightIndex, int receiverId)
+{
+   if (stencilSupported)
+   {
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      glDepthMask(GL_FALSE);
+      renderState.setStencilFunc(GL_EQUAL, receiverId | SHADOWED_MASK, RECEIVER_ID_MASK);
+      renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+      renderState.setStencilWriteMask(SHADOWED_MASK);
+   }
+
+   outlineRanges.clear();
+   Model3D *aModel;
+   ConvexHull *proxy;
+   float casterMatrix[16];
+   for (int index = 0; index < modelList.size(); index++)
+   {
+      aModel = modelList[index];
+      proxy = findShadowProxy(aModel);
+      if (!proxy && outlinesSupported && addOutline(aModel, shadowMatrix, lightIndex))
+         continue;
+
+      // Transform the model onto the receiver plane, from where it is
+      int storeIndex = sceneStore.getIndex(aModel->getStoreId());
+      multiplyMatrices(shadowMatrix, sceneStore.getWorldMatrixAt(storeIndex), casterMatrix);
+      glPushMatrix();
+      glMultMatrixf(casterMatrix);
+
+      // draw the model, or the hull standing in for it
+      if (proxy)
+      {
+         glEnableClientState(GL_VERTEX_ARRAY);
+         glVertexPointer(3, GL_FLOAT, 0, proxy->getVertices());
+         glDrawElements(GL_TRIANGLES, proxy->getNumTriangles() * 3, GL_UNSIGNED_INT, proxy->getTriangles());
+         glDisableClientState(GL_VERTEX_ARRAY);
+      }
+      else
+         glCallList(sceneStore.getMeshIdAt(storeIndex));
+
+      glPopMatrix();
+   }
+   if (!outlineRanges.empty())
+      markOutlines(receiverId);
+
+   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+   glDepthMask(GL_TRUE);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Mark the pixels inside the outlines as shadowed: count the edges wound
+   each way over each pixel of the receiver into the stencil buffer, the
+   pixels left with a count are inside
+
+  @param receiverId The receiver's stencil id
+  */
+void PlanarProjectedShadowScene::markOutlines(int receiverId)
+{
+   glEnableClientState(GL_VERTEX_ARRAY);
+   renderState.setStencilFunc(GL_EQUAL, receiverId, RECEIVER_ID_MASK);
+   renderState.setStencilWriteMask(COUNT_MASK);
+   if (GLExtensions::hasSeparateStencil)
+   {
+      renderState.setStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+      renderState.setStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+      drawOutlines();
+   }
+   else
+   {
+      glEnable(GL_CULL_FACE);
+      glCullFace(GL_BACK);
+      renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+      drawOutlines();
+      glCullFace(GL_FRONT);
+      renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+      drawOutlines();
+      glCullFace(GL_BACK);
+      glDisable(GL_CULL_FACE);
+   }
+
+   // turn the counts into shadow marks, clearing the counts as it goes
+   renderState.setStencilFunc(GL_NOTEQUAL, SHADOWED_MASK, COUNT_MASK);
+   renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+   renderState.setStencilWriteMask(SHADOWED_MASK | COUNT_MASK);
+   drawOutlines();
+   glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Mark each receiver's pixels with its stencil id, by drawing the receivers
+   again where they are already in the depth buffer
+
+  @param first The first receiver to mark
+  @param last One past the last receiver to mark
+  */
+void PlanarProjectedShadowScene::markReceivers(int first, int last)
+{
+   glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+   glDepthMask(GL_FALSE);
+   glDepthFunc(GL_LEQUAL);
+   renderState.setPolygonOffsetFill(false);
+   renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+   renderState.setStencilWriteMask(RECEIVER_ID_MASK);
+   for (int index = first; index < last; index++)
+   {
+      int storeIndex = sceneStore.getIndex(shadowReceiverList[index]->getStoreId());
+      renderState.setStencilFunc(GL_ALWAYS, (index - first + 1) << RECEIVER_ID_SHIFT, 0xffffffff);
+      glPushMatrix();
+      glMultMatrixf(sceneStore.getWorldMatrixAt(storeIndex));
+      glCallList(sceneStore.getMeshIdAt(storeIndex));
+      glPopMatrix();
+   }
+   glDepthFunc(GL_LESS);
+   glDepthMask(GL_TRUE);
+   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Lay black over the pixels of a receiver marked as shadowed, clearing the
+   marks as it goes so no pixel is darkened twice
+
+  @param receiverId The receiver's stencil id
+  */
+void PlanarProjectedShadowScene::darkenShadows(int receiverId)
+{
+   renderState.setStencilFunc(GL_EQUAL, receiverId | SHADOWED_MASK, RECEIVER_ID_MASK | SHADOWED_MASK);
+   renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+   renderState.setStencilWriteMask(SHADOWED_MASK);
+   renderState.setBlend(true);
+   renderState.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   renderState.setColor(0.0, 0.0, 0.0, SHADOW_ALPHA);
+   glDisable(GL_DEPTH_TEST);
+
+   // a quad over the whole screen, the scissor and stencil keep it in place
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+   glRectf(-1.0, -1.0, 1.0, 1.0);
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+
+   glEnable(GL_DEPTH_TEST);
+   renderState.setBlend(false);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the part of the screen a receiver covers, from the corners of its
+   bounds
+
+  @param receiver The receiver
+  @param rectangle Set to the x, y, width and height of the part in pixels
+  @return false if the part can't be found (the receiver is partly behind
+          the camera)
+  */
+bool PlanarProjectedShadowScene::findReceiverRectangle(Model3D *receiver, int *rectangle)
+{
+   BoundingVolume bounds = receiver->getBounds();
+   const float *world = sceneStore.getWorldMatrixAt(sceneStore.getIndex(receiver->getStoreId()));
+   scissorPoints.clear();
+   for (int corner = 0; corner < 8; corner++)
+   {
+      float point[3] =
+      {
+         corner & 1 ? bounds.maximum.x : bounds.minimum.x,
+         corner & 2 ? bounds.maximum.y : bounds.minimum.y,
+         corner & 4 ? bounds.maximum.z : bounds.minimum.z
+      };
+      for (int axis = 0; axis < 3; axis++)
+      {
+         scissorPoints.push_back(world[axis] * point[0] + world[4 + axis] * point[1] +
+            world[8 + axis] * point[2] + world[12 + axis]);
+      }
+   }
+   return findScreenRectangle(cameraProjection, viewport, scissorPoints, rectangle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a caster's outline from a light to the outlines drawn, as a fan of
+   triangles from the silhouette's first vertex.  The outline needn't be one
+   loop or convex, the triangles' windings cancel outside it.  The outline
+   is kept in the caster's model space and only found again when the shadow
+   scheduler says so, it is shared by every receiver.
+
+  @param aModel The caster
+  @param shadowMatrix The matrix that projects onto the receiver plane
+  @param lightIndex The light
+  @return false if the caster has no mesh data or its mesh isn't closed
+          (an open mesh's silhouette doesn't bound its shadow), it must be
+          drawn whole
+  */
+bool PlanarProjectedShadowScene::addOutline(Model3D *aModel, const float *shadowMatrix, int lightIndex)
+{
+   EdgeMesh *mesh = findEdgeMesh(aModel);
+   if (mesh->getNumTriangles() == 0 || !mesh->isClosed())
+      return false;
+
+   int storeIndex = sceneStore.getIndex(aModel->getStoreId());
+   ShadowScheduler::ShadowResult &outline = shadowScheduler.findShadow(aModel->getStoreId(), lightIndex);
+   if (outline.refresh)
+   {
+      shadowScheduler.startRefresh();
+      float light[3];
+      toModelSpace(storeIndex, pointLightList[lightIndex], light);
+      outline.vertices.clear();
+      if (mesh->findSilhouette(light, silhouette) > 0)
+      {
+         const float *vertices = mesh->getVertices();
+         const float *anchor = vertices + silhouette[0] * 3;
+         for (int index = 0; index < silhouette.size(); index += 2)
+         {
+            const float *from = vertices + silhouette[index] * 3;
+            const float *to = vertices + silhouette[index + 1] * 3;
+            outline.vertices.insert(outline.vertices.end(), anchor, anchor + 3);
+            outline.vertices.insert(outline.vertices.end(), from, from + 3);
+            outline.vertices.insert(outline.vertices.end(), to, to + 3);
+         }
+      }
+      shadowScheduler.finishRefresh(outline);
+   }
+   if (outline.vertices.empty())
+      return true;
+
+   OutlineRange range;
+   multiplyMatrices(shadowMatrix, sceneStore.getWorldMatrixAt(storeIndex), range.matrix);
+   range.vertices = &outline.vertices[0];
+   range.count = outline.vertices.size() / 3;
+   outlineRanges.push_back(range);
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the outlines added for a receiver and light, each projected from
+   where its caster is onto the receiver plane
+  */
+void PlanarProjectedShadowScene::drawOutlines()
+{
+   for (int index = 0; index < outlineRanges.size(); index++)
+   {
+      const OutlineRange &range = outlineRanges[index];
+      glVertexPointer(3, GL_FLOAT, 0, range.vertices);
+      glPushMatrix();
+      glMultMatrixf(range.matrix);
+      glDrawArrays(GL_TRIANGLES, 0, range.count);
+      glPopMatrix();
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   A implmentation of drawShadows uses a planar projection technique to draw
+   stencil buffer shadows on a flat plane.  Each receiver's pixels are given
+   its own stencil id and the shadows projected onto its plane are kept to
+   them, so they stop at the receiver's edges.
+*/
+void PlanarProjectedShadowScene::drawShadows()
+{
+   if (!initialized)
+      initialize();
+
+   // find the casters whose shadows can be seen for each light
+   visibleCasters.resize(pointLightList.size());
+   int lightIndex;
+   for (lightIndex = 0; lightIndex < pointLightList.size(); lightIndex++)
+   {
+      visibleCasters[lightIndex].clear();
+      if (isEmptyLightSlot(lightIndex))
+         continue;
+      findVisibleCasters(pointLightList[lightIndex], visibleCasters[lightIndex]);
+      scheduleShadows(visibleCasters[lightIndex]);
+   }
+
+   // pick the casters whose outlines are found again this frame
+   shadowScheduler.selectUpdates();
+
+   // the planes and matrices of the receivers and lights that moved, and
+   // the static shadows that need drawing again
+   updateShadowMatrices();
+   cachesBaked = 0;
+   if (cachingSupported)
+      updateShadowCaches();
+
+   renderState.setLighting(false);
+   renderState.setTexture(0);
+   renderState.setStencilTest(stencilSupported);
+
+   // this will make sure the shadow drawing doesn't conflict with the actual scene polygons
+   renderState.setPolygonOffsetFill(true);
+
+   if (!stencilSupported)
+   {
+      // the shadows go straight onto the screen, unblended so overlaps
+      // don't show
+      renderState.setColor(0.0, 0.0, 0.0, 0.8);
+      for (int index = 0; index < shadowReceiverList.size(); index++)
+      {
+         for (lightIndex = 0; lightIndex < pointLightList.size(); lightIndex++)
+         {
+            if (isEmptyLightSlot(lightIndex))
+               continue;
+            findReceiverCasters(index, lightIndex);
+            renderModelListAsShadows(receiverCasters, getShadowMatrix(index, lightIndex), lightIndex, 0);
+            drawProjectileShadows(receiverPlanes[index].plane, pointLightList[lightIndex]);
+         }
+      }
+      renderState.setPolygonOffsetFill(false);
+      return;
+   }
+
+   glGetFloatv(GL_PROJECTION_MATRIX, cameraProjection);
+   glGetIntegerv(GL_VIEWPORT, viewport);
+
+   // the receivers are marked a batch at a time, as many as there are ids
+   for (int batch = 0; batch < shadowReceiverList.size(); batch += MAX_RECEIVER_IDS)
+   {
+      int batchEnd = batch + MAX_RECEIVER_IDS;
+      if (batchEnd > shadowReceiverList.size())
+         batchEnd = shadowReceiverList.size();
+      if (batch > 0)
+      {
+         renderState.setStencilWriteMask(0xffffffff);
+         glClear(GL_STENCIL_BUFFER_BIT);
+      }
+      markReceivers(batch, batchEnd);
+
+      // loop through each receiver and draw shadows on it, kept to the part
+      // of the screen it covers
+      for (int index = batch; index < batchEnd; index++)
+      {
+         int receiverId = (index - batch + 1) << RECEIVER_ID_SHIFT;
+         const ReceiverPlane &receiverPlane = receiverPlanes[index];
+         if (viewFrustum.classifyBox(receiverPlane.minimum[0], receiverPlane.minimum[1], receiverPlane.minimum[2],
+               receiverPlane.maximum[0], receiverPlane.maximum[1], receiverPlane.maximum[2]) == Frustum::OUTSIDE)
+            continue;
+         int rectangle[4];
+         if (findReceiverRectangle(shadowReceiverList[index], rectangle))
+         {
+            if (rectangle[2] == 0 || rectangle[3] == 0)
+               continue;
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(rectangle[0], rectangle[1], rectangle[2], rectangle[3]);
+         }
+
+         // draw a shadow for each light on this plane
+         renderState.setPolygonOffsetFill(true);
+         for (lightIndex = 0; lightIndex < pointLightList.size(); lightIndex++)
+         {
+            if (isEmptyLightSlot(lightIndex))
+               continue;
+            findReceiverCasters(index, lightIndex);
+            if (cachingSupported && shadowCaches[index * pointLightList.size() + lightIndex].valid)
+            {
+               const ShadowCache &cache = shadowCaches[index * pointLightList.size() + lightIndex];
+               removeCachedCasters(cache);
+               if (!cache.casters.empty())
+                  markCachedShadows(index, lightIndex, receiverId);
+            }
+            renderModelListAsShadows(receiverCasters, getShadowMatrix(index, lightIndex), lightIndex, receiverId);
+            darkenShadows(receiverId);
+
+            // projectiles get a cheap blob instead of a projected shape
+            renderState.setStencilFunc(GL_EQUAL, receiverId, RECEIVER_ID_MASK);
+            renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            drawProjectileShadows(receiverPlane.plane, pointLightList[lightIndex]);
+         }
+         glDisable(GL_SCISSOR_TEST);
+      }
+   }
+
+   // the next pass sets its own lighting, texture and color as needed, the
+   // frame's stencil clear needs every bit writable
+   renderState.setStencilWriteMask(0xffffffff);
+   renderState.setPolygonOffsetFill(false);
+   renderState.setStencilTest(false);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the visible casters from a light whose shadows can fall on a
+   receiver, into receiverCasters
+
+  @param receiverIndex The receiver
+  @param lightIndex The light
+  */
+void PlanarProjectedShadowScene::findReceiverCasters(int receiverIndex, int lightIndex)
+{
+   const vector<Model3D*> &casterList = visibleCasters[lightIndex];
+   const ReceiverPlane &receiverPlane = receiverPlanes[receiverIndex];
+   receiverCasters.clear();
+   for (int index = 0; index < casterList.size(); index++)
+   {
+      if (canShadowReceiver(casterList[index], receiverPlane, pointLightList[lightIndex]))
+         receiverCasters.push_back(casterList[index]);
+   }
+   shadowPairsTested += casterList.size();
+   shadowPairsRejected += casterList.size() - receiverCasters.size();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test if a caster's shadow from a light can fall on a receiver.  The box
+   around the caster's bounding sphere is projected from the light onto the
+   receiver plane, the shadow is inside the box around the projected
+   corners.  A caster wholly behind the plane from the light throws no
+   shadow on it.  The test is conservative, a caster that reaches up to the
+   light (its shadow has no bound) is always kept.
+
+  @param caster The caster
+  @param receiverPlane The receiver's plane and box
+  @param lightPosition The light
+  @param checkView false to keep shadows outside the view (for the cache)
+  @return false if the shadow can't be seen on the receiver
+  */
+bool PlanarProjectedShadowScene::canShadowReceiver(Model3D *caster, const ReceiverPlane &receiverPlane,
+                                                   const Vector3D &lightPosition, bool checkView) const
+{
+   const float *plane = receiverPlane.plane;
+   float length = (float)sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+   if (length == 0.0)
+      return true;
+
+   // distances from the plane, positive on the light's side
+   const float *sphere = sceneStore.getWorldSphereAt(sceneStore.getIndex(caster->getStoreId()));
+   float light[3] = {lightPosition.x, lightPosition.y, lightPosition.z};
+   float lightDistance = (plane[0] * light[0] + plane[1] * light[1] + plane[2] * light[2] + plane[3]) / length;
+   float side = lightDistance < 0.0 ? -1.0 : 1.0;
+   lightDistance *= side;
+   float scale = side / length;
+   float casterDistance = (plane[0] * sphere[0] + plane[1] * sphere[1] + plane[2] * sphere[2] + plane[3]) * scale;
+   if (casterDistance < -sphere[3])
+      return false;
+   float reach = sphere[3] * (fabs(plane[0]) + fabs(plane[1]) + fabs(plane[2])) / length;
+   if (casterDistance + reach >= lightDistance)
+      return true;
+
+   // the shadow's footprint, from the corners of the box around the sphere
+   float minimum[3] = {1.0e30f, 1.0e30f, 1.0e30f};
+   float maximum[3] = {-1.0e30f, -1.0e30f, -1.0e30f};
+   int axis;
+   for (int corner = 0; corner < 8; corner++)
+   {
+      float point[3] =
+      {
+         sphere[0] + (corner & 1 ? sphere[3] : -sphere[3]),
+         sphere[1] + (corner & 2 ? sphere[3] : -sphere[3]),
+         sphere[2] + (corner & 4 ? sphere[3] : -sphere[3])
+      };
+      float pointDistance = (plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2] + plane[3]) * scale;
+      float stretch = lightDistance / (lightDistance - pointDistance);
+      for (axis = 0; axis < 3; axis++)
+      {
+         float projected = light[axis] + (point[axis] - light[axis]) * stretch;
+         if (projected < minimum[axis]) minimum[axis] = projected;
+         if (projected > maximum[axis]) maximum[axis] = projected;
+      }
+   }
+
+   for (axis = 0; axis < 3; axis++)
+   {
+      if (maximum[axis] < receiverPlane.minimum[axis] || minimum[axis] > receiverPlane.maximum[axis])
+         return false;
+   }
+   return !checkView || viewFrustum.classifyBox(minimum[0], minimum[1], minimum[2],
+      maximum[0], maximum[1], maximum[2]) != Frustum::OUTSIDE;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the box around a receiver in the world, from the corners of its
+   bounds.  The box is grown a little so a footprint projected onto a flat
+   receiver is not lost to rounding.
+
+  @param receiver The receiver
+  @param minimum Set to the smallest corner of the box
+  @param maximum Set to the largest corner of the box
+  */
+void PlanarProjectedShadowScene::findReceiverBox(Model3D *receiver, float *minimum, float *maximum)
+{
+   BoundingVolume bounds = receiver->getBounds();
+   const float *world = sceneStore.getWorldMatrixAt(sceneStore.getIndex(receiver->getStoreId()));
+   int axis;
+   for (axis = 0; axis < 3; axis++)
+   {
+      minimum[axis] = 1.0e30f;
+      maximum[axis] = -1.0e30f;
+   }
+   for (int corner = 0; corner < 8; corner++)
+   {
+      float point[3] =
+      {
+         corner & 1 ? bounds.maximum.x : bounds.minimum.x,
+         corner & 2 ? bounds.maximum.y : bounds.minimum.y,
+         corner & 4 ? bounds.maximum.z : bounds.minimum.z
+      };
+      for (axis = 0; axis < 3; axis++)
+      {
+         float value = world[axis] * point[0] + world[4 + axis] * point[1] +
+            world[8 + axis] * point[2] + world[12 + axis];
+         if (value < minimum[axis]) minimum[axis] = value;
+         if (value > maximum[axis]) maximum[axis] = value;
+      }
+   }
+
+   float size = 0.0;
+   for (axis = 0; axis < 3; axis++)
+   {
+      if (maximum[axis] - minimum[axis] > size)
+         size = maximum[axis] - minimum[axis];
+   }
+   for (axis = 0; axis < 3; axis++)
+   {
+      minimum[axis] -= size * RECEIVER_BOX_SLACK;
+      maximum[axis] += size * RECEIVER_BOX_SLACK;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Test if a model has stayed still long enough for its shadows to be cached
+  */
+bool PlanarProjectedShadowScene::isStatic(Model3D *aModel) const
+{
+   return sceneStore.getStillUpdatesAt(sceneStore.getIndex(aModel->getStoreId())) >= STATIC_UPDATES;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Check the cached static shadows of each receiver and light, drawing them
+   again where the light, the receiver or a cached caster has moved, or a
+   caster has just settled where its shadow can reach the receiver.  Only
+   static receivers are cached.
+  */
+void PlanarProjectedShadowScene::updateShadowCaches()
+{
+   int numLights = pointLightList.size();
+   int numReceivers = shadowReceiverList.size();
+   int index;
+   if (shadowCaches.size() != numReceivers * numLights)
+   {
+      for (index = 0; index < shadowCaches.size(); index++)
+      {
+         if (shadowCaches[index].textureId)
+            glDeleteTextures(1, &shadowCaches[index].textureId);
+      }
+      shadowCaches.resize(numReceivers * numLights);
+      for (index = 0; index < shadowCaches.size(); index++)
+      {
+         shadowCaches[index].textureId = 0;
+         shadowCaches[index].valid = false;
+      }
+   }
+
+   settledCasters.clear();
+   for (index = 0; index < shadowCasterList.size(); index++)
+   {
+      Model3D *caster = shadowCasterList[index];
+      if (sceneStore.getStillUpdatesAt(sceneStore.getIndex(caster->getStoreId())) == STATIC_UPDATES)
+         settledCasters.push_back(caster);
+   }
+
+   for (index = 0; index < numReceivers; index++)
+   {
+      const ReceiverPlane &receiverPlane = receiverPlanes[index];
+      bool receiverStatic = isStatic(receiverPlane.receiver);
+      for (int lightIndex = 0; lightIndex < numLights; lightIndex++)
+      {
+         ShadowCache &cache = shadowCaches[index * numLights + lightIndex];
+         if (!receiverStatic || isEmptyLightSlot(lightIndex))
+         {
+            cache.valid = false;
+            continue;
+         }
+
+         const Vector3D &light = pointLightList[lightIndex];
+         bool valid = cache.valid && cache.receiver == receiverPlane.receiver &&
+            cache.modelsRemoved == modelsRemoved &&
+            cache.light.x == light.x && cache.light.y == light.y && cache.light.z == light.z;
+         int caster;
+         for (caster = 0; valid && caster < cache.casters.size(); caster++)
+            valid = isStatic(cache.casters[caster]);
+         for (caster = 0; valid && caster < settledCasters.size(); caster++)
+            valid = !canShadowReceiver(settledCasters[caster], receiverPlane, light, false);
+         if (!valid)
+            bakeShadowCache(index, lightIndex);
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the shadows of the static casters that can reach a receiver into
+   its cache texture.  The texture lies across the receiver plane, over the
+   receiver's box, and is cleared to clear and drawn opaque where there is
+   shadow.  The camera's viewport, matrices and clear color are put back
+   after.
+
+  @param receiverIndex The receiver
+  @param lightIndex The light
+  */
+void PlanarProjectedShadowScene::bakeShadowCache(int receiverIndex, int lightIndex)
+{
+   ShadowCache &cache = shadowCaches[receiverIndex * pointLightList.size() + lightIndex];
+   const ReceiverPlane &receiverPlane = receiverPlanes[receiverIndex];
+   const Vector3D &light = pointLightList[lightIndex];
+   cache.receiver = receiverPlane.receiver;
+   cache.light = light;
+   cache.modelsRemoved = modelsRemoved;
+   cache.valid = true;
+   cachesBaked++;
+
+   // the static casters whose shadows can reach the receiver, sorted so the
+   // frames can find them
+   cache.casters.clear();
+   int index;
+   for (index = 0; index < shadowCasterList.size(); index++)
+   {
+      Model3D *caster = shadowCasterList[index];
+      if (isStatic(caster) && canShadowReceiver(caster, receiverPlane, light, false))
+         cache.casters.push_back(caster);
+   }
+   std::sort(cache.casters.begin(), cache.casters.end());
+   if (cache.casters.empty())
+      return;
+
+   // two axes across the plane, from the world axis most across it
+   const float *plane = receiverPlane.plane;
+   float length = (float)sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+   float normal[3] = {plane[0] / length, plane[1] / length, plane[2] / length};
+   int axis = 0;
+   if (fabs(normal[1]) < fabs(normal[axis])) axis = 1;
+   if (fabs(normal[2]) < fabs(normal[axis])) axis = 2;
+   float worldAxis[3] = {0.0, 0.0, 0.0};
+   worldAxis[axis] = 1.0;
+   float across[3] =
+   {
+      normal[1] * worldAxis[2] - normal[2] * worldAxis[1],
+      normal[2] * worldAxis[0] - normal[0] * worldAxis[2],
+      normal[0] * worldAxis[1] - normal[1] * worldAxis[0]
+   };
+   length = (float)sqrt(across[0] * across[0] + across[1] * across[1] + across[2] * across[2]);
+   across[0] /= length;
+   across[1] /= length;
+   across[2] /= length;
+   float along[3] =
+   {
+      normal[1] * across[2] - normal[2] * across[1],
+      normal[2] * across[0] - normal[0] * across[2],
+      normal[0] * across[1] - normal[1] * across[0]
+   };
+
+   // the texture covers the receiver's box
+   float sMinimum = 1.0e30f, sMaximum = -1.0e30f, tMinimum = 1.0e30f, tMaximum = -1.0e30f;
+   for (int corner = 0; corner < 8; corner++)
+   {
+      float point[3] =
+      {
+         corner & 1 ? receiverPlane.maximum[0] : receiverPlane.minimum[0],
+         corner & 2 ? receiverPlane.maximum[1] : receiverPlane.minimum[1],
+         corner & 4 ? receiverPlane.maximum[2] : receiverPlane.minimum[2]
+      };
+      float s = across[0] * point[0] + across[1] * point[1] + across[2] * point[2];
+      float t = along[0] * point[0] + along[1] * point[1] + along[2] * point[2];
+      if (s < sMinimum) sMinimum = s;
+      if (s > sMaximum) sMaximum = s;
+      if (t < tMinimum) tMinimum = t;
+      if (t > tMaximum) tMaximum = t;
+   }
+   for (axis = 0; axis < 3; axis++)
+   {
+      cache.sPlane[axis] = across[axis] / (sMaximum - sMinimum);
+      cache.tPlane[axis] = along[axis] / (tMaximum - tMinimum);
+   }
+   cache.sPlane[3] = -sMinimum / (sMaximum - sMinimum);
+   cache.tPlane[3] = -tMinimum / (tMaximum - tMinimum);
+
+   if (!cache.textureId)
+   {
+      glGenTextures(1, &cache.textureId);
+      renderState.setTexture(cache.textureId);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SHADOW_CACHE_SIZE, SHADOW_CACHE_SIZE, 0,
+         GL_RGBA, GL_UNSIGNED_BYTE, 0);
+   }
+
+   GLint viewport[4];
+   glGetIntegerv(GL_VIEWPORT, viewport);
+   float clearColor[4];
+   glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, cacheFramebufferId);
+   GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cache.textureId, 0);
+   glViewport(0, 0, SHADOW_CACHE_SIZE, SHADOW_CACHE_SIZE);
+   glClearColor(1.0, 1.0, 1.0, 0.0);
+   glClear(GL_COLOR_BUFFER_BIT);
+
+   // look straight down onto the plane
+   float view[16] =
+   {
+      across[0], along[0], normal[0], 0.0,
+      across[1], along[1], normal[1], 0.0,
+      across[2], along[2], normal[2], 0.0,
+      0.0, 0.0, 0.0, 1.0
+   };
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glOrtho(sMinimum, sMaximum, tMinimum, tMaximum, -SHADOW_CACHE_DEPTH, SHADOW_CACHE_DEPTH);
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadMatrixf(view);
+
+   renderState.setLighting(false);
+   renderState.setTexture(0);
+   renderState.setBlend(false);
+   renderState.setStencilTest(false);
+   renderState.setColor(0.0, 0.0, 0.0, 1.0);
+   glDisable(GL_DEPTH_TEST);
+   const float *shadowMatrix = getShadowMatrix(receiverIndex, lightIndex);
+   float casterMatrix[16];
+   for (index = 0; index < cache.casters.size(); index++)
+   {
+      Model3D *caster = cache.casters[index];
+      int storeIndex = sceneStore.getIndex(caster->getStoreId());
+      multiplyMatrices(shadowMatrix, sceneStore.getWorldMatrixAt(storeIndex), casterMatrix);
+      glPushMatrix();
+      glMultMatrixf(casterMatrix);
+      ConvexHull *proxy = findShadowProxy(caster);
+      if (proxy)
+      {
+         glEnableClientState(GL_VERTEX_ARRAY);
+         glVertexPointer(3, GL_FLOAT, 0, proxy->getVertices());
+         glDrawElements(GL_TRIANGLES, proxy->getNumTriangles() * 3, GL_UNSIGNED_INT, proxy->getTriangles());
+         glDisableClientState(GL_VERTEX_ARRAY);
+      }
+      else
+         glCallList(sceneStore.getMeshIdAt(storeIndex));
+      glPopMatrix();
+   }
+   glEnable(GL_DEPTH_TEST);
+
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+   glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+   glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Take the casters a receiver's cache has drawn out of receiverCasters,
+   their shadows come from the cache
+  */
+void PlanarProjectedShadowScene::removeCachedCasters(const ShadowCache &cache)
+{
+   int kept = 0;
+   for (int index = 0; index < receiverCasters.size(); index++)
+   {
+      if (!std::binary_search(cache.casters.begin(), cache.casters.end(), receiverCasters[index]))
+         receiverCasters[kept++] = receiverCasters[index];
+   }
+   receiverCasters.resize(kept);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Mark a receiver's pixels that are in its cached shadows as shadowed, by
+   drawing the receiver again with the cache texture laid across it and
+   keeping the pixels where the texture is opaque
+
+  @param receiverIndex The receiver
+  @param lightIndex The light
+  @param receiverId The receiver's stencil id
+  */
+void PlanarProjectedShadowScene::markCachedShadows(int receiverIndex, int lightIndex, int receiverId)
+{
+   const ShadowCache &cache = shadowCaches[receiverIndex * pointLightList.size() + lightIndex];
+   glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+   glDepthMask(GL_FALSE);
+   glDepthFunc(GL_LEQUAL);
+   renderState.setStencilFunc(GL_EQUAL, receiverId | SHADOWED_MASK, RECEIVER_ID_MASK);
+   renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+   renderState.setStencilWriteMask(SHADOWED_MASK);
+   renderState.setTexture(cache.textureId);
+   renderState.setColor(1.0, 1.0, 1.0, 1.0);
+
+   // the planes are in the world, the modelview only holds the camera here
+   glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+   glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+   glTexGenfv(GL_S, GL_EYE_PLANE, cache.sPlane);
+   glTexGenfv(GL_T, GL_EYE_PLANE, cache.tPlane);
+   glEnable(GL_TEXTURE_GEN_S);
+   glEnable(GL_TEXTURE_GEN_T);
+   glEnable(GL_ALPHA_TEST);
+   glAlphaFunc(GL_GREATER, 0.5);
+
+   int storeIndex = sceneStore.getIndex(receiverPlanes[receiverIndex].receiver->getStoreId());
+   glPushMatrix();
+   glMultMatrixf(sceneStore.getWorldMatrixAt(storeIndex));
+   glCallList(sceneStore.getMeshIdAt(storeIndex));
+   glPopMatrix();
+
+   glDisable(GL_ALPHA_TEST);
+   glDisable(GL_TEXTURE_GEN_S);
+   glDisable(GL_TEXTURE_GEN_T);
+   renderState.setTexture(0);
+   renderState.setColor(0.0, 0.0, 0.0, SHADOW_ALPHA);
+   glDepthFunc(GL_LESS);
+   glDepthMask(GL_TRUE);
+   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Bring the receiver planes and the shadow matrices up to date.  A plane is
+   found again when its receiver's world matrix or sphere differ from the
+   ones it was found from (or a different model is in its place), a matrix
+   is made again when its plane or its light moves.
+*/
+void PlanarProjectedShadowScene::updateShadowMatrices()
+{
+   matricesRebuilt = 0;
+   int numLights = pointLightList.size();
+   int numReceivers = shadowReceiverList.size();
+   bool rebuildAll = matrixLights.size() != numLights ||
+      shadowMatrices.size() != numReceivers * numLights * 16;
+   if (rebuildAll)
+   {
+      matrixLights = pointLightList;
+      shadowMatrices.resize(numReceivers * numLights * 16);
+   }
+   receiverPlanes.resize(numReceivers);
+
+   // which lights moved since their matrices were made
+   unsigned char *lightMoved = (unsigned char*)frameArena.allocate(numLights + 1);
+   int lightIndex;
+   for (lightIndex = 0; lightIndex < numLights; lightIndex++)
+   {
+      const Vector3D &light = pointLightList[lightIndex];
+      Vector3D &cached = matrixLights[lightIndex];
+      bool moved = rebuildAll || light.x != cached.x || light.y != cached.y || light.z != cached.z;
+      lightMoved[lightIndex] = moved ? 1 : 0;
+      cached = light;
+   }
+
+   for (int index = 0; index < numReceivers; index++)
+   {
+      ReceiverPlane &receiverPlane = receiverPlanes[index];
+      Model3D *receiver = shadowReceiverList[index];
+      int storeIndex = sceneStore.getIndex(receiver->getStoreId());
+      const float *world = sceneStore.getWorldMatrixAt(storeIndex);
+      const float *sphere = sceneStore.getWorldSphereAt(storeIndex);
+      bool receiverMoved = rebuildAll || receiverPlane.receiver != receiver ||
+         memcmp(receiverPlane.world, world, 16 * sizeof(float)) != 0 ||
+         memcmp(receiverPlane.sphere, sphere, 4 * sizeof(float)) != 0;
+      if (receiverMoved)
+      {
+         receiverPlane.receiver = receiver;
+         memcpy(receiverPlane.world, world, 16 * sizeof(float));
+         memcpy(receiverPlane.sphere, sphere, 4 * sizeof(float));
+         findReceiverPlane(receiver, receiverPlane.plane);
+         findReceiverBox(receiver, receiverPlane.minimum, receiverPlane.maximum);
+      }
+
+      for (lightIndex = 0; lightIndex < numLights; lightIndex++)
+      {
+         if (!receiverMoved && !lightMoved[lightIndex])
+            continue;
+         const Vector3D &light = pointLightList[lightIndex];
+         float tempLight[4] = {light.x, light.y, light.z, 1.0};
+         FTM shadowMatrix = calculateShadowTransformation(receiverPlane.plane, tempLight);
+         float *matrix = &shadowMatrices[(index * numLights + lightIndex) * 16];
+         matrix[0] = shadowMatrix._00; matrix[1] = shadowMatrix._01; matrix[2] = shadowMatrix._02; matrix[3] = shadowMatrix._03;
+         matrix[4] = shadowMatrix._10; matrix[5] = shadowMatrix._11; matrix[6] = shadowMatrix._12; matrix[7] = shadowMatrix._13;
+         matrix[8] = shadowMatrix._20; matrix[9] = shadowMatrix._21; matrix[10] = shadowMatrix._22; matrix[11] = shadowMatrix._23;
+         matrix[12] = shadowMatrix._30; matrix[13] = shadowMatrix._31; matrix[14] = shadowMatrix._32; matrix[15] = shadowMatrix._33;
+         matricesRebuilt++;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The matrix that projects onto a receiver's plane from a light
+
+  @param receiverIndex The receiver's place in the receiver list
+  @param lightIndex The light's place in the light list
+  @return The matrix, in the order openGL takes it
+*/
+const float* PlanarProjectedShadowScene::getShadowMatrix(int receiverIndex, int lightIndex) const
+{
+   return &shadowMatrices[(receiverIndex * pointLightList.size() + lightIndex) * 16];
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the plane of a receiver in the world.  A receiver with mesh data
+   takes its plane from its triangles (their normals added together, so a
+   nearly flat mesh gives its average plane).  One without, or whose
+   normals cancel out (a closed mesh), takes the flat side of its bounds:
+   the plane through their center across the axis they are thinnest along.
+
+  @param receiver The receiver
+  @param plane Set to the plane (4 floats)
+*/
+void PlanarProjectedShadowScene::findReceiverPlane(Model3D *receiver, float *plane)
+{
+   float normal[3] = {0.0, 0.0, 0.0};
+   float point[3];
+   EdgeMesh *mesh = findEdgeMesh(receiver);
+   int axis;
+   bool fromMesh = false;
+   if (mesh->getNumTriangles() > 0)
+   {
+      float totalLength = 0.0;
+      const float *vertices = mesh->getVertices();
+      const int *triangles = mesh->getTriangles();
+      for (int index = 0; index < mesh->getNumTriangles() * 3; index += 3)
+      {
+         const float *a = vertices + triangles[index] * 3;
+         const float *b = vertices + triangles[index + 1] * 3;
+         const float *c = vertices + triangles[index + 2] * 3;
+         float edge0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+         float edge1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+         float cross[3] =
+         {
+            edge0[1] * edge1[2] - edge0[2] * edge1[1],
+            edge0[2] * edge1[0] - edge0[0] * edge1[2],
+            edge0[0] * edge1[1] - edge0[1] * edge1[0]
+         };
+         for (axis = 0; axis < 3; axis++)
+            normal[axis] += cross[axis];
+         totalLength += (float)sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+      }
+      for (axis = 0; axis < 3; axis++)
+         point[axis] = vertices[triangles[0] * 3 + axis];
+      float length = (float)sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+      fromMesh = length > FLAT_RECEIVER_TOLERANCE * totalLength;
+   }
+   if (!fromMesh)
+   {
+      normal[0] = 0.0;
+      normal[1] = 0.0;
+      normal[2] = 0.0;
+      BoundingVolume bounds = receiver->getBounds();
+      float extent[3] =
+      {
+         bounds.maximum.x - bounds.minimum.x,
+         bounds.maximum.y - bounds.minimum.y,
+         bounds.maximum.z - bounds.minimum.z
+      };
+      int thinnest = 0;
+      for (axis = 1; axis < 3; axis++)
+      {
+         if (extent[axis] < extent[thinnest])
+            thinnest = axis;
+      }
+      normal[thinnest] = 1.0;
+      point[0] = bounds.center.x;
+      point[1] = bounds.center.y;
+      point[2] = bounds.center.z;
+   }
+
+   // into the world, the world matrix is a rotation and a translation
+   const float *world = sceneStore.getWorldMatrixAt(sceneStore.getIndex(receiver->getStoreId()));
+   for (axis = 0; axis < 3; axis++)
+   {
+      plane[axis] = world[axis] * normal[0] + world[4 + axis] * normal[1] + world[8 + axis] * normal[2];
+   }
+   float worldPoint[3];
+   for (axis = 0; axis < 3; axis++)
+   {
+      worldPoint[axis] = world[axis] * point[0] + world[4 + axis] * point[1] +
+         world[8 + axis] * point[2] + world[12 + axis];
+   }
+   plane[3] = -(plane[0] * worldPoint[0] + plane[1] * worldPoint[1] + plane[2] * worldPoint[2]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Multiply two matrices in the order openGL keeps them (column by column),
+   the result applies the second and then the first
+
+  @param first The matrix on the left
+  @param second The matrix on the right
+  @param result Set to the product, it must not be either matrix
+*/
+void PlanarProjectedShadowScene::multiplyMatrices(const float *first, const float *second, float *result)
+{
+   for (int column = 0; column < 4; column++)
+   {
+      for (int row = 0; row < 4; row++)
+      {
+         result[column * 4 + row] =
+            first[row] * second[column * 4] +
+            first[4 + row] * second[column * 4 + 1] +
+            first[8 + row] * second[column * 4 + 2] +
+            first[12 + row] * second[column * 4 + 3];
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Calculate a plane that transforms objects onto the argument plane
+  We also pass in a 4D light position.
+
+  @param projectionPlane The plane to project onto
+  @param lightPosition The position we are projecting
+  @return Shadow frame transformation matrix
+*/
+FTM PlanarProjectedShadowScene::calculateShadowTransformation(float* projectionPlane, float* lightPosition)
+{
+   float dotProduct =
+      projectionPlane[0] * lightPosition[0] +
+      projectionPlane[1] * lightPosition[1] +
+      projectionPlane[2] * lightPosition[2] +
+      projectionPlane[3] * lightPosition[3];
+
+   FTM shadowMatrix;
+
+   shadowMatrix._00 = dotProduct - lightPosition[0] * projectionPlane[0];
+   shadowMatrix._10 = 0.0 - lightPosition[0] * projectionPlane[1];
+   shadowMatrix._20 = 0.0 - lightPosition[0] * projectionPlane[2];
+   shadowMatrix._30 = 0.0 - lightPosition[0] * projectionPlane[3];
+
+   shadowMatrix._01 = 0.0 - lightPosition[1] * projectionPlane[0];
+   shadowMatrix._11 = dotProduct - lightPosition[1] * projectionPlane[1];
+   shadowMatrix._21 = 0.0 - lightPosition[1] * projectionPlane[2];
+   shadowMatrix._31 = 0.0 - lightPosition[1] * projectionPlane[3];
+
+   shadowMatrix._02 = 0.0 - lightPosition[2] * projectionPlane[0];
+   shadowMatrix._12 = 0.0 - lightPosition[2] * projectionPlane[1];
+   shadowMatrix._22 = dotProduct - lightPosition[2] * projectionPlane[2];
+   shadowMatrix._32 = 0.0 - lightPosition[2] * projectionPlane[3];
+
+   shadowMatrix._03 = 0.0 - lightPosition[3] * projectionPlane[0];
+   shadowMatrix._13 = 0.0 - lightPosition[3] * projectionPlane[1];
+   shadowMatrix._23 = 0.0 - lightPosition[3] * projectionPlane[2];
+   shadowMatrix._33 = dotProduct - lightPosition[3] * projectionPlane[3];
+
+   return shadowMatrix;
+}
+}
@@ -1,32 +1,145 @@
-#ifndef PLANARPROJECTEDSHADOWSCENE_H
-#define PLANARPROJECTEDSHADOWSCENE_H
-//-----------------------------------------------------------------------------
-#include <vector>
-#include "ShadowableScene.h"
-#include "FTM.h"
-
-namespace SML_CORE
-{
-// forward declare
-class Model3D;
-
-/**
-  This class is a specalized ShadowableScene class that provides the ability
-  to render projected planar shadows.
-
-  @author Jason Dudash
-*/
-class PlanarProjectedShadowScene : public ShadowableScene
-{
-private:
-   void renderModelListAsShadows(const std::vector<Model3D*> &modelList, FTM shadowMatrix);
-   void drawShadows();
-   FTM calculateShadowTransformation(float* projectionPlane, float* lightPosition);
-   float* calculatePlaneFromPoints(float p0[3], float p1[3], float p2[3]);
-
-public:
-	PlanarProjectedShadowScene();
-	virtual ~PlanarProjectedShadowScene();
-};
-}
-#endif
+#ifndef PLANARPROJECTEDSHADOWSCENE_H
+#define PLANARPROJECTEDSHADOWSCENE_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "ShadowableScene.h"
+#include "FTM.h"
+
+namespace SML_CORE
+{
+// forward declare
+class Model3D;
+
+/**
+  This class is a specalized ShadowableScene class that provides the ability
+  to render projected planar shadows.
+
+  Casters with mesh data are shadowed by their silhouette from the light:
+  the outline is projected as one polygon, filled through the stencil buffer
+  (it needn't be convex), instead of projecting every triangle of the
+  caster.  Casters without mesh data are projected whole.  The outlines are
+  kept in the casters' model space and the shadow scheduler decides which
+  are found again each frame (see ShadowScheduler).
+
+  Any number of flat receivers can be shadowed.  Each receiver's pixels are
+  marked with its own id in the stencil buffer and the shadows projected
+  onto its plane are kept to them (and to a scissor around it).  Shadowed
+  pixels are marked first and darkened once after, so overlapping shadows
+  don't darken twice.  This needs an 8 bit stencil buffer, without one the
+  shadows are drawn unclipped.
+
+  A caster is only projected onto a receiver its shadow can fall on: its
+  bounds are projected from the light onto the receiver plane and the
+  footprint has to touch the receiver's box and the view.
+
+  A caster whose convex hull is close to its mesh has the hull drawn in its
+  place (a few dozen triangles), see ShadowableScene::findShadowProxy.
+
+  Casters and receivers that have stayed still for a while are static.  The
+  shadows static casters throw on a static receiver are drawn once into a
+  texture laid across the receiver (with framebuffer objects) and that
+  texture marks them each frame, only the casters still moving (and the
+  fireballs) are projected again.  The light, the receiver or a cached
+  caster moving, or a caster settling, draws the texture again.
+
+  Each receiver's plane is taken from its geometry and kept, with the
+  matrix that projects onto it from each light, until the receiver or the
+  light moves.
+
+  @author Jason Dudash
+*/
+class PlanarProjectedShadowScene : public ShadowableScene
+{
+private:
+   /** A caster's outline, in its model space, and the shadow and world
+       matrices it is drawn through multiplied together */
+   class OutlineRange
+   {
+   public:
+      float matrix[16];
+      const float *vertices;
+      int count;
+   };
+
+   /** A receiver's plane and box in the world, kept until the receiver
+       moves */
+   class ReceiverPlane
+   {
+   public:
+      Model3D *receiver;
+      float world[16];
+      float sphere[4];
+      float plane[4];
+      float minimum[3];
+      float maximum[3];
+   };
+
+   /** The shadows the static casters throw onto a static receiver from a
+       light, drawn once into a texture across the receiver plane and kept
+       until the light, the receiver or one of the casters moves */
+   class ShadowCache
+   {
+   public:
+      unsigned int textureId;
+      float sPlane[4];
+      float tPlane[4];
+      Vector3D light;
+      Model3D *receiver;
+      int modelsRemoved;
+      std::vector<Model3D*> casters;
+      bool valid;
+   };
+
+   std::vector< std::vector<Model3D*> > visibleCasters;
+   bool initialized;
+   bool stencilSupported;
+   bool outlinesSupported;
+   std::vector<int> silhouette;
+   std::vector<OutlineRange> outlineRanges;
+   std::vector<ReceiverPlane> receiverPlanes;
+   std::vector<Vector3D> matrixLights;
+   std::vector<float> shadowMatrices;
+   int matricesRebuilt;
+   float cameraProjection[16];
+   int viewport[4];
+   std::vector<float> scissorPoints;
+   std::vector<Model3D*> receiverCasters;
+   bool cachingSupported;
+   unsigned int cacheFramebufferId;
+   std::vector<ShadowCache> shadowCaches;
+   std::vector<Model3D*> settledCasters;
+   int cachesBaked;
+
+   void initialize();
+   void updateShadowMatrices();
+   void findReceiverPlane(Model3D *receiver, float *plane);
+   void findReceiverBox(Model3D *receiver, float *minimum, float *maximum);
+   void findReceiverCasters(int receiverIndex, int lightIndex);
+   bool canShadowReceiver(Model3D *caster, const ReceiverPlane &receiverPlane, const Vector3D &lightPosition,
+                          bool checkView=true) const;
+   bool isStatic(Model3D *aModel) const;
+   void updateShadowCaches();
+   void bakeShadowCache(int receiverIndex, int lightIndex);
+   void markCachedShadows(int receiverIndex, int lightIndex, int receiverId);
+   void removeCachedCasters(const ShadowCache &cache);
+   const float* getShadowMatrix(int receiverIndex, int lightIndex) const;
+   void renderModelListAsShadows(const std::vector<Model3D*> &modelList, const float *shadowMatrix,
+                                 int lightIndex, int receiverId);
+   void markOutlines(int receiverId);
+   void markReceivers(int first, int last);
+   void darkenShadows(int receiverId);
+   bool findReceiverRectangle(Model3D *receiver, int *rectangle);
+   bool addOutline(Model3D *aModel, const float *shadowMatrix, int lightIndex);
+   void drawOutlines();
+   void drawShadows();
+   FTM calculateShadowTransformation(float* projectionPlane, float* lightPosition);
+   static void multiplyMatrices(const float *first, const float *second, float *result);
+
+public:
+	PlanarProjectedShadowScene();
+	virtual ~PlanarProjectedShadowScene();
+   int getMatricesRebuilt() const {return matricesRebuilt;};
+   int getCachesBaked() const {return cachesBaked;};
+};
+}
+#endif
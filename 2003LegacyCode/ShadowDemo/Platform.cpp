@@ -0,0 +1,210 @@
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/time.h>
+#endif
+
+namespace SML_CORE
+{
+/** What a thread is started with */
+class ThreadStart
+{
+public:
+   ThreadFunction function;
+   void *data;
+};
+
+#ifdef _WIN32
+//-----------------------------------------------------------------------------
+// the windows versions
+//-----------------------------------------------------------------------------
+static unsigned int __stdcall threadMain(void *start)
+{
+   ThreadStart threadStart = *(ThreadStart*)start;
+   delete (ThreadStart*)start;
+   threadStart.function(threadStart.data);
+   return 0;
+}
+
+void* startThread(ThreadFunction function, void *data)
+{
+   ThreadStart *start = new ThreadStart;
+   start->function = function;
+   start->data = data;
+   return (void*)_beginthreadex(NULL, 0, threadMain, start, 0, NULL);
+}
+
+void joinThread(void *thread)
+{
+   WaitForSingleObject((HANDLE)thread, INFINITE);
+   CloseHandle((HANDLE)thread);
+}
+
+void yieldThread() {Sleep(0);}
+void sleepThread(int milliseconds) {Sleep(milliseconds > 0 ? milliseconds : 0);}
+
+int getNumProcessors()
+{
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+}
+
+void* createLock()
+{
+   CRITICAL_SECTION *section = new CRITICAL_SECTION;
+   InitializeCriticalSection(section);
+   return section;
+}
+
+void destroyLock(void *lock)
+{
+   DeleteCriticalSection((CRITICAL_SECTION*)lock);
+   delete (CRITICAL_SECTION*)lock;
+}
+
+void lockMutex(void *lock) {EnterCriticalSection((CRITICAL_SECTION*)lock);}
+void unlockMutex(void *lock) {LeaveCriticalSection((CRITICAL_SECTION*)lock);}
+
+void* createSemaphore() {return CreateSemaphore(NULL, 0, 0x7fffffff, NULL);}
+void destroySemaphore(void *semaphore) {CloseHandle((HANDLE)semaphore);}
+void signalSemaphore(void *semaphore) {ReleaseSemaphore((HANDLE)semaphore, 1, NULL);}
+void waitSemaphore(void *semaphore) {WaitForSingleObject((HANDLE)semaphore, INFINITE);}
+
+long atomicExchange(volatile long *target, long value)
+{
+   return InterlockedExchange((LONG*)target, value);
+}
+
+long atomicAdd(volatile long *target, long value)
+{
+   return InterlockedExchangeAdd((LONG*)target, value);
+}
+
+double getPreciseMilliseconds()
+{
+   static LARGE_INTEGER frequency;
+   static LARGE_INTEGER start;
+   static bool started = false;
+   LARGE_INTEGER now;
+   if (!started)
+   {
+      QueryPerformanceFrequency(&frequency);
+      QueryPerformanceCounter(&start);
+      started = true;
+   }
+   QueryPerformanceCounter(&now);
+   return (double)(now.QuadPart - start.QuadPart) * 1000.0 / (double)frequency.QuadPart;
+}
+
+#else
+//-----------------------------------------------------------------------------
+// the posix versions
+//-----------------------------------------------------------------------------
+static void* threadMain(void *start)
+{
+   ThreadStart threadStart = *(ThreadStart*)start;
+   delete (ThreadStart*)start;
+   threadStart.function(threadStart.data);
+   return 0;
+}
+
+void* startThread(ThreadFunction function, void *data)
+{
+   ThreadStart *start = new ThreadStart;
+   start->function = function;
+   start->data = data;
+   pthread_t *thread = new pthread_t;
+   pthread_create(thread, NULL, threadMain, start);
+   return thread;
+}
+
+void joinThread(void *thread)
+{
+   pthread_join(*(pthread_t*)thread, NULL);
+   delete (pthread_t*)thread;
+}
+
+void yieldThread() {sched_yield();}
+void sleepThread(int milliseconds) {usleep(milliseconds > 0 ? milliseconds * 1000 : 0);}
+
+int getNumProcessors()
+{
+   int numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+   return numProcessors > 0 ? numProcessors : 1;
+}
+
+void* createLock()
+{
+   pthread_mutex_t *mutex = new pthread_mutex_t;
+   pthread_mutex_init(mutex, NULL);
+   return mutex;
+}
+
+void destroyLock(void *lock)
+{
+   pthread_mutex_destroy((pthread_mutex_t*)lock);
+   delete (pthread_mutex_t*)lock;
+}
+
+void lockMutex(void *lock) {pthread_mutex_lock((pthread_mutex_t*)lock);}
+void unlockMutex(void *lock) {pthread_mutex_unlock((pthread_mutex_t*)lock);}
+
+void* createSemaphore()
+{
+   sem_t *semaphore = new sem_t;
+   sem_init(semaphore, 0, 0);
+   return semaphore;
+}
+
+void destroySemaphore(void *semaphore)
+{
+   sem_destroy((sem_t*)semaphore);
+   delete (sem_t*)semaphore;
+}
+
+void signalSemaphore(void *semaphore) {sem_post((sem_t*)semaphore);}
+void waitSemaphore(void *semaphore) {while (sem_wait((sem_t*)semaphore) != 0);}
+
+long atomicExchange(volatile long *target, long value)
+{
+   // test and set is only an acquire barrier, make it a full one
+   __sync_synchronize();
+   return __sync_lock_test_and_set(target, value);
+}
+
+long atomicAdd(volatile long *target, long value)
+{
+   return __sync_fetch_and_add(target, value);
+}
+
+double getPreciseMilliseconds()
+{
+   static struct timeval start;
+   static bool started = false;
+   struct timeval now;
+   if (!started)
+   {
+      gettimeofday(&start, NULL);
+      started = true;
+   }
+   gettimeofday(&now, NULL);
+   return (now.tv_sec - start.tv_sec) * 1000.0 + (now.tv_usec - start.tv_usec) / 1000.0;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// the same clock in whole milliseconds
+//-----------------------------------------------------------------------------
+int getMilliseconds()
+{
+   return (int)getPreciseMilliseconds();
+}
+}
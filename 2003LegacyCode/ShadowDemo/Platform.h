@@ -0,0 +1,46 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+//-----------------------------------------------------------------------------
+
+namespace SML_CORE
+{
+/**
+  The few operating system calls the engine needs to run on more than one
+  thread: threads, locks, semaphores, atomic exchange and add and a clock.
+  They are plain functions over opaque handles, implemented with the Win32
+  API on windows and with posix threads everywhere else.
+*/
+
+/** The entry point of a thread started with startThread */
+typedef void (*ThreadFunction)(void *data);
+
+// threads
+void* startThread(ThreadFunction function, void *data);
+void joinThread(void *thread);
+void yieldThread();
+void sleepThread(int milliseconds);
+int getNumProcessors();
+
+// locks (a mutex that one thread holds at a time)
+void* createLock();
+void destroyLock(void *lock);
+void lockMutex(void *lock);
+void unlockMutex(void *lock);
+
+// counting semaphores
+void* createSemaphore();
+void destroySemaphore(void *semaphore);
+void signalSemaphore(void *semaphore);
+void waitSemaphore(void *semaphore);
+
+// swap a value in, with a full memory barrier, and return the old value
+long atomicExchange(volatile long *target, long value);
+
+// add to a value, with a full memory barrier, and return the old value
+long atomicAdd(volatile long *target, long value);
+
+// milliseconds since the first call (a high resolution clock)
+int getMilliseconds();
+double getPreciseMilliseconds();
+}
+#endif
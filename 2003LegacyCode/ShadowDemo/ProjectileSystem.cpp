@@ -0,0 +1,190 @@
+#include <math.h>
+#include <string.h>
+#include "ProjectileSystem.h"
+#include "JobSystem.h"
+
+namespace SML_CORE
+{
+// used to convert degrees to radians
+static const float DEGREES_TO_RADIANS = 3.14159265f / 180.0f;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor.  All the memory the pool will ever use is allocated here.
+
+  @param maxProjectiles The most projectiles that can be alive at once
+  */
+ProjectileSystem::ProjectileSystem(int maxProjectiles) :
+capacity(maxProjectiles),
+numActive(0),
+numExpired(0),
+turnRate(0.0),
+stepSeconds(0.0),
+stepCos(1.0),
+stepSin(0.0),
+textureId(0),
+positionX(maxProjectiles),
+positionY(maxProjectiles),
+positionZ(maxProjectiles),
+previousX(maxProjectiles),
+previousY(maxProjectiles),
+previousZ(maxProjectiles),
+velocityX(maxProjectiles),
+velocityY(maxProjectiles),
+velocityZ(maxProjectiles),
+lifetime(maxProjectiles),
+radius(maxProjectiles)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+ProjectileSystem::~ProjectileSystem()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start a new projectile
+
+  @param position Where the projectile starts
+  @param velocity How far the projectile moves each second
+  @param life How many seconds the projectile lives
+  @param size The radius of the projectile
+  @return false if the pool is full (nothing is spawned)
+  */
+bool ProjectileSystem::spawn(const Vector3D &position, const Vector3D &velocity, float life, float size)
+{
+   if (numActive == capacity)
+      return false;
+
+   int index = numActive++;
+   positionX[index] = position.x;
+   positionY[index] = position.y;
+   positionZ[index] = position.z;
+   previousX[index] = position.x;
+   previousY[index] = position.y;
+   previousZ[index] = position.z;
+   velocityX[index] = velocity.x;
+   velocityY[index] = velocity.y;
+   velocityZ[index] = velocity.z;
+   lifetime[index] = life;
+   radius[index] = size;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Move every live projectile forward in time and remove the ones that have
+   run out of life.  The moving is split across the job system's threads
+   when one is given, the removal is done on this thread.
+
+  @param seconds The time step
+  @param jobs The job system to spread the work over (0 to do it here)
+  */
+void ProjectileSystem::update(float seconds, JobSystem *jobs)
+{
+   stepSeconds = seconds;
+   float angle = turnRate * DEGREES_TO_RADIANS * seconds;
+   stepCos = (float)cos(angle);
+   stepSin = (float)sin(angle);
+
+   numExpired = 0;
+   if (numActive == 0)
+      return;
+
+   if (jobs)
+      jobs->parallelFor(integrateJob, this, numActive, UPDATE_GRAIN_SIZE);
+   else
+      integrate(0, numActive);
+
+   // swap the last live projectile into the place of each expired one
+   float *life = &lifetime[0];
+   int index = 0;
+   while (index < numActive)
+   {
+      if (life[index] > 0.0)
+      {
+         index++;
+         continue;
+      }
+
+      int last = --numActive;
+      positionX[index] = positionX[last];
+      positionY[index] = positionY[last];
+      positionZ[index] = positionZ[last];
+      previousX[index] = previousX[last];
+      previousY[index] = previousY[last];
+      previousZ[index] = previousZ[last];
+      velocityX[index] = velocityX[last];
+      velocityY[index] = velocityY[last];
+      velocityZ[index] = velocityZ[last];
+      lifetime[index] = lifetime[last];
+      radius[index] = radius[last];
+      numExpired++;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn (by the turn rate) and move a range of projectiles by the current
+   time step, each array is walked once in order.
+
+  @param begin The first projectile
+  @param end One past the last projectile
+  */
+void ProjectileSystem::integrate(int begin, int end)
+{
+   if (begin >= end)
+      return;
+
+   float seconds = stepSeconds;
+   float *x = &positionX[0];
+   float *y = &positionY[0];
+   float *z = &positionZ[0];
+   float *vx = &velocityX[0];
+   const float *vy = &velocityY[0];
+   float *vz = &velocityZ[0];
+   float *life = &lifetime[0];
+   int index;
+
+   if (turnRate != 0.0)
+   {
+      float cosAngle = stepCos;
+      float sinAngle = stepSin;
+      for (index = begin; index < end; index++)
+      {
+         float newX = vx[index] * cosAngle + vz[index] * sinAngle;
+         float newZ = vz[index] * cosAngle - vx[index] * sinAngle;
+         vx[index] = newX;
+         vz[index] = newZ;
+      }
+   }
+
+   // remember where they were
+   memcpy(&previousX[begin], &x[begin], (end - begin) * sizeof(float));
+   memcpy(&previousY[begin], &y[begin], (end - begin) * sizeof(float));
+   memcpy(&previousZ[begin], &z[begin], (end - begin) * sizeof(float));
+
+   for (index = begin; index < end; index++)
+   {
+      x[index] += vx[index] * seconds;
+      y[index] += vy[index] * seconds;
+      z[index] += vz[index] * seconds;
+      life[index] -= seconds;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   A job that integrates a range of the projectiles (data is the system)
+  */
+void ProjectileSystem::integrateJob(void *data, int begin, int end)
+{
+   ((ProjectileSystem*)data)->integrate(begin, end);
+}
+}
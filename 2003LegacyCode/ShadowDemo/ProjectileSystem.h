@@ -0,0 +1,80 @@
+#ifndef PROJECTILESYSTEM_H
+#define PROJECTILESYSTEM_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "Vector3D.h"
+
+namespace SML_CORE
+{
+// forward declarations
+class JobSystem;
+
+/**
+  This class moves a pool of simple projectiles (or particles): points with
+  a velocity, a size and a remaining lifetime.  The pool has a fixed
+  capacity that is allocated up front, the live projectiles are kept packed
+  at the front of each array so the whole pool is updated in one pass over
+  flat memory.  A projectile that runs out of life is removed by moving the
+  last live projectile into its place.
+
+  The update can be spread over the threads of a JobSystem, each thread
+  moves its own range of the arrays.
+
+  Each update keeps the positions from before the step, so the projectiles
+  can be drawn somewhere between the two, smoothly between fixed simulation
+  ticks.
+
+  Projectiles aren't models, a scene draws them in a batch (see
+  ShadowableScene::setProjectiles).
+*/
+class ProjectileSystem
+{
+private:
+   int capacity;
+   int numActive;
+   int numExpired;
+   float turnRate;
+   float stepSeconds;
+   float stepCos;
+   float stepSin;
+   unsigned int textureId;
+   std::vector<float> positionX;
+   std::vector<float> positionY;
+   std::vector<float> positionZ;
+   std::vector<float> previousX;
+   std::vector<float> previousY;
+   std::vector<float> previousZ;
+   std::vector<float> velocityX;
+   std::vector<float> velocityY;
+   std::vector<float> velocityZ;
+   std::vector<float> lifetime;
+   std::vector<float> radius;
+
+   void integrate(int begin, int end);
+   static void integrateJob(void *data, int begin, int end);
+
+public:
+   /** the fewest projectiles worth giving to a thread */
+   enum {UPDATE_GRAIN_SIZE = 4096};
+
+   ProjectileSystem(int capacity=100000);
+   virtual ~ProjectileSystem();
+   bool spawn(const Vector3D &position, const Vector3D &velocity, float life, float size=1.0);
+   void update(float seconds, JobSystem *jobs=0);
+   void clear() {numActive = 0;};
+   void setTurnRate(float degreesPerSecond) {turnRate = degreesPerSecond;};
+   void setTexture(unsigned int texture) {textureId = texture;};
+   unsigned int getTextureId() const {return textureId;};
+   int getCapacity() const {return capacity;};
+   int getNumActive() const {return numActive;};
+   int getNumExpired() const {return numExpired;};
+   const float* getPositionsX() const {return capacity ? &positionX[0] : 0;};
+   const float* getPositionsY() const {return capacity ? &positionY[0] : 0;};
+   const float* getPositionsZ() const {return capacity ? &positionZ[0] : 0;};
+   const float* getRadii() const {return capacity ? &radius[0] : 0;};
+   const float* getPreviousPositionsX() const {return capacity ? &previousX[0] : 0;};
+   const float* getPreviousPositionsY() const {return capacity ? &previousY[0] : 0;};
+   const float* getPreviousPositionsZ() const {return capacity ? &previousZ[0] : 0;};
+};
+}
+#endif
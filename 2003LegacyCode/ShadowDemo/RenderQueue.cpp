@@ -0,0 +1,180 @@
+#include <string.h>
+#include "RenderQueue.h"
+
+using std::vector;
+
+namespace SML_CORE
+{
+// bit positions of the fields in the sort key
+static const int PASS_SHIFT = 60;
+static const int LIGHTING_SHIFT = 59;
+static const int TEXTURE_SHIFT = 47;
+static const int MATERIAL_SHIFT = 32;
+static const unsigned int MAX_TEXTURE_INDEX = 0xfff;
+static const unsigned int MAX_MATERIAL_INDEX = 0x7fff;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+  */
+RenderQueue::RenderQueue() :
+items(0),
+sortBuffer(0),
+payloads(0),
+frameTextures(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+RenderQueue::~RenderQueue()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Empty the queue for a new frame.  The memory is kept so a steady frame
+   loop doesn't allocate.
+  */
+void RenderQueue::clear()
+{
+   items.clear();
+   payloads.clear();
+   frameTextures.clear();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Record a draw of the argument model
+
+  @param model The model to draw
+  @param lit true if the model is drawn with lighting
+  @param textureId The openGL texture name, 0 if the model isn't textured
+  @param materialId The index of the model's material in a shared table
+  @param viewDepth The distance of the model from the camera
+  @param pass The pass the model is drawn in
+  */
+void RenderQueue::addModel(Model3D *model, bool lit, unsigned int textureId, int materialId, float viewDepth, int pass)
+{
+   RenderSortKey key = (RenderSortKey)(pass & 0xf) << PASS_SHIFT;
+   if (lit)
+   {
+      unsigned int materialIndex = materialId;
+      if (materialIndex > MAX_MATERIAL_INDEX)
+         materialIndex = MAX_MATERIAL_INDEX;
+      key |= (RenderSortKey)1 << LIGHTING_SHIFT;
+      key |= (RenderSortKey)materialIndex << MATERIAL_SHIFT;
+   }
+   key |= (RenderSortKey)getTextureIndex(textureId) << TEXTURE_SHIFT;
+
+   unsigned int depthBits = getDepthBits(viewDepth);
+   if (pass == TRANSLUCENT_PASS)
+      depthBits = ~depthBits;
+   key |= depthBits;
+
+   RenderItem item;
+   item.key = key;
+   item.payloadIndex = payloads.size();
+   items.push_back(item);
+   payloads.push_back(model);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Sort the recorded draws by their keys.  This is a least significant digit
+   radix sort (8 bits per digit), digits that are the same for every key are
+   skipped, which is most of the pass/lighting bits in a typical frame.
+  */
+void RenderQueue::sort()
+{
+   int numItems = items.size();
+   if (numItems < 2)
+      return;
+   sortBuffer.resize(numItems);
+
+   RenderItem *source = &items[0];
+   RenderItem *destination = &sortBuffer[0];
+   int counts[256];
+
+   for (int shift = 0; shift < 64; shift += 8)
+   {
+      // count the number of keys with each digit value
+      memset(counts, 0, sizeof(counts));
+      int index;
+      for (index = 0; index < numItems; index++)
+         counts[(unsigned int)(source[index].key >> shift) & 0xff]++;
+
+      // all keys share this digit, nothing to do
+      if (counts[(unsigned int)(source[0].key >> shift) & 0xff] == numItems)
+         continue;
+
+      // turn the counts into starting offsets
+      int offset = 0;
+      for (int digit = 0; digit < 256; digit++)
+      {
+         int count = counts[digit];
+         counts[digit] = offset;
+         offset += count;
+      }
+
+      // scatter (stable, so earlier digits stay in order)
+      for (index = 0; index < numItems; index++)
+         destination[counts[(unsigned int)(source[index].key >> shift) & 0xff]++] = source[index];
+
+      RenderItem *temp = source;
+      source = destination;
+      destination = temp;
+   }
+
+   // the sorted keys must end up back in the item list
+   if (source != &items[0])
+      memcpy(&items[0], source, numItems * sizeof(RenderItem));
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the per frame index of a texture, adding it if this is the first
+   draw that uses it this frame.  An untextured draw uses index 0.
+
+  @param textureId The openGL texture name
+  @return The index to put in the sort key
+  */
+unsigned int RenderQueue::getTextureIndex(unsigned int textureId)
+{
+   if (textureId == 0)
+      return 0;
+
+   for (unsigned int index = 0; index < frameTextures.size(); index++)
+   {
+      if (frameTextures[index] == textureId)
+         return index + 1;
+   }
+   if (frameTextures.size() == MAX_TEXTURE_INDEX)
+      return MAX_TEXTURE_INDEX;
+
+   frameTextures.push_back(textureId);
+   return frameTextures.size();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn a view depth into sortable bits.  The bits of a positive IEEE float
+   sort in the same order as the float does, anything behind the camera is
+   treated as depth 0.
+
+  @param depth The view space depth
+  @return The bits to put in the sort key
+  */
+unsigned int RenderQueue::getDepthBits(float depth)
+{
+   if (!(depth > 0.0f))
+      return 0;
+   unsigned int bits;
+   memcpy(&bits, &depth, sizeof(bits));
+   return bits;
+}
+}
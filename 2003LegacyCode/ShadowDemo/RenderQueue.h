@@ -0,0 +1,73 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+//-----------------------------------------------------------------------------
+#include <vector>
+
+namespace SML_CORE
+{
+// forward declarations
+class Model3D;
+
+#ifdef _MSC_VER
+typedef unsigned __int64 RenderSortKey;
+#else
+typedef unsigned long long RenderSortKey;
+#endif
+
+/**
+  This class collects the draws for a frame and orders them before they are
+  submitted to openGL.  Each draw is recorded as a packed 64 bit sort key and
+  a payload (the model), the keys are radix sorted once per frame.
+
+  The key layout from the most to the least significant bit is:
+   - pass (4 bits)
+   - lighting mode (1 bit, unlit models first)
+   - texture (12 bits, a per frame index of the texture)
+   - material (15 bits, the model's material id, an index into the shared
+     material table in SceneStore)
+   - depth (32 bits, view space distance)
+
+  So opaque draws are grouped by texture and then material to keep state
+  changes down, and drawn front to back inside each group for early depth
+  rejection.  Translucent draws have their depth inverted (back to front).
+*/
+class RenderQueue
+{
+public:
+   /** Passes are drawn in this order */
+   enum RenderPass
+   {
+      OPAQUE_PASS = 0,
+      TRANSLUCENT_PASS,
+      NUM_PASSES  //this must be the last element
+   };
+
+private:
+   /** A sort key and the index of the payload it belongs to */
+   class RenderItem
+   {
+   public:
+      RenderSortKey key;
+      int payloadIndex;
+   };
+
+   std::vector<RenderItem> items;
+   std::vector<RenderItem> sortBuffer;
+   std::vector<Model3D*> payloads;
+   std::vector<unsigned int> frameTextures;
+
+   unsigned int getTextureIndex(unsigned int textureId);
+   static unsigned int getDepthBits(float depth);
+
+public:
+   RenderQueue();
+   virtual ~RenderQueue();
+   void clear();
+   void addModel(Model3D *model, bool lit, unsigned int textureId, int materialId, float viewDepth, int pass=OPAQUE_PASS);
+   void sort();
+   int getSize() const {return items.size();};
+   Model3D* getModel(int index) const {return payloads[items[index].payloadIndex];};
+   int getNumTextures() const {return frameTextures.size();};
+};
+}
+#endif
@@ -0,0 +1,345 @@
+#include <GL/glut.h>
+#include "RenderStateCache.h"
+#include "GLExtensions.h"
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Constructor, nothing is known about the openGL state yet
+  */
+RenderStateCache::RenderStateCache() :
+changesIssued(0),
+changesAvoided(0)
+{
+   invalidate();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+RenderStateCache::~RenderStateCache()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Forget everything we know about the openGL state.  The next request for
+   each piece of state will always be passed on to openGL.
+  */
+void RenderStateCache::invalidate()
+{
+   lightingState = UNKNOWN;
+   texture2DState = UNKNOWN;
+   stencilTestState = UNKNOWN;
+   polygonOffsetFillState = UNKNOWN;
+   blendState = UNKNOWN;
+   textureKnown = false;
+   stencilFuncKnown = false;
+   stencilOpKnown = false;
+   stencilWriteMaskKnown = false;
+   polygonOffsetKnown = false;
+   blendFuncKnown = false;
+   colorKnown = false;
+   specularKnown = false;
+   shininessKnown = false;
+   ambientDiffuseKnown = false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start counting state changes for a new frame
+  */
+void RenderStateCache::resetFrameCounters()
+{
+   changesIssued = 0;
+   changesAvoided = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Enable or disable an openGL capability if it isn't already in that state
+
+  @param capability The openGL capability (GL_LIGHTING, GL_BLEND, ...)
+  @param enable true to enable the capability, false to disable it
+  @param cachedState The cached state of that capability
+  */
+void RenderStateCache::setCapability(unsigned int capability, bool enable, int &cachedState)
+{
+   int wanted = enable ? ENABLED : DISABLED;
+   if (cachedState == wanted)
+   {
+      changesAvoided++;
+      return;
+   }
+
+   if (enable) glEnable(capability);
+   else glDisable(capability);
+   cachedState = wanted;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn openGL lighting on or off
+
+  @param enable true for lit drawing
+  */
+void RenderStateCache::setLighting(bool enable)
+{
+   setCapability(GL_LIGHTING, enable, lightingState);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the texture used for drawing.  A texture id of 0 turns texturing off,
+   anything else turns texturing on and binds the texture.
+
+  @param textureId The openGL texture name, or 0 for no texture
+  */
+void RenderStateCache::setTexture(unsigned int textureId)
+{
+   setCapability(GL_TEXTURE_2D, textureId != 0, texture2DState);
+   if (textureId == 0)
+      return;
+
+   if (textureKnown && boundTexture == textureId)
+   {
+      changesAvoided++;
+      return;
+   }
+   glBindTexture(GL_TEXTURE_2D, textureId);
+   boundTexture = textureId;
+   textureKnown = true;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn the stencil test on or off
+
+  @param enable true to enable the stencil test
+  */
+void RenderStateCache::setStencilTest(bool enable)
+{
+   setCapability(GL_STENCIL_TEST, enable, stencilTestState);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the stencil function (see glStencilFunc)
+  */
+void RenderStateCache::setStencilFunc(int func, int ref, unsigned int mask)
+{
+   if (stencilFuncKnown && stencilFunc == func && stencilRef == ref && stencilMask == mask)
+   {
+      changesAvoided++;
+      return;
+   }
+   glStencilFunc(func, ref, mask);
+   stencilFunc = func;
+   stencilRef = ref;
+   stencilMask = mask;
+   stencilFuncKnown = true;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set which bits of the stencil buffer can be written (see glStencilMask),
+   glClear keeps to it too
+  */
+void RenderStateCache::setStencilWriteMask(unsigned int mask)
+{
+   if (stencilWriteMaskKnown && stencilWriteMask == mask)
+   {
+      changesAvoided++;
+      return;
+   }
+   glStencilMask(mask);
+   stencilWriteMask = mask;
+   stencilWriteMaskKnown = true;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the stencil operations (see glStencilOp)
+  */
+void RenderStateCache::setStencilOp(int fail, int zFail, int zPass)
+{
+   if (stencilOpKnown && stencilFail == fail && stencilZFail == zFail && stencilZPass == zPass)
+   {
+      changesAvoided++;
+      return;
+   }
+   glStencilOp(fail, zFail, zPass);
+   stencilFail = fail;
+   stencilZFail = zFail;
+   stencilZPass = zPass;
+   stencilOpKnown = true;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the stencil operations of front or back facing polygons apart (needs
+   GLExtensions::hasSeparateStencil).  The two sides then differ, so the
+   next setStencilOp is always issued.
+
+  @param face GL_FRONT or GL_BACK
+  @param fail The operation when the stencil test fails
+  @param zFail The operation when the stencil test passes but the depth test fails
+  @param zPass The operation when both tests pass
+  */
+void RenderStateCache::setStencilOpSeparate(int face, int fail, int zFail, int zPass)
+{
+   GLExtensions::stencilOpSeparate(face, fail, zFail, zPass);
+   stencilOpKnown = false;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn polygon offset for filled polygons on or off
+
+  @param enable true to offset filled polygons
+  */
+void RenderStateCache::setPolygonOffsetFill(bool enable)
+{
+   setCapability(GL_POLYGON_OFFSET_FILL, enable, polygonOffsetFillState);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the polygon offset values (see glPolygonOffset)
+  */
+void RenderStateCache::setPolygonOffset(float factor, float units)
+{
+   if (polygonOffsetKnown && offsetFactor == factor && offsetUnits == units)
+   {
+      changesAvoided++;
+      return;
+   }
+   glPolygonOffset(factor, units);
+   offsetFactor = factor;
+   offsetUnits = units;
+   polygonOffsetKnown = true;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn blending on or off
+
+  @param enable true to blend
+  */
+void RenderStateCache::setBlend(bool enable)
+{
+   setCapability(GL_BLEND, enable, blendState);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the blending function (see glBlendFunc)
+  */
+void RenderStateCache::setBlendFunc(int source, int destination)
+{
+   if (blendFuncKnown && blendSource == source && blendDestination == destination)
+   {
+      changesAvoided++;
+      return;
+   }
+   glBlendFunc(source, destination);
+   blendSource = source;
+   blendDestination = destination;
+   blendFuncKnown = true;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the current color (used for unlit drawing)
+  */
+void RenderStateCache::setColor(float red, float green, float blue, float alpha)
+{
+   if (colorKnown && color[0] == red && color[1] == green && color[2] == blue && color[3] == alpha)
+   {
+      changesAvoided++;
+      return;
+   }
+   glColor4f(red, green, blue, alpha);
+   color[0] = red;
+   color[1] = green;
+   color[2] = blue;
+   color[3] = alpha;
+   colorKnown = true;
+   changesIssued++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the front face material properties (used for lit drawing).  Each of
+   the specular, shininess and ambient/diffuse parts is only sent when it
+   differs from the current material.
+
+  @param material The material to draw with
+  */
+void RenderStateCache::setMaterial(const Material &material)
+{
+   if (specularKnown &&
+       currentMaterial.specularRed == material.specularRed &&
+       currentMaterial.specularGreen == material.specularGreen &&
+       currentMaterial.specularBlue == material.specularBlue &&
+       currentMaterial.specularAlpha == material.specularAlpha)
+   {
+      changesAvoided++;
+   }
+   else
+   {
+      float matSpecular[] = {material.specularRed, material.specularGreen, material.specularBlue, material.specularAlpha};
+      glMaterialfv(GL_FRONT, GL_SPECULAR, matSpecular);
+      currentMaterial.specularRed = material.specularRed;
+      currentMaterial.specularGreen = material.specularGreen;
+      currentMaterial.specularBlue = material.specularBlue;
+      currentMaterial.specularAlpha = material.specularAlpha;
+      specularKnown = true;
+      changesIssued++;
+   }
+
+   if (shininessKnown && currentMaterial.shininess == material.shininess)
+   {
+      changesAvoided++;
+   }
+   else
+   {
+      float matShininess[] = {material.shininess};
+      glMaterialfv(GL_FRONT, GL_SHININESS, matShininess);
+      currentMaterial.shininess = material.shininess;
+      shininessKnown = true;
+      changesIssued++;
+   }
+
+   if (ambientDiffuseKnown &&
+       currentMaterial.ambientDiffuseRed == material.ambientDiffuseRed &&
+       currentMaterial.ambientDiffuseGreen == material.ambientDiffuseGreen &&
+       currentMaterial.ambientDiffuseBlue == material.ambientDiffuseBlue &&
+       currentMaterial.ambientDiffuseAlpha == material.ambientDiffuseAlpha)
+   {
+      changesAvoided++;
+   }
+   else
+   {
+      float matAmbDiff[] = {material.ambientDiffuseRed, material.ambientDiffuseGreen, material.ambientDiffuseBlue, material.ambientDiffuseAlpha};
+      glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, matAmbDiff);
+      currentMaterial.ambientDiffuseRed = material.ambientDiffuseRed;
+      currentMaterial.ambientDiffuseGreen = material.ambientDiffuseGreen;
+      currentMaterial.ambientDiffuseBlue = material.ambientDiffuseBlue;
+      currentMaterial.ambientDiffuseAlpha = material.ambientDiffuseAlpha;
+      ambientDiffuseKnown = true;
+      changesIssued++;
+   }
+}
+}
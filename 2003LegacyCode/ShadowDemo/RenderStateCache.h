@@ -0,0 +1,85 @@
+#ifndef RENDERSTATECACHE_H
+#define RENDERSTATECACHE_H
+//-----------------------------------------------------------------------------
+#include "Material.h"
+
+namespace SML_CORE
+{
+/**
+  This class shadows the openGL state that the scenes change while drawing
+  (lighting, texturing, stencil, polygon offset, blending, color and material)
+  and only passes a request on to openGL when it actually changes something.
+  It replaces the glPushAttrib(GL_ALL_ATTRIB_BITS)/glPopAttrib pairs that used
+  to wrap every display list and shadow pass.
+
+  All state changes that the scenes make must go through the cache, otherwise
+  call invalidate() so the next request is always issued.
+*/
+class RenderStateCache
+{
+private:
+   /** cached on/off state of a capability, UNKNOWN forces the next call */
+   enum CapabilityState
+   {
+      UNKNOWN = -1,
+      DISABLED = 0,
+      ENABLED = 1
+   };
+
+   int lightingState;
+   int texture2DState;
+   int stencilTestState;
+   int polygonOffsetFillState;
+   int blendState;
+   bool textureKnown;
+   unsigned int boundTexture;
+   bool stencilFuncKnown;
+   int stencilFunc;
+   int stencilRef;
+   unsigned int stencilMask;
+   bool stencilWriteMaskKnown;
+   unsigned int stencilWriteMask;
+   bool stencilOpKnown;
+   int stencilFail;
+   int stencilZFail;
+   int stencilZPass;
+   bool polygonOffsetKnown;
+   float offsetFactor;
+   float offsetUnits;
+   bool blendFuncKnown;
+   int blendSource;
+   int blendDestination;
+   bool colorKnown;
+   float color[4];
+   bool specularKnown;
+   bool shininessKnown;
+   bool ambientDiffuseKnown;
+   Material currentMaterial;
+   int changesIssued;
+   int changesAvoided;
+
+   void setCapability(unsigned int capability, bool enable, int &cachedState);
+
+public:
+   RenderStateCache();
+   virtual ~RenderStateCache();
+   void invalidate();
+   void resetFrameCounters();
+   void setLighting(bool enable);
+   void setTexture(unsigned int textureId);
+   void setStencilTest(bool enable);
+   void setStencilFunc(int func, int ref, unsigned int mask);
+   void setStencilOp(int fail, int zFail, int zPass);
+   void setStencilOpSeparate(int face, int fail, int zFail, int zPass);
+   void setStencilWriteMask(unsigned int mask);
+   void setPolygonOffsetFill(bool enable);
+   void setPolygonOffset(float factor, float units);
+   void setBlend(bool enable);
+   void setBlendFunc(int source, int destination);
+   void setColor(float red, float green, float blue, float alpha=1.0);
+   void setMaterial(const Material &material);
+   int getChangesIssued() const {return changesIssued;};
+   int getChangesAvoided() const {return changesAvoided;};
+};
+}
+#endif
@@ -0,0 +1,93 @@
+#include <string.h>
+#include "SceneSnapshot.h"
+#include "SceneStore.h"
+#include "ProjectileSystem.h"
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Constructor, an empty snapshot
+  */
+SceneSnapshot::SceneSnapshot() :
+tick(0),
+tickTime(0),
+numModels(0),
+positions(0),
+previousPositions(0),
+orientations(0),
+flags(0),
+numProjectiles(0),
+projectileX(0),
+projectileY(0),
+projectileZ(0),
+previousX(0),
+previousY(0),
+previousZ(0),
+projectileRadii(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+SceneSnapshot::~SceneSnapshot()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Copy the moving parts of a scene.  Call this on the thread that runs the
+   simulation, between ticks.
+
+  @param store The scene's models
+  @param projectiles The scene's projectiles (0 if there are none)
+  */
+void SceneSnapshot::capture(const SceneStore &store, const ProjectileSystem *projectiles)
+{
+   numModels = store.getSize();
+   if (flags.size() < numModels)
+   {
+      positions.resize(numModels * 3);
+      previousPositions.resize(numModels * 3);
+      orientations.resize(numModels * 16);
+      flags.resize(numModels);
+   }
+   if (numModels > 0)
+   {
+      memcpy(&positions[0], store.getPositionAt(0), numModels * 3 * sizeof(float));
+      memcpy(&previousPositions[0], store.getPreviousPositionAt(0), numModels * 3 * sizeof(float));
+      memcpy(&orientations[0], store.getOrientationAt(0), numModels * 16 * sizeof(float));
+      for (int index = 0; index < numModels; index++)
+         flags[index] = store.getFlagsAt(index);
+   }
+
+   numProjectiles = projectiles ? projectiles->getNumActive() : 0;
+   if (numProjectiles == 0)
+      return;
+
+   // size for the whole pool once rather than growing tick by tick
+   if (projectileX.size() < numProjectiles)
+   {
+      int capacity = projectiles->getCapacity();
+      projectileX.resize(capacity);
+      projectileY.resize(capacity);
+      projectileZ.resize(capacity);
+      previousX.resize(capacity);
+      previousY.resize(capacity);
+      previousZ.resize(capacity);
+      projectileRadii.resize(capacity);
+   }
+   int size = numProjectiles * sizeof(float);
+   memcpy(&projectileX[0], projectiles->getPositionsX(), size);
+   memcpy(&projectileY[0], projectiles->getPositionsY(), size);
+   memcpy(&projectileZ[0], projectiles->getPositionsZ(), size);
+   memcpy(&previousX[0], projectiles->getPreviousPositionsX(), size);
+   memcpy(&previousY[0], projectiles->getPreviousPositionsY(), size);
+   memcpy(&previousZ[0], projectiles->getPreviousPositionsZ(), size);
+   memcpy(&projectileRadii[0], projectiles->getRadii(), size);
+}
+}
@@ -0,0 +1,51 @@
+#ifndef SCENESNAPSHOT_H
+#define SCENESNAPSHOT_H
+//-----------------------------------------------------------------------------
+#include <vector>
+
+namespace SML_CORE
+{
+// forward declarations
+class SceneStore;
+class ProjectileSystem;
+
+/**
+  This class is a copy of everything that moves in a scene at the end of a
+  simulation tick: each model's position (now and at the start of the tick)
+  and orientation, and each projectile's position and size.  The simulation
+  thread fills one in and hands it to the render thread through a
+  TripleBuffer, so the render thread draws from its own copy and never reads
+  the arrays the simulation is writing.
+
+  The rest of a model (its bounds, material, mesh, texture and color) is
+  set up before the threads start and doesn't change, so it isn't copied.
+
+  The arrays only grow, after the first few ticks taking a snapshot is a
+  few straight copies and no allocations.
+*/
+class SceneSnapshot
+{
+public:
+   unsigned long tick;     // the simulation tick the copy was taken after
+   int tickTime;           // when (in clock milliseconds) that tick ended
+   int numModels;
+   std::vector<float> positions;          // x,y,z by dense store index
+   std::vector<float> previousPositions;  // x,y,z at the start of the tick
+   std::vector<float> orientations;       // 16 floats, column major
+   std::vector<unsigned int> flags;       // the store's model flags
+   int numProjectiles;
+   std::vector<float> projectileX;
+   std::vector<float> projectileY;
+   std::vector<float> projectileZ;
+   std::vector<float> previousX;
+   std::vector<float> previousY;
+   std::vector<float> previousZ;
+   std::vector<float> projectileRadii;
+
+   SceneSnapshot();
+   virtual ~SceneSnapshot();
+   void capture(const SceneStore &store, const ProjectileSystem *projectiles);
+   const float* getOrientationAt(int index) const {return index < numModels ? &orientations[index * 16] : 0;};
+};
+}
+#endif
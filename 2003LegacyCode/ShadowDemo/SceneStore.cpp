@@ -0,0 +1,584 @@
+#include <math.h>
+#include <string.h>
+#include "SceneStore.h"
+#include "Model3D.h"
+#include "JobSystem.h"
+#include "SceneSnapshot.h"
+
+using std::vector;
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+  */
+SceneStore::SceneStore() :
+idToIndex(0),
+indexToId(0),
+firstFreeId(INVALID_ID),
+positions(0),
+previousPositions(0),
+orientations(0),
+worldMatrices(0),
+localSpheres(0),
+worldSpheres(0),
+colors(0),
+materialIds(0),
+meshIds(0),
+textureIds(0),
+flags(0),
+moved(0),
+lit(0),
+stillUpdates(0),
+spatialIds(0),
+models(0),
+materials(0),
+interpolation(1.0),
+transformSource(0),
+rebuildAll(false)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+SceneStore::~SceneStore()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Copy a model's data to the end of the arrays.  The model must not be
+   attached to a store yet, its own copy of the data is read.
+
+  @param model The model to add
+  @return The id of the model in this store
+  */
+int SceneStore::add(Model3D *model)
+{
+   // find an id for the model
+   int id = firstFreeId;
+   if (id != INVALID_ID)
+   {
+      firstFreeId = -2 - idToIndex[id];
+   }
+   else
+   {
+      idToIndex.push_back(0);
+      id = idToIndex.size() - 1;
+   }
+   int index = models.size();
+   idToIndex[id] = index;
+   indexToId.push_back(id);
+
+   // grow every array by one model
+   positions.resize(positions.size() + 3);
+   previousPositions.resize(previousPositions.size() + 3);
+   orientations.resize(orientations.size() + 16);
+   worldMatrices.resize(worldMatrices.size() + 16);
+   localSpheres.resize(localSpheres.size() + 4);
+   worldSpheres.resize(worldSpheres.size() + 4);
+   colors.resize(colors.size() + 3);
+   materialIds.push_back(0);
+   meshIds.push_back(model->getCallListId());
+   textureIds.push_back(model->getTextureId());
+   flags.push_back(DIRTY_FLAG);
+   moved.push_back(0);
+   lit.push_back(0);
+   stillUpdates.push_back(0);
+   spatialIds.push_back(-1);
+   models.push_back(model);
+
+   // copy the rest of the model's data in
+   Vector3D position = model->getPosition();
+   setPosition(id, position.x, position.y, position.z);
+   setOrientation(id, model->getFTM());
+   setColor(id, model->getRed(), model->getGreen(), model->getBlue());
+   setMaterial(id, model->getMaterial());
+   setLit(id, model->isLit());
+   if (model->hasBounds())
+   {
+      BoundingVolume bounds = model->getBounds();
+      setBounds(id, bounds.center, bounds.radius);
+   }
+
+   // the model starts at rest, then is ready to be culled and drawn
+   memcpy(&previousPositions[index * 3], &positions[index * 3], 3 * sizeof(float));
+   updateWorld(index, &positions[index * 3], &previousPositions[index * 3], &orientations[index * 16], flags[index]);
+   flags[index] &= ~DIRTY_FLAG;
+   lit[index] = (flags[index] & LIT_FLAG) != 0;
+   return id;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Remove a model, the last model in the arrays is moved into its place.
+
+  @param id The id of the model
+  */
+void SceneStore::remove(int id)
+{
+   int index = idToIndex[id];
+   int lastIndex = models.size() - 1;
+   if (index != lastIndex)
+   {
+      memcpy(&positions[index * 3], &positions[lastIndex * 3], 3 * sizeof(float));
+      memcpy(&previousPositions[index * 3], &previousPositions[lastIndex * 3], 3 * sizeof(float));
+      memcpy(&orientations[index * 16], &orientations[lastIndex * 16], 16 * sizeof(float));
+      memcpy(&worldMatrices[index * 16], &worldMatrices[lastIndex * 16], 16 * sizeof(float));
+      memcpy(&localSpheres[index * 4], &localSpheres[lastIndex * 4], 4 * sizeof(float));
+      memcpy(&worldSpheres[index * 4], &worldSpheres[lastIndex * 4], 4 * sizeof(float));
+      memcpy(&colors[index * 3], &colors[lastIndex * 3], 3 * sizeof(float));
+      materialIds[index] = materialIds[lastIndex];
+      meshIds[index] = meshIds[lastIndex];
+      textureIds[index] = textureIds[lastIndex];
+      flags[index] = flags[lastIndex];
+      moved[index] = moved[lastIndex];
+      lit[index] = lit[lastIndex];
+      stillUpdates[index] = stillUpdates[lastIndex];
+      spatialIds[index] = spatialIds[lastIndex];
+      models[index] = models[lastIndex];
+      indexToId[index] = indexToId[lastIndex];
+      idToIndex[indexToId[index]] = index;
+   }
+
+   positions.resize(lastIndex * 3);
+   previousPositions.resize(lastIndex * 3);
+   orientations.resize(lastIndex * 16);
+   worldMatrices.resize(lastIndex * 16);
+   localSpheres.resize(lastIndex * 4);
+   worldSpheres.resize(lastIndex * 4);
+   colors.resize(lastIndex * 3);
+   materialIds.pop_back();
+   meshIds.pop_back();
+   textureIds.pop_back();
+   flags.pop_back();
+   moved.pop_back();
+   lit.pop_back();
+   stillUpdates.pop_back();
+   spatialIds.pop_back();
+   models.pop_back();
+   indexToId.pop_back();
+
+   // free ids are chained through the id table as -2 - next
+   idToIndex[id] = -2 - firstFreeId;
+   firstFreeId = id;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Get the position of a model
+
+  @param id The id of the model
+  @return The position of the model
+  */
+Vector3D SceneStore::getPosition(int id) const
+{
+   const float *position = &positions[idToIndex[id] * 3];
+   return Vector3D(position[0], position[1], position[2]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the position of a model
+
+  @param id The id of the model
+  @param x X component of new position
+  @param y Y component of new position
+  @param z Z component of new position
+  */
+void SceneStore::setPosition(int id, float x, float y, float z)
+{
+   int index = idToIndex[id];
+   float *position = &positions[index * 3];
+   position[0] = x;
+   position[1] = y;
+   position[2] = z;
+   flags[index] |= DIRTY_FLAG;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Get the orientation (FTM) of a model
+
+  @param id The id of the model
+  @return A copy of the model's FTM
+  */
+FTM SceneStore::getOrientation(int id) const
+{
+   const float *matrix = &orientations[idToIndex[id] * 16];
+   FTM orientation;
+   orientation._00 = matrix[0];  orientation._01 = matrix[1];  orientation._02 = matrix[2];  orientation._03 = matrix[3];
+   orientation._10 = matrix[4];  orientation._11 = matrix[5];  orientation._12 = matrix[6];  orientation._13 = matrix[7];
+   orientation._20 = matrix[8];  orientation._21 = matrix[9];  orientation._22 = matrix[10]; orientation._23 = matrix[11];
+   orientation._30 = matrix[12]; orientation._31 = matrix[13]; orientation._32 = matrix[14]; orientation._33 = matrix[15];
+   return orientation;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the orientation (FTM) of a model
+
+  @param id The id of the model
+  @param orientation The new FTM
+  */
+void SceneStore::setOrientation(int id, const FTM &orientation)
+{
+   int index = idToIndex[id];
+   float *matrix = &orientations[index * 16];
+   matrix[0] = orientation._00;  matrix[1] = orientation._01;  matrix[2] = orientation._02;  matrix[3] = orientation._03;
+   matrix[4] = orientation._10;  matrix[5] = orientation._11;  matrix[6] = orientation._12;  matrix[7] = orientation._13;
+   matrix[8] = orientation._20;  matrix[9] = orientation._21;  matrix[10] = orientation._22; matrix[11] = orientation._23;
+   matrix[12] = orientation._30; matrix[13] = orientation._31; matrix[14] = orientation._32; matrix[15] = orientation._33;
+   flags[index] |= DIRTY_FLAG;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Get the color of a model
+
+  @param id The id of the model
+  @param red Set to the red component
+  @param green Set to the green component
+  @param blue Set to the blue component
+  */
+void SceneStore::getColor(int id, float &red, float &green, float &blue) const
+{
+   const float *color = &colors[idToIndex[id] * 3];
+   red = color[0];
+   green = color[1];
+   blue = color[2];
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the color of a model
+
+  @param id The id of the model
+  @param red Component of color
+  @param green Component of color
+  @param blue Component of color
+  */
+void SceneStore::setColor(int id, float red, float green, float blue)
+{
+   float *color = &colors[idToIndex[id] * 3];
+   color[0] = red;
+   color[1] = green;
+   color[2] = blue;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the material of a model
+
+  @param id The id of the model
+  @param material The new material properties
+  */
+void SceneStore::setMaterial(int id, const Material &material)
+{
+   materialIds[idToIndex[id]] = findMaterial(material);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set if a model is drawn with lighting
+
+  @param id The id of the model
+  @param lit true to use lighting
+  */
+void SceneStore::setLit(int id, bool lit)
+{
+   int index = idToIndex[id];
+   if (lit)
+      flags[index] |= LIT_FLAG;
+   else
+      flags[index] &= ~LIT_FLAG;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set the model space bounding sphere of a model
+
+  @param id The id of the model
+  @param center The center of the sphere
+  @param radius The radius of the sphere
+  */
+void SceneStore::setBounds(int id, const Vector3D &center, float radius)
+{
+   int index = idToIndex[id];
+   float *sphere = &localSpheres[index * 4];
+   sphere[0] = center.x;
+   sphere[1] = center.y;
+   sphere[2] = center.z;
+   sphere[3] = radius;
+   flags[index] |= BOUNDS_FLAG | DIRTY_FLAG;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Rebuild the world matrices and bounding spheres of every model that
+   changed since the last update.  Models whose world bounds changed are
+   flagged as moved until the next update (see hasMovedAt).
+
+  @param jobs The job system to spread the work over (0 to do it here)
+  */
+void SceneStore::updateTransforms(JobSystem *jobs)
+{
+   if (jobs)
+      jobs->parallelFor(updateTransformJob, this, models.size(), TRANSFORM_GRAIN_SIZE);
+   else
+      updateTransformRange(0, models.size());
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Rebuild the world matrices and bounding spheres from a snapshot of the
+   simulation rather than from this store's own positions.  This is what
+   the render thread calls when the simulation runs on another thread, it
+   only writes the arrays the render thread owns.
+
+   Every model is rebuilt when the snapshot is new, after that only the
+   models that moved during the snapshot's tick (they are drawn at a new
+   point between its two positions each frame).  Only the models whose
+   world bounds came out different are flagged as moved.
+
+  @param snapshot The simulation's transforms
+  @param alpha How far between the snapshot's previous and current
+               positions to draw the models
+  @param newSnapshot true if the snapshot changed since the last update
+  @param jobs The job system to spread the work over (0 to do it here)
+  */
+void SceneStore::updateTransforms(const SceneSnapshot &snapshot, float alpha, bool newSnapshot, JobSystem *jobs)
+{
+   transformSource = &snapshot;
+   rebuildAll = newSnapshot;
+   interpolation = alpha;
+
+   int numModels = models.size();
+   if (snapshot.numModels < numModels)
+      numModels = snapshot.numModels;
+   if (jobs)
+      jobs->parallelFor(updateTransformJob, this, numModels, TRANSFORM_GRAIN_SIZE);
+   else
+      updateTransformRange(0, numModels);
+   transformSource = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start a simulation tick: remember where every model is so the frames
+   drawn during the tick can be interpolated from there.  Models that were
+   moving are flagged so their world matrix catches up with where they are.
+  */
+void SceneStore::beginTick()
+{
+   int numModels = models.size();
+   for (int index = 0; index < numModels; index++)
+   {
+      float *current = &positions[index * 3];
+      float *previous = &previousPositions[index * 3];
+      if (previous[0] != current[0] || previous[1] != current[1] || previous[2] != current[2])
+      {
+         previous[0] = current[0];
+         previous[1] = current[1];
+         previous[2] = current[2];
+         flags[index] |= DIRTY_FLAG;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set how far through the current tick the next frame is drawn, models
+   that moved during the tick are flagged so their world matrix is rebuilt.
+   Positions are interpolated, orientations change on the tick.
+
+  @param alpha 0 draws models where they were at the start of the tick,
+               1 where they are now
+  */
+void SceneStore::setInterpolation(float alpha)
+{
+   interpolation = alpha;
+   int numModels = models.size();
+   for (int index = 0; index < numModels; index++)
+   {
+      const float *current = &positions[index * 3];
+      const float *previous = &previousPositions[index * 3];
+      if (previous[0] != current[0] || previous[1] != current[1] || previous[2] != current[2])
+         flags[index] |= DIRTY_FLAG;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Update the transforms of a range of models (see updateTransforms)
+
+  @param begin The first dense index
+  @param end One past the last dense index
+  */
+void SceneStore::updateTransformRange(int begin, int end)
+{
+   int index;
+   float oldWorld[16];
+   float oldSphere[4];
+   if (transformSource)
+   {
+      const SceneSnapshot &snapshot = *transformSource;
+      for (index = begin; index < end; index++)
+      {
+         const float *current = &snapshot.positions[index * 3];
+         const float *previous = &snapshot.previousPositions[index * 3];
+         bool moving = previous[0] != current[0] || previous[1] != current[1] || previous[2] != current[2];
+         bool rebuilt = rebuildAll || moving;
+         lit[index] = (snapshot.flags[index] & LIT_FLAG) != 0;
+         if (rebuilt)
+         {
+            memcpy(oldWorld, &worldMatrices[index * 16], 16 * sizeof(float));
+            memcpy(oldSphere, &worldSpheres[index * 4], 4 * sizeof(float));
+            updateWorld(index, current, previous, &snapshot.orientations[index * 16], snapshot.flags[index]);
+         }
+         findMoved(index, rebuilt, oldWorld, oldSphere);
+      }
+      return;
+   }
+
+   for (index = begin; index < end; index++)
+   {
+      unsigned int modelFlags = flags[index];
+      bool rebuilt = (modelFlags & DIRTY_FLAG) != 0;
+      lit[index] = (modelFlags & LIT_FLAG) != 0;
+      if (rebuilt)
+      {
+         memcpy(oldWorld, &worldMatrices[index * 16], 16 * sizeof(float));
+         memcpy(oldSphere, &worldSpheres[index * 4], 4 * sizeof(float));
+         updateWorld(index, &positions[index * 3], &previousPositions[index * 3], &orientations[index * 16], modelFlags);
+         flags[index] = modelFlags & ~DIRTY_FLAG;
+      }
+      findMoved(index, rebuilt, oldWorld, oldSphere);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Flag a model as moved if its world matrix or sphere changed, and count
+   the updates it has gone without them changing.  A model that was rebuilt
+   but came out the same (every model is rebuilt for a new snapshot) is not
+   moved.
+
+  @param index The dense index
+  @param rebuilt true if the model's world matrix was rebuilt
+  @param oldWorld The world matrix before the update
+  @param oldSphere The world sphere before the update
+  */
+void SceneStore::findMoved(int index, bool rebuilt, const float *oldWorld, const float *oldSphere)
+{
+   moved[index] = rebuilt && (memcmp(oldWorld, &worldMatrices[index * 16], 16 * sizeof(float)) != 0 ||
+      memcmp(oldSphere, &worldSpheres[index * 4], 4 * sizeof(float)) != 0);
+   if (moved[index])
+      stillUpdates[index] = 0;
+   else if (stillUpdates[index] < MAX_STILL_UPDATES)
+      stillUpdates[index]++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   A job that updates a range of the transforms (data is the store)
+  */
+void SceneStore::updateTransformJob(void *data, int begin, int end)
+{
+   ((SceneStore*)data)->updateTransformRange(begin, end);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Build the world matrix of a model (its position then its orientation)
+   and move its bounding sphere into the world.  A model with no bounds gets
+   a huge sphere so that it is never culled.
+
+  @param index The dense index of the model
+  @param current The model's position (x,y,z)
+  @param previous The model's position at the start of the tick
+  @param orientation The model's orientation (16 floats)
+  @param modelFlags The model's flags
+  */
+void SceneStore::updateWorld(int index, const float *current, const float *previous, const float *orientation, unsigned int modelFlags)
+{
+   float *world = &worldMatrices[index * 16];
+
+   // draw the model between where it was and where it is
+   float position[3];
+   position[0] = previous[0] + (current[0] - previous[0]) * interpolation;
+   position[1] = previous[1] + (current[1] - previous[1]) * interpolation;
+   position[2] = previous[2] + (current[2] - previous[2]) * interpolation;
+
+   // translate * orientation, column by column
+   for (int column = 0; column < 4; column++)
+   {
+      const float *source = &orientation[column * 4];
+      float *destination = &world[column * 4];
+      destination[0] = source[0] + position[0] * source[3];
+      destination[1] = source[1] + position[1] * source[3];
+      destination[2] = source[2] + position[2] * source[3];
+      destination[3] = source[3];
+   }
+
+   float *sphere = &worldSpheres[index * 4];
+   if (!(modelFlags & BOUNDS_FLAG))
+   {
+      sphere[0] = world[12];
+      sphere[1] = world[13];
+      sphere[2] = world[14];
+      sphere[3] = 1.0e30f;
+      return;
+   }
+
+   const float *local = &localSpheres[index * 4];
+   sphere[0] = world[0] * local[0] + world[4] * local[1] + world[8] * local[2] + world[12];
+   sphere[1] = world[1] * local[0] + world[5] * local[1] + world[9] * local[2] + world[13];
+   sphere[2] = world[2] * local[0] + world[6] * local[1] + world[10] * local[2] + world[14];
+
+   // the largest axis scale keeps the sphere around the model
+   float maxScale = 0.0;
+   for (int axis = 0; axis < 3; axis++)
+   {
+      const float *column = &world[axis * 4];
+      float scale = column[0] * column[0] + column[1] * column[1] + column[2] * column[2];
+      if (scale > maxScale)
+         maxScale = scale;
+   }
+   sphere[3] = local[3] * (float)sqrt(maxScale);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find a material in the shared table, adding it if it isn't there yet.
+
+  @param material The material properties
+  @return The index of the material in the table
+  */
+int SceneStore::findMaterial(const Material &material)
+{
+   for (int index = 0; index < materials.size(); index++)
+   {
+      const Material &other = materials[index];
+      if (other.specularRed == material.specularRed &&
+          other.specularGreen == material.specularGreen &&
+          other.specularBlue == material.specularBlue &&
+          other.specularAlpha == material.specularAlpha &&
+          other.shininess == material.shininess &&
+          other.ambientDiffuseRed == material.ambientDiffuseRed &&
+          other.ambientDiffuseGreen == material.ambientDiffuseGreen &&
+          other.ambientDiffuseBlue == material.ambientDiffuseBlue &&
+          other.ambientDiffuseAlpha == material.ambientDiffuseAlpha)
+      {
+         return index;
+      }
+   }
+   materials.push_back(material);
+   return materials.size() - 1;
+}
+}
@@ -0,0 +1,148 @@
+#ifndef SCENESTORE_H
+#define SCENESTORE_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "Vector3D.h"
+#include "FTM.h"
+#include "Material.h"
+
+namespace SML_CORE
+{
+// forward declarations
+class Model3D;
+class JobSystem;
+class SceneSnapshot;
+
+/**
+  This class holds the per frame data of the models in a scene as a
+  structure of arrays: positions, orientations, world matrices, bounding
+  spheres, colors, material ids, mesh (display list) ids, texture ids and
+  flags each live in their own contiguous array.  The loops that touch
+  every model each frame (transform updates, culling, queueing draws) walk
+  these arrays in order instead of chasing Model3D pointers.
+
+  Models are found by a stable id.  The arrays are kept dense: removing a
+  model moves the last one into its place and fixes up the id table.
+  Materials are shared, each distinct material is stored once and models
+  keep an index into the material table.
+
+  A Model3D added to a scene is attached to the scene's store and forwards
+  its accessors here (see Model3D::attach).
+
+  When the simulation runs on its own thread the arrays are split between
+  the threads.  The simulation owns the positions, orientations and flags
+  (everything the Model3D facade writes), the render thread owns the world
+  matrices, world spheres, moved and lit flags and still counts and
+  rebuilds them from a SceneSnapshot of the simulation's arrays.  Models
+  are only added and removed before the threads start.
+*/
+class SceneStore
+{
+public:
+   /** Bits of the per model flags */
+   enum StoreFlag
+   {
+      LIT_FLAG = 1,        // drawn with lighting and its material
+      BOUNDS_FLAG = 2,     // has a bounding sphere (never culled otherwise)
+      DIRTY_FLAG = 4       // the world matrix needs to be rebuilt
+   };
+
+   /** returned when a model can't be found */
+   enum {INVALID_ID = -1};
+
+   /** the fewest models worth giving to a thread */
+   enum {TRANSFORM_GRAIN_SIZE = 256};
+
+   /** the most updates a model is counted as still for */
+   enum {MAX_STILL_UPDATES = 255};
+
+private:
+   // id <-> dense index tables
+   std::vector<int> idToIndex;
+   std::vector<int> indexToId;
+   int firstFreeId;
+
+   // the dense per model arrays
+   std::vector<float> positions;       // x,y,z
+   std::vector<float> previousPositions; // x,y,z at the start of the tick
+   std::vector<float> orientations;    // 16 floats, column major like FTM
+   std::vector<float> worldMatrices;   // 16 floats, column major
+   std::vector<float> localSpheres;    // x,y,z,radius in model space
+   std::vector<float> worldSpheres;    // x,y,z,radius in the world
+   std::vector<float> colors;          // r,g,b
+   std::vector<int> materialIds;
+   std::vector<int> meshIds;
+   std::vector<unsigned int> textureIds;
+   std::vector<unsigned int> flags;
+   std::vector<unsigned char> moved;   // the world bounds changed in the last update
+   std::vector<unsigned char> lit;     // LIT_FLAG as of the last update
+   std::vector<unsigned char> stillUpdates; // updates since the world bounds last changed
+   std::vector<int> spatialIds;
+   std::vector<Model3D*> models;
+
+   std::vector<Material> materials;
+   float interpolation;
+
+   // where updateTransformRange reads the transforms from (0 for this store)
+   const SceneSnapshot *transformSource;
+   bool rebuildAll;
+
+   void updateWorld(int index, const float *current, const float *previous, const float *orientation, unsigned int modelFlags);
+   void findMoved(int index, bool rebuilt, const float *oldWorld, const float *oldSphere);
+   void updateTransformRange(int begin, int end);
+   static void updateTransformJob(void *data, int begin, int end);
+   int findMaterial(const Material &material);
+
+public:
+   SceneStore();
+   virtual ~SceneStore();
+   int add(Model3D *model);
+   void remove(int id);
+   int getSize() const {return models.size();};
+   int getIndex(int id) const {return idToIndex[id];};
+
+   // id based access, used by the Model3D facade
+   Vector3D getPosition(int id) const;
+   void setPosition(int id, float x, float y, float z);
+   FTM getOrientation(int id) const;
+   void setOrientation(int id, const FTM &orientation);
+   void getColor(int id, float &red, float &green, float &blue) const;
+   void setColor(int id, float red, float green, float blue);
+   Material getMaterial(int id) const {return materials[materialIds[idToIndex[id]]];};
+   void setMaterial(int id, const Material &material);
+   int getMeshId(int id) const {return meshIds[idToIndex[id]];};
+   void setMeshId(int id, int meshId) {meshIds[idToIndex[id]] = meshId;};
+   unsigned int getTextureId(int id) const {return textureIds[idToIndex[id]];};
+   void setTextureId(int id, unsigned int textureId) {textureIds[idToIndex[id]] = textureId;};
+   bool isLit(int id) const {return (flags[idToIndex[id]] & LIT_FLAG) != 0;};
+   void setLit(int id, bool lit);
+   void setBounds(int id, const Vector3D &center, float radius);
+   int getSpatialId(int id) const {return spatialIds[idToIndex[id]];};
+   void setSpatialId(int id, int spatialId) {spatialIds[idToIndex[id]] = spatialId;};
+
+   // dense index access, used by the per frame sweeps
+   void updateTransforms(JobSystem *jobs=0);
+   void updateTransforms(const SceneSnapshot &snapshot, float alpha, bool newSnapshot, JobSystem *jobs=0);
+   void beginTick();
+   void setInterpolation(float alpha);
+   Model3D* getModelAt(int index) const {return models[index];};
+   bool hasMovedAt(int index) const {return moved[index] != 0;};
+   int getStillUpdatesAt(int index) const {return stillUpdates[index];};
+   bool isLitAt(int index) const {return lit[index] != 0;};
+   const float* getWorldMatrixAt(int index) const {return &worldMatrices[index * 16];};
+   const float* getWorldSphereAt(int index) const {return &worldSpheres[index * 4];};
+   const float* getColorAt(int index) const {return &colors[index * 3];};
+   int getMaterialIdAt(int index) const {return materialIds[index];};
+   const Material& getSharedMaterial(int materialId) const {return materials[materialId];};
+   int getMeshIdAt(int index) const {return meshIds[index];};
+   unsigned int getTextureIdAt(int index) const {return textureIds[index];};
+   int getSpatialIdAt(int index) const {return spatialIds[index];};
+
+   // the simulation's arrays, copied by SceneSnapshot::capture
+   const float* getPositionAt(int index) const {return &positions[index * 3];};
+   const float* getPreviousPositionAt(int index) const {return &previousPositions[index * 3];};
+   const float* getOrientationAt(int index) const {return &orientations[index * 16];};
+   unsigned int getFlagsAt(int index) const {return flags[index];};
+};
+}
+#endif
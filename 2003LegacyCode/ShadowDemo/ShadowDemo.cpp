@@ -1,556 +1,1378 @@
-/**
-\mainpage
-\section title Shadows and Mesh Loading
-
-   Jason Dudash                              <br>
-   CS5984 - Computer Graphics, Spring 2003   <br>
-
-\section overview Project Overview:
-  This project demonstrates real-time shadowing techniques as well as an
-example of loading 3D geometry information from a file.  These topics are
-explored in more detail in the accompanying paper: "Shadows and Complex Geometry".
-
-\section features Features:
-- Texture Mapping, Mipmapping, Skinabble Meshes
-- Point Lights
-- Planar Projected Shadows
-- Smooth Shading
-- Mesh Loading (from .x files)
-- Double Buffering
-- OpenGL Display Lists (for improved rendering speeds)
-- Scene Based Rendering
-- Fullscreen Mode
-
-\section build How to Build & Dependencies:
-  This project was developed in Microsoft Visual Studio 6.0.  It requires that
-you have installed GLUT.  If you are attempting to bulid this project in another
-development environment make sure you link in: glaux.lib.
-
-\subsection depends Dependencies include:
-    -# tank.x
-    -# greentank.bmp
-    -# browntank.bmp
-    -# fireball.bmp
-    -# grass.bmp
-
-\section exec How To Run:
-Goto "[install dir]/ShadowDemo/Release" and double-click "ShadowDemo.exe".
-Or from a command prompt type "[install dir]/ShadowDemo/Release/ShadowDemo.exe"
-
-\section future Future Feature List
-- Sync all activity on a timer
-- Unkludge the fireball implementation
-- Fix loadable x file mesh texture mapping
-- Collision detection
-- Create a VolumeShadowScene Class
-- Create an ObjectManager/Resource Loader class
-- Use a Composite design pattern for Model3D in order to nest models
-- Add multiple mesh loading capability to XFileLoader
-- Skybox
-- Add colors to lights
-*/
-#include <stdlib.h>
-#include <math.h>
-#include <iostream>
-#include <sstream>
-#include "ShadowDemo.h"
-#include "XFileLoader.h"
-#include "PlanarProjectedShadowScene.h"
-#include "Vector3D.h"
-#include "Camera.h"
-#include "FTM.h"
-
-/** \namespace std namespace is defined by the C++ STL */
-using namespace std;
-/** \namespace SML_CORE The CORE functionality of the Shadows and Mesh Loading Engine */
-using namespace SML_CORE;
-/** \namespace SML_APP The APPLICATION that demonstrates the Shadows and Mesh Loading Engine */
-using namespace SML_APP;
-
-namespace SML_APP
-{
-// temp place for variables
-ShadowableScene *theScene;
-Camera *theCamera;
-Model3D *groundModel;
-Model3D *teapotModel;
-Model3D *evilTankModel;
-Model3D *tankModel;
-
-//-----------------------------------------------------------------------------
-/**
-   Initalize the system
-*/
-void initialize()
-{
-   //glClearColor(0.6, 0.6, 0.8, 1.0);
-   glClearColor(0.0, 0.0, 0.0, 1.0);
-   glEnable(GL_DEPTH_TEST);
-   glShadeModel (GL_SMOOTH);
-
-   // load the bitmap textures
-   createTexture(textureList, "grass.bmp", GRASS_TEXTURE);
-   createTexture(textureList, "fireball.bmp", FIREBALL_TEXTURE);
-   createTexture(textureList, "greentank.bmp", TANK_TEXTURE);
-   createTexture(textureList, "browntank.bmp", EVIL_TANK_TEXTURE);
-
-   // load in the hardcoded geometry
-   initDisplayLists();
-
-   /// \todo replace individual models with a list
-   groundModel = new Model3D("Ground", GROUND, Vector3D(0,0,0), false);
-   teapotModel = new Model3D("Teapot", TEAPOT, Vector3D(0,5,20));
-   evilTankModel = new Model3D("EvilTank", EVIL_TANK, Vector3D(75,0,150));
-   tankModel = new Model3D("Tank", TANK, Vector3D(100,0,100));
-
-   // set a texture to be used when drawing these models
-   tankModel->setTexture(TANK_TEXTURE, textureList);
-   evilTankModel->setTexture(EVIL_TANK_TEXTURE, textureList);
-
-   // load in the mesh data geometry
-   XFileLoader tankLoader;
-   if (tankLoader.loadXFile("tank.x"))
-   {
-      tankLoader.createModel3D(tankModel);
-      tankModel->createOpenGLDisplayList();
-      tankLoader.createModel3D(evilTankModel);
-      evilTankModel->createOpenGLDisplayList();
-   }
-   else
-   {
-      cout << "ERROR! - Could not load tank model" << endl;
-      finalize();
-   }
-
-   // Create & setup the scene and the Camera
-   theScene =  new PlanarProjectedShadowScene(); 
-   theCamera = new Camera(Vector3D(10.0,80.0,100.0), Vector3D(150.0,-50.0,100.0));
-
-   // add all our geometry to the scene
-   theScene->addModel(groundModel, ShadowableScene.RECEIVES_SHADOWS);
-   theScene->addModel(tankModel, ShadowableScene.CASTS_SHADOWS);
-   theScene->addModel(evilTankModel, ShadowableScene.CASTS_SHADOWS);
-
-   theScene->addPointLightSource(50.0, 45.0, 100.0);
-   theScene->drawLights(true);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Initalize a texture map into memory
-   Note: this routine is derived from DigiBen's texture mapping tutorial
-   http://www.gametutorials.com/
-*/
-void createTexture(UINT textureArray[], LPSTR fileName, int id)
-{
-   AUX_RGBImageRec *bitmapPtr = NULL;
-
-   if (!fileName) return;
-   bitmapPtr = auxDIBImageLoad(fileName);
-   if (bitmapPtr==NULL) exit(0);
-   glGenTextures(1, &textureArray[id]);
-   glBindTexture(GL_TEXTURE_2D, textureArray[id]);
-   gluBuild2DMipmaps(GL_TEXTURE_2D, 3, bitmapPtr->sizeX, bitmapPtr->sizeY, GL_RGB,
-      GL_UNSIGNED_BYTE, bitmapPtr->data);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-   if (bitmapPtr)
-      if (bitmapPtr->data)
-         free(bitmapPtr);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Initalize display lists with 3d models data
-*/
-void initDisplayLists()
-{
-	//----------------------------------------------
-   // Initialize the ground plane display list,
-   // note: We also stick texture coords to the plane
-	glNewList(GROUND, GL_COMPILE);
-      glPushMatrix();
-		glPushAttrib(GL_ALL_ATTRIB_BITS);
-      glEnable(GL_TEXTURE_2D);
-      glColor3f(1.0,1.0,1.0);
-      glBindTexture(GL_TEXTURE_2D, textureList[GRASS_TEXTURE]);
-		glBegin(GL_POLYGON);
-         glTexCoord2f(0,1);
-         glVertex3f(0.0,0.0,0.0);
-         
-         glTexCoord2f(0.0,0.0);
-         glVertex3f(0.0,0.0,200);
-
-         glTexCoord2f(1.0,0.0);
-         glVertex3f(200,0.0,200);
-         
-         glTexCoord2f(1.0,1.0);
-         glVertex3f(200,0.0,0.0);
-		glEnd();
-      glDisable(GL_TEXTURE_2D);
-		glPopAttrib();
-		glPopMatrix();
-	glEndList();
-
-   //----------------------------------------------
-   // Initialize the teapot display list
-	glNewList(TEAPOT, GL_COMPILE);
-      glPushMatrix();
-		glPushAttrib(GL_ALL_ATTRIB_BITS);
-      glutSolidTeapot(2.0);
-		glPopAttrib();
-		glPopMatrix();
-	glEndList();
-
-	//----------------------------------------------
-   // Initialize the fireball display list
-	glNewList(FIREBALL, GL_COMPILE);
-      glPushMatrix();
-		glPushAttrib(GL_ALL_ATTRIB_BITS);
-      glEnable(GL_TEXTURE_2D);
-      glEnable(GL_TEXTURE_GEN_S);
-      glTranslatef(0.0,5.0,0.0);
-      glBindTexture(GL_TEXTURE_2D, textureList[FIREBALL_TEXTURE]);
-      glTexCoord2f(0.0,1.0);
-      glutSolidSphere (0.6, 20, 16);
-      glutSolidTetrahedron();
-      glDisable(GL_TEXTURE_GEN_S);
-      glDisable(GL_TEXTURE_2D);
-		glPopAttrib();
-		glPopMatrix();
-	glEndList();
-}
-
-//-----------------------------------------------------------------------------
-/**
-   create the menu system and attach it to the proper input
-*/
-void initMenuSystem()
-{
-   int keyboardCommandsMenu = glutCreateMenu(handleMainMenuInput);
-   glutAddMenuEntry("1,2 : Select Tank", MENU_NONE);
-   glutAddMenuEntry("WSAD : Move Current Tank", MENU_NONE);
-   glutAddMenuEntry("<space> : Fire!", MENU_NONE);
-   glutAddMenuEntry("Q : Quit", MENU_NONE);
-   int cameraMenu = glutCreateMenu(handleMainMenuInput);
-   glutAddMenuEntry("HighUp Cam", MENU_HIGHUP_CAM);
-   glutAddMenuEntry("Side Cam", MENU_SIDE_CAM);
-   //glutAddMenuEntry("Tank Cam", MENU_TOGGLE_ATTACH_TO_TANK);
-   int mainMenu = glutCreateMenu(handleMainMenuInput);
-   glutAddMenuEntry("Shadows On", MENU_SHADOWS_ON);
-   glutAddMenuEntry("Shadows Off", MENU_SHADOWS_OFF);
-   glutAddMenuEntry("--------------------", MENU_NONE);
-   glutAddSubMenu("Camera", cameraMenu);
-   glutAddMenuEntry("--------------------", MENU_NONE);
-   glutAddMenuEntry("Toggle Fullscreen", MENU_TOGGLE_FULLSCREEN);
-   glutAddMenuEntry("Toggle Show Lights", MENU_TOGGLE_SHOWLIGHTS);
-   glutAddMenuEntry("--------------------", MENU_NONE);
-   glutAddSubMenu("Keyboard Commands", keyboardCommandsMenu);
-   glutAddMenuEntry("--------------------", MENU_NONE);
-   glutAddMenuEntry("Quit", MENU_EXIT);
-   glutAttachMenu(GLUT_RIGHT_BUTTON);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Callback that occurs when glut thinks its time to redraw the window.
-*/
-void handleDisplay()
-{
-   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-   glMatrixMode(GL_MODELVIEW);
-   glLoadIdentity();
-
-   theCamera->update();
-   theScene->render();
-
-   glFlush();
-   glutSwapBuffers();
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Callback that occurs when the window is resized.
-*/
-void handleReshape(int width, int height)
-{
-   // set the perspective
-   glMatrixMode(GL_PROJECTION);
-   glLoadIdentity();
-   float ratio = 1.0 * width / height;
-   gluPerspective(60.0,ratio,1.0,500.0);
-   glMatrixMode(GL_MODELVIEW);
-   glViewport(0, 0, width, height);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Callback that handle menu input
-*/
-void handleMainMenuInput(int input)
-{
-   switch(input)
-   {
-   case MENU_EXIT:
-      finalize();
-      break;
-   case MENU_SIDE_CAM:
-      theCamera->locX = 10;
-      theCamera->locY = 30;
-      theCamera->locZ = 100;
-      break;
-   case MENU_HIGHUP_CAM:
-      theCamera->locX = 10;
-      theCamera->locY = 80;
-      theCamera->locZ = 100;
-      break;
-   case MENU_TOGGLE_ATTACH_TO_TANK:
-      if (theCamera->isAttached())
-         theCamera->unattach();
-      else
-         theCamera->attachToModel(tankModel);
-      break;
-   case MENU_TOGGLE_FULLSCREEN:
-      if (fullscreen)
-      {
-         glutReshapeWindow(WINDOW_WIDTH, WINDOW_HEIGHT);
-         glutPositionWindow(50,50);
-         fullscreen = false;
-      }
-      else
-      {
-         glutFullScreen();
-         fullscreen = true;
-      }
-      break;
-   case MENU_TOGGLE_SHOWLIGHTS:
-      if (theScene->isDrawLightsOn())
-         theScene->drawLights(false);
-      else
-         theScene->drawLights(true);
-      break;
-   case MENU_SHADOWS_ON:
-      theScene->turnOnShadows();
-      break;
-   case MENU_SHADOWS_OFF:
-      theScene->turnOffShadows();
-      break;
-   }
-   glutPostRedisplay();
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Callback to handle mouse events
-*/
-void handleMouse(int button, int state, int x, int y)
-{
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Callback to handle keyboard events
-*/
-void handleKeyboardInput(unsigned char key, int x, int y)
-{
-   switch (key)
-   {
-   case 'q':
-   case 'Q':
-      finalize();
-      break;
-   case 'w':
-   case 'W':
-      // move forward
-      if (currentTank==1) tankModel->moveModel(1,0,0);
-      else if (currentTank==2) evilTankModel->moveModel(1,0,0);
-      break;
-   case 's':
-   case 'S':
-      // move backward
-      if (currentTank==1) tankModel->moveModel(-1,0,0);
-      else if (currentTank==2) evilTankModel->moveModel(-1,0,0);
-      break;
-   case 'a':
-   case 'A':
-      // turn left
-      if (currentTank==1) tankModel->rotateModel(5, 0,1,0);
-      else if (currentTank==2) evilTankModel->rotateModel(5, 0,1,0);
-      break;
-   case 'd':
-   case 'D':
-      // turn right
-      if (currentTank==1) tankModel->rotateModel(-5, 0,1,0);
-      else if (currentTank==2) evilTankModel->rotateModel(-5, 0,1,0);
-      break;
-   case 'i':
-   case 'I':
-
-      break;
-   case 'k':
-   case 'K':
-
-      break;
-   case 'j':
-   case 'J':
-
-      break;
-   case 'l':
-   case 'L':
-
-      break;
-   case ' ':
-      //fireBall(tankModel);
-      cout << "Fire!" << endl;
-      if (currentTank==1) createFireball(tankModel);
-      else if (currentTank==2) createFireball(evilTankModel);
-      break;
-   case '1':
-      currentTank = 1;
-      break;
-   case '2':
-      currentTank = 2;
-      break;
-   case 'B':
-   case 'b':
-      cheaterB=true;
-      break;
-   case 'e':
-      if (!cheaterB) break;
-      if (!cheaterE) {cheaterE=true;break;}
-      if (cheaterE2) {
-         // turn it off
-         cheaterB = false;
-         cheaterE = false;
-         cheaterE2 = false;
-         cout << "normal fire mode" << endl;
-         break;
-      }
-
-      else cheaterE2 = true;
-      cout << "KILLER BEES!" << endl;
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Callback to handle idle mode
-*/
-void handleIdle()
-{
-   glutPostRedisplay();
-   handleFireballs();
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Cleanup the application before we close
-*/
-void finalize()
-{
-   glDeleteTextures(1, &textureList[GRASS_TEXTURE]);
-
-   if (theScene) delete theScene;
-   if (theCamera) delete theCamera;
-   if (groundModel) delete groundModel;
-   if (teapotModel) delete teapotModel;
-   if (evilTankModel) delete evilTankModel;
-   if (tankModel) delete tankModel;
-
-   //cleanup fireballs (if any)
-   Model3D* tempModel;
-   for (int fireIndex=0; fireIndex<fireballs.size(); fireIndex++)
-   {
-      tempModel = fireballs[fireIndex];
-      delete tempModel;
-   }
-
-   exit(0);
-}
-
-
-//-----------------------------------------------------------------------------
-/**
-   A really quick kuldge to make the demo more fun.  A real implmentation
-   would require alot more functionality in the system (time calcs, world to
-   store geometry and update, etc...)
-*/
-void handleFireballs()
-{
-   // loop thru the list of fireballs
-   Model3D* tempModel;
-   for (int fireIndex=0; fireIndex<fireballs.size(); fireIndex++)
-   {
-      tempModel = fireballs[fireIndex];
-      // dont ever remove any... it's just temp code anyway.
-      if (false)
-      {
-         // remove it
-         theScene->removeModel(tempModel->getName());
-         delete tempModel;
-         tempModel = 0;
-         fireballs.erase(&fireballs[fireIndex]);
-      }
-      else
-      {
-         tempModel->moveModel(2.5,0,0);
-
-         // Remove this comment for "killer bees"
-         if (cheaterE2) tempModel->rotateModel(5, 0,1,0);
-      }
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   A really quick kuldge to make the demo more fun.  A real implmentation
-   would require alot more functionality in the system (time calcs, world to
-   store geometry and update, etc...)
-*/
-void createFireball(Model3D *tankModel)
-{
-   numFired++;
-   Vector3D initialPos = tankModel->getPosition();
-   FTM initialOrient = tankModel->getFTM();
-   stringstream streamName("");
-   streamName << "Fireball" << numFired;
-   Model3D* tempModel = new Model3D(streamName.str(), FIREBALL, initialPos);
-   tempModel->setTransformMatrix(initialOrient);
-   // nudge it forward a bit
-   tempModel->moveModel(5,0,0);
-   tempModel->setTexture(FIREBALL_TEXTURE, textureList);
-   fireballs.push_back(tempModel);
-
-   theScene->addModel(tempModel, ShadowableScene.CASTS_SHADOWS);
-}
-}
-
-/**
-  This is the entry point into the application
-  */
-int main(int argc, char** argv)
-{
-   // setup glut and create a window
-   glutInit(&argc,argv);
-   glutInitDisplayMode (GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-   glutInitWindowSize(WINDOW_WIDTH,WINDOW_HEIGHT);
-   glutInitWindowPosition(150,150);
-   glutCreateWindow("Shadows & Mesh Loading");
-
-   // program initilization
-   initialize();
-   initMenuSystem();
-
-   // setup our callbacks
-   glutDisplayFunc(handleDisplay);
-   glutReshapeFunc(handleReshape);
-   glutMouseFunc(handleMouse);
-   glutKeyboardFunc(handleKeyboardInput);
-   glutIdleFunc(handleIdle);
-
-   // start
-   glutMainLoop();
-
-   return 0;
+/**
+\mainpage
+\section title Shadows and Mesh Loading
+
+   Jason Dudash                              <br>
+   CS5984 - Computer Graphics, Spring 2003   <br>
+
+\section overview Project Overview:
+  This project demonstrates real-time shadowing techniques as well as an
+example of loading 3D geometry information from a file.  These topics are
+explored in more detail in the accompanying paper: "Shadows and Complex Geometry".
+
+\section features Features:
+- Texture Mapping, Mipmapping, Skinabble Meshes
+- Point Lights (hundreds of them with -lights N, sorted into clusters of
+  the view each frame, the most significant are shadowed and the rest are
+  lit per pixel by the shadow maps' lighting pass)
+- Planar Projected Shadows (drawn from the casters' convex hulls where
+  they are close, run with -noshadowproxies to draw the whole model, the
+  shadows of models that have stopped moving are kept in textures)
+- Omnidirectional Shadow Maps (run with -shadowmaps)
+- Cascaded Shadow Maps for the sun (run with -shadowmaps -sun)
+- Soft Shadow Map Filtering (4 and 16 tap percentage closer filtering and
+  variance shadow maps, press H to step through them)
+- Stencil Shadow Volumes (run with -shadowvolumes)
+- Shadow Scheduling (distant and slow casters keep their shadow volumes and
+  outlines for a few frames, run with -noshadowscheduler to build them
+  every frame)
+- Smooth Shading
+- Mesh Loading (from .x files)
+- Double Buffering
+- OpenGL Display Lists (for improved rendering speeds)
+- Scene Based Rendering
+- Fullscreen Mode
+
+\section build How to Build & Dependencies:
+  This project was developed in Microsoft Visual Studio 6.0.  It requires that
+you have installed GLUT.  If you are attempting to bulid this project in another
+development environment make sure you link in: glaux.lib.
+
+\subsection depends Dependencies include:
+    -# tank.x
+    -# greentank.bmp
+    -# browntank.bmp
+    -# fireball.bmp
+    -# grass.bmp
+
+\section exec How To Run:
+Goto "[install dir]/ShadowDemo/Release" and double-click "ShadowDemo.exe".
+Or from a command prompt type "[install dir]/ShadowDemo/Release/ShadowDemo.exe"
+Add -shadowmaps to the command line to shadow with cube shadow maps instead of
+planar projection, or -shadowvolumes to shadow with stencil shadow volumes.
+Add -sun to light the scene with the sun instead of the point light, it is
+shadowed with cascaded shadow maps by -shadowmaps.
+Add -lights 500 (or any number up to 1024) to scatter that many small colored
+lights over the ground.
+Add -noshadowproxies to draw the whole tank for its planar shadow.
+Add -noshadowscheduler to build every tank's shadow volume or outline every
+frame, instead of less often for distant and slow tanks.
+Press V to time each technique drawing a grid of tanks, with and without
+the shadow scheduler, and the shadow maps with each filter.  Press H to step through the shadow map filters.  Press O
+to time culling crowds of 200 to 100000 objects with the octree against
+testing them all.
+
+\section future Future Feature List
+- Fix loadable x file mesh texture mapping
+- Collision detection
+- Create an ObjectManager/Resource Loader class
+- Use a Composite design pattern for Model3D in order to nest models
+- Add multiple mesh loading capability to XFileLoader
+- Skybox
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <iostream>
+#include "ShadowDemo.h"
+#include "XFileLoader.h"
+#include "PlanarProjectedShadowScene.h"
+#include "ShadowMapScene.h"
+#include "VolumeShadowScene.h"
+#include "Vector3D.h"
+#include "Camera.h"
+#include "FTM.h"
+#include "AllocationCounter.h"
+#include "Platform.h"
+
+/** \namespace std namespace is defined by the C++ STL */
+using namespace std;
+/** \namespace SML_CORE The CORE functionality of the Shadows and Mesh Loading Engine */
+using namespace SML_CORE;
+/** \namespace SML_APP The APPLICATION that demonstrates the Shadows and Mesh Loading Engine */
+using namespace SML_APP;
+
+namespace SML_APP
+{
+// temp place for variables
+ShadowableScene *theScene;
+Camera *theCamera;
+Model3D *groundModel;
+Model3D *teapotModel;
+Model3D *evilTankModel;
+Model3D *tankModel;
+
+//-----------------------------------------------------------------------------
+/**
+   Initalize the system
+*/
+void initialize()
+{
+   //glClearColor(0.6, 0.6, 0.8, 1.0);
+   glClearColor(0.0, 0.0, 0.0, 1.0);
+   glEnable(GL_DEPTH_TEST);
+   glShadeModel (GL_SMOOTH);
+
+   // start the worker threads
+   jobs = new JobSystem();
+
+   // read the bitmap textures on the workers, each one is handed to openGL
+   // on this thread once it has been read
+   JobId texturesLoaded = jobs->createJob(0, 0);
+   for (int index = 0; index < TEXTURE_LIST_SIZE; index++)
+   {
+      JobId read = jobs->createJob(readTextureBitmap, &textureLoads[index]);
+      JobId upload = jobs->createMainThreadJob(uploadTexture, &textureLoads[index]);
+      jobs->addDependency(upload, read);
+      jobs->addDependency(texturesLoaded, upload);
+      jobs->submit(read);
+      jobs->submit(upload);
+   }
+   jobs->submit(texturesLoaded);
+
+   // the tank mesh is read at the same time
+   XFileLoader tankLoader;
+   JobId tankRead = jobs->run(readTankMesh, &tankLoader);
+
+   // load in the hardcoded geometry while that goes on
+   initDisplayLists();
+   jobs->wait(texturesLoaded);
+
+   /// \todo replace individual models with a list
+   groundModel = new (modelPool.allocate()) Model3D("Ground", GROUND, Vector3D(0,0,0), false);
+   teapotModel = new (modelPool.allocate()) Model3D("Teapot", TEAPOT, Vector3D(0,5,20));
+   evilTankModel = new (modelPool.allocate()) Model3D("EvilTank", EVIL_TANK, Vector3D(75,0,150));
+   tankModel = new (modelPool.allocate()) Model3D("Tank", TANK, Vector3D(100,0,100));
+
+   // models built from hand made display lists need their bounds set
+   groundModel->setBounds(BoundingVolume(Vector3D(0,0,0), Vector3D(200,0,200)));
+   teapotModel->setBounds(BoundingVolume(Vector3D(-3,-2,-2), Vector3D(3.5,2,2)));
+
+   // set a texture to be used when drawing these models
+   groundModel->setTexture(GRASS_TEXTURE, textureList);
+   tankModel->setTexture(TANK_TEXTURE, textureList);
+   evilTankModel->setTexture(EVIL_TANK_TEXTURE, textureList);
+
+   // load in the mesh data geometry
+   jobs->wait(tankRead);
+   if (tankMeshLoaded)
+   {
+      tankLoader.createModel3D(tankModel);
+      tankModel->createOpenGLDisplayList();
+      tankModel->setShadowProxyAllowed(shadowProxiesOn);
+      tankLoader.createModel3D(evilTankModel);
+      evilTankModel->createOpenGLDisplayList();
+      evilTankModel->setShadowProxyAllowed(shadowProxiesOn);
+   }
+   else
+   {
+      cout << "ERROR! - Could not load tank model" << endl;
+      finalize();
+   }
+
+   // Create & setup the scene and the Camera
+   theScene = createScene(shadowTechnique);
+   theCamera = new Camera(Vector3D(10.0,80.0,100.0), Vector3D(150.0,-50.0,100.0));
+   theScene->setCamera(theCamera);
+   theScene->setJobSystem(jobs);
+
+   // frames are fenced so the CPU stays a set number of frames ahead
+   framePacer = new FramePacer(FRAMES_IN_FLIGHT, STREAM_BYTES_PER_FRAME);
+   theScene->setStreamBuffer(&framePacer->getStreamBuffer());
+
+   // add all our geometry to the scene
+   theScene->addModel(groundModel, ShadowableScene.RECEIVES_SHADOWS);
+   theScene->addModel(tankModel, ShadowableScene.CASTS_SHADOWS);
+   theScene->addModel(evilTankModel, ShadowableScene.CASTS_SHADOWS);
+
+   // the fireballs are drawn by the scene in a batch
+   fireballs = new ProjectileSystem(MAX_FIREBALLS);
+   fireballs->setTexture(textureList[FIREBALL_TEXTURE]);
+   theScene->setProjectiles(fireballs);
+
+   if (sunOn)
+      theScene->addDirectionalLightSource(0.4, -1.0, 0.3);
+   else
+      theScene->addPointLightSource(50.0, 45.0, 100.0);
+   for (int light = 0; light < extraLights; light++)
+   {
+      float x = rand() / (float)RAND_MAX * 200.0;
+      float z = rand() / (float)RAND_MAX * 200.0;
+      float red = 0.1 + 0.4 * rand() / (float)RAND_MAX;
+      float green = 0.1 + 0.4 * rand() / (float)RAND_MAX;
+      float blue = 0.1 + 0.4 * rand() / (float)RAND_MAX;
+      theScene->addPointLightSource(x, EXTRA_LIGHT_HEIGHT, z, EXTRA_LIGHT_RADIUS, red, green, blue);
+   }
+   theScene->drawLights(true);
+
+   // everything is in place, the simulation can run on its own now
+   startSimulation();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read a texture's bitmap from disk.  This is a job, it doesn't touch
+   openGL so it can run on any thread.
+   Note: this routine is derived from DigiBen's texture mapping tutorial
+   http://www.gametutorials.com/
+
+  @param data The TextureLoad to read
+*/
+void readTextureBitmap(void *data, int begin, int end)
+{
+   TextureLoad *load = (TextureLoad*)data;
+   if (!load->fileName) return;
+   load->bitmap = auxDIBImageLoad(load->fileName);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Initalize a texture map into memory from its bitmap.  This is a main
+   thread job (it calls openGL).
+
+  @param data The TextureLoad that has been read
+*/
+void uploadTexture(void *data, int begin, int end)
+{
+   TextureLoad *load = (TextureLoad*)data;
+   AUX_RGBImageRec *bitmapPtr = load->bitmap;
+
+   if (!load->fileName) return;
+   if (bitmapPtr==NULL) exit(0);
+   glGenTextures(1, &textureList[load->id]);
+   glBindTexture(GL_TEXTURE_2D, textureList[load->id]);
+   gluBuild2DMipmaps(GL_TEXTURE_2D, 3, bitmapPtr->sizeX, bitmapPtr->sizeY, GL_RGB,
+      GL_UNSIGNED_BYTE, bitmapPtr->data);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+   if (bitmapPtr)
+      if (bitmapPtr->data)
+         free(bitmapPtr);
+   load->bitmap = NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read the tank mesh from disk.  This is a job, the display lists are made
+   from it on the main thread.
+
+  @param data The XFileLoader to read into
+*/
+void readTankMesh(void *data, int begin, int end)
+{
+   tankMeshLoaded = ((XFileLoader*)data)->loadXFile("tank.x");
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Initalize display lists with 3d models data
+*/
+void initDisplayLists()
+{
+	//----------------------------------------------
+   // Initialize the ground plane display list,
+   // note: We also stick texture coords to the plane, the scene binds the
+   // texture and sets the color before calling the list
+	glNewList(GROUND, GL_COMPILE);
+      glPushMatrix();
+		glBegin(GL_POLYGON);
+         glTexCoord2f(0,1);
+         glVertex3f(0.0,0.0,0.0);
+         
+         glTexCoord2f(0.0,0.0);
+         glVertex3f(0.0,0.0,200);
+
+         glTexCoord2f(1.0,0.0);
+         glVertex3f(200,0.0,200);
+         
+         glTexCoord2f(1.0,1.0);
+         glVertex3f(200,0.0,0.0);
+		glEnd();
+		glPopMatrix();
+	glEndList();
+
+   //----------------------------------------------
+   // Initialize the teapot display list
+	glNewList(TEAPOT, GL_COMPILE);
+      glPushMatrix();
+      glutSolidTeapot(2.0);
+		glPopMatrix();
+	glEndList();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   create the menu system and attach it to the proper input
+*/
+void initMenuSystem()
+{
+   int keyboardCommandsMenu = glutCreateMenu(handleMainMenuInput);
+   glutAddMenuEntry("1,2 : Select Tank", MENU_NONE);
+   glutAddMenuEntry("WSAD : Move Current Tank", MENU_NONE);
+   glutAddMenuEntry("<space> : Fire!", MENU_NONE);
+   glutAddMenuEntry("P : Fireball Storm", MENU_NONE);
+   glutAddMenuEntry("F : Print Frame Statistics", MENU_NONE);
+   glutAddMenuEntry("H : Cycle Shadow Map Filter", MENU_NONE);
+   glutAddMenuEntry("Q : Quit", MENU_NONE);
+   int cameraMenu = glutCreateMenu(handleMainMenuInput);
+   glutAddMenuEntry("HighUp Cam", MENU_HIGHUP_CAM);
+   glutAddMenuEntry("Side Cam", MENU_SIDE_CAM);
+   //glutAddMenuEntry("Tank Cam", MENU_TOGGLE_ATTACH_TO_TANK);
+   int mainMenu = glutCreateMenu(handleMainMenuInput);
+   glutAddMenuEntry("Shadows On", MENU_SHADOWS_ON);
+   glutAddMenuEntry("Shadows Off", MENU_SHADOWS_OFF);
+   glutAddMenuEntry("--------------------", MENU_NONE);
+   glutAddSubMenu("Camera", cameraMenu);
+   glutAddMenuEntry("--------------------", MENU_NONE);
+   glutAddMenuEntry("Toggle Fullscreen", MENU_TOGGLE_FULLSCREEN);
+   glutAddMenuEntry("Toggle Show Lights", MENU_TOGGLE_SHOWLIGHTS);
+   glutAddMenuEntry("--------------------", MENU_NONE);
+   glutAddSubMenu("Keyboard Commands", keyboardCommandsMenu);
+   glutAddMenuEntry("--------------------", MENU_NONE);
+   glutAddMenuEntry("Quit", MENU_EXIT);
+   glutAttachMenu(GLUT_RIGHT_BUTTON);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Callback that occurs when glut thinks its time to redraw the window.
+*/
+void handleDisplay()
+{
+   // wait here if the GPU is more than the frames in flight behind
+   framePacer->beginFrame();
+
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+   glMatrixMode(GL_MODELVIEW);
+   glLoadIdentity();
+
+   int now = getMilliseconds();
+   simulationClock.beginFrame(now);
+   unsigned long allocationsBefore = AllocationCounter::getThreadAllocations();
+   unsigned long allAllocationsBefore = AllocationCounter::getNumAllocations();
+
+   // do any openGL work the jobs have handed back
+   jobs->runMainThreadJobs();
+
+   // draw the newest tick the simulation has finished, moved on from the
+   // tick before by how long ago it finished
+   bool isNew = snapshots.acquire();
+   const SceneSnapshot &snapshot = snapshots.getReadBuffer();
+   float alpha = (now - snapshot.tickTime) * simulationClock.getTickRate() / 1000.0f;
+   if (alpha < 0.0)
+      alpha = 0.0;
+   if (alpha > 1.0)
+      alpha = 1.0;
+   theScene->setSnapshot(&snapshot, isNew);
+   theScene->setInterpolation(alpha);
+
+   updateCamera(snapshot);
+   theScene->render();
+
+   // the workers and the simulation run on while this frame is drawn, only
+   // what this thread allocates is counted against the frame
+   frameAllocations = AllocationCounter::getThreadAllocations() - allocationsBefore;
+   frameAllocationsAllThreads = AllocationCounter::getNumAllocations() - allAllocationsBefore;
+
+   framePacer->endFrame();
+   glutSwapBuffers();
+
+   // with a frame cap the next frame waits for its time to come around.
+   // Only one timer is kept waiting, frames drawn for other reasons (a
+   // resize, a benchmark) would otherwise start more timer chains.
+   if (simulationClock.getFrameCap() != 0 && !timerPending)
+   {
+      timerPending = true;
+      glutTimerFunc(simulationClock.getFrameDelay(getMilliseconds()), handleTimer, 0);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Move the camera for a frame.  An attached camera follows the model as
+   the snapshot has it.
+
+  @param snapshot The simulation tick being drawn
+*/
+void updateCamera(const SceneSnapshot &snapshot)
+{
+   if (theCamera->isAttached())
+   {
+      Model3D *attached = theCamera->attachModel;
+      theCamera->update(snapshot.getOrientationAt(attached->getStore()->getIndex(attached->getStoreId())));
+   }
+   else
+   {
+      theCamera->update();
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the last frame again, twice, into the back buffer and count the
+   heap allocations this thread makes drawing the second.  The first brings
+   the scene's buffers up to what the frame needs, so the second should
+   make none.
+
+  @return The allocations made drawing the second frame
+*/
+unsigned long countSteadyStateAllocations()
+{
+   unsigned long allocations = 0;
+   for (int frame = 0; frame < 2; frame++)
+   {
+      // paced like any other frame so the GPU doesn't fall further behind
+      framePacer->beginFrame();
+      unsigned long before = AllocationCounter::getThreadAllocations();
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+      glMatrixMode(GL_MODELVIEW);
+      glLoadIdentity();
+      updateCamera(snapshots.getReadBuffer());
+      theScene->render();
+      allocations = AllocationCounter::getThreadAllocations() - before;
+      framePacer->endFrame();
+   }
+   glutPostRedisplay();
+   return allocations;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Callback that occurs when the window is resized.
+*/
+void handleReshape(int width, int height)
+{
+   // set the perspective
+   glMatrixMode(GL_PROJECTION);
+   glLoadIdentity();
+   float ratio = 1.0 * width / height;
+   gluPerspective(60.0,ratio,1.0,500.0);
+   glMatrixMode(GL_MODELVIEW);
+   glViewport(0, 0, width, height);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Callback that handle menu input
+*/
+void handleMainMenuInput(int input)
+{
+   switch(input)
+   {
+   case MENU_EXIT:
+      finalize();
+      break;
+   case MENU_SIDE_CAM:
+      theCamera->locX = 10;
+      theCamera->locY = 30;
+      theCamera->locZ = 100;
+      break;
+   case MENU_HIGHUP_CAM:
+      theCamera->locX = 10;
+      theCamera->locY = 80;
+      theCamera->locZ = 100;
+      break;
+   case MENU_TOGGLE_ATTACH_TO_TANK:
+      if (theCamera->isAttached())
+         theCamera->unattach();
+      else
+         theCamera->attachToModel(tankModel);
+      break;
+   case MENU_TOGGLE_FULLSCREEN:
+      if (fullscreen)
+      {
+         glutReshapeWindow(WINDOW_WIDTH, WINDOW_HEIGHT);
+         glutPositionWindow(50,50);
+         fullscreen = false;
+      }
+      else
+      {
+         glutFullScreen();
+         fullscreen = true;
+      }
+      break;
+   case MENU_TOGGLE_SHOWLIGHTS:
+      if (theScene->isDrawLightsOn())
+         theScene->drawLights(false);
+      else
+         theScene->drawLights(true);
+      break;
+   case MENU_SHADOWS_ON:
+      theScene->turnOnShadows();
+      break;
+   case MENU_SHADOWS_OFF:
+      theScene->turnOffShadows();
+      break;
+   }
+   glutPostRedisplay();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Callback to handle mouse events
+*/
+void handleMouse(int button, int state, int x, int y)
+{
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Callback to handle keyboard events
+*/
+void handleKeyboardInput(unsigned char key, int x, int y)
+{
+   switch (key)
+   {
+   case 'q':
+   case 'Q':
+      finalize();
+      break;
+   case 'f':
+   case 'F':
+      printFrameStatistics();
+      break;
+   case 't':
+   case 'T':
+      runJobBenchmark();
+      break;
+   case 'v':
+   case 'V':
+      runShadowBenchmark();
+      break;
+   case 'o':
+   case 'O':
+      runCullingBenchmark();
+      break;
+   case 'c':
+   case 'C':
+      toggleFrameCap();
+      break;
+   case 'g':
+   case 'G':
+      cycleFramesInFlight();
+      break;
+   case 'h':
+   case 'H':
+      cycleShadowFilter();
+      break;
+   default:
+      // everything else changes the simulation, it waits for the next tick
+      lockMutex(inputLock);
+      if (numPendingInput < MAX_PENDING_INPUT)
+         pendingInput[numPendingInput++] = key;
+      unlockMutex(inputLock);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Do what a key asks.  Called on a simulation tick so a run is the same
+   however fast the frames are drawn.
+*/
+void applyInput(unsigned char key)
+{
+   switch (key)
+   {
+   case 'w':
+   case 'W':
+      // move forward
+      if (currentTank==1) tankModel->moveModel(1,0,0);
+      else if (currentTank==2) evilTankModel->moveModel(1,0,0);
+      break;
+   case 's':
+   case 'S':
+      // move backward
+      if (currentTank==1) tankModel->moveModel(-1,0,0);
+      else if (currentTank==2) evilTankModel->moveModel(-1,0,0);
+      break;
+   case 'a':
+   case 'A':
+      // turn left
+      if (currentTank==1) tankModel->rotateModel(5, 0,1,0);
+      else if (currentTank==2) evilTankModel->rotateModel(5, 0,1,0);
+      break;
+   case 'd':
+   case 'D':
+      // turn right
+      if (currentTank==1) tankModel->rotateModel(-5, 0,1,0);
+      else if (currentTank==2) evilTankModel->rotateModel(-5, 0,1,0);
+      break;
+   case 'i':
+   case 'I':
+
+      break;
+   case 'k':
+   case 'K':
+
+      break;
+   case 'j':
+   case 'J':
+
+      break;
+   case 'l':
+   case 'L':
+
+      break;
+   case ' ':
+      //fireBall(tankModel);
+      cout << "Fire!" << endl;
+      if (currentTank==1) createFireball(tankModel);
+      else if (currentTank==2) createFireball(evilTankModel);
+      break;
+   case 'p':
+   case 'P':
+      if (currentTank==1) createFireballStorm(tankModel);
+      else if (currentTank==2) createFireballStorm(evilTankModel);
+      break;
+   case '1':
+      currentTank = 1;
+      break;
+   case '2':
+      currentTank = 2;
+      break;
+   case 'B':
+   case 'b':
+      cheaterB=true;
+      break;
+   case 'e':
+      if (!cheaterB) break;
+      if (!cheaterE) {cheaterE=true;break;}
+      if (cheaterE2) {
+         // turn it off
+         cheaterB = false;
+         cheaterE = false;
+         cheaterE2 = false;
+         fireballs->setTurnRate(0.0);
+         cout << "normal fire mode" << endl;
+         break;
+      }
+
+      else cheaterE2 = true;
+      fireballs->setTurnRate(300.0);
+      cout << "KILLER BEES!" << endl;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Callback to handle idle mode
+*/
+void handleIdle()
+{
+   glutPostRedisplay();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Callback for the frame cap timer, it is time to start the next frame
+*/
+void handleTimer(int value)
+{
+   timerPending = false;
+   glutPostRedisplay();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start the simulation thread.  The models, fireballs and scene must all
+   be set up first, from here on the simulation thread owns their state and
+   this thread only draws snapshots of it.
+*/
+void startSimulation()
+{
+   inputLock = createLock();
+
+   // start the clock and give the render thread something to draw
+   simulationClock.advance(getMilliseconds());
+   publishSnapshot();
+
+   simulationRunning = true;
+   simulationThread = startThread(runSimulation, 0);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Stop the simulation thread and wait for it to finish its tick
+*/
+void stopSimulation()
+{
+   if (simulationThread)
+   {
+      simulationRunning = false;
+      joinThread(simulationThread);
+      simulationThread = 0;
+   }
+   if (inputLock)
+   {
+      destroyLock(inputLock);
+      inputLock = 0;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The simulation thread.  Run the ticks that are due, hand the result to
+   the render thread, then sleep until the next tick is due.
+*/
+void runSimulation(void *data)
+{
+   while (simulationRunning)
+   {
+      int numTicks = simulationClock.advance(getMilliseconds());
+      for (int tick = 0; tick < numTicks; tick++)
+         simulateTick(simulationClock.getTickSeconds());
+      if (numTicks > 0)
+         publishSnapshot();
+      sleepThread(simulationClock.getTickDelay(getMilliseconds()));
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Copy the scene as the last tick left it into the free snapshot and hand
+   it to the render thread.  Only called on the simulation thread (or before
+   it starts).
+*/
+void publishSnapshot()
+{
+   SceneSnapshot &snapshot = snapshots.getWriteBuffer();
+   theScene->captureSnapshot(snapshot);
+   snapshot.tick = simulationClock.getTickCount();
+   snapshot.tickTime = simulationClock.getTickTime();
+   snapshots.publish();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Step the simulation forward one tick: the keys pressed since the last
+   tick are applied and the fireballs move.
+
+  @param seconds The length of a tick
+*/
+void simulateTick(float seconds)
+{
+   theScene->beginTick();
+
+   // take the keys pressed since the last tick
+   unsigned char keys[MAX_PENDING_INPUT];
+   lockMutex(inputLock);
+   int numKeys = numPendingInput;
+   for (int index = 0; index < numKeys; index++)
+      keys[index] = pendingInput[index];
+   numPendingInput = 0;
+   unlockMutex(inputLock);
+
+   for (int key = 0; key < numKeys; key++)
+      applyInput(keys[key]);
+
+   fireballs->update(seconds, jobs);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Turn the frame cap on or off.  While it is on the frames are started by
+   a timer (the CPU sleeps in between), while it is off by the idle callback.
+*/
+void toggleFrameCap()
+{
+   if (simulationClock.getFrameCap() == 0)
+   {
+      simulationClock.setFrameCap(FRAME_CAP);
+      glutIdleFunc(NULL);
+      glutPostRedisplay();
+      cout << "frame cap " << FRAME_CAP << " fps" << endl;
+   }
+   else
+   {
+      simulationClock.setFrameCap(0);
+      glutIdleFunc(handleIdle);
+      cout << "frame cap off" << endl;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Step through 1, 2 ... FramePacer::MAX_FRAMES_IN_FLIGHT frames in flight.
+   One frame in flight keeps the CPU and GPU in lock step, more let them
+   overlap at the cost of latency.
+*/
+void cycleFramesInFlight()
+{
+   int count = framePacer->getFramesInFlight() % FramePacer::MAX_FRAMES_IN_FLIGHT + 1;
+   framePacer->setFramesInFlight(count);
+   cout << count << " frames in flight" << endl;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Step through the ShadowMapScene's filters, from hard shadows to variance
+   shadow maps
+*/
+void cycleShadowFilter()
+{
+   if (shadowTechnique != SHADOW_MAPS)
+   {
+      cout << "the shadow filters are only used by shadow maps (run with -shadowmaps)" << endl;
+      return;
+   }
+   ShadowMapScene *mapScene = (ShadowMapScene*)theScene;
+   int filter = (mapScene->getShadowFilter() + 1) % ShadowMapScene::NUM_SHADOW_FILTERS;
+   mapScene->setShadowFilter(filter);
+   cout << "shadow filter: " << shadowFilterNames[filter] << endl;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Print the counters gathered while rendering the last frame
+*/
+void printFrameStatistics()
+{
+   cout << "Frame statistics:" << endl;
+   cout << "  models tested         = " << theScene->getObjectsTested()
+        << " (a linear scan tests " << theScene->getNumModels() << ")" << endl;
+   cout << "  models rejected       = " << theScene->getObjectsRejected() << endl;
+   cout << "  casters tested        = " << theScene->getCastersTested() << endl;
+   cout << "  casters rejected      = " << theScene->getCastersRejected() << endl;
+   cout << "  shadow pairs tested   = " << theScene->getShadowPairsTested() << endl;
+   cout << "  shadow pairs rejected = " << theScene->getShadowPairsRejected() << endl;
+   cout << "  model draws           = " << theScene->getNumDraws() << endl;
+   cout << "  point lights          = " << theScene->getNumPointLights() << endl;
+   cout << "  lights shadowed       = " << theScene->getNumShadowedLights() << endl;
+   const LightClusters &clusters = theScene->getLightClusters();
+   if (clusters.getClustersUsed() > 0)
+   {
+      cout << "  lights in view        = " << clusters.getLightsInView() << endl;
+      cout << "  light clusters used   = " << clusters.getClustersUsed() << " of " << LightClusters::NUM_CLUSTERS << endl;
+      cout << "  most cluster lights   = " << clusters.getMostClusterLights() << endl;
+      cout << "  lights left out       = " << clusters.getLightsLeftOut() << endl;
+   }
+   cout << "  shadows rebuilt       = " << theScene->getShadowScheduler().getRefreshes() << endl;
+   cout << "  shadows deferred      = " << theScene->getShadowScheduler().getCasterDeferrals() << endl;
+   cout << "  fireballs live        = " << snapshots.getReadBuffer().numProjectiles << endl;
+   cout << "  fireballs drawn       = " << theScene->getProjectilesDrawn() << endl;
+   cout << "  state changes issued  = " << theScene->getStateChangesIssued() << endl;
+   cout << "  state changes avoided = " << theScene->getStateChangesAvoided() << endl;
+   if (AllocationCounter::isEnabled())
+   {
+      cout << "  heap allocations      = " << frameAllocations << " drawing, "
+           << frameAllocationsAllThreads << " on all threads" << endl;
+      unsigned long steadyAllocations = countSteadyStateAllocations();
+      cout << "  drawn again, allocs   = " << steadyAllocations << endl;
+      if (steadyAllocations != 0)
+      {
+         cout << "WARNING: drawing the same frame again still allocated "
+              << steadyAllocations << " times" << endl;
+      }
+   }
+   else
+   {
+      cout << "  heap allocations      = (not counted in this build)" << endl;
+   }
+   cout << "  frames in flight      = " << framePacer->getFramesInFlight();
+   if (!framePacer->isPaced())
+      cout << " (no fences, not paced)";
+   cout << endl;
+   cout << "  CPU wait on GPU       = " << framePacer->getCpuWaitTime() << " ms" << endl;
+   cout << "  GPU wait on CPU       = " << framePacer->getGpuWaitTime() << " ms" << endl;
+   cout << "  GPU frame time        = " << framePacer->getGpuFrameTime() << " ms" << endl;
+   StreamBuffer &streamBuffer = framePacer->getStreamBuffer();
+   if (streamBuffer.isMapped())
+      cout << "  stream buffer used    = " << streamBuffer.getBytesUsed() << " of "
+           << streamBuffer.getRegionSize() << " bytes, "
+           << streamBuffer.getNumOverflows() << " overflows" << endl;
+   else
+      cout << "  stream buffer used    = (not mapped, drawing from client memory)" << endl;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Time the fireball update with a full pool of fireballs on 1 thread, 2
+   threads and so on up to one per core, and print how each compares to 1.
+   Then time the same update over an array of structures (a fireball's
+   values side by side) on 1 thread, to compare with the projectile
+   system's separate arrays.
+*/
+void runJobBenchmark()
+{
+   ProjectileSystem benchmarkFireballs(MAX_FIREBALLS);
+   benchmarkFireballs.setTurnRate(90.0);
+   while (benchmarkFireballs.getNumActive() < benchmarkFireballs.getCapacity())
+   {
+      float angle = rand() / (float)RAND_MAX * 6.28;
+      Vector3D velocity(cos(angle) * FIREBALL_SPEED, 0.0, sin(angle) * FIREBALL_SPEED);
+      benchmarkFireballs.spawn(Vector3D(100,5,100), velocity, FIREBALL_LIFETIME);
+   }
+
+   cout << "Job system scaling (" << BENCHMARK_STEPS << " updates of "
+        << MAX_FIREBALLS << " fireballs):" << endl;
+   int oneThreadTime = 0;
+   for (int numThreads = 1; numThreads <= JobSystem::getNumProcessors(); numThreads++)
+   {
+      JobSystem benchmarkJobs(numThreads);
+      int startTime = glutGet(GLUT_ELAPSED_TIME);
+      for (int step = 0; step < BENCHMARK_STEPS; step++)
+         benchmarkFireballs.update(0.0001, &benchmarkJobs);
+      int time = glutGet(GLUT_ELAPSED_TIME) - startTime;
+
+      if (numThreads == 1)
+         oneThreadTime = time;
+      cout << "  " << numThreads << " threads: " << time << " ms";
+      if (time > 0)
+         cout << " (" << oneThreadTime / (float)time << "x)";
+      cout << endl;
+   }
+
+   // the same update with each fireball's values kept together, on 1 thread
+   vector<BenchmarkFireball> structures(MAX_FIREBALLS);
+   int index;
+   for (index = 0; index < MAX_FIREBALLS; index++)
+   {
+      BenchmarkFireball &fireball = structures[index];
+      float angle = rand() / (float)RAND_MAX * 6.28;
+      fireball.position[0] = 100.0;
+      fireball.position[1] = 5.0;
+      fireball.position[2] = 100.0;
+      fireball.velocity[0] = cos(angle) * FIREBALL_SPEED;
+      fireball.velocity[1] = 0.0;
+      fireball.velocity[2] = sin(angle) * FIREBALL_SPEED;
+      fireball.lifetime = FIREBALL_LIFETIME;
+      fireball.radius = 1.0;
+   }
+   float seconds = 0.0001;
+   float turn = 90.0 * 3.14159265 / 180.0 * seconds;
+   float cosTurn = cos(turn);
+   float sinTurn = sin(turn);
+   int startTime = glutGet(GLUT_ELAPSED_TIME);
+   for (int step = 0; step < BENCHMARK_STEPS; step++)
+   {
+      for (index = 0; index < MAX_FIREBALLS; index++)
+      {
+         BenchmarkFireball &fireball = structures[index];
+         float newX = fireball.velocity[0] * cosTurn + fireball.velocity[2] * sinTurn;
+         float newZ = fireball.velocity[2] * cosTurn - fireball.velocity[0] * sinTurn;
+         fireball.velocity[0] = newX;
+         fireball.velocity[2] = newZ;
+         for (int axis = 0; axis < 3; axis++)
+         {
+            fireball.previous[axis] = fireball.position[axis];
+            fireball.position[axis] += fireball.velocity[axis] * seconds;
+         }
+         fireball.lifetime -= seconds;
+      }
+   }
+   int time = glutGet(GLUT_ELAPSED_TIME) - startTime;
+   cout << "  array of structures, 1 thread: " << time << " ms";
+   if (time > 0)
+      cout << " (" << oneThreadTime / (float)time << "x)";
+   cout << endl;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Time culling crowds of objects scattered over a big field to a view
+   looking across it, for each of the CULL_BENCHMARK_CROWDS sizes
+*/
+void runCullingBenchmark()
+{
+   // the same view the demo starts with, from the middle of the field
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   gluPerspective(45.0, 1.0, 1.0, 1000.0);
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+   gluLookAt(0.0,20.0,0.0, 100.0,0.0,100.0, 0.0,1.0,0.0);
+   Frustum frustum;
+   frustum.extractFromOpenGL();
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+
+   cout << "Culling timing (" << CULL_BENCHMARK_QUERIES << " queries, ms/query):" << endl;
+   for (int crowd = 0; crowd < NUM_CULL_BENCHMARK_CROWDS; crowd++)
+      timeCulling(frustum, CULL_BENCHMARK_CROWDS[crowd]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Time culling one crowd of objects to a view, once with the loose octree
+   the scenes use and once by testing every object (one at a time, then
+   four at a time with Frustum::cullSpheres), and print the time a query
+   takes and the objects the octree tests.  Each way collects the visible
+   objects into a list, the way the scenes use the results.
+
+  @param frustum The view
+  @param numObjects The size of the crowd
+*/
+void timeCulling(const Frustum &frustum, int numObjects)
+{
+   vector<float> x(numObjects);
+   vector<float> y(numObjects);
+   vector<float> z(numObjects);
+   vector<float> radius(numObjects);
+   vector<unsigned char> visible(numObjects);
+   vector<Model3D*> models(numObjects);
+   LooseOctree octree(Vector3D(0,0,0), CULL_BENCHMARK_SIZE, 8);
+   int index;
+   for (index = 0; index < numObjects; index++)
+   {
+      x[index] = (rand() / (float)RAND_MAX * 2.0 - 1.0) * CULL_BENCHMARK_SIZE;
+      y[index] = rand() / (float)RAND_MAX * 20.0;
+      z[index] = (rand() / (float)RAND_MAX * 2.0 - 1.0) * CULL_BENCHMARK_SIZE;
+      radius[index] = 1.0 + rand() / (float)RAND_MAX * 9.0;
+      octree.insert(models[index], 1, x[index], y[index], z[index], radius[index]);
+   }
+
+   vector<Model3D*> results;
+   results.reserve(numObjects);
+   int query;
+   double startTime = getPreciseMilliseconds();
+   for (query = 0; query < CULL_BENCHMARK_QUERIES; query++)
+   {
+      results.clear();
+      octree.queryFrustum(frustum, 1, results);
+   }
+   double octreeTime = (getPreciseMilliseconds() - startTime) / CULL_BENCHMARK_QUERIES;
+   int numVisible = results.size();
+
+   startTime = getPreciseMilliseconds();
+   for (query = 0; query < CULL_BENCHMARK_QUERIES; query++)
+   {
+      results.clear();
+      for (index = 0; index < numObjects; index++)
+      {
+         if (frustum.isSphereVisible(x[index], y[index], z[index], radius[index]))
+            results.push_back(models[index]);
+      }
+   }
+   double linearTime = (getPreciseMilliseconds() - startTime) / CULL_BENCHMARK_QUERIES;
+   int linearVisible = results.size();
+
+   startTime = getPreciseMilliseconds();
+   for (query = 0; query < CULL_BENCHMARK_QUERIES; query++)
+   {
+      results.clear();
+      frustum.cullSpheres(&x[0], &y[0], &z[0], &radius[0], numObjects, &visible[0]);
+      for (index = 0; index < numObjects; index++)
+      {
+         if (visible[index])
+            results.push_back(models[index]);
+      }
+   }
+   double batchedTime = (getPreciseMilliseconds() - startTime) / CULL_BENCHMARK_QUERIES;
+
+   cout << "  " << numObjects << " objects, " << numVisible << " visible: octree " << octreeTime
+        << " (" << octree.getLastTestCount() << " tested), linear scan " << linearTime
+        << ", batched linear " << batchedTime << endl;
+   if (linearVisible != numVisible)
+      cout << "ERROR: the octree found " << numVisible << " objects and the scan " << linearVisible << endl;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make a scene that shadows with one of the ShadowTechniques
+
+  @param technique The ShadowTechniques value
+  @return The new scene, the caller deletes it
+*/
+ShadowableScene* createScene(int technique)
+{
+   ShadowableScene *scene;
+   if (technique == SHADOW_MAPS)
+      scene = new ShadowMapScene();
+   else if (technique == SHADOW_VOLUMES)
+      scene = new VolumeShadowScene();
+   else
+      scene = new PlanarProjectedShadowScene();
+   scene->getShadowScheduler().setEnabled(shadowSchedulerOn);
+   return scene;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Time drawing a grid of tanks under the light with each shadow technique
+   in turn and print the time a frame takes, then the techniques that build
+   shadows on the CPU with the shadow scheduler on and off.  The frames are
+   drawn to the back buffer and finished before the clock is read, they
+   aren't shown.
+*/
+void runShadowBenchmark()
+{
+   static const char *techniqueNames[NUM_SHADOW_TECHNIQUES] =
+   {
+      "planar projection", "cube shadow maps", "shadow volumes"
+   };
+
+   // the tanks share the tank display list but need their own mesh data
+   XFileLoader tankLoader;
+   if (!tankLoader.loadXFile("tank.x"))
+   {
+      cout << "ERROR: could not load tank.x for the shadow benchmark" << endl;
+      return;
+   }
+   Model3D *ground = new (modelPool.allocate()) Model3D("BenchmarkGround", GROUND, Vector3D(0,0,0), false);
+   ground->setBounds(BoundingVolume(Vector3D(0,0,0), Vector3D(200,0,200)));
+   ground->setTexture(GRASS_TEXTURE, textureList);
+   vector<Model3D*> tanks;
+   int row;
+   for (row = 0; row < SHADOW_BENCHMARK_TANKS; row++)
+   {
+      for (int column = 0; column < SHADOW_BENCHMARK_TANKS; column++)
+      {
+         Vector3D position(30 + row * 140.0 / SHADOW_BENCHMARK_TANKS, 0, 30 + column * 140.0 / SHADOW_BENCHMARK_TANKS);
+         Model3D *tank = new (modelPool.allocate()) Model3D("BenchmarkTank", TANK, position);
+         tankLoader.createModel3D(tank);
+         tank->setTexture(TANK_TEXTURE, textureList);
+         tank->setShadowProxyAllowed(shadowProxiesOn);
+         tanks.push_back(tank);
+      }
+   }
+   Camera benchmarkCamera(Vector3D(10.0,80.0,100.0), Vector3D(150.0,-50.0,100.0));
+
+   cout << "Shadow technique timing (" << SHADOW_BENCHMARK_FRAMES << " frames, "
+        << tanks.size() << " tanks):" << endl;
+   int technique;
+   for (technique = 0; technique < NUM_SHADOW_TECHNIQUES; technique++)
+   {
+      ShadowableScene *scene = createScene(technique);
+      double time = timeShadowScene(scene, benchmarkCamera, ground, tanks);
+      cout << "  " << techniqueNames[technique] << ": " << time << " ms/frame" << endl;
+      delete scene;
+   }
+
+   // the scheduler only reuses the shadows built on the CPU, the shadow
+   // maps draw every caster each frame either way
+   cout << "Shadow scheduler timing:" << endl;
+   for (technique = 0; technique < NUM_SHADOW_TECHNIQUES; technique++)
+   {
+      if (technique == SHADOW_MAPS)
+         continue;
+      for (int scheduled = 0; scheduled < 2; scheduled++)
+      {
+         ShadowableScene *scene = createScene(technique);
+         scene->getShadowScheduler().setEnabled(scheduled != 0);
+         double time = timeShadowScene(scene, benchmarkCamera, ground, tanks);
+         cout << "  " << techniqueNames[technique] << (scheduled ? ", scheduled: " : ", every frame: ")
+              << time << " ms/frame" << endl;
+         delete scene;
+      }
+   }
+
+   // the filters' cost is what each adds to hard shadow maps
+   cout << "Shadow map filter timing:" << endl;
+   double hardTime = 0.0;
+   for (int filter = 0; filter < ShadowMapScene::NUM_SHADOW_FILTERS; filter++)
+   {
+      ShadowMapScene *scene = new ShadowMapScene();
+      scene->getShadowScheduler().setEnabled(shadowSchedulerOn);
+      scene->setShadowFilter(filter);
+      double time = timeShadowScene(scene, benchmarkCamera, ground, tanks);
+      if (filter == ShadowMapScene::HARD_SHADOWS)
+         hardTime = time;
+      cout << "  " << shadowFilterNames[filter] << ": " << time << " ms/frame (+"
+           << time - hardTime << ")" << endl;
+      delete scene;
+   }
+
+   for (row = 0; row < tanks.size(); row++)
+      modelPool.destroy(tanks[row]);
+   modelPool.destroy(ground);
+
+   // the benchmark scenes drew on the same context, the main scene can't
+   // trust what its render state cache remembers
+   if (theScene)
+      theScene->invalidateRenderState();
+   glutPostRedisplay();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Time a scene drawing the benchmark's tanks under the light.  The frames
+   are drawn to the back buffer and finished before the clock is read.  The
+   GL state the scene changes (lights, enables, stencil, blending, texture
+   bindings) is put back afterwards for the main scene, and the models are
+   taken back out of the scene through their handles.  The ground is added
+   and removed once more on the way out, the handle it was first given must
+   not find it again.
+
+  @param scene The scene, the models and light are added to it
+  @param camera The camera the frames are drawn from
+  @param ground The ground the tanks stand on
+  @param tanks The tanks
+  @return The time a frame takes (milliseconds)
+*/
+double timeShadowScene(ShadowableScene *scene, Camera &camera, Model3D *ground, const vector<Model3D*> &tanks)
+{
+   scene->setCamera(&camera);
+   ModelHandle groundHandle = scene->addModel(ground, ShadowableScene.RECEIVES_SHADOWS);
+   vector<ModelHandle> tankHandles;
+   int index;
+   for (index = 0; index < tanks.size(); index++)
+      tankHandles.push_back(scene->addModel(tanks[index], ShadowableScene.CASTS_SHADOWS));
+   glPushAttrib(GL_ALL_ATTRIB_BITS);
+   glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
+   scene->addPointLightSource(50.0, 45.0, 100.0);
+
+   // the first frame makes the scene's buffers and textures, it isn't timed
+   double startTime = 0.0;
+   for (int frame = 0; frame <= SHADOW_BENCHMARK_FRAMES; frame++)
+   {
+      if (frame == 1)
+      {
+         glFinish();
+         startTime = getPreciseMilliseconds();
+      }
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+      glMatrixMode(GL_MODELVIEW);
+      glLoadIdentity();
+      camera.update();
+      scene->render();
+   }
+   glFinish();
+   double time = (getPreciseMilliseconds() - startTime) / SHADOW_BENCHMARK_FRAMES;
+   glPopClientAttrib();
+   glPopAttrib();
+
+   for (index = 0; index < tankHandles.size(); index++)
+      scene->removeModel(tankHandles[index]);
+   scene->removeModel(groundHandle);
+   ModelHandle reusedHandle = scene->addModel(ground, ShadowableScene.RECEIVES_SHADOWS);
+   if (scene->getModel(groundHandle) != 0 || scene->removeModel(groundHandle) != 0)
+      cout << "ERROR: a removed model's handle still finds a model" << endl;
+   if (scene->removeModel(reusedHandle) != ground)
+      cout << "ERROR: the handle of a re-added model doesn't find it" << endl;
+   return time;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Cleanup the application before we close
+*/
+void finalize()
+{
+   // the simulation thread goes first, it uses everything below
+   stopSimulation();
+
+   glDeleteTextures(1, &textureList[GRASS_TEXTURE]);
+
+   if (theScene) delete theScene;
+   if (framePacer) delete framePacer;
+   if (theCamera) delete theCamera;
+   if (groundModel) modelPool.destroy(groundModel);
+   if (teapotModel) modelPool.destroy(teapotModel);
+   if (evilTankModel) modelPool.destroy(evilTankModel);
+   if (tankModel) modelPool.destroy(tankModel);
+
+   if (fireballs) delete fireballs;
+   if (jobs) delete jobs;
+
+   exit(0);
+}
+
+
+//-----------------------------------------------------------------------------
+/**
+   Find where a fireball shot from a tank starts and which way it goes.  It
+   starts a little in front of and above the tank and heads the way the
+   tank faces.
+*/
+void getFireballStart(Model3D *tankModel, Vector3D &position, Vector3D &direction)
+{
+   FTM orientation = tankModel->getFTM();
+   Vector3D muzzle = orientation.transformPoint(Vector3D(5,5,0));
+   Vector3D tankPosition = tankModel->getPosition();
+   position = Vector3D(tankPosition.x + muzzle.x, tankPosition.y + muzzle.y, tankPosition.z + muzzle.z);
+   direction = orientation.transformVector(Vector3D(1,0,0));
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Shoot a fireball from a tank
+*/
+void createFireball(Model3D *tankModel)
+{
+   Vector3D position, direction;
+   getFireballStart(tankModel, position, direction);
+   Vector3D velocity(direction.x * FIREBALL_SPEED, direction.y * FIREBALL_SPEED, direction.z * FIREBALL_SPEED);
+   if (fireballs->spawn(position, velocity, FIREBALL_LIFETIME))
+      numFired++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Fill the fireball pool with a spray of fireballs, fanned out in front of a
+   tank at random angles and speeds.  Used to load test the projectile
+   system.
+*/
+void createFireballStorm(Model3D *tankModel)
+{
+   Vector3D position, direction;
+   getFireballStart(tankModel, position, direction);
+   float heading = atan2(direction.z, direction.x);
+
+   int numSpawned = 0;
+   while (fireballs->getNumActive() < fireballs->getCapacity())
+   {
+      float angle = heading + (rand() / (float)RAND_MAX - 0.5) * 1.5;
+      float speed = FIREBALL_SPEED * (0.25 + 0.75 * rand() / (float)RAND_MAX);
+      float climb = (rand() / (float)RAND_MAX) * 0.2 * FIREBALL_SPEED;
+      Vector3D velocity(cos(angle) * speed, climb, sin(angle) * speed);
+      fireballs->spawn(position, velocity, FIREBALL_LIFETIME * (0.5 + rand() / (float)RAND_MAX));
+      numSpawned++;
+   }
+   numFired += numSpawned;
+   cout << "Fired " << numSpawned << " fireballs" << endl;
+}
+}
+
+/**
+  This is the entry point into the application
+  */
+int main(int argc, char** argv)
+{
+   // setup glut and create a window
+   glutInit(&argc,argv);
+
+   // glut has taken its own arguments out, the rest are ours
+   for (int arg = 1; arg < argc; arg++)
+   {
+      if (strcmp(argv[arg], "-shadowmaps") == 0)
+         shadowTechnique = SHADOW_MAPS;
+      else if (strcmp(argv[arg], "-shadowvolumes") == 0)
+         shadowTechnique = SHADOW_VOLUMES;
+      else if (strcmp(argv[arg], "-sun") == 0)
+         sunOn = true;
+      else if (strcmp(argv[arg], "-lights") == 0 && arg + 1 < argc)
+         extraLights = atoi(argv[++arg]);
+      else if (strcmp(argv[arg], "-noshadowproxies") == 0)
+         shadowProxiesOn = false;
+      else if (strcmp(argv[arg], "-noshadowscheduler") == 0)
+         shadowSchedulerOn = false;
+      else
+         cout << "ERROR: unknown argument " << argv[arg] << endl;
+   }
+   glutInitDisplayMode (GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_STENCIL);
+   glutInitWindowSize(WINDOW_WIDTH,WINDOW_HEIGHT);
+   glutInitWindowPosition(150,150);
+   glutCreateWindow("Shadows & Mesh Loading");
+
+   // program initilization
+   initialize();
+   initMenuSystem();
+
+   // setup our callbacks
+   glutDisplayFunc(handleDisplay);
+   glutReshapeFunc(handleReshape);
+   glutMouseFunc(handleMouse);
+   glutKeyboardFunc(handleKeyboardInput);
+   if (simulationClock.getFrameCap() == 0)
+      glutIdleFunc(handleIdle);
+
+   // start
+   glutMainLoop();
+
+   return 0;
 }
\ No newline at end of file
@@ -1,183 +1,383 @@
-# Microsoft Developer Studio Project File - Name="ShadowDemo" - Package Owner=<4>
-# Microsoft Developer Studio Generated Build File, Format Version 6.00
-# ** DO NOT EDIT **
-
-# TARGTYPE "Win32 (x86) Console Application" 0x0103
-
-CFG=ShadowDemo - Win32 Debug
-!MESSAGE This is not a valid makefile. To build this project using NMAKE,
-!MESSAGE use the Export Makefile command and run
-!MESSAGE 
-!MESSAGE NMAKE /f "ShadowDemo.mak".
-!MESSAGE 
-!MESSAGE You can specify a configuration when running NMAKE
-!MESSAGE by defining the macro CFG on the command line. For example:
-!MESSAGE 
-!MESSAGE NMAKE /f "ShadowDemo.mak" CFG="ShadowDemo - Win32 Debug"
-!MESSAGE 
-!MESSAGE Possible choices for configuration are:
-!MESSAGE 
-!MESSAGE "ShadowDemo - Win32 Release" (based on "Win32 (x86) Console Application")
-!MESSAGE "ShadowDemo - Win32 Debug" (based on "Win32 (x86) Console Application")
-!MESSAGE 
-
-# Begin Project
-# PROP AllowPerConfigDependencies 0
-# PROP Scc_ProjName ""$/School Projects/CS5984 Computer Graphics/Project/ShadowDemo", LLBAAAAA"
-# PROP Scc_LocalPath "."
-CPP=cl.exe
-RSC=rc.exe
-
-!IF  "$(CFG)" == "ShadowDemo - Win32 Release"
-
-# PROP BASE Use_MFC 0
-# PROP BASE Use_Debug_Libraries 0
-# PROP BASE Output_Dir "Release"
-# PROP BASE Intermediate_Dir "Release"
-# PROP BASE Target_Dir ""
-# PROP Use_MFC 0
-# PROP Use_Debug_Libraries 0
-# PROP Output_Dir "Release"
-# PROP Intermediate_Dir "Release"
-# PROP Ignore_Export_Lib 0
-# PROP Target_Dir ""
-# ADD BASE CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_CONSOLE" /D "_MBCS" /YX /FD /c
-# ADD CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_CONSOLE" /D "_MBCS" /YX /FD /c
-# ADD BASE RSC /l 0x409 /d "NDEBUG"
-# ADD RSC /l 0x409 /d "NDEBUG"
-BSC32=bscmake.exe
-# ADD BASE BSC32 /nologo
-# ADD BSC32 /nologo
-LINK32=link.exe
-# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /machine:I386
-# ADD LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib glaux.lib /nologo /subsystem:console /machine:I386
-
-!ELSEIF  "$(CFG)" == "ShadowDemo - Win32 Debug"
-
-# PROP BASE Use_MFC 0
-# PROP BASE Use_Debug_Libraries 1
-# PROP BASE Output_Dir "Debug"
-# PROP BASE Intermediate_Dir "Debug"
-# PROP BASE Target_Dir ""
-# PROP Use_MFC 0
-# PROP Use_Debug_Libraries 1
-# PROP Output_Dir "Debug"
-# PROP Intermediate_Dir "Debug"
-# PROP Ignore_Export_Lib 0
-# PROP Target_Dir ""
-# ADD BASE CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_CONSOLE" /D "_MBCS" /YX /FD /GZ /c
-# ADD CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_CONSOLE" /D "_MBCS" /YX /FD /GZ /c
-# ADD BASE RSC /l 0x409 /d "_DEBUG"
-# ADD RSC /l 0x409 /d "_DEBUG"
-BSC32=bscmake.exe
-# ADD BASE BSC32 /nologo
-# ADD BSC32 /nologo
-LINK32=link.exe
-# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /debug /machine:I386 /pdbtype:sept
-# ADD LINK32 glaux.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /debug /machine:I386 /pdbtype:sept
-# Begin Special Build Tool
-SOURCE="$(InputPath)"
-PostBuild_Desc=Create Documentation
-PostBuild_Cmds="C:\Program Files\doxygen\bin\doxygen" doxyfile
-# End Special Build Tool
-
-!ENDIF 
-
-# Begin Target
-
-# Name "ShadowDemo - Win32 Release"
-# Name "ShadowDemo - Win32 Debug"
-# Begin Group "Source Files"
-
-# PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;idl;hpj;bat"
-# Begin Source File
-
-SOURCE=.\Camera.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\FTM.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\Material.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\Model3D.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\PlanarProjectedShadowScene.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\ShadowableScene.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\ShadowDemo.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\Vector3D.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\XFileLoader.cpp
-# End Source File
-# End Group
-# Begin Group "Header Files"
-
-# PROP Default_Filter "h;hpp;hxx;hm;inl"
-# Begin Source File
-
-SOURCE=.\Camera.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Face.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\FTM.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Material.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Model3D.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\PlanarProjectedShadowScene.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\ShadowableScene.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\ShadowDemo.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\UV.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Vector3D.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\XFileLoader.h
-# End Source File
-# End Group
-# Begin Group "Resource Files"
-
-# PROP Default_Filter "ico;cur;bmp;dlg;rc2;rct;bin;rgs;gif;jpg;jpeg;jpe"
-# End Group
-# End Target
-# End Project
+# Microsoft Developer Studio Project File - Name="ShadowDemo" - Package Owner=<4>
+# Microsoft Developer Studio Generated Build File, Format Version 6.00
+# ** DO NOT EDIT **
+
+# TARGTYPE "Win32 (x86) Console Application" 0x0103
+
+CFG=ShadowDemo - Win32 Debug
+!MESSAGE This is not a valid makefile. To build this project using NMAKE,
+!MESSAGE use the Export Makefile command and run
+!MESSAGE 
+!MESSAGE NMAKE /f "ShadowDemo.mak".
+!MESSAGE 
+!MESSAGE You can specify a configuration when running NMAKE
+!MESSAGE by defining the macro CFG on the command line. For example:
+!MESSAGE 
+!MESSAGE NMAKE /f "ShadowDemo.mak" CFG="ShadowDemo - Win32 Debug"
+!MESSAGE 
+!MESSAGE Possible choices for configuration are:
+!MESSAGE 
+!MESSAGE "ShadowDemo - Win32 Release" (based on "Win32 (x86) Console Application")
+!MESSAGE "ShadowDemo - Win32 Debug" (based on "Win32 (x86) Console Application")
+!MESSAGE 
+
+# Begin Project
+# PROP AllowPerConfigDependencies 0
+# PROP Scc_ProjName ""$/School Projects/CS5984 Computer Graphics/Project/ShadowDemo", LLBAAAAA"
+# PROP Scc_LocalPath "."
+CPP=cl.exe
+RSC=rc.exe
+
+!IF  "$(CFG)" == "ShadowDemo - Win32 Release"
+
+# PROP BASE Use_MFC 0
+# PROP BASE Use_Debug_Libraries 0
+# PROP BASE Output_Dir "Release"
+# PROP BASE Intermediate_Dir "Release"
+# PROP BASE Target_Dir ""
+# PROP Use_MFC 0
+# PROP Use_Debug_Libraries 0
+# PROP Output_Dir "Release"
+# PROP Intermediate_Dir "Release"
+# PROP Ignore_Export_Lib 0
+# PROP Target_Dir ""
+# ADD BASE CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_CONSOLE" /D "_MBCS" /YX /FD /c
+# ADD CPP /nologo /W3 /GX /O2 /MT /D "WIN32" /D "NDEBUG" /D "_CONSOLE" /D "_MBCS" /D "SML_USE_SSE" /YX /FD /c
+# ADD BASE RSC /l 0x409 /d "NDEBUG"
+# ADD RSC /l 0x409 /d "NDEBUG"
+BSC32=bscmake.exe
+# ADD BASE BSC32 /nologo
+# ADD BSC32 /nologo
+LINK32=link.exe
+# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /machine:I386
+# ADD LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib glaux.lib /nologo /subsystem:console /machine:I386
+
+!ELSEIF  "$(CFG)" == "ShadowDemo - Win32 Debug"
+
+# PROP BASE Use_MFC 0
+# PROP BASE Use_Debug_Libraries 1
+# PROP BASE Output_Dir "Debug"
+# PROP BASE Intermediate_Dir "Debug"
+# PROP BASE Target_Dir ""
+# PROP Use_MFC 0
+# PROP Use_Debug_Libraries 1
+# PROP Output_Dir "Debug"
+# PROP Intermediate_Dir "Debug"
+# PROP Ignore_Export_Lib 0
+# PROP Target_Dir ""
+# ADD BASE CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_CONSOLE" /D "_MBCS" /YX /FD /GZ /c
+# ADD CPP /nologo /W3 /Gm /GX /ZI /Od /MTd /D "WIN32" /D "_DEBUG" /D "_CONSOLE" /D "_MBCS" /D "SML_USE_SSE" /D "SML_COUNT_ALLOCATIONS" /YX /FD /GZ /c
+# ADD BASE RSC /l 0x409 /d "_DEBUG"
+# ADD RSC /l 0x409 /d "_DEBUG"
+BSC32=bscmake.exe
+# ADD BASE BSC32 /nologo
+# ADD BSC32 /nologo
+LINK32=link.exe
+# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /debug /machine:I386 /pdbtype:sept
+# ADD LINK32 glaux.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /debug /machine:I386 /pdbtype:sept
+# Begin Special Build Tool
+SOURCE="$(InputPath)"
+PostBuild_Desc=Create Documentation
+PostBuild_Cmds="C:\Program Files\doxygen\bin\doxygen" doxyfile
+# End Special Build Tool
+
+!ENDIF 
+
+# Begin Target
+
+# Name "ShadowDemo - Win32 Release"
+# Name "ShadowDemo - Win32 Debug"
+# Begin Group "Source Files"
+
+# PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;idl;hpj;bat"
+# Begin Source File
+
+SOURCE=.\AllocationCounter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\BillboardRenderer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\BoundingVolume.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Camera.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\ConvexHull.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\EdgeMesh.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\FramePacer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Frustum.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\FTM.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\GLExtensions.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\JobSystem.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\LightClusters.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\LinearArena.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\LooseOctree.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Material.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Model3D.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\ModelRegistry.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\PlanarProjectedShadowScene.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Platform.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\ProjectileSystem.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\RenderQueue.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\RenderStateCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\SceneSnapshot.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\SceneStore.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowableScene.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowDemo.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowMapScene.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowScheduler.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\SimulationClock.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\StreamBuffer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Vector3D.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\VolumeShadowScene.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\XFileLoader.cpp
+# End Source File
+# End Group
+# Begin Group "Header Files"
+
+# PROP Default_Filter "h;hpp;hxx;hm;inl"
+# Begin Source File
+
+SOURCE=.\AllocationCounter.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\BillboardRenderer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\BoundingVolume.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Camera.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ConvexHull.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\EdgeMesh.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Face.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\FramePacer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Frustum.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\FTM.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\GLExtensions.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\JobSystem.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\LightClusters.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\LinearArena.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\LooseOctree.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Material.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Model3D.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ModelRegistry.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ObjectPool.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\PlanarProjectedShadowScene.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Platform.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ProjectileSystem.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\RenderQueue.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\RenderStateCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\SceneSnapshot.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\SceneStore.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowableScene.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowDemo.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowMapScene.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ShadowScheduler.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\SimulationClock.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\StreamBuffer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\TripleBuffer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\UV.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Vector3D.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\VolumeShadowScene.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\XFileLoader.h
+# End Source File
+# End Group
+# Begin Group "Resource Files"
+
+# PROP Default_Filter "ico;cur;bmp;dlg;rc2;rct;bin;rgs;gif;jpg;jpeg;jpe"
+# End Group
+# End Target
+# End Project
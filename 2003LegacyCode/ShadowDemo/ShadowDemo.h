@@ -1,107 +1,298 @@
-#ifndef MAIN_H
-#define MAIN_H
-
-#include <gl/glaux.h>
-#include <vector>
-#include "Model3D.h"
-#include <GL/glut.h>
-
-namespace SML_APP
-{
-// define global data
-//-----------------------------------------------------------------------------
-static const int WINDOW_WIDTH = 600;
-static const int WINDOW_HEIGHT = 600;
-bool fullscreen = false;
-
-/** textures that get loaded into memory */
-enum DisplayListTextures
-{
-   GRASS_TEXTURE = 0,
-   FIREBALL_TEXTURE,
-   TANK_TEXTURE,
-   EVIL_TANK_TEXTURE,
-   TEXTURE_LIST_SIZE  //this must be the last element
-};
-
-/** Commands that can be taken in the GLUT menus */
-enum MenuCommands
-{
-   MENU_EXIT = 1,
-   MENU_TOGGLE_ATTACH_TO_TANK,
-   MENU_TOGGLE_FULLSCREEN,
-   MENU_TOGGLE_SHOWLIGHTS,
-   MENU_SHADOWS_ON,
-   MENU_SHADOWS_OFF,
-   MENU_SIDE_CAM,
-   MENU_HIGHUP_CAM,
-   MENU_NONE
-};
-
-/** Each model must have it's own display list right now define them here */
-enum DisplayLists
-{
-   CAR = 1,
-   TEAPOT,
-   GROUND,
-   EVIL_TANK,
-   TANK,
-   FIREBALL
-};
-
-// data used to draw the map
-UINT textureList[TEXTURE_LIST_SIZE];
-float mapSizeX = 25.5;
-float mapSizeZ = 25.5;
-
-// kludge fireballs and tanks
-std::vector<SML_CORE::Model3D*> fireballs;
-int numFired = 0;
-bool cheaterB=false;
-bool cheaterE=false;
-bool cheaterE2=false;
-int currentTank = 1;
-
-// declare our functions
-//-----------------------------------------------------------------------------
-// initalize application
-void initialize();
-
-// exit the app
-void finalize();
-
-// load the menus and setup their callbacks
-void initMenuSystem();
-
-// callback for when openGL decides to redraw the window
-void handleDisplay();
-
-// callback for when the window is resized
-void handleReshape(int width, int height);
-
-// callback for when a main menu item has been selected
-void handleMainMenuInput(int input);
-
-// callback for when a mouse event occurs
-void handleMouse(int button, int state, int x, int y);
-
-// callback for when a key has been pressed
-void handleKeyboardInput(unsigned char key, int x, int y);
-
-// callback to handle idle actions
-void handleIdle();
-
-// create a texture
-void createTexture(UINT textureArray[], LPSTR fileName, int id);
-
-// setup our display lists
-void initDisplayLists();
-
-// kludge to shoot a fireball from the given model (just for fun)
-void handleFireballs();
-
-// create a fireball at the tanks current position and add it to the fireball list
-void createFireball(SML_CORE::Model3D* theModel);
-
-}
+#ifndef MAIN_H
+#define MAIN_H
+
+#include <gl/glaux.h>
+#include <vector>
+#include "Model3D.h"
+#include "ModelRegistry.h"
+#include "ProjectileSystem.h"
+#include "ObjectPool.h"
+#include "JobSystem.h"
+#include "SimulationClock.h"
+#include "SceneSnapshot.h"
+#include "TripleBuffer.h"
+#include "FramePacer.h"
+#include "ShadowableScene.h"
+#include "ShadowMapScene.h"
+#include <GL/glut.h>
+
+namespace SML_APP
+{
+// define global data
+//-----------------------------------------------------------------------------
+static const int WINDOW_WIDTH = 600;
+static const int WINDOW_HEIGHT = 600;
+bool fullscreen = false;
+
+/** textures that get loaded into memory */
+enum DisplayListTextures
+{
+   GRASS_TEXTURE = 0,
+   FIREBALL_TEXTURE,
+   TANK_TEXTURE,
+   EVIL_TANK_TEXTURE,
+   TEXTURE_LIST_SIZE  //this must be the last element
+};
+
+/** The ways the scene can be shadowed, picked on the command line */
+enum ShadowTechniques
+{
+   PLANAR_SHADOWS = 0,
+   SHADOW_MAPS,
+   SHADOW_VOLUMES,
+   NUM_SHADOW_TECHNIQUES  //this must be the last element
+};
+int shadowTechnique = PLANAR_SHADOWS;
+
+// the scene can be lit by the sun instead of the point light (-sun)
+bool sunOn = false;
+
+// small colored lights scattered over the ground as well as the main light
+// (-lights N), only the few that matter most are shadowed
+int extraLights = 0;
+static const float EXTRA_LIGHT_HEIGHT = 6.0;
+static const float EXTRA_LIGHT_RADIUS = 8.0;
+
+// the names of the ShadowMapScene's ShadowFilters, in the filters' order
+static const char *shadowFilterNames[SML_CORE::ShadowMapScene::NUM_SHADOW_FILTERS] =
+{
+   "hard", "4 tap PCF", "16 tap PCF", "variance shadow maps"
+};
+
+// the tanks' shadows can be drawn from their convex hulls (-noshadowproxies
+// draws the whole tank)
+bool shadowProxiesOn = true;
+
+// distant and slow tanks keep their shadow volumes and outlines for a few
+// frames (-noshadowscheduler builds them all every frame)
+bool shadowSchedulerOn = true;
+
+/** Commands that can be taken in the GLUT menus */
+enum MenuCommands
+{
+   MENU_EXIT = 1,
+   MENU_TOGGLE_ATTACH_TO_TANK,
+   MENU_TOGGLE_FULLSCREEN,
+   MENU_TOGGLE_SHOWLIGHTS,
+   MENU_SHADOWS_ON,
+   MENU_SHADOWS_OFF,
+   MENU_SIDE_CAM,
+   MENU_HIGHUP_CAM,
+   MENU_NONE
+};
+
+/** Each model must have it's own display list right now define them here */
+enum DisplayLists
+{
+   CAR = 1,
+   TEAPOT,
+   GROUND,
+   EVIL_TANK,
+   TANK
+};
+
+/** A texture being loaded, a worker reads the bitmap and then the main
+    thread hands it to openGL */
+class TextureLoad
+{
+public:
+   LPSTR fileName;
+   int id;
+   AUX_RGBImageRec *bitmap;
+};
+
+// data used to draw the map
+UINT textureList[TEXTURE_LIST_SIZE];
+TextureLoad textureLoads[TEXTURE_LIST_SIZE] =
+{
+   {"grass.bmp", GRASS_TEXTURE, 0},
+   {"fireball.bmp", FIREBALL_TEXTURE, 0},
+   {"greentank.bmp", TANK_TEXTURE, 0},
+   {"browntank.bmp", EVIL_TANK_TEXTURE, 0}
+};
+bool tankMeshLoaded = false;
+float mapSizeX = 25.5;
+float mapSizeZ = 25.5;
+
+// fireballs and tanks
+static const int MAX_FIREBALLS = 100000;
+static const float FIREBALL_SPEED = 150.0;
+static const float FIREBALL_LIFETIME = 2.0;
+SML_CORE::ProjectileSystem *fireballs = 0;
+int numFired = 0;
+bool cheaterB=false;
+bool cheaterE=false;
+bool cheaterE2=false;
+int currentTank = 1;
+
+// the simulation runs at a fixed tick rate, the frames drawn are capped
+// (0 for no cap) and interpolated between ticks
+static const int TICK_RATE = 60;
+static const int FRAME_CAP = 60;
+SML_CORE::SimulationClock simulationClock(TICK_RATE, FRAME_CAP);
+bool timerPending = false;  // the frame cap timer is waiting to fire
+
+// keys that change the simulation wait here for the next tick (the glut
+// thread adds them and the simulation thread takes them, under the lock)
+static const int MAX_PENDING_INPUT = 64;
+unsigned char pendingInput[MAX_PENDING_INPUT];
+int numPendingInput = 0;
+void *inputLock = 0;
+
+// the simulation runs on its own thread and hands the glut thread (which
+// owns the openGL context and draws) a snapshot of the scene after each tick
+SML_CORE::TripleBuffer<SML_CORE::SceneSnapshot> snapshots;
+void *simulationThread = 0;
+volatile bool simulationRunning = false;
+
+// the models come from a pool instead of the heap
+SML_CORE::ObjectPool<SML_CORE::Model3D> modelPool;
+
+// the threads that share out the loading and per frame work
+SML_CORE::JobSystem *jobs = 0;
+static const int BENCHMARK_STEPS = 200;
+
+// a fireball with its values side by side, the job benchmark updates an
+// array of these to compare with the projectile system's separate arrays
+class BenchmarkFireball
+{
+public:
+   float position[3];
+   float previous[3];
+   float velocity[3];
+   float lifetime;
+   float radius;
+};
+
+// the shadow techniques are timed on a grid of tanks drawn this many times
+static const int SHADOW_BENCHMARK_FRAMES = 100;
+static const int SHADOW_BENCHMARK_TANKS = 6;  // tanks on each side of the grid
+
+// the octree is timed against testing every object on crowds of each of
+// these sizes, scattered over a field CULL_BENCHMARK_SIZE from the center
+// each way
+static const int CULL_BENCHMARK_QUERIES = 200;
+static const int NUM_CULL_BENCHMARK_CROWDS = 4;
+static const int CULL_BENCHMARK_CROWDS[NUM_CULL_BENCHMARK_CROWDS] = {200, 1000, 10000, 100000};
+static const float CULL_BENCHMARK_SIZE = 1000.0;
+
+// the frames the CPU may build ahead of the GPU, each with its own part of
+// the stream buffer the billboards are written into
+static const int FRAMES_IN_FLIGHT = 2;
+static const int STREAM_BYTES_PER_FRAME = 16 * 1024 * 1024;
+SML_CORE::FramePacer *framePacer = 0;
+
+// heap allocations made by the glut thread while drawing the last frame,
+// and by every thread in that time (debug build only)
+unsigned long frameAllocations = 0;
+unsigned long frameAllocationsAllThreads = 0;
+
+// declare our functions
+//-----------------------------------------------------------------------------
+// initalize application
+void initialize();
+
+// exit the app
+void finalize();
+
+// load the menus and setup their callbacks
+void initMenuSystem();
+
+// callback for when openGL decides to redraw the window
+void handleDisplay();
+
+// move the camera for a frame of a simulation tick
+void updateCamera(const SML_CORE::SceneSnapshot &snapshot);
+
+// draw the last frame again and count what drawing it allocates
+unsigned long countSteadyStateAllocations();
+
+// callback for when the window is resized
+void handleReshape(int width, int height);
+
+// callback for when a main menu item has been selected
+void handleMainMenuInput(int input);
+
+// callback for when a mouse event occurs
+void handleMouse(int button, int state, int x, int y);
+
+// callback for when a key has been pressed
+void handleKeyboardInput(unsigned char key, int x, int y);
+
+// callback to handle idle actions
+void handleIdle();
+
+// callback for the frame cap timer
+void handleTimer(int value);
+
+// start the simulation thread, and stop it
+void startSimulation();
+void stopSimulation();
+
+// the simulation thread: run the ticks as they come due
+void runSimulation(void *data);
+
+// hand the render thread a snapshot of the scene as it is now
+void publishSnapshot();
+
+// step the simulation forward one tick
+void simulateTick(float seconds);
+
+// do what a key asks, called on a simulation tick
+void applyInput(unsigned char key);
+
+// turn the frame cap on or off
+void toggleFrameCap();
+
+// step the frames in flight through 1 to FramePacer::MAX_FRAMES_IN_FLIGHT
+void cycleFramesInFlight();
+
+// print the counters gathered while rendering the last frame
+void printFrameStatistics();
+
+// read a texture's bitmap from disk (a job, it can run on any thread)
+void readTextureBitmap(void *data, int begin, int end);
+
+// hand a texture's bitmap to openGL (a main thread job)
+void uploadTexture(void *data, int begin, int end);
+
+// read the tank mesh from disk (a job, data is the XFileLoader)
+void readTankMesh(void *data, int begin, int end);
+
+// time the fireball update on 1 to N threads
+void runJobBenchmark();
+
+// make a scene that shadows with one of the ShadowTechniques
+SML_CORE::ShadowableScene* createScene(int technique);
+
+// time drawing a grid of tanks with each of the ShadowTechniques, with and
+// without the shadow scheduler, and the shadow maps with each of their filters
+void runShadowBenchmark();
+
+// time a scene drawing the benchmark's tanks, in milliseconds a frame
+double timeShadowScene(SML_CORE::ShadowableScene *scene, SML_CORE::Camera &camera,
+   SML_CORE::Model3D *ground, const std::vector<SML_CORE::Model3D*> &tanks);
+
+// time culling crowds of objects with the octree and with a linear scan
+void runCullingBenchmark();
+
+// time culling one crowd of objects to a view
+void timeCulling(const SML_CORE::Frustum &frustum, int numObjects);
+
+// step through the shadow map filters
+void cycleShadowFilter();
+
+// setup our display lists
+void initDisplayLists();
+
+// find where a fireball shot from the given model starts and which way it goes
+void getFireballStart(SML_CORE::Model3D* theModel, SML_CORE::Vector3D &position, SML_CORE::Vector3D &direction);
+
+// create a fireball at the tanks current position, heading the way it faces
+void createFireball(SML_CORE::Model3D* theModel);
+
+// fill the fireball pool with a spray of fireballs from the given model
+void createFireballStorm(SML_CORE::Model3D* theModel);
+
+}
 #endif
\ No newline at end of file
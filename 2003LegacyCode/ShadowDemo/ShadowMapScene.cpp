@@ -0,0 +1,1669 @@
+#include <GL/glut.h>
+#include <stdio.h>
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "ShadowMapScene.h"
+#include "GLExtensions.h"
+#include "Model3D.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+namespace SML_CORE
+{
+// the light's view of the scene starts this close to it
+static const float SHADOW_NEAR_PLANE = 0.5;
+
+// the defaults for how far the lights reach and how much nearer the light
+// a caster must be to shadow a point (both in world units)
+static const float DEFAULT_LIGHT_RANGE = 400.0;
+static const float DEFAULT_DEPTH_BIAS = 0.5;
+
+// the defaults for the sun's cascades: how many, how far the split leans
+// towards logarithmic spacing (0 even, 1 logarithmic) and how far from the
+// camera the shadows reach
+static const int DEFAULT_CASCADES = 3;
+static const float DEFAULT_CASCADE_SPLIT_WEIGHT = 0.75;
+static const float DEFAULT_SHADOW_DISTANCE = 400.0;
+
+// how far back towards the sun a cascade looks for casters, and how far
+// nearer the sun than a point a caster must be to shadow it (in texels of
+// the point's cascade, they get bigger with each cascade)
+static const float CASCADE_CASTER_REACH = 10000.0;
+static const float CASCADE_BIAS_TEXELS = 2.0;
+
+// which way each face of a cube map looks and which way is up on it, in
+// the order of the faces from GL_TEXTURE_CUBE_MAP_POSITIVE_X
+static const float CUBE_FACE_DIRECTIONS[6][3] =
+{
+   { 1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0,-1, 0}, {0, 0, 1}, {0, 0,-1}
+};
+static const float CUBE_FACE_UPS[6][3] =
+{
+   {0,-1, 0}, {0,-1, 0}, {0, 0, 1}, {0, 0,-1}, {0,-1, 0}, {0,-1, 0}
+};
+
+// the blur texture holds a map for each face of a cube, BLUR_COLUMNS across
+// and BLUR_ROWS up, so every face is blurred across before any is written
+// back (blurring a face across reads its neighbours)
+static const int BLUR_COLUMNS = 3;
+static const int BLUR_ROWS = 2;
+
+// the shaders are built for one of the ShadowFilters, each starts with the
+// filter and map size (see filterHead).  The maps hold a depth packed into
+// the four bytes of the color, or for variance shadows the depth and its
+// square packed into two bytes each.  The maps are cleared to white, just
+// over one, which has to be brought under one to be packed again.
+static const char *PACK_DEPTH_FUNCTIONS =
+   "vec4 packDepth(float distance)\n"
+   "{\n"
+   "#if FILTER == VARIANCE_SHADOWS\n"
+   "   return packMoments(vec2(distance, distance * distance));\n"
+   "#else\n"
+   "   vec4 bytes = fract(distance * vec4(1.0, 255.0, 65025.0, 16581375.0));\n"
+   "   return bytes - bytes.yzww * vec4(1.0/255.0, 1.0/255.0, 1.0/255.0, 0.0);\n"
+   "#endif\n"
+   "}\n";
+static const char *MOMENTS_FUNCTIONS =
+   "vec4 packMoments(vec2 moments)\n"
+   "{\n"
+   "   vec4 bytes = fract(min(moments.xxyy, 0.999) * vec4(1.0, 255.0, 1.0, 255.0));\n"
+   "   return bytes - bytes.yyww * vec4(1.0/255.0, 0.0, 1.0/255.0, 0.0);\n"
+   "}\n"
+   "vec2 unpackMoments(vec4 bytes)\n"
+   "{\n"
+   "   return vec2(dot(bytes.xy, vec2(1.0, 1.0/255.0)), dot(bytes.zw, vec2(1.0, 1.0/255.0)));\n"
+   "}\n";
+
+// the depth pass writes how far each pixel is from the light, as a fraction
+// of the light's range
+static const char *DEPTH_VERTEX_SHADER =
+   "#version 120\n"
+   "varying vec3 lightToVertex;\n"
+   "void main()\n"
+   "{\n"
+   "   lightToVertex = (gl_ModelViewMatrix * gl_Vertex).xyz;\n"
+   "   gl_Position = ftransform();\n"
+   "}\n";
+static const char *DEPTH_FRAGMENT_SHADER =
+   "uniform float lightRange;\n"
+   "varying vec3 lightToVertex;\n"
+   "void main()\n"
+   "{\n"
+   "   gl_FragColor = packDepth(min(length(lightToVertex) / lightRange, 0.999));\n"
+   "}\n";
+
+// the sun's depth pass writes how far past the near plane of the cascade's
+// box each pixel is, as a fraction of the box's depth
+static const char *CASCADE_DEPTH_VERTEX_SHADER =
+   "#version 120\n"
+   "varying float depth;\n"
+   "void main()\n"
+   "{\n"
+   "   depth = -(gl_ModelViewMatrix * gl_Vertex).z;\n"
+   "   gl_Position = ftransform();\n"
+   "}\n";
+static const char *CASCADE_DEPTH_FRAGMENT_SHADER =
+   "uniform float cascadeNear;\n"
+   "uniform float cascadeRange;\n"
+   "varying float depth;\n"
+   "void main()\n"
+   "{\n"
+   "   gl_FragColor = packDepth(clamp((depth - cascadeNear) / cascadeRange, 0.0, 0.999));\n"
+   "}\n";
+
+// the variance maps are blurred one way then the other (a separable 5 tap
+// binomial blur) through a texture with room for the six maps of a cube.
+// The pass that reads a cube map face finds its texels by direction, so the
+// blur runs over the face's edges.  The written texel is found from its
+// place in the viewport.
+static const char *BLUR_VERTEX_SHADER =
+   "#version 120\n"
+   "void main()\n"
+   "{\n"
+   "   gl_Position = gl_Vertex;\n"
+   "}\n";
+static const char *BLUR_FRAGMENT_SHADER =
+   "#if CUBE_SOURCE\n"
+   "uniform samplerCube source;\n"
+   "uniform vec3 faceForward;\n"
+   "uniform vec3 faceRight;\n"
+   "uniform vec3 faceUp;\n"
+   "#else\n"
+   "uniform sampler2D source;\n"
+   "uniform vec4 sourceArea;\n"
+   "uniform vec4 sourceLimits;\n"
+   "uniform vec2 blurStep;\n"
+   "#endif\n"
+   "uniform vec2 targetOrigin;\n"
+   "void main()\n"
+   "{\n"
+   "   const float weights[5] = float[5](1.0/16.0, 4.0/16.0, 6.0/16.0, 4.0/16.0, 1.0/16.0);\n"
+   "   vec2 position = (gl_FragCoord.xy - targetOrigin) / float(MAP_SIZE);\n"
+   "   vec2 moments = vec2(0.0);\n"
+   "   for (int tap = 0; tap < 5; tap++)\n"
+   "   {\n"
+   "      float offset = float(tap - 2);\n"
+   "#if CUBE_SOURCE\n"
+   "      vec2 face = position * 2.0 - 1.0 + vec2(offset * 2.0 / float(MAP_SIZE), 0.0);\n"
+   "      vec4 bytes = textureCube(source, faceForward + face.x * faceRight + face.y * faceUp);\n"
+   "#else\n"
+   "      vec2 coordinates = sourceArea.xy + position * sourceArea.zw + blurStep * offset;\n"
+   "      vec4 bytes = texture2D(source, clamp(coordinates, sourceLimits.xy, sourceLimits.zw));\n"
+   "#endif\n"
+   "      moments += unpackMoments(bytes) * weights[tap];\n"
+   "   }\n"
+   "   gl_FragColor = packMoments(moments);\n"
+   "}\n";
+
+// the lighting pass does what openGL's lighting does for the scene (per
+// vertex, one GL light per point light and one for the sun) but keeps each
+// light's share apart so the fragments can leave it out where they are
+// shadowed.  Models that aren't lit lose part of their color in shadow
+// instead.  A # in the per light parts is replaced by the light's number.
+// The lights that aren't shadowed are found in the fragment's cluster and
+// lit per pixel.
+static const char *LIGHTING_VERTEX_HEAD =
+   "#define UNLIT_LIGHT_SHARE 0.5\n"
+   "uniform mat4 eyeToWorld;\n"
+   "uniform bool lit;\n"
+   "varying vec4 baseColor;\n"
+   "varying vec3 worldPosition;\n"
+   "varying float eyeDepth;\n"
+   "#if NUM_CASCADES > 0\n"
+   "varying vec4 sunColor;\n"
+   "#endif\n"
+   "#if CLUSTERED_LIGHTS\n"
+   "varying vec3 worldNormal;\n"
+   "varying vec3 clusterColor;\n"
+   "#endif\n";
+static const char *LIGHTING_VERTEX_LIGHT_DECLARATIONS =
+   "uniform vec3 lightPosition#;\n"
+   "varying vec4 lightColor#;\n"
+   "varying vec3 lightToVertex#;\n";
+static const char *LIGHTING_VERTEX_MAIN =
+   "vec4 shadeVertex(vec3 toLight, vec3 normal, vec4 diffuse, vec4 specular)\n"
+   "{\n"
+   "   vec3 direction = normalize(toLight);\n"
+   "   float diffuseLevel = dot(normal, direction);\n"
+   "   if (diffuseLevel <= 0.0)\n"
+   "      return vec4(0.0);\n"
+   "   float specularLevel = max(dot(normal, normalize(direction + vec3(0.0, 0.0, 1.0))), 0.0);\n"
+   "   if (specularLevel > 0.0)\n"
+   "      specularLevel = pow(specularLevel, gl_FrontMaterial.shininess);\n"
+   "   return vec4((diffuse * diffuseLevel + specular * specularLevel).rgb, 0.0);\n"
+   "}\n"
+   "void main()\n"
+   "{\n"
+   "   vec4 eyePosition = gl_ModelViewMatrix * gl_Vertex;\n"
+   "   worldPosition = (eyeToWorld * eyePosition).xyz;\n"
+   "   eyeDepth = -eyePosition.z;\n"
+   "   vec3 normal = normalize(gl_NormalMatrix * gl_Normal);\n"
+   "#if CLUSTERED_LIGHTS\n"
+   "   worldNormal = mat3(eyeToWorld) * normal;\n"
+   "   clusterColor = lit ? gl_FrontMaterial.diffuse.rgb : gl_Color.rgb;\n"
+   "#endif\n"
+   "   vec4 unlitColor = vec4(gl_Color.rgb * (UNLIT_LIGHT_SHARE / float(SHADED_LIGHTS)), 0.0);\n"
+   "   if (lit)\n"
+   "      baseColor = vec4(gl_FrontLightModelProduct.sceneColor.rgb, gl_FrontMaterial.diffuse.a);\n"
+   "   else\n"
+   "      baseColor = vec4(gl_Color.rgb * (1.0 - UNLIT_LIGHT_SHARE), gl_Color.a);\n"
+   "   gl_Position = ftransform();\n"
+   "   gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+   "#if NUM_CASCADES > 0\n"
+   "   if (lit)\n"
+   "   {\n"
+   "      baseColor.rgb += gl_FrontLightProduct[SUN_LIGHT].ambient.rgb;\n"
+   "      sunColor = shadeVertex(gl_LightSource[SUN_LIGHT].position.xyz, normal,\n"
+   "         gl_FrontLightProduct[SUN_LIGHT].diffuse, gl_FrontLightProduct[SUN_LIGHT].specular);\n"
+   "   }\n"
+   "   else\n"
+   "      sunColor = unlitColor;\n"
+   "#endif\n";
+static const char *LIGHTING_VERTEX_LIGHT =
+   "   lightToVertex# = worldPosition - lightPosition#;\n"
+   "   if (lit)\n"
+   "   {\n"
+   "      baseColor.rgb += gl_FrontLightProduct[#].ambient.rgb;\n"
+   "      lightColor# = shadeVertex(gl_LightSource[#].position.xyz - eyePosition.xyz, normal,\n"
+   "         gl_FrontLightProduct[#].diffuse, gl_FrontLightProduct[#].specular);\n"
+   "   }\n"
+   "   else\n"
+   "      lightColor# = unlitColor;\n";
+static const char *LIGHTING_FRAGMENT_HEAD =
+   "uniform bool textured;\n"
+   "uniform sampler2D modelTexture;\n"
+   "uniform float lightRange;\n"
+   "uniform float depthBias;\n"
+   "varying vec4 baseColor;\n"
+   "#if NUM_CASCADES > 0 || CLUSTERED_LIGHTS\n"
+   "varying vec3 worldPosition;\n"
+   "varying float eyeDepth;\n"
+   "#endif\n"
+   "#if NUM_CASCADES > 0\n"
+   "uniform sampler2D cascadeMap;\n"
+   "uniform float cascadeEnds[NUM_CASCADES];\n"
+   "uniform mat4 cascadeMatrices[NUM_CASCADES];\n"
+   "uniform float cascadeRanges[NUM_CASCADES];\n"
+   "uniform float cascadeBiases[NUM_CASCADES];\n"
+   "varying vec4 sunColor;\n"
+   "#endif\n"
+   "#if CLUSTERED_LIGHTS\n"
+   "uniform bool lit;\n"
+   "uniform sampler2D clusterMap;\n"
+   "uniform sampler2D clusterLightIndices;\n"
+   "uniform sampler2D clusterLightData;\n"
+   "uniform vec4 clusterScreen;\n"
+   "uniform vec2 clusterDepth;\n"
+   "uniform vec2 clusterSizes;\n"
+   "varying vec3 worldNormal;\n"
+   "varying vec3 clusterColor;\n"
+   "#endif\n";
+static const char *LIGHTING_FRAGMENT_LIGHT_DECLARATIONS =
+   "uniform samplerCube shadowMap#;\n"
+   "varying vec4 lightColor#;\n"
+   "varying vec3 lightToVertex#;\n";
+static const char *LIGHTING_FRAGMENT_MAIN =
+   "#if FILTER == PCF_4_TAPS\n"
+   "#define TAP_ROWS 2\n"
+   "#else\n"
+   "#define TAP_ROWS 4\n"
+   "#endif\n"
+   "// the least variance a variance map is taken to have, and how much of the\n"
+   "// light that leaks round one caster into the shadow of another is cut\n"
+   "#define MIN_VARIANCE 0.00002\n"
+   "#define BLEED_CUT 0.3\n"
+   "float unpackDepth(vec4 bytes)\n"
+   "{\n"
+   "   return dot(bytes, vec4(1.0, 1.0/255.0, 1.0/65025.0, 1.0/16581375.0));\n"
+   "}\n"
+   "float varianceVisibility(vec4 bytes, float distance)\n"
+   "{\n"
+   "   vec2 moments = unpackMoments(bytes);\n"
+   "   if (distance <= moments.x)\n"
+   "      return 1.0;\n"
+   "   float variance = max(moments.y - moments.x * moments.x, MIN_VARIANCE);\n"
+   "   float offset = distance - moments.x;\n"
+   "   float visibility = variance / (variance + offset * offset);\n"
+   "   return clamp((visibility - BLEED_CUT) / (1.0 - BLEED_CUT), 0.0, 1.0);\n"
+   "}\n"
+   "float lightVisibility(samplerCube shadowMap, vec3 lightToFragment)\n"
+   "{\n"
+   "   float distance = length(lightToFragment) - depthBias;\n"
+   "#if FILTER == VARIANCE_SHADOWS\n"
+   "   return varianceVisibility(textureCube(shadowMap, lightToFragment), distance / lightRange);\n"
+   "#elif FILTER == HARD_SHADOWS\n"
+   "   return distance > unpackDepth(textureCube(shadowMap, lightToFragment)) * lightRange ? 0.0 : 1.0;\n"
+   "#else\n"
+   "   // the taps are a texel apart on the face the fragment is seen through\n"
+   "   vec3 size = abs(lightToFragment);\n"
+   "   float texel = 2.0 * max(size.x, max(size.y, size.z)) / float(MAP_SIZE);\n"
+   "   vec3 up = size.y > size.x && size.y > size.z ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);\n"
+   "   vec3 across = normalize(cross(lightToFragment, up));\n"
+   "   vec3 along = normalize(cross(lightToFragment, across));\n"
+   "   float visibility = 0.0;\n"
+   "   for (int row = 0; row < TAP_ROWS; row++)\n"
+   "   {\n"
+   "      for (int column = 0; column < TAP_ROWS; column++)\n"
+   "      {\n"
+   "         vec2 offset = (vec2(column, row) - 0.5 * float(TAP_ROWS - 1)) * texel;\n"
+   "         vec3 direction = lightToFragment + across * offset.x + along * offset.y;\n"
+   "         visibility += distance > unpackDepth(textureCube(shadowMap, direction)) * lightRange ? 0.0 : 1.0;\n"
+   "      }\n"
+   "   }\n"
+   "   return visibility / float(TAP_ROWS * TAP_ROWS);\n"
+   "#endif\n"
+   "}\n"
+   "#if NUM_CASCADES > 0\n"
+   "float cascadeVisibility(int cascade, vec3 mapPosition)\n"
+   "{\n"
+   "   float distance = mapPosition.z - cascadeBiases[cascade];\n"
+   "   float range = cascadeRanges[cascade];\n"
+   "#if FILTER == VARIANCE_SHADOWS\n"
+   "   return varianceVisibility(texture2D(cascadeMap, mapPosition.xy), distance / range);\n"
+   "#elif FILTER == HARD_SHADOWS\n"
+   "   return distance > unpackDepth(texture2D(cascadeMap, mapPosition.xy)) * range ? 0.0 : 1.0;\n"
+   "#else\n"
+   "   // the taps are a texel apart and kept in the cascade's part of the map\n"
+   "   vec2 texel = vec2(1.0 / float(MAP_SIZE * NUM_CASCADES), 1.0 / float(MAP_SIZE));\n"
+   "   vec2 low = vec2(float(cascade) / float(NUM_CASCADES), 0.0) + texel * 0.5;\n"
+   "   vec2 high = vec2(float(cascade + 1) / float(NUM_CASCADES), 1.0) - texel * 0.5;\n"
+   "   float visibility = 0.0;\n"
+   "   for (int row = 0; row < TAP_ROWS; row++)\n"
+   "   {\n"
+   "      for (int column = 0; column < TAP_ROWS; column++)\n"
+   "      {\n"
+   "         vec2 offset = (vec2(column, row) - 0.5 * float(TAP_ROWS - 1)) * texel;\n"
+   "         vec2 coordinates = clamp(mapPosition.xy + offset, low, high);\n"
+   "         visibility += distance > unpackDepth(texture2D(cascadeMap, coordinates)) * range ? 0.0 : 1.0;\n"
+   "      }\n"
+   "   }\n"
+   "   return visibility / float(TAP_ROWS * TAP_ROWS);\n"
+   "#endif\n"
+   "}\n"
+   "float sunVisibility()\n"
+   "{\n"
+   "   for (int cascade = 0; cascade < NUM_CASCADES; cascade++)\n"
+   "   {\n"
+   "      if (eyeDepth < cascadeEnds[cascade])\n"
+   "         return cascadeVisibility(cascade, (cascadeMatrices[cascade] * vec4(worldPosition, 1.0)).xyz);\n"
+   "   }\n"
+   "   return 1.0;\n"
+   "}\n"
+   "#endif\n"
+   "#if CLUSTERED_LIGHTS\n"
+   "// the cluster holds an offset into the light indices and a count, each\n"
+   "// light two texels of data: its position and reach, then its color and\n"
+   "// whether it is shadowed (those are lit above).  The diffuse part fades\n"
+   "// out to nothing at the light's reach, models that aren't lit take it\n"
+   "// whichever way they face.\n"
+   "vec4 clusterLighting()\n"
+   "{\n"
+   "   vec2 tile = floor((gl_FragCoord.xy - clusterScreen.xy) * clusterScreen.zw);\n"
+   "   tile = clamp(tile, vec2(0.0), vec2(float(CLUSTERS_X - 1), float(CLUSTERS_Y - 1)));\n"
+   "   float slice = floor(log(max(eyeDepth, clusterDepth.x) / clusterDepth.x) * clusterDepth.y);\n"
+   "   slice = min(slice, float(CLUSTERS_Z - 1));\n"
+   "   vec4 cluster = texture2D(clusterMap, vec2((tile.y * float(CLUSTERS_X) + tile.x + 0.5) /\n"
+   "      float(CLUSTERS_X * CLUSTERS_Y), (slice + 0.5) / float(CLUSTERS_Z)));\n"
+   "   vec3 normal = normalize(worldNormal);\n"
+   "   vec3 total = vec3(0.0);\n"
+   "   for (int index = 0; index < MAX_CLUSTER_LIGHTS; index++)\n"
+   "   {\n"
+   "      if (float(index) >= cluster.a)\n"
+   "         break;\n"
+   "      float place = cluster.r + float(index);\n"
+   "      float row = floor(place / float(INDEX_WIDTH));\n"
+   "      float light = texture2D(clusterLightIndices, vec2((place - row * float(INDEX_WIDTH) + 0.5) /\n"
+   "         float(INDEX_WIDTH), (row + 0.5) / clusterSizes.x)).r;\n"
+   "      float lightRow = (light + 0.5) / clusterSizes.y;\n"
+   "      vec4 color = texture2D(clusterLightData, vec2(0.75, lightRow));\n"
+   "      if (color.a > 0.5)\n"
+   "         continue;\n"
+   "      vec4 position = texture2D(clusterLightData, vec2(0.25, lightRow));\n"
+   "      vec3 toLight = position.xyz - worldPosition;\n"
+   "      float fade = max(1.0 - dot(toLight, toLight) / (position.w * position.w), 0.0);\n"
+   "      float facing = lit ? max(dot(normal, normalize(toLight)), 0.0) : 1.0;\n"
+   "      total += color.rgb * (facing * fade * fade);\n"
+   "   }\n"
+   "   return vec4(total * clusterColor, 0.0);\n"
+   "}\n"
+   "#endif\n"
+   "void main()\n"
+   "{\n"
+   "   vec4 color = baseColor;\n";
+static const char *LIGHTING_FRAGMENT_LIGHT =
+   "   color += lightColor# * lightVisibility(shadowMap#, lightToVertex#);\n";
+static const char *LIGHTING_FRAGMENT_TAIL =
+   "#if NUM_CASCADES > 0\n"
+   "   color += sunColor * sunVisibility();\n"
+   "#endif\n"
+   "#if CLUSTERED_LIGHTS\n"
+   "   color += clusterLighting();\n"
+   "#endif\n"
+   "   color = clamp(color, 0.0, 1.0);\n"
+   "   if (textured)\n"
+   "      color *= texture2D(modelTexture, gl_TexCoord[0].st);\n"
+   "   gl_FragColor = color;\n"
+   "}\n";
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor.  Nothing is made until the first frame.
+
+  @param mapSize The width of each face of the lights' cube maps
+  */
+ShadowMapScene::ShadowMapScene(int mapSize) : ShadowableScene(),
+initialized(false),
+supported(false),
+mapSize(mapSize),
+lightRange(DEFAULT_LIGHT_RANGE),
+depthBias(DEFAULT_DEPTH_BIAS),
+framebufferId(0),
+depthBufferId(0),
+depthProgram(0),
+depthRangeLocation(-1),
+lightingProgram(0),
+numShadowLights(0),
+eyeToWorldLocation(-1),
+lightRangeLocation(-1),
+depthBiasLocation(-1),
+litLocation(-1),
+texturedLocation(-1),
+lightingPassOn(false),
+modelLit(-1),
+modelTextured(-1),
+numCascades(DEFAULT_CASCADES),
+cascadeSplitWeight(DEFAULT_CASCADE_SPLIT_WEIGHT),
+shadowDistance(DEFAULT_SHADOW_DISTANCE),
+cascadeMapCascades(0),
+cascadeTexture(0),
+cascadeFramebufferId(0),
+cascadeDepthBufferId(0),
+cascadeDepthProgram(0),
+cascadeNearLocation(-1),
+cascadeRangeLocation(-1),
+numShadowCascades(0),
+cascadeEndsLocation(-1),
+cascadeMatricesLocation(-1),
+cascadeRangesLocation(-1),
+cascadeBiasesLocation(-1),
+cascadesDrawn(0),
+shadowFilter(HARD_SHADOWS),
+programFilter(-1),
+blurProgram(0),
+cubeBlurProgram(0),
+blurTexture(0),
+blurFramebufferId(0),
+blurAreaLocation(-1),
+blurLimitsLocation(-1),
+blurStepLocation(-1),
+blurOriginLocation(-1),
+cubeBlurOriginLocation(-1),
+faceForwardLocation(-1),
+faceRightLocation(-1),
+faceUpLocation(-1),
+shadingClusters(false),
+clusterTexture(0),
+clusterIndexTexture(0),
+clusterLightTexture(0),
+clusterIndexRows(0),
+clusterLightRows(0),
+clusterScreenLocation(-1),
+clusterDepthLocation(-1),
+clusterSizesLocation(-1)
+{
+   for (int light = 0; light < MAX_SHADOW_LIGHTS; light++)
+      lightPositionLocations[light] = -1;
+   for (int cascade = 0; cascade < MAX_CASCADES; cascade++)
+      cascades[cascade].drawn = false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+ShadowMapScene::~ShadowMapScene()
+{
+   if (lightingProgram)
+      GLExtensions::deleteProgram(lightingProgram);
+   if (depthProgram)
+      GLExtensions::deleteProgram(depthProgram);
+   for (int light = 0; light < cubeTextures.size(); light++)
+      glDeleteTextures(1, &cubeTextures[light]);
+   if (framebufferId)
+      GLExtensions::deleteFramebuffers(1, &framebufferId);
+   if (depthBufferId)
+      GLExtensions::deleteRenderbuffers(1, &depthBufferId);
+   if (cascadeDepthProgram)
+      GLExtensions::deleteProgram(cascadeDepthProgram);
+   if (cascadeTexture)
+      glDeleteTextures(1, &cascadeTexture);
+   if (cascadeFramebufferId)
+      GLExtensions::deleteFramebuffers(1, &cascadeFramebufferId);
+   if (cascadeDepthBufferId)
+      GLExtensions::deleteRenderbuffers(1, &cascadeDepthBufferId);
+   if (blurProgram)
+      GLExtensions::deleteProgram(blurProgram);
+   if (cubeBlurProgram)
+      GLExtensions::deleteProgram(cubeBlurProgram);
+   if (blurTexture)
+      glDeleteTextures(1, &blurTexture);
+   if (blurFramebufferId)
+      GLExtensions::deleteFramebuffers(1, &blurFramebufferId);
+   if (clusterTexture)
+   {
+      glDeleteTextures(1, &clusterTexture);
+      glDeleteTextures(1, &clusterIndexTexture);
+      glDeleteTextures(1, &clusterLightTexture);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set how many cascades the sun's view is split into
+
+  @param count The cascades (1 to MAX_CASCADES)
+  */
+void ShadowMapScene::setCascades(int count)
+{
+   if (count < 1 || count > MAX_CASCADES)
+   {
+      cout << "ERROR: the sun can have 1 to " << MAX_CASCADES << " cascades, not " << count << endl;
+      return;
+   }
+   numCascades = count;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Pick how the shadow maps are filtered, the programs and maps are made
+   again on the next frame
+
+  @param filter One of the ShadowFilters
+  */
+void ShadowMapScene::setShadowFilter(int filter)
+{
+   if (filter < 0 || filter >= NUM_SHADOW_FILTERS)
+   {
+      cout << "ERROR: there is no shadow filter " << filter << endl;
+      return;
+   }
+   shadowFilter = filter;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make the depth program and the framebuffer the cube maps are drawn
+   through, the first time the scene is drawn
+  */
+void ShadowMapScene::initialize()
+{
+   initialized = true;
+   GLExtensions::load();
+   if (!GLExtensions::hasShaders || !GLExtensions::hasFramebufferObjects || !GLExtensions::hasTextureUnits)
+   {
+      cout << "ERROR: shadow maps need openGL 2.0 and framebuffer objects, drawing without shadows" << endl;
+      return;
+   }
+
+   if (!createFilterPrograms())
+      return;
+   if (!GLExtensions::hasFloatTextures && pointLightX.size() > MAX_LIGHTS)
+      cout << "ERROR: the lights that aren't shadowed need float textures, only the shadowed lights are drawn" << endl;
+
+   // one depth buffer is shared by every face of every light
+   GLExtensions::genRenderbuffers(1, &depthBufferId);
+   GLExtensions::bindRenderbuffer(GL_RENDERBUFFER, depthBufferId);
+   GLExtensions::renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mapSize, mapSize);
+   GLExtensions::bindRenderbuffer(GL_RENDERBUFFER, 0);
+
+   // the framebuffer can only be checked with a face attached
+   cubeTextures.push_back(createShadowCube());
+   GLExtensions::genFramebuffers(1, &framebufferId);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, framebufferId);
+   GLExtensions::framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBufferId);
+   GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_CUBE_MAP_POSITIVE_X, cubeTextures[0], 0);
+   GLenum status = GLExtensions::checkFramebufferStatus(GL_FRAMEBUFFER);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+   if (status != GL_FRAMEBUFFER_COMPLETE)
+   {
+      cout << "ERROR: can't draw into a shadow cube map (status " << status << "), drawing without shadows" << endl;
+      return;
+   }
+   supported = true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The start of every shader's source: the version, the filter they are
+   built for and the size of the maps
+
+  @return The defines
+  */
+string ShadowMapScene::filterHead() const
+{
+   char head[200];
+   sprintf(head, "#version 120\n#define HARD_SHADOWS %d\n#define PCF_4_TAPS %d\n#define PCF_16_TAPS %d\n"
+      "#define VARIANCE_SHADOWS %d\n#define FILTER %d\n#define MAP_SIZE %d\n",
+      HARD_SHADOWS, PCF_4_TAPS, PCF_16_TAPS, VARIANCE_SHADOWS, shadowFilter, mapSize);
+   return head;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make the depth programs (and the blur programs for variance shadows) for
+   the shadow filter.  The lighting program is made again on the next
+   lighting pass and the cascades are drawn again.
+
+  @return false if a program didn't build
+  */
+bool ShadowMapScene::createFilterPrograms()
+{
+   if (depthProgram)
+      GLExtensions::deleteProgram(depthProgram);
+   if (cascadeDepthProgram)
+      GLExtensions::deleteProgram(cascadeDepthProgram);
+   programFilter = shadowFilter;
+   numShadowLights = -1;
+   for (int cascade = 0; cascade < MAX_CASCADES; cascade++)
+      cascades[cascade].drawn = false;
+
+   string fragmentHead = filterHead() + MOMENTS_FUNCTIONS + PACK_DEPTH_FUNCTIONS;
+   depthProgram = createProgram(DEPTH_VERTEX_SHADER, fragmentHead + DEPTH_FRAGMENT_SHADER, "shadow map depth");
+   cascadeDepthProgram = createProgram(CASCADE_DEPTH_VERTEX_SHADER, fragmentHead + CASCADE_DEPTH_FRAGMENT_SHADER, "cascade depth");
+   if (!depthProgram || !cascadeDepthProgram)
+      return false;
+   depthRangeLocation = GLExtensions::getUniformLocation(depthProgram, "lightRange");
+   cascadeNearLocation = GLExtensions::getUniformLocation(cascadeDepthProgram, "cascadeNear");
+   cascadeRangeLocation = GLExtensions::getUniformLocation(cascadeDepthProgram, "cascadeRange");
+
+   if (shadowFilter != VARIANCE_SHADOWS || blurProgram)
+      return true;
+   string blurSource = string(MOMENTS_FUNCTIONS) + BLUR_FRAGMENT_SHADER;
+   blurProgram = createProgram(BLUR_VERTEX_SHADER, filterHead() + "#define CUBE_SOURCE 0\n" + blurSource, "shadow map blur");
+   cubeBlurProgram = createProgram(BLUR_VERTEX_SHADER, filterHead() + "#define CUBE_SOURCE 1\n" + blurSource, "cube map blur");
+   if (!blurProgram || !cubeBlurProgram)
+      return false;
+   blurAreaLocation = GLExtensions::getUniformLocation(blurProgram, "sourceArea");
+   blurLimitsLocation = GLExtensions::getUniformLocation(blurProgram, "sourceLimits");
+   blurStepLocation = GLExtensions::getUniformLocation(blurProgram, "blurStep");
+   blurOriginLocation = GLExtensions::getUniformLocation(blurProgram, "targetOrigin");
+   cubeBlurOriginLocation = GLExtensions::getUniformLocation(cubeBlurProgram, "targetOrigin");
+   faceForwardLocation = GLExtensions::getUniformLocation(cubeBlurProgram, "faceForward");
+   faceRightLocation = GLExtensions::getUniformLocation(cubeBlurProgram, "faceRight");
+   faceUpLocation = GLExtensions::getUniformLocation(cubeBlurProgram, "faceUp");
+   return createBlurTarget();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make the texture the maps are blurred through (room for the six faces of
+   a cube) and the framebuffer the blur passes draw with
+
+  @return false if the blur can't be drawn
+  */
+bool ShadowMapScene::createBlurTarget()
+{
+   GLint maxSize;
+   glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+   if (mapSize * BLUR_COLUMNS > maxSize)
+   {
+      cout << "ERROR: the variance shadow maps are too big to blur, drawing without shadows" << endl;
+      return false;
+   }
+
+   glGenTextures(1, &blurTexture);
+   glBindTexture(GL_TEXTURE_2D, blurTexture);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, mapSize * BLUR_COLUMNS, mapSize * BLUR_ROWS, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, 0);
+   glBindTexture(GL_TEXTURE_2D, 0);
+   renderState.invalidate();
+
+   GLExtensions::genFramebuffers(1, &blurFramebufferId);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, blurFramebufferId);
+   GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurTexture, 0);
+   GLenum status = GLExtensions::checkFramebufferStatus(GL_FRAMEBUFFER);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+   if (status != GL_FRAMEBUFFER_COMPLETE)
+   {
+      cout << "ERROR: can't blur the variance shadow maps (status " << status << "), drawing without shadows" << endl;
+      return false;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make a cube map for a light
+
+  @return The texture id of the cube map
+  */
+unsigned int ShadowMapScene::createShadowCube()
+{
+   unsigned int textureId;
+   glGenTextures(1, &textureId);
+   glBindTexture(GL_TEXTURE_CUBE_MAP, textureId);
+   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   for (int face = 0; face < 6; face++)
+   {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8, mapSize, mapSize, 0,
+         GL_RGBA, GL_UNSIGNED_BYTE, 0);
+   }
+   glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+   return textureId;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make the lighting program for a number of lights
+
+  @param numLights The point lights to shade with (0 to MAX_SHADOW_LIGHTS)
+  @param numSunCascades The sun's cascades, 0 if there is no sun
+  @param clustered true if the lights that aren't shadowed are lit from
+                   the clusters
+  @return false if the program didn't build
+  */
+bool ShadowMapScene::createLightingProgram(int numLights, int numSunCascades, bool clustered)
+{
+   if (lightingProgram)
+      GLExtensions::deleteProgram(lightingProgram);
+   numShadowLights = numLights;
+   numShadowCascades = numSunCascades;
+   shadingClusters = clustered;
+
+   // the sun is the openGL light after the point lights
+   char lights[400];
+   sprintf(lights, "#define NUM_LIGHTS %d\n#define NUM_CASCADES %d\n#define SHADED_LIGHTS %d\n#define SUN_LIGHT %d\n"
+      "#define CLUSTERED_LIGHTS %d\n#define CLUSTERS_X %d\n#define CLUSTERS_Y %d\n#define CLUSTERS_Z %d\n"
+      "#define MAX_CLUSTER_LIGHTS %d\n#define INDEX_WIDTH %d\n",
+      numLights, numSunCascades, numLights + (numSunCascades > 0 ? 1 : 0), MAX_LIGHTS,
+      clustered ? 1 : 0, LightClusters::CLUSTERS_X, LightClusters::CLUSTERS_Y, LightClusters::CLUSTERS_Z,
+      LightClusters::MAX_CLUSTER_LIGHTS, CLUSTER_INDEX_WIDTH);
+   string head = filterHead() + lights;
+   string vertexSource = head + LIGHTING_VERTEX_HEAD +
+      repeatForLights(LIGHTING_VERTEX_LIGHT_DECLARATIONS, numLights) + LIGHTING_VERTEX_MAIN +
+      repeatForLights(LIGHTING_VERTEX_LIGHT, numLights) + "}\n";
+   string fragmentSource = head + MOMENTS_FUNCTIONS + LIGHTING_FRAGMENT_HEAD +
+      repeatForLights(LIGHTING_FRAGMENT_LIGHT_DECLARATIONS, numLights) + LIGHTING_FRAGMENT_MAIN +
+      repeatForLights(LIGHTING_FRAGMENT_LIGHT, numLights) + LIGHTING_FRAGMENT_TAIL;
+
+   lightingProgram = createProgram(vertexSource, fragmentSource, "shadow map lighting");
+   if (!lightingProgram)
+      return false;
+
+   eyeToWorldLocation = GLExtensions::getUniformLocation(lightingProgram, "eyeToWorld");
+   lightRangeLocation = GLExtensions::getUniformLocation(lightingProgram, "lightRange");
+   depthBiasLocation = GLExtensions::getUniformLocation(lightingProgram, "depthBias");
+   litLocation = GLExtensions::getUniformLocation(lightingProgram, "lit");
+   texturedLocation = GLExtensions::getUniformLocation(lightingProgram, "textured");
+   cascadeEndsLocation = GLExtensions::getUniformLocation(lightingProgram, "cascadeEnds");
+   cascadeMatricesLocation = GLExtensions::getUniformLocation(lightingProgram, "cascadeMatrices");
+   cascadeRangesLocation = GLExtensions::getUniformLocation(lightingProgram, "cascadeRanges");
+   cascadeBiasesLocation = GLExtensions::getUniformLocation(lightingProgram, "cascadeBiases");
+   clusterScreenLocation = GLExtensions::getUniformLocation(lightingProgram, "clusterScreen");
+   clusterDepthLocation = GLExtensions::getUniformLocation(lightingProgram, "clusterDepth");
+   clusterSizesLocation = GLExtensions::getUniformLocation(lightingProgram, "clusterSizes");
+
+   // the model's own texture stays on unit 0, the cube maps go above it,
+   // the cascades above them and the clusters above those
+   GLExtensions::useProgram(lightingProgram);
+   GLExtensions::uniform1i(GLExtensions::getUniformLocation(lightingProgram, "modelTexture"), 0);
+   for (int light = 0; light < numLights; light++)
+   {
+      char name[32];
+      sprintf(name, "lightPosition%d", light);
+      lightPositionLocations[light] = GLExtensions::getUniformLocation(lightingProgram, name);
+      sprintf(name, "shadowMap%d", light);
+      GLExtensions::uniform1i(GLExtensions::getUniformLocation(lightingProgram, name), light + 1);
+   }
+   if (numSunCascades > 0)
+      GLExtensions::uniform1i(GLExtensions::getUniformLocation(lightingProgram, "cascadeMap"), numLights + 1);
+   if (clustered)
+   {
+      GLExtensions::uniform1i(GLExtensions::getUniformLocation(lightingProgram, "clusterMap"), numLights + 2);
+      GLExtensions::uniform1i(GLExtensions::getUniformLocation(lightingProgram, "clusterLightIndices"), numLights + 3);
+      GLExtensions::uniform1i(GLExtensions::getUniformLocation(lightingProgram, "clusterLightData"), numLights + 4);
+   }
+   GLExtensions::useProgram(0);
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make the texture the sun's cascades are drawn into, side by side, and the
+   framebuffer they are drawn through
+
+  @return false if the cascades can't be drawn
+  */
+bool ShadowMapScene::createCascadeMap()
+{
+   if (!cascadeFramebufferId)
+   {
+      GLExtensions::genFramebuffers(1, &cascadeFramebufferId);
+      GLExtensions::genRenderbuffers(1, &cascadeDepthBufferId);
+      glGenTextures(1, &cascadeTexture);
+   }
+   cascadeMapCascades = numCascades;
+   for (int cascade = 0; cascade < MAX_CASCADES; cascade++)
+      cascades[cascade].drawn = false;
+
+   glBindTexture(GL_TEXTURE_2D, cascadeTexture);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, mapSize * numCascades, mapSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+   glBindTexture(GL_TEXTURE_2D, 0);
+   renderState.invalidate();
+
+   GLExtensions::bindRenderbuffer(GL_RENDERBUFFER, cascadeDepthBufferId);
+   GLExtensions::renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mapSize * numCascades, mapSize);
+   GLExtensions::bindRenderbuffer(GL_RENDERBUFFER, 0);
+
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, cascadeFramebufferId);
+   GLExtensions::framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, cascadeDepthBufferId);
+   GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cascadeTexture, 0);
+   GLenum status = GLExtensions::checkFramebufferStatus(GL_FRAMEBUFFER);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+   if (status != GL_FRAMEBUFFER_COMPLETE)
+   {
+      cout << "ERROR: can't draw into the sun's cascades (status " << status << "), drawing without shadows" << endl;
+      return false;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the distance to the nearest caster around each light into its cube
+   map.  The camera's viewport, matrices and clear color are put back after.
+
+  @param numLights The lights to draw cube maps for
+  */
+void ShadowMapScene::renderShadowMaps(int numLights)
+{
+   GLint viewport[4];
+   glGetIntegerv(GL_VIEWPORT, viewport);
+   float clearColor[4];
+   glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+   // a face looks a quarter turn out from the light, up to the light's range
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, framebufferId);
+   glViewport(0, 0, mapSize, mapSize);
+   glClearColor(1.0, 1.0, 1.0, 1.0);
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   gluPerspective(90.0, 1.0, SHADOW_NEAR_PLANE, lightRange);
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+
+   GLExtensions::useProgram(depthProgram);
+   GLExtensions::uniform1f(depthRangeLocation, lightRange);
+   int light;
+   for (light = 0; light < numLights; light++)
+   {
+      if (!isEmptyLightSlot(light))
+         renderShadowCube(light);
+   }
+   if (shadowFilter == VARIANCE_SHADOWS)
+   {
+      for (light = 0; light < numLights; light++)
+      {
+         if (!isEmptyLightSlot(light))
+            blurShadowCube(light);
+      }
+   }
+   GLExtensions::useProgram(0);
+
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+   glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+   glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the six faces of a light's cube map, each with just the casters it
+   can see
+
+  @param light The light's place in the point light list
+  */
+void ShadowMapScene::renderShadowCube(int light)
+{
+   const Vector3D &position = pointLightList[light];
+   for (int face = 0; face < 6; face++)
+   {
+      GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+         GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubeTextures[light], 0);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      glLoadIdentity();
+      gluLookAt(position.x, position.y, position.z,
+         position.x + CUBE_FACE_DIRECTIONS[face][0],
+         position.y + CUBE_FACE_DIRECTIONS[face][1],
+         position.z + CUBE_FACE_DIRECTIONS[face][2],
+         CUBE_FACE_UPS[face][0], CUBE_FACE_UPS[face][1], CUBE_FACE_UPS[face][2]);
+
+      Frustum faceFrustum;
+      faceFrustum.extractFromOpenGL();
+      faceCasters.clear();
+      findCasters(faceFrustum, faceCasters);
+
+      for (int index = 0; index < faceCasters.size(); index++)
+      {
+         int storeIndex = sceneStore.getIndex(faceCasters[index]->getStoreId());
+         glPushMatrix();
+         glMultMatrixf(sceneStore.getWorldMatrixAt(storeIndex));
+         glCallList(sceneStore.getMeshIdAt(storeIndex));
+         glPopMatrix();
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Bring the sun's cascades up to date with the camera, drawing the ones
+   whose box or casters moved.  The camera's viewport, matrices and clear
+   color are put back after.
+
+  @param eyeToWorld The inverse of the camera's view matrix
+  */
+void ShadowMapScene::renderCascades(const float *eyeToWorld)
+{
+   // the slices run from the camera's near plane out to the shadow distance
+   // (or the far plane if that is nearer)
+   float projection[16];
+   glGetFloatv(GL_PROJECTION_MATRIX, projection);
+   float nearDepth = projection[14] / (projection[10] - 1.0);
+   float farDepth = shadowDistance;
+   if (projection[10] != -1.0 && projection[14] / (projection[10] + 1.0) < farDepth)
+      farDepth = projection[14] / (projection[10] + 1.0);
+
+   // a new sun direction moves every cascade.  The sun's view looks down
+   // the direction it shines with its up as near the world's as it can be
+   // (like gluLookAt).
+   const Vector3D &sun = directionalLightList[0];
+   if (sun.x != cascadeLight.x || sun.y != cascadeLight.y || sun.z != cascadeLight.z)
+   {
+      cascadeLight = sun;
+      for (int cascade = 0; cascade < MAX_CASCADES; cascade++)
+         cascades[cascade].drawn = false;
+      float *across = &sunAxes[0];
+      float *along = &sunAxes[3];
+      float *depthAxis = &sunAxes[6];
+      depthAxis[0] = sun.x;
+      depthAxis[1] = sun.y;
+      depthAxis[2] = sun.z;
+      if (fabs(sun.y) > 0.9)
+      {
+         across[0] = 0.0;
+         across[1] = sun.z;
+         across[2] = -sun.y;
+      }
+      else
+      {
+         across[0] = -sun.z;
+         across[1] = 0.0;
+         across[2] = sun.x;
+      }
+      float length = (float)sqrt(across[0] * across[0] + across[1] * across[1] + across[2] * across[2]);
+      across[0] /= length;
+      across[1] /= length;
+      across[2] /= length;
+      along[0] = across[1] * depthAxis[2] - across[2] * depthAxis[1];
+      along[1] = across[2] * depthAxis[0] - across[0] * depthAxis[2];
+      along[2] = across[0] * depthAxis[1] - across[1] * depthAxis[0];
+   }
+
+   GLint viewport[4];
+   glGetIntegerv(GL_VIEWPORT, viewport);
+   float clearColor[4];
+   glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+   bool bound = false;
+   bool redrawn[MAX_CASCADES];
+
+   float start = nearDepth;
+   int cascade;
+   for (cascade = 0; cascade < numCascades; cascade++)
+   {
+      redrawn[cascade] = false;
+      // the practical split, between even and logarithmic spacing
+      float fraction = (float)(cascade + 1) / numCascades;
+      float even = nearDepth + (farDepth - nearDepth) * fraction;
+      float logarithmic = nearDepth * (float)pow(farDepth / nearDepth, fraction);
+      cascades[cascade].end = cascadeSplitWeight * logarithmic + (1.0 - cascadeSplitWeight) * even;
+      if (!updateCascade(cascade, start, eyeToWorld, projection))
+      {
+         start = cascades[cascade].end;
+         continue;
+      }
+
+      if (!bound)
+      {
+         GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, cascadeFramebufferId);
+         glClearColor(1.0, 1.0, 1.0, 1.0);
+         glMatrixMode(GL_PROJECTION);
+         glPushMatrix();
+         glMatrixMode(GL_MODELVIEW);
+         glPushMatrix();
+         GLExtensions::useProgram(cascadeDepthProgram);
+         bound = true;
+      }
+      renderCascade(cascade);
+      redrawn[cascade] = true;
+      cascadesDrawn++;
+      start = cascades[cascade].end;
+   }
+
+   if (!bound)
+      return;
+   glDisable(GL_SCISSOR_TEST);
+   if (shadowFilter == VARIANCE_SHADOWS)
+   {
+      for (cascade = 0; cascade < numCascades; cascade++)
+      {
+         if (redrawn[cascade])
+            blurCascade(cascade);
+      }
+   }
+   GLExtensions::useProgram(0);
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+   glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+   glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Fit a cascade's box around its slice of the view and find its casters.
+   The box is square around the slice's bounding sphere as the sun sees it,
+   with its center snapped to whole texels, and reaches back to the nearest
+   caster towards the sun.
+
+  @param cascade The cascade
+  @param start The view depth the cascade's slice starts at
+  @param eyeToWorld The inverse of the camera's view matrix
+  @param projection The camera's projection
+  @return true if the box or its casters changed and it must be drawn
+  */
+bool ShadowMapScene::updateCascade(int cascade, float start, const float *eyeToWorld, const float *projection)
+{
+   Cascade &slice = cascades[cascade];
+
+   // the sphere around the slice is centered on the view axis, as near the
+   // middle as puts its near and far corners on it
+   float spread = 1.0 / (projection[0] * projection[0]) + 1.0 / (projection[5] * projection[5]);
+   float end = slice.end;
+   float middle = ((end * end - start * start) * (1.0 + spread)) / (2.0 * (end - start));
+   if (middle > end)
+      middle = end;
+   float radius = (float)sqrt((end - middle) * (end - middle) + end * end * spread);
+   float nearRadius = (float)sqrt((middle - start) * (middle - start) + start * start * spread);
+   if (nearRadius > radius)
+      radius = nearRadius;
+   float center[3];
+   for (int axis = 0; axis < 3; axis++)
+      center[axis] = eyeToWorld[12 + axis] - eyeToWorld[8 + axis] * middle;
+
+   // the sun's axes, the depth runs the way it shines
+   const float *across = &sunAxes[0];
+   const float *along = &sunAxes[3];
+   const float *depthAxis = &sunAxes[6];
+
+   // snap the center to the texels so the map only ever moves whole texels
+   float texelSize = 2.0 * radius / mapSize;
+   float x = across[0] * center[0] + across[1] * center[1] + across[2] * center[2];
+   float y = along[0] * center[0] + along[1] * center[1] + along[2] * center[2];
+   float depth = depthAxis[0] * center[0] + depthAxis[1] * center[1] + depthAxis[2] * center[2];
+   x = (float)floor(x / texelSize) * texelSize;
+   y = (float)floor(y / texelSize) * texelSize;
+
+   // the casters in the box and back towards the sun
+   Frustum box;
+   box.addPlane(across[0], across[1], across[2], radius - x);
+   box.addPlane(-across[0], -across[1], -across[2], radius + x);
+   box.addPlane(along[0], along[1], along[2], radius - y);
+   box.addPlane(-along[0], -along[1], -along[2], radius + y);
+   box.addPlane(-depthAxis[0], -depthAxis[1], -depthAxis[2], depth + radius);
+   box.addPlane(depthAxis[0], depthAxis[1], depthAxis[2], CASCADE_CASTER_REACH - depth);
+   cascadeCasters.clear();
+   findCasters(box, cascadeCasters);
+   std::sort(cascadeCasters.begin(), cascadeCasters.end());
+
+   // each caster's world matrix and sphere, compared with the ones the
+   // cascade was last drawn with
+   float nearest = depth - radius;
+   cascadeTransforms.clear();
+   int index;
+   for (index = 0; index < cascadeCasters.size(); index++)
+   {
+      int storeIndex = sceneStore.getIndex(cascadeCasters[index]->getStoreId());
+      const float *world = sceneStore.getWorldMatrixAt(storeIndex);
+      const float *sphere = sceneStore.getWorldSphereAt(storeIndex);
+      float casterDepth = depthAxis[0] * sphere[0] + depthAxis[1] * sphere[1] + depthAxis[2] * sphere[2] - sphere[3];
+      if (casterDepth < nearest)
+         nearest = casterDepth;
+      cascadeTransforms.insert(cascadeTransforms.end(), world, world + 16);
+      cascadeTransforms.insert(cascadeTransforms.end(), sphere, sphere + 4);
+   }
+
+   float bounds[5] = {x, y, radius, nearest, depth + radius};
+   bool changed = !slice.drawn || slice.casters != cascadeCasters || slice.casterTransforms != cascadeTransforms;
+   for (index = 0; index < 5 && !changed; index++)
+      changed = bounds[index] != slice.bounds[index];
+   if (!changed)
+      return false;
+
+   for (index = 0; index < 5; index++)
+      slice.bounds[index] = bounds[index];
+   slice.casters.swap(cascadeCasters);
+   slice.casterTransforms.swap(cascadeTransforms);
+   slice.texelSize = texelSize;
+   slice.drawn = true;
+
+   // the lookup takes a world point to its place in the cascade's part of
+   // the texture and its depth past the near plane
+   float scale = 1.0 / (2.0 * radius);
+   float *lookup = slice.lookupMatrix;
+   for (int axis = 0; axis < 3; axis++)
+   {
+      lookup[axis * 4] = across[axis] * scale / numCascades;
+      lookup[axis * 4 + 1] = along[axis] * scale;
+      lookup[axis * 4 + 2] = depthAxis[axis];
+      lookup[axis * 4 + 3] = 0.0;
+   }
+   lookup[12] = ((radius - x) * scale + cascade) / numCascades;
+   lookup[13] = (radius - y) * scale;
+   lookup[14] = -nearest;
+   lookup[15] = 1.0;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw a cascade's casters from the sun into its part of the texture, the
+   framebuffer and depth program are already bound
+
+  @param cascade The cascade
+  */
+void ShadowMapScene::renderCascade(int cascade)
+{
+   Cascade &slice = cascades[cascade];
+   glViewport(cascade * mapSize, 0, mapSize, mapSize);
+   glScissor(cascade * mapSize, 0, mapSize, mapSize);
+   glEnable(GL_SCISSOR_TEST);
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+   // the sun looks down its depth axis
+   float view[16] =
+   {
+      sunAxes[0], sunAxes[3], -sunAxes[6], 0.0,
+      sunAxes[1], sunAxes[4], -sunAxes[7], 0.0,
+      sunAxes[2], sunAxes[5], -sunAxes[8], 0.0,
+      0.0, 0.0, 0.0, 1.0
+   };
+   float x = slice.bounds[0];
+   float y = slice.bounds[1];
+   float radius = slice.bounds[2];
+   glMatrixMode(GL_PROJECTION);
+   glLoadIdentity();
+   glOrtho(x - radius, x + radius, y - radius, y + radius, slice.bounds[3], slice.bounds[4]);
+   glMatrixMode(GL_MODELVIEW);
+   glLoadMatrixf(view);
+   GLExtensions::uniform1f(cascadeNearLocation, slice.bounds[3]);
+   GLExtensions::uniform1f(cascadeRangeLocation, slice.bounds[4] - slice.bounds[3]);
+
+   for (int index = 0; index < slice.casters.size(); index++)
+   {
+      int storeIndex = sceneStore.getIndex(slice.casters[index]->getStoreId());
+      glPushMatrix();
+      glMultMatrixf(sceneStore.getWorldMatrixAt(storeIndex));
+      glCallList(sceneStore.getMeshIdAt(storeIndex));
+      glPopMatrix();
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Blur a light's variance cube map: every face across into its own part of
+   the blur texture, then each face down back into the cube.  Blurring
+   across reads past a face's edges into its neighbours, so no face is
+   written back until all have been read.  The depth program and
+   framebuffer are left unbound.
+
+  @param light The light's place in the point light list
+  */
+void ShadowMapScene::blurShadowCube(int light)
+{
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, blurFramebufferId);
+   GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurTexture, 0);
+   GLExtensions::useProgram(cubeBlurProgram);
+   glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTextures[light]);
+   int face;
+   for (face = 0; face < 6; face++)
+   {
+      // a face's texels look along its direction, right and up as it was drawn
+      const float *forward = CUBE_FACE_DIRECTIONS[face];
+      const float *up = CUBE_FACE_UPS[face];
+      float right[3] =
+      {
+         forward[1] * up[2] - forward[2] * up[1],
+         forward[2] * up[0] - forward[0] * up[2],
+         forward[0] * up[1] - forward[1] * up[0]
+      };
+      int x = face % BLUR_COLUMNS * mapSize;
+      int y = face / BLUR_COLUMNS * mapSize;
+      glViewport(x, y, mapSize, mapSize);
+      GLExtensions::uniform3f(faceForwardLocation, forward[0], forward[1], forward[2]);
+      GLExtensions::uniform3f(faceRightLocation, right[0], right[1], right[2]);
+      GLExtensions::uniform3f(faceUpLocation, up[0], up[1], up[2]);
+      GLExtensions::uniform2f(cubeBlurOriginLocation, x, y);
+      drawBlurQuad();
+   }
+   glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+   glViewport(0, 0, mapSize, mapSize);
+   GLExtensions::useProgram(blurProgram);
+   GLExtensions::uniform2f(blurStepLocation, 0.0, 1.0 / (mapSize * BLUR_ROWS));
+   GLExtensions::uniform2f(blurOriginLocation, 0.0, 0.0);
+   renderState.setTexture(blurTexture);
+   for (face = 0; face < 6; face++)
+   {
+      GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+         GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubeTextures[light], 0);
+      setBlurSource(face);
+      drawBlurQuad();
+   }
+   renderState.setTexture(0);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Blur one of the sun's variance cascades, across into the blur texture and
+   then down back into its part of the cascade texture.  The cascade
+   framebuffer is left unbound.
+
+  @param cascade The cascade
+  */
+void ShadowMapScene::blurCascade(int cascade)
+{
+   float tileWidth = 1.0 / numCascades;
+   float halfTexel = 0.5 / (mapSize * numCascades);
+
+   GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, blurFramebufferId);
+   GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurTexture, 0);
+   glViewport(0, 0, mapSize, mapSize);
+   GLExtensions::useProgram(blurProgram);
+   GLExtensions::uniform4f(blurAreaLocation, cascade * tileWidth, 0.0, tileWidth, 1.0);
+   GLExtensions::uniform4f(blurLimitsLocation, cascade * tileWidth + halfTexel, 0.0,
+      (cascade + 1) * tileWidth - halfTexel, 1.0);
+   GLExtensions::uniform2f(blurStepLocation, 1.0 / (mapSize * numCascades), 0.0);
+   GLExtensions::uniform2f(blurOriginLocation, 0.0, 0.0);
+   renderState.setTexture(cascadeTexture);
+   drawBlurQuad();
+
+   GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cascadeTexture, 0);
+   glViewport(cascade * mapSize, 0, mapSize, mapSize);
+   setBlurSource(0);
+   GLExtensions::uniform2f(blurStepLocation, 0.0, 1.0 / (mapSize * BLUR_ROWS));
+   GLExtensions::uniform2f(blurOriginLocation, cascade * mapSize, 0.0);
+   renderState.setTexture(blurTexture);
+   drawBlurQuad();
+   renderState.setTexture(0);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Point the blur program at one map's part of the blur texture, the taps
+   are kept half a texel inside it
+
+  @param tile The part (a cube face), they go across then up
+  */
+void ShadowMapScene::setBlurSource(int tile)
+{
+   float width = 1.0 / BLUR_COLUMNS;
+   float height = 1.0 / BLUR_ROWS;
+   float left = tile % BLUR_COLUMNS * width;
+   float bottom = tile / BLUR_COLUMNS * height;
+   float halfTexelX = 0.5 / (mapSize * BLUR_COLUMNS);
+   float halfTexelY = 0.5 / (mapSize * BLUR_ROWS);
+   GLExtensions::uniform4f(blurAreaLocation, left, bottom, width, height);
+   GLExtensions::uniform4f(blurLimitsLocation, left + halfTexelX, bottom + halfTexelY,
+      left + width - halfTexelX, bottom + height - halfTexelY);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw a quad over the whole viewport for a blur pass, the blur's vertex
+   shader takes the corners as they are
+  */
+void ShadowMapScene::drawBlurQuad()
+{
+   glBegin(GL_QUADS);
+   glVertex2f(-1.0, -1.0);
+   glVertex2f(1.0, -1.0);
+   glVertex2f(1.0, 1.0);
+   glVertex2f(-1.0, 1.0);
+   glEnd();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Put this frame's clusters into the textures the lighting program reads
+   them from and bind those: the offset and count of each cluster, the
+   light indices of every cluster one after another, and each light's
+   position, reach, color and whether it is shadowed.  The textures only
+   grow.
+
+  @param firstUnit The texture unit of the first texture, the other two
+                   follow it
+  */
+void ShadowMapScene::uploadClusters(int firstUnit)
+{
+   int clustersWide = LightClusters::CLUSTERS_X * LightClusters::CLUSTERS_Y;
+   int index;
+   if (!clusterTexture)
+   {
+      glGenTextures(1, &clusterTexture);
+      glGenTextures(1, &clusterIndexTexture);
+      glGenTextures(1, &clusterLightTexture);
+      GLExtensions::activeTexture(GL_TEXTURE0 + firstUnit);
+      unsigned int textures[3] = {clusterTexture, clusterIndexTexture, clusterLightTexture};
+      for (index = 0; index < 3; index++)
+      {
+         glBindTexture(GL_TEXTURE_2D, textures[index]);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      }
+      glBindTexture(GL_TEXTURE_2D, clusterTexture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA32F_ARB, clustersWide, LightClusters::CLUSTERS_Z, 0,
+         GL_LUMINANCE_ALPHA, GL_FLOAT, 0);
+   }
+
+   // each cluster's offset and count, a row of tiles for each slice
+   const vector<int> &offsets = lightClusters.getOffsets();
+   const vector<int> &counts = lightClusters.getCounts();
+   clusterUpload.resize(LightClusters::NUM_CLUSTERS * 2);
+   for (index = 0; index < LightClusters::NUM_CLUSTERS; index++)
+   {
+      clusterUpload[index * 2] = offsets[index];
+      clusterUpload[index * 2 + 1] = counts[index];
+   }
+   GLExtensions::activeTexture(GL_TEXTURE0 + firstUnit);
+   glBindTexture(GL_TEXTURE_2D, clusterTexture);
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, clustersWide, LightClusters::CLUSTERS_Z,
+      GL_LUMINANCE_ALPHA, GL_FLOAT, &clusterUpload[0]);
+
+   // the light indices, in whole rows
+   const vector<int> &indices = lightClusters.getLightIndices();
+   int rows = (indices.size() + CLUSTER_INDEX_WIDTH - 1) / CLUSTER_INDEX_WIDTH;
+   if (rows < 1)
+      rows = 1;
+   GLExtensions::activeTexture(GL_TEXTURE0 + firstUnit + 1);
+   glBindTexture(GL_TEXTURE_2D, clusterIndexTexture);
+   if (rows > clusterIndexRows)
+   {
+      clusterIndexRows = rows;
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE32F_ARB, CLUSTER_INDEX_WIDTH, rows, 0,
+         GL_LUMINANCE, GL_FLOAT, 0);
+   }
+   clusterUpload.assign(rows * CLUSTER_INDEX_WIDTH, 0.0);
+   for (index = 0; index < indices.size(); index++)
+      clusterUpload[index] = indices[index];
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, CLUSTER_INDEX_WIDTH, rows, GL_LUMINANCE, GL_FLOAT, &clusterUpload[0]);
+
+   // two texels for each light
+   int numPointLights = pointLightX.size();
+   GLExtensions::activeTexture(GL_TEXTURE0 + firstUnit + 2);
+   glBindTexture(GL_TEXTURE_2D, clusterLightTexture);
+   if (numPointLights > clusterLightRows)
+   {
+      clusterLightRows = numPointLights;
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, 2, numPointLights, 0, GL_RGBA, GL_FLOAT, 0);
+   }
+   clusterUpload.resize(numPointLights * 8);
+   for (index = 0; index < numPointLights; index++)
+   {
+      float *light = &clusterUpload[index * 8];
+      light[0] = pointLightX[index];
+      light[1] = pointLightY[index];
+      light[2] = pointLightZ[index];
+      light[3] = pointLightRadii[index];
+      light[4] = pointLightColors[index * 3];
+      light[5] = pointLightColors[index * 3 + 1];
+      light[6] = pointLightColors[index * 3 + 2];
+      light[7] = 0.0;
+   }
+   for (index = 0; index < shadowLightIndices.size(); index++)
+   {
+      if (!isEmptyLightSlot(index))
+         clusterUpload[shadowLightIndices[index] * 8 + 7] = 1.0;
+   }
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, numPointLights, GL_RGBA, GL_FLOAT, &clusterUpload[0]);
+
+   // the tiles are found from the fragment's place in the viewport
+   int viewport[4];
+   glGetIntegerv(GL_VIEWPORT, viewport);
+   GLExtensions::uniform4f(clusterScreenLocation, viewport[0], viewport[1],
+      (float)LightClusters::CLUSTERS_X / viewport[2], (float)LightClusters::CLUSTERS_Y / viewport[3]);
+   GLExtensions::uniform2f(clusterDepthLocation, lightClusters.getNearDepth(), lightClusters.getSliceScale());
+   GLExtensions::uniform2f(clusterSizesLocation, clusterIndexRows, clusterLightRows);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the cube maps and start shading the visible models with them
+  */
+void ShadowMapScene::beginLightingPass()
+{
+   cascadesDrawn = 0;
+   if (!drawShadowsFlag || (pointLightList.size() == 0 && directionalLightList.size() == 0))
+      return;
+   if (!initialized)
+      initialize();
+   if (!supported)
+      return;
+   if (shadowFilter != programFilter && !createFilterPrograms())
+   {
+      supported = false;
+      return;
+   }
+
+   int numLights = pointLightList.size();
+   if (numLights > MAX_SHADOW_LIGHTS)
+      numLights = MAX_SHADOW_LIGHTS;
+   int sunCascades = directionalLightList.size() > 0 ? numCascades : 0;
+   bool clustered = GLExtensions::hasFloatTextures && pointLightX.size() > numLights;
+   if ((numLights != numShadowLights || sunCascades != numShadowCascades || clustered != shadingClusters) &&
+       !createLightingProgram(numLights, sunCascades, clustered))
+   {
+      supported = false;
+      return;
+   }
+   if (sunCascades != cascadeMapCascades && sunCascades > 0 && !createCascadeMap())
+   {
+      supported = false;
+      return;
+   }
+   while (cubeTextures.size() < numLights)
+      cubeTextures.push_back(createShadowCube());
+
+   renderShadowMaps(numLights);
+
+   // the cube maps are looked up in the world's axes, the view matrix is
+   // rigid so its inverse is the transposed rotation and turned translation
+   float eyeToWorld[16];
+   for (int row = 0; row < 3; row++)
+   {
+      for (int column = 0; column < 3; column++)
+         eyeToWorld[column * 4 + row] = viewMatrix[row * 4 + column];
+      eyeToWorld[row * 4 + 3] = 0.0;
+      eyeToWorld[12 + row] = -(viewMatrix[row * 4] * viewMatrix[12] +
+         viewMatrix[row * 4 + 1] * viewMatrix[13] + viewMatrix[row * 4 + 2] * viewMatrix[14]);
+   }
+   eyeToWorld[15] = 1.0;
+
+   if (sunCascades > 0)
+      renderCascades(eyeToWorld);
+
+   GLExtensions::useProgram(lightingProgram);
+   GLExtensions::uniformMatrix4fv(eyeToWorldLocation, 1, GL_FALSE, eyeToWorld);
+   GLExtensions::uniform1f(lightRangeLocation, lightRange);
+   GLExtensions::uniform1f(depthBiasLocation, depthBias);
+   for (int light = 0; light < numLights; light++)
+   {
+      const Vector3D &position = pointLightList[light];
+      GLExtensions::uniform3f(lightPositionLocations[light], position.x, position.y, position.z);
+      GLExtensions::activeTexture(GL_TEXTURE0 + light + 1);
+      glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTextures[light]);
+   }
+   if (sunCascades > 0)
+   {
+      float ends[MAX_CASCADES];
+      float matrices[MAX_CASCADES * 16];
+      float ranges[MAX_CASCADES];
+      float biases[MAX_CASCADES];
+      for (int cascade = 0; cascade < sunCascades; cascade++)
+      {
+         const Cascade &slice = cascades[cascade];
+         ends[cascade] = slice.end;
+         memcpy(&matrices[cascade * 16], slice.lookupMatrix, 16 * sizeof(float));
+         ranges[cascade] = slice.bounds[4] - slice.bounds[3];
+         biases[cascade] = slice.texelSize * CASCADE_BIAS_TEXELS;
+      }
+      GLExtensions::uniform1fv(cascadeEndsLocation, sunCascades, ends);
+      GLExtensions::uniformMatrix4fv(cascadeMatricesLocation, sunCascades, GL_FALSE, matrices);
+      GLExtensions::uniform1fv(cascadeRangesLocation, sunCascades, ranges);
+      GLExtensions::uniform1fv(cascadeBiasesLocation, sunCascades, biases);
+      GLExtensions::activeTexture(GL_TEXTURE0 + numLights + 1);
+      glBindTexture(GL_TEXTURE_2D, cascadeTexture);
+   }
+   if (clustered)
+      uploadClusters(numLights + 2);
+   GLExtensions::activeTexture(GL_TEXTURE0);
+
+   modelLit = -1;
+   modelTextured = -1;
+   lightingPassOn = true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Go back to openGL's lighting for whatever is drawn after the models
+  */
+void ShadowMapScene::endLightingPass()
+{
+   if (!lightingPassOn)
+      return;
+   GLExtensions::useProgram(0);
+   lightingPassOn = false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Tell the lighting program how the next model is shaded, only when that
+   changes (the draws are sorted by state)
+
+  @param lit true if the model is lit, false if it is drawn in its color
+  @param textured true if the model's texture is bound
+  */
+void ShadowMapScene::setModelShading(bool lit, bool textured)
+{
+   if (!lightingPassOn)
+      return;
+   if (modelLit != (int)lit)
+   {
+      GLExtensions::uniform1i(litLocation, lit);
+      modelLit = lit;
+   }
+   if (modelTextured != (int)textured)
+   {
+      GLExtensions::uniform1i(texturedLocation, textured);
+      modelTextured = textured;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   The shadows were drawn by the lighting pass, there is nothing left to do
+  */
+void ShadowMapScene::drawShadows()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Build a shader program
+
+  @param vertexSource The vertex shader
+  @param fragmentSource The fragment shader
+  @param name What the program is for, for the error messages
+  @return The program, 0 if it didn't build
+  */
+unsigned int ShadowMapScene::createProgram(const string &vertexSource, const string &fragmentSource, const char *name)
+{
+   unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, name);
+   unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, name);
+   if (!vertexShader || !fragmentShader)
+   {
+      if (vertexShader) GLExtensions::deleteShader(vertexShader);
+      if (fragmentShader) GLExtensions::deleteShader(fragmentShader);
+      return 0;
+   }
+
+   unsigned int program = GLExtensions::createProgram();
+   GLExtensions::attachShader(program, vertexShader);
+   GLExtensions::attachShader(program, fragmentShader);
+   GLExtensions::linkProgram(program);
+
+   // the program keeps the shaders until it is deleted
+   GLExtensions::deleteShader(vertexShader);
+   GLExtensions::deleteShader(fragmentShader);
+
+   GLint linked = 0;
+   GLExtensions::getProgramiv(program, GL_LINK_STATUS, &linked);
+   if (!linked)
+   {
+      char log[1024];
+      GLExtensions::getProgramInfoLog(program, sizeof(log), 0, log);
+      cout << "ERROR: the " << name << " program didn't link" << endl << log << endl;
+      GLExtensions::deleteProgram(program);
+      return 0;
+   }
+   return program;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Compile a shader
+
+  @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+  @param source The shader's code
+  @param name What the shader is for, for the error messages
+  @return The shader, 0 if it didn't compile
+  */
+unsigned int ShadowMapScene::compileShader(unsigned int type, const string &source, const char *name)
+{
+   unsigned int shader = GLExtensions::createShader(type);
+   const char *text = source.c_str();
+   GLExtensions::shaderSource(shader, 1, &text, 0);
+   GLExtensions::compileShader(shader);
+
+   GLint compiled = 0;
+   GLExtensions::getShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+   if (!compiled)
+   {
+      char log[1024];
+      GLExtensions::getShaderInfoLog(shader, sizeof(log), 0, log);
+      cout << "ERROR: the " << name << (type == GL_VERTEX_SHADER ? " vertex" : " fragment")
+           << " shader didn't compile" << endl << log << endl;
+      GLExtensions::deleteShader(shader);
+      return 0;
+   }
+   return shader;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Write out a piece of shader code once for each light
+
+  @param code The code, each # in it is replaced by the light's number
+  @param numLights How many lights (up to 10)
+  @return The code for all the lights
+  */
+string ShadowMapScene::repeatForLights(const char *code, int numLights)
+{
+   string result;
+   for (int light = 0; light < numLights; light++)
+   {
+      string lightCode = code;
+      for (int index = 0; index < lightCode.size(); index++)
+      {
+         if (lightCode[index] == '#')
+            lightCode[index] = (char)('0' + light);
+      }
+      result += lightCode;
+   }
+   return result;
+}
+}
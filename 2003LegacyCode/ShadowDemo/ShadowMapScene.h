@@ -0,0 +1,199 @@
+#ifndef SHADOWMAPSCENE_H
+#define SHADOWMAPSCENE_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include "ShadowableScene.h"
+
+namespace SML_CORE
+{
+// forward declare
+class Model3D;
+
+/**
+  This class is a specalized ShadowableScene class that shadows the scene
+  with shadow maps.  Each point light renders the distance to the nearest
+  caster in every direction into a cube map (one depth pass of six faces
+  per light, however many receivers there are), then the lighting pass
+  shades every visible model with a shader that leaves out the light where
+  something nearer the light is in the cube map.  So shadows fall on
+  anything, the tanks included, not just the ground plane.
+
+  The sun (the directional light) is shadowed with cascaded shadow maps.
+  The part of the view out to the shadow distance is split into cascades,
+  each a slice of the view further out than the last (the split moves
+  between even and logarithmic spacing with the split weight).  Each
+  cascade is drawn from the sun with an orthographic view around its
+  slice's bounding sphere, into its own part of one texture, with just the
+  casters in the box from the sphere back towards the sun.  The sphere
+  keeps the cascade the same size however the camera turns, and its center
+  is snapped to whole texels so the shadow edges don't crawl as the camera
+  moves.  A cascade is only drawn again when its box or its casters move.
+
+  The shadow edges are hard, or softened by one of the ShadowFilters, which
+  can be changed between frames.  Percentage closer filtering compares 4
+  or 16 texels a texel apart around the point and lights it by the share
+  that pass.  Variance shadow maps hold the depth and its square, blurred
+  one way then the other after the map is drawn, so one lookup gives a
+  soft edge whatever its width.
+
+  The point lights that aren't shadowed are lit per pixel in the lighting
+  pass.  The lists of the lights in each of the view's clusters and the
+  lights' positions and colors are put into float textures each frame, a
+  fragment finds its cluster from where it is on the screen and its depth
+  and adds up the lights in the cluster's list.  So a fragment costs the
+  lights of its cluster, not every light in the scene.  Without float
+  textures only the shadowed lights light the scene.
+
+  The distances are packed into RGBA8 textures so only openGL 2.0 and
+  framebuffer objects are needed (Mesa's software renderer has both).
+  Without them the scene is drawn unshadowed.  Packed depths can't be
+  filtered by the texture units, the taps are compared in the shader.
+*/
+class ShadowMapScene : public ShadowableScene
+{
+public:
+   /** the most lights that are shadowed, the rest are lit without shadows
+       from the clusters (with float textures) or left out */
+   enum {MAX_SHADOW_LIGHTS = 4};
+   /** the width of a cube map face when none is given */
+   enum {DEFAULT_MAP_SIZE = 512};
+   /** the most cascades the sun's view can be split into */
+   enum {MAX_CASCADES = 4};
+   /** the width of the texture the clusters' light lists are packed into */
+   enum {CLUSTER_INDEX_WIDTH = 1024};
+
+   /** The ways the shadow maps can be filtered, cheapest first */
+   enum ShadowFilters
+   {
+      HARD_SHADOWS = 0,   // one tap
+      PCF_4_TAPS,
+      PCF_16_TAPS,
+      VARIANCE_SHADOWS,
+      NUM_SHADOW_FILTERS  //this must be the last element
+   };
+
+private:
+   /** One of the sun's cascades, its slice of the view and what was last
+       drawn for it */
+   class Cascade
+   {
+   public:
+      float end;
+      float bounds[5];
+      float texelSize;
+      float lookupMatrix[16];
+      std::vector<Model3D*> casters;
+      std::vector<float> casterTransforms;
+      bool drawn;
+   };
+
+   bool initialized;
+   bool supported;
+   int mapSize;
+   float lightRange;
+   float depthBias;
+   unsigned int framebufferId;
+   unsigned int depthBufferId;
+   std::vector<unsigned int> cubeTextures;
+   unsigned int depthProgram;
+   int depthRangeLocation;
+   unsigned int lightingProgram;
+   int numShadowLights;
+   int eyeToWorldLocation;
+   int lightRangeLocation;
+   int depthBiasLocation;
+   int litLocation;
+   int texturedLocation;
+   int lightPositionLocations[MAX_SHADOW_LIGHTS];
+   bool lightingPassOn;
+   int modelLit;
+   int modelTextured;
+   std::vector<Model3D*> faceCasters;
+   int numCascades;
+   float cascadeSplitWeight;
+   float shadowDistance;
+   Cascade cascades[MAX_CASCADES];
+   int cascadeMapCascades;
+   unsigned int cascadeTexture;
+   unsigned int cascadeFramebufferId;
+   unsigned int cascadeDepthBufferId;
+   unsigned int cascadeDepthProgram;
+   int cascadeNearLocation;
+   int cascadeRangeLocation;
+   Vector3D cascadeLight;
+   float sunAxes[9];
+   int numShadowCascades;
+   int cascadeEndsLocation;
+   int cascadeMatricesLocation;
+   int cascadeRangesLocation;
+   int cascadeBiasesLocation;
+   int cascadesDrawn;
+   std::vector<Model3D*> cascadeCasters;
+   std::vector<float> cascadeTransforms;
+   int shadowFilter;
+   int programFilter;
+   unsigned int blurProgram;
+   unsigned int cubeBlurProgram;
+   unsigned int blurTexture;
+   unsigned int blurFramebufferId;
+   int blurAreaLocation;
+   int blurLimitsLocation;
+   int blurStepLocation;
+   int blurOriginLocation;
+   int cubeBlurOriginLocation;
+   int faceForwardLocation;
+   int faceRightLocation;
+   int faceUpLocation;
+   bool shadingClusters;
+   unsigned int clusterTexture;
+   unsigned int clusterIndexTexture;
+   unsigned int clusterLightTexture;
+   int clusterIndexRows;
+   int clusterLightRows;
+   int clusterScreenLocation;
+   int clusterDepthLocation;
+   int clusterSizesLocation;
+   std::vector<float> clusterUpload;
+
+   void initialize();
+   bool createFilterPrograms();
+   bool createBlurTarget();
+   void setBlurSource(int tile);
+   std::string filterHead() const;
+   unsigned int createShadowCube();
+   bool createLightingProgram(int numLights, int numSunCascades, bool clustered);
+   bool createCascadeMap();
+   void renderShadowMaps(int numLights);
+   void renderShadowCube(int light);
+   void renderCascades(const float *eyeToWorld);
+   bool updateCascade(int cascade, float start, const float *eyeToWorld, const float *projection);
+   void renderCascade(int cascade);
+   void blurShadowCube(int light);
+   void blurCascade(int cascade);
+   static void drawBlurQuad();
+   void uploadClusters(int firstUnit);
+   void drawShadows();
+   void beginLightingPass();
+   void endLightingPass();
+   void setModelShading(bool lit, bool textured);
+   static unsigned int createProgram(const std::string &vertexSource, const std::string &fragmentSource, const char *name);
+   static unsigned int compileShader(unsigned int type, const std::string &source, const char *name);
+   static std::string repeatForLights(const char *code, int numLights);
+
+public:
+   ShadowMapScene(int mapSize=DEFAULT_MAP_SIZE);
+   virtual ~ShadowMapScene();
+   void setLightRange(float range) {lightRange = range;};
+   void setDepthBias(float bias) {depthBias = bias;};
+   void setCascades(int count);
+   void setCascadeSplitWeight(float weight) {cascadeSplitWeight = weight;};
+   void setShadowDistance(float distance) {shadowDistance = distance;};
+   int getCascades() const {return numCascades;};
+   int getCascadesDrawn() const {return cascadesDrawn;};
+   void setShadowFilter(int filter);
+   int getShadowFilter() const {return shadowFilter;};
+   bool isSupported() const {return supported;};
+};
+}
+#endif
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "ShadowScheduler.h"
+#include "Platform.h"
+
+using std::vector;
+using std::map;
+
+namespace SML_CORE
+{
+// casters whose bounds are at least this many pixels across the screen are
+// refreshed every frame, smaller ones less often (down to MAX_INTERVAL)
+static const float FULL_RATE_PIXELS = 48.0;
+static const int MAX_INTERVAL = 8;
+
+// a caster isn't left for more frames than it takes to move this many
+// pixels across the screen
+static const float MAX_DRIFT_PIXELS = 4.0;
+
+// the default time the refreshes may take each frame, and the time one is
+// guessed to take before any have been measured (milliseconds)
+static const float DEFAULT_BUDGET = 2.0;
+static const float DEFAULT_REFRESH_COST = 0.05;
+
+// how much each frame's measured refresh time moves the estimate
+static const float COST_SMOOTHING = 0.1;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+  */
+ShadowScheduler::ShadowScheduler() :
+enabled(true),
+budget(DEFAULT_BUDGET),
+frame(0),
+pixelScale(1.0),
+refreshCost(DEFAULT_REFRESH_COST),
+refreshStart(0.0),
+refreshTime(0.0),
+refreshes(0),
+casterRefreshes(0),
+casterDeferrals(0)
+{
+   for (int index = 0; index < 16; index++)
+      viewMatrix[index] = index % 5 == 0 ? 1.0 : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+ShadowScheduler::~ShadowScheduler()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start a frame.  The time the last frame's refreshes took goes into the
+   estimate of what one costs.
+
+  @param view The camera's view matrix
+  @param scale The pixels across the screen a unit at a distance of one
+               covers (half the viewport height times the projection's y
+               scale)
+  */
+void ShadowScheduler::beginFrame(const float *view, float scale)
+{
+   if (refreshes > 0)
+      refreshCost += (refreshTime / refreshes - refreshCost) * COST_SMOOTHING;
+
+   frame++;
+   memcpy(viewMatrix, view, 16 * sizeof(float));
+   pixelScale = scale;
+   candidates.clear();
+   refreshTime = 0.0;
+   refreshes = 0;
+   casterRefreshes = 0;
+   casterDeferrals = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find a caster's schedule, a new caster gets one with nothing built
+
+  @param storeId The caster's id in the scene store
+  @return The schedule
+  */
+ShadowScheduler::CasterSchedule& ShadowScheduler::findSchedule(int storeId)
+{
+   map<int, CasterSchedule>::iterator found = schedules.find(storeId);
+   if (found != schedules.end())
+      return found->second;
+
+   CasterSchedule schedule;
+   schedule.lastUpdate = -1;
+   schedule.phase = storeId % MAX_INTERVAL;
+   schedule.lastSeen = -1;
+   schedule.interval = 1;
+   schedule.priority = 0.0;
+   schedule.candidateFrame = -1;
+   schedule.candidateLights = 0;
+   schedule.due = false;
+   schedule.center[0] = 0.0;
+   schedule.center[1] = 0.0;
+   schedule.center[2] = 0.0;
+   return schedules.insert(map<int, CasterSchedule>::value_type(storeId, schedule)).first->second;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a caster whose shadow may be drawn this frame and work out its
+   interval.  A caster is added once for each light it may be drawn for,
+   its interval is only worked out the first time in a frame.
+
+  @param storeId The caster's id in the scene store
+  @param sphere The caster's world bounding sphere (center and radius)
+  */
+void ShadowScheduler::addCandidate(int storeId, const float *sphere)
+{
+   CasterSchedule &schedule = findSchedule(storeId);
+   if (schedule.candidateFrame == frame)
+   {
+      schedule.candidateLights++;
+      return;
+   }
+   schedule.candidateFrame = frame;
+   schedule.candidateLights = 1;
+
+   // the size of the caster on the screen, anything the camera is inside
+   // counts as full size
+   float depth = -(viewMatrix[2] * sphere[0] + viewMatrix[6] * sphere[1] + viewMatrix[10] * sphere[2] + viewMatrix[14]);
+   if (depth < sphere[3])
+      depth = sphere[3];
+   float pixels = 2.0 * sphere[3] * pixelScale / depth;
+   if (pixels >= FULL_RATE_PIXELS)
+      schedule.interval = 1;
+   else if (pixels * MAX_INTERVAL <= FULL_RATE_PIXELS)
+      schedule.interval = MAX_INTERVAL;
+   else
+      schedule.interval = (int)(FULL_RATE_PIXELS / pixels);
+
+   // how fast it has been moving across the screen since it was last seen
+   if (schedule.lastSeen >= 0)
+   {
+      float offset[3] =
+      {
+         sphere[0] - schedule.center[0],
+         sphere[1] - schedule.center[1],
+         sphere[2] - schedule.center[2]
+      };
+      float moved = (float)sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+      float speed = moved * pixelScale / (depth * (frame - schedule.lastSeen));
+      if (speed * schedule.interval > MAX_DRIFT_PIXELS)
+      {
+         schedule.interval = (int)(MAX_DRIFT_PIXELS / speed);
+         if (schedule.interval < 1)
+            schedule.interval = 1;
+      }
+   }
+   schedule.lastSeen = frame;
+   schedule.center[0] = sphere[0];
+   schedule.center[1] = sphere[1];
+   schedule.center[2] = sphere[2];
+
+   schedule.due = !enabled;
+   candidates.push_back(&schedule);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Compare the casters waiting for a refresh, the most overdue first
+  */
+bool ShadowScheduler::isMoreOverdue(const CasterSchedule *first, const CasterSchedule *second)
+{
+   return first->priority > second->priority;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Pick the casters that are refreshed this frame.  The casters with nothing
+   built are taken first, then the due casters most overdue first until the
+   time they are expected to take would go over the budget.  A caster is
+   expected to take a refresh for each light it was added for.
+  */
+void ShadowScheduler::selectUpdates()
+{
+   float spent = 0.0;
+   waiting.clear();
+   // grow the list along with the candidates, not when they first fall due
+   waiting.reserve(candidates.size());
+   int index;
+   for (index = 0; index < candidates.size(); index++)
+   {
+      CasterSchedule &schedule = *candidates[index];
+      if (schedule.lastUpdate < 0 || !enabled)
+      {
+         schedule.due = true;
+         spent += refreshCost * schedule.candidateLights;
+         continue;
+      }
+      int age = frame - schedule.lastUpdate;
+      if (age < schedule.interval)
+         continue;
+      schedule.priority = (float)age / schedule.interval;
+      waiting.push_back(&schedule);
+   }
+
+   std::sort(waiting.begin(), waiting.end(), isMoreOverdue);
+   for (index = 0; index < waiting.size(); index++)
+   {
+      CasterSchedule &schedule = *waiting[index];
+      float cost = refreshCost * schedule.candidateLights;
+      if (spent + cost > budget)
+      {
+         casterDeferrals++;
+         continue;
+      }
+      schedule.due = true;
+      spent += cost;
+   }
+
+   // casters built for the first time are spread over the frames after,
+   // so casters that arrive together aren't all due again together
+   for (index = 0; index < candidates.size(); index++)
+   {
+      CasterSchedule &schedule = *candidates[index];
+      if (!schedule.due)
+         continue;
+      if (schedule.lastUpdate < 0)
+         schedule.lastUpdate = frame - schedule.phase % schedule.interval;
+      else
+         schedule.lastUpdate = frame;
+      casterRefreshes++;
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the shadow built for a caster from a light.  Its refresh flag says
+   whether it should be built again: the caster is due this frame and it
+   hasn't been built yet this frame, or it has never been built.
+
+  @param storeId The caster's id in the scene store
+  @param lightIndex The light
+  @return The shadow, the scene builds into its vertices
+  */
+ShadowScheduler::ShadowResult& ShadowScheduler::findShadow(int storeId, int lightIndex)
+{
+   CasterSchedule &schedule = findSchedule(storeId);
+   if (schedule.shadows.size() <= lightIndex)
+   {
+      ShadowResult empty;
+      empty.frame = -1;
+      empty.refresh = true;
+      schedule.shadows.resize(lightIndex + 1, empty);
+   }
+   ShadowResult &shadow = schedule.shadows[lightIndex];
+   shadow.refresh = shadow.frame < 0 ||
+      (schedule.due && schedule.candidateFrame == frame && shadow.frame != frame);
+   return shadow;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start timing the building of a shadow
+  */
+void ShadowScheduler::startRefresh()
+{
+   refreshStart = getPreciseMilliseconds();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Stop timing the building of a shadow and mark it built this frame
+
+  @param shadow The shadow built
+  */
+void ShadowScheduler::finishRefresh(ShadowResult &shadow)
+{
+   refreshTime += getPreciseMilliseconds() - refreshStart;
+   refreshes++;
+   shadow.frame = frame;
+   shadow.refresh = false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Drop what is kept for a caster, when it leaves the scene (its store id
+   may be given to another model)
+
+  @param storeId The caster's id in the scene store
+  */
+void ShadowScheduler::forget(int storeId)
+{
+   map<int, CasterSchedule>::iterator found = schedules.find(storeId);
+   if (found == schedules.end())
+      return;
+
+   // it can't be left among this frame's candidates
+   vector<CasterSchedule*>::iterator candidate =
+      std::find(candidates.begin(), candidates.end(), &found->second);
+   if (candidate != candidates.end())
+      candidates.erase(candidate);
+   schedules.erase(found);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Drop the shadows built from one light, when another light takes its
+   place.  The casters keep their intervals and their shadows from the
+   other lights, the dropped ones are built again the next time they are
+   asked for.
+
+  @param lightIndex The light
+  */
+void ShadowScheduler::forgetShadows(int lightIndex)
+{
+   map<int, CasterSchedule>::iterator schedule;
+   for (schedule = schedules.begin(); schedule != schedules.end(); schedule++)
+   {
+      vector<ShadowResult> &shadows = schedule->second.shadows;
+      if (lightIndex < shadows.size())
+      {
+         shadows[lightIndex].vertices.clear();
+         shadows[lightIndex].frame = -1;
+      }
+   }
+}
+}
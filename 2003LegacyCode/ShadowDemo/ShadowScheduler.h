@@ -0,0 +1,99 @@
+#ifndef SHADOWSCHEDULER_H
+#define SHADOWSCHEDULER_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <map>
+
+namespace SML_CORE
+{
+/**
+  This class decides which casters have the shadow geometry built on the
+  CPU (silhouettes, outlines, volumes) built again each frame.  The rest
+  reuse what was built for them last time.  The geometry is kept in the
+  caster's model space, so a reused shadow still follows its caster and
+  only its shape is out of date.
+
+  Each caster the scene may draw a shadow for is given an interval, in
+  frames, from the size of its bounds on the screen and how fast they move
+  across it.  Casters at least FULL_RATE_PIXELS across are due every frame,
+  smaller ones less often, down to every MAX_INTERVAL frames.  Casters that
+  move fast on the screen are due more often.  Each frame the due casters
+  are refreshed most overdue first while the time they are expected to
+  take fits the budget, the rest wait for the next frame.  A caster with
+  nothing built yet is always refreshed.  The time a refresh takes is
+  measured as the scene builds them.
+
+  Call beginFrame, add the candidates, then selectUpdates before the scene
+  asks for the shadows with findShadow.
+*/
+class ShadowScheduler
+{
+public:
+   /** The shadow geometry built for a caster from one light, in the
+       caster's model space, and the frame it was built.  refresh is set by
+       findShadow when it should be built again. */
+   class ShadowResult
+   {
+   public:
+      std::vector<float> vertices;
+      int frame;
+      bool refresh;
+   };
+
+private:
+   /** A caster's interval and the shadows built for it */
+   class CasterSchedule
+   {
+   public:
+      int lastUpdate;
+      int phase;
+      int lastSeen;
+      float center[3];
+      int interval;
+      float priority;
+      int candidateFrame;
+      int candidateLights;
+      bool due;
+      std::vector<ShadowResult> shadows;
+   };
+
+   std::map<int, CasterSchedule> schedules;
+   std::vector<CasterSchedule*> candidates;
+   std::vector<CasterSchedule*> waiting;
+   bool enabled;
+   float budget;
+   int frame;
+   float viewMatrix[16];
+   float pixelScale;
+   float refreshCost;
+   double refreshStart;
+   double refreshTime;
+   int refreshes;
+   int casterRefreshes;
+   int casterDeferrals;
+
+   CasterSchedule& findSchedule(int storeId);
+   static bool isMoreOverdue(const CasterSchedule *first, const CasterSchedule *second);
+
+public:
+   ShadowScheduler();
+   virtual ~ShadowScheduler();
+   void beginFrame(const float *view, float scale);
+   void addCandidate(int storeId, const float *sphere);
+   void selectUpdates();
+   ShadowResult& findShadow(int storeId, int lightIndex);
+   void startRefresh();
+   void finishRefresh(ShadowResult &shadow);
+   void forget(int storeId);
+   void forgetShadows(int lightIndex);
+   void setEnabled(bool on) {enabled = on;};
+   bool isEnabled() const {return enabled;};
+   void setBudget(float milliseconds) {budget = milliseconds;};
+   float getBudget() const {return budget;};
+   float getRefreshCost() const {return refreshCost;};
+   int getRefreshes() const {return refreshes;};
+   int getCasterRefreshes() const {return casterRefreshes;};
+   int getCasterDeferrals() const {return casterDeferrals;};
+};
+}
+#endif
@@ -1,255 +1,1033 @@
-#include <GL/glut.h>
-#include "ShadowableScene.h"
-#include "Model3D.h"
-
-using std::string;
-using std::vector;
-
-namespace SML_CORE
-{
-// static constants defined
-const int ShadowableScene::MAX_LIGHTS = 1;
-
-//-----------------------------------------------------------------------------
-/**
-      Constructor
-  */
-ShadowableScene::ShadowableScene() :
-drawLightsFlag(false),
-drawShadowsFlag(true),
-shadowCasterList(0),
-shadowReceiverList(0),
-normalList(0),
-pointLightList(0)
-{
-   // the default light level
-   float lmodelAmbient[] = { 0.4, 0.4, 0.4, 1.0 };
-   glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lmodelAmbient);
-   glEnable(GL_LIGHTING);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Destructor
-  */
-ShadowableScene::~ShadowableScene()
-{
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Add a call list number to the scene, but I need to add with a unique id, 
-   vector positon, and call list id.
-  */
-void ShadowableScene::addModel(Model3D* model, int mode)
-{
-   switch(mode)
-   {
-   case (NONE):
-      normalList.push_back(model);
-      break;
-   case (RECEIVES_SHADOWS):
-      shadowReceiverList.push_back(model);
-      break;
-   case (CASTS_SHADOWS):
-      shadowCasterList.push_back(model);
-      break;
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Remove a call list
-  */
-bool ShadowableScene::removeModel(string modelName)
-{
-   /// \todo loop through all the display lists and try to find the modelName
-   if (removeModelFromList(modelName, shadowCasterList))
-      return true;
-   else if (removeModelFromList(modelName, shadowReceiverList))
-      return true;
-   else if (removeModelFromList(modelName, normalList))
-      return true;
-
-   return false;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Remove the argument model from the argument list
-  */
-bool ShadowableScene::removeModelFromList(string modelName, vector<Model3D*> &list)
-{
-   /// \todo loop through all the display lists and try to find the modelName
-   Model3D *aModel;
-   for (int index = 0; index < list.size(); index++)
-   {
-      aModel = list[index];
-      if (aModel->getName() == modelName)
-      {
-         shadowCasterList.erase(&list[index]);
-         return true;
-      }
-   }
-
-   return false;
-}
-
-//-----------------------------------------------------------------------------
-/**
-  Render the scene
-*/
-void ShadowableScene::render()
-{
-   // update light positions and properties
-   updateLights();
-
-   // iterate through the normal list and display the geomerty
-   renderModelList(normalList);
-
-   // iterate  through the receiver list and display the geometry
-   renderModelList(shadowReceiverList);
-
-   // iterate  through the caster list and display the geometry
-   renderModelList(shadowCasterList);
-
-   // Draw the shadows
-   if (drawShadowsFlag) drawShadows();
-}
-
-//-----------------------------------------------------------------------------
-/**
-  Render the model list to the screen
-*/
-void ShadowableScene::renderModelList(const vector<Model3D*> &modelList)
-{
-   Model3D *aModel;
-   for (int index = 0; index < modelList.size(); index++)
-   {
-      aModel = modelList[index];
-      glPushMatrix();
-
-      // Position the model
-      Vector3D position(aModel->getPosition());
-      glTranslatef(position.x, position.y, position.z);
-      
-      // Orient the model
-      FTM rotations(aModel->getFTM());
-      float tempMatrix[] = 
-      { 
-         rotations._00,rotations._01,rotations._02,rotations._03,
-         rotations._10,rotations._11,rotations._12,rotations._13,
-         rotations._20,rotations._21,rotations._22,rotations._23,
-         rotations._30,rotations._31,rotations._32,rotations._33,
-      };
-      glMultMatrixf(tempMatrix);
-
-      if (!aModel->isLit())
-      {
-         // Set the color (for non lit scenes)
-         glColor3f(aModel->getRed(),aModel->getGreen(),aModel->getBlue());
-         glDisable(GL_LIGHTING);
-      }
-      else
-      {
-         // Set the material props (for lit scenes)
-         Material tempMaterial = aModel->getMaterial();
-         float matSpecular[] = {tempMaterial.specularRed, tempMaterial.specularGreen, tempMaterial.specularBlue, tempMaterial.specularAlpha};
-         glMaterialfv(GL_FRONT, GL_SPECULAR, matSpecular);
-         float matShininess[] = {tempMaterial.shininess};
-         glMaterialfv(GL_FRONT, GL_SHININESS, matShininess);
-         float matAmbDiff[] = { tempMaterial.ambientDiffuseRed, tempMaterial.ambientDiffuseGreen, tempMaterial.ambientDiffuseBlue, tempMaterial.ambientDiffuseAlpha };         
-         glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, matAmbDiff);
-         glEnable(GL_LIGHTING);
-      }
-
-      // draw the model
-      glCallList(aModel->getCallListId());
-      
-      glPopMatrix();
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Add a point light source to the scene.
-
-  @param x The x position of the light
-  @param y The y position of the light
-  @param z The z position of the light
-*/
-void ShadowableScene::addPointLightSource(float x, float y, float z)
-{
-   if (pointLightList.size() == MAX_LIGHTS)
-      return;
-   
-   /// \todo determine how to do this for multiple sources
-   float lightAmbient[] = { 0.3, 0.3, 0.3, 1.0};
-   glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmbient);
-   float lightDiffuse[] = { 0.7, 0.5, 0.5, 1.0};
-   glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
-
-   // add the light to our list of lights
-   Vector3D *tempVector = new Vector3D(x,y,z);
-   pointLightList.push_back(*tempVector);
-   delete tempVector;
-
-   /// \todo determine how to do this for multiple sources
-   glEnable(GL_LIGHT0);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Add a point directional light source to the scene.
-
-  @param x The x component of the dircetion vector
-  @param y The y component of the dircetion vector
-  @param z The z component of the dircetion vector
-*/
-void ShadowableScene::addDirectionalLightSource(float x, float y, float z)
-{
-
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Goto through all the light lists and set the light properties.
-*/
-void ShadowableScene::updateLights()
-{
-   /// \todo determine how to update an entire scene of lights
-   for (int lightIndex=0; lightIndex<pointLightList.size(); lightIndex++)
-   {
-      Vector3D tempPosition = pointLightList[lightIndex];
-      float pos[] = {tempPosition.x, tempPosition.y, tempPosition.z, 1.0};
-      glLightfv(GL_LIGHT0, GL_POSITION, pos);
-
-      // this draws a small yellow sphere at the light source
-      if (drawLightsFlag)
-      {
-         glPushMatrix();
-         glPushAttrib(GL_ALL_ATTRIB_BITS);
-         glColor3f(1.0,1.0,0.0);
-         glLineWidth(2.0);
-         glDisable(GL_LIGHTING);
-         glBegin(GL_LINES);
-           glVertex3f(tempPosition.x, tempPosition.y, tempPosition.z);
-           glVertex3f(tempPosition.x, 0.0, tempPosition.z);
-         glEnd();
-         glTranslatef(tempPosition.x, tempPosition.y, tempPosition.z);
-         glColor4f(1.0,1.0,0.0,0.75);
-         glutSolidSphere (1.0, 20, 16);
-         glPopAttrib();
-         glPopMatrix();
-      }
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Routine that draws the models in the caster list onto the receiver list
-   using a shadow projection algorithm.  Pure virtual and must be overridden
-   in derrived classes.
-*/
-void ShadowableScene::drawShadows() {}
+#include <algorithm>
+#include <GL/glut.h>
+#include <iostream>
+#include <math.h>
+#include "ShadowableScene.h"
+#include "Model3D.h"
+#include "Camera.h"
+#include "ProjectileSystem.h"
+#include "JobSystem.h"
+#include "SceneSnapshot.h"
+#include "EdgeMesh.h"
+#include "ConvexHull.h"
+
+using std::string;
+using std::vector;
+using std::map;
+using std::cout;
+using std::endl;
+
+namespace SML_CORE
+{
+// static constants defined, MAX_LIGHTS is the openGL lights the shadowed
+// point lights take (the directional lights take the ones after)
+const int ShadowableScene::MAX_LIGHTS = 4;
+const int ShadowableScene::MAX_POINT_LIGHTS = 1024;
+const int ShadowableScene::MAX_DIRECTIONAL_LIGHTS = 1;
+
+// the spatial index flags for each ModelShadowMode
+static const unsigned int ALL_MODES_MASK = 0xffffffff;
+static unsigned int getModeMask(int mode) {return 1 << mode;}
+
+// a caster's shadow proxy is its convex hull cut down to this many
+// vertices, it is only used if the points left out stay within a part of
+// the mesh's size and the mesh fills enough of the hull (it isn't too
+// concave)
+static const int SHADOW_PROXY_VERTICES = 32;
+static const float SHADOW_PROXY_MAX_ERROR = 0.02;
+static const float SHADOW_PROXY_MIN_FILL = 0.75;
+
+// the fewest items worth giving to a thread
+static const int DEPTH_GRAIN_SIZE = 256;
+static const int CULL_GRAIN_SIZE = 4096;
+
+// how many of the most significant lights in each cluster are shadowed
+static const int DEFAULT_SHADOW_LIGHTS_PER_CLUSTER = 1;
+
+// the first shadowed light also lights the whole scene a little
+static const float LIGHT_AMBIENT = 0.3;
+
+//-----------------------------------------------------------------------------
+/**
+      Constructor
+  */
+ShadowableScene::ShadowableScene() :
+drawLightsFlag(false),
+drawShadowsFlag(true),
+modelRegistry(NUM_SHADOW_MODES),
+shadowCasterList(modelRegistry.getModels(CASTS_SHADOWS)),
+shadowReceiverList(modelRegistry.getModels(RECEIVES_SHADOWS)),
+normalList(modelRegistry.getModels(NONE)),
+pointLightList(0),
+shadowLightsPerCluster(DEFAULT_SHADOW_LIGHTS_PER_CLUSTER),
+sceneCamera(0),
+objectsTested(0),
+objectsRejected(0),
+castersTested(0),
+castersRejected(0),
+shadowPairsTested(0),
+shadowPairsRejected(0),
+projectiles(0),
+projectilesDrawn(0),
+jobs(0),
+interpolation(1.0),
+snapshot(0),
+snapshotIsNew(false),
+modelsRemoved(0)
+{
+   projectileFrame.count = 0;
+
+   // the default light level
+   float lmodelAmbient[] = { 0.4, 0.4, 0.4, 1.0 };
+   glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lmodelAmbient);
+   renderState.setLighting(true);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+ShadowableScene::~ShadowableScene()
+{
+   // give the models their data back, they can outlive the scene
+   for (int index = sceneStore.getSize() - 1; index >= 0; index--)
+      sceneStore.getModelAt(index)->detach();
+
+   map<int, EdgeMesh*>::iterator mesh;
+   for (mesh = edgeMeshes.begin(); mesh != edgeMeshes.end(); ++mesh)
+      delete mesh->second;
+   map<int, ConvexHull*>::iterator proxy;
+   for (proxy = shadowProxies.begin(); proxy != shadowProxies.end(); ++proxy)
+      delete proxy->second;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a model to the scene.  The scene doesn't own the model, it must stay
+   alive until it is removed.
+
+  @param model The model to add
+  @param mode The ModelShadowMode of the model
+  @return The handle used to find or remove the model later
+  */
+ModelHandle ShadowableScene::addModel(Model3D* model, int mode)
+{
+   if (mode < 0 || mode >= NUM_SHADOW_MODES)
+   {
+      cout << "ERROR: unknown shadow mode " << mode << " for model " << model->getName() << endl;
+      return ModelHandle();
+   }
+
+   ModelHandle handle = modelRegistry.add(model, mode);
+   model->attach(&sceneStore);
+   insertIntoSpatialIndex(model, mode);
+
+   // casters get their shadow proxy while the scene is loading
+   if (mode == CASTS_SHADOWS)
+      findShadowProxy(model);
+   return handle;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Put an attached model in the spatial index
+  */
+void ShadowableScene::insertIntoSpatialIndex(Model3D* model, int mode)
+{
+   const float *sphere = sceneStore.getWorldSphereAt(sceneStore.getIndex(model->getStoreId()));
+   int id = spatialIndex.insert(model, getModeMask(mode), sphere[0], sphere[1], sphere[2], sphere[3]);
+   sceneStore.setSpatialId(model->getStoreId(), id);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Rebuild the world transforms of the models that changed since the last
+   frame and move them in the spatial index.  Only the models that left the
+   loose bounds of their octree node are relinked, the rest just get their
+   new bounding sphere.
+  */
+void ShadowableScene::updateSpatialIndex()
+{
+   if (snapshot)
+   {
+      sceneStore.updateTransforms(*snapshot, interpolation, snapshotIsNew, jobs);
+      snapshotIsNew = false;
+   }
+   else
+   {
+      sceneStore.updateTransforms(jobs);
+   }
+
+   int numModels = sceneStore.getSize();
+   for (int index = 0; index < numModels; index++)
+   {
+      if (!sceneStore.hasMovedAt(index))
+         continue;
+      const float *sphere = sceneStore.getWorldSphereAt(index);
+      spatialIndex.update(sceneStore.getSpatialIdAt(index), sphere[0], sphere[1], sphere[2], sphere[3]);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Change the region covered by the spatial index, every model is put back
+   into the new index.
+
+  @param center The center of the indexed region
+  @param halfSize Half the width of the indexed region
+  @param maxDepth The deepest level of the octree
+  */
+void ShadowableScene::setWorldBounds(Vector3D center, float halfSize, int maxDepth)
+{
+   spatialIndex.reset(center, halfSize, maxDepth);
+   int index;
+   for (index = 0; index < normalList.size(); index++)
+      insertIntoSpatialIndex(normalList[index], NONE);
+   for (index = 0; index < shadowReceiverList.size(); index++)
+      insertIntoSpatialIndex(shadowReceiverList[index], RECEIVES_SHADOWS);
+   for (index = 0; index < shadowCasterList.size(); index++)
+      insertIntoSpatialIndex(shadowCasterList[index], CASTS_SHADOWS);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the models whose bounds overlap a sphere
+
+  @param center The center of the sphere
+  @param radius The radius of the sphere
+  @param results The models found are added to this list
+  */
+void ShadowableScene::findModelsInSphere(Vector3D center, float radius, vector<Model3D*> &results)
+{
+   spatialIndex.querySphere(center, radius, ALL_MODES_MASK, results);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the models whose bounds are hit by a ray
+
+  @param origin Where the ray starts
+  @param direction The unit length direction of the ray
+  @param maxDistance How far along the ray to look
+  @param results The models found are added to this list
+  */
+void ShadowableScene::findModelsAlongRay(Vector3D origin, Vector3D direction, float maxDistance, vector<Model3D*> &results)
+{
+   spatialIndex.queryRay(origin, direction, maxDistance, ALL_MODES_MASK, results);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Remove a model from the scene
+
+  @param handle The handle returned when the model was added
+  @return The model removed (so the caller can delete it), 0 if the handle
+          is stale
+  */
+Model3D* ShadowableScene::removeModel(ModelHandle handle)
+{
+   Model3D *aModel = modelRegistry.remove(handle);
+   if (aModel)
+   {
+      spatialIndex.remove(sceneStore.getSpatialId(aModel->getStoreId()));
+      shadowScheduler.forget(aModel->getStoreId());
+      aModel->detach();
+      modelsRemoved++;
+   }
+   return aModel;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Render the scene
+*/
+void ShadowableScene::render()
+{
+   // count the state changes made (and avoided) this frame, and the culling
+   renderState.resetFrameCounters();
+   objectsTested = 0;
+   objectsRejected = 0;
+   castersTested = 0;
+   castersRejected = 0;
+   shadowPairsTested = 0;
+   shadowPairsRejected = 0;
+   projectilesDrawn = 0;
+
+   // everything allocated from the frame arena last frame is done with
+   frameArena.reset();
+   findProjectileFrame();
+
+   // the camera has been applied, keep its matrix for the lights' clusters
+   // and the depth sort and its frustum for culling
+   glGetFloatv(GL_MODELVIEW_MATRIX, viewMatrix);
+
+   // pick the lights that are shadowed, then update light positions and
+   // properties
+   assignLights();
+   updateLights();
+
+   if (sceneCamera)
+      viewFrustum = sceneCamera->getFrustum();
+   else
+      viewFrustum.extractFromOpenGL();
+
+   // bring the spatial index up to date with the models that moved
+   updateSpatialIndex();
+
+   // queue the normal, receiver and caster geometry that can be seen
+   visibleModels.clear();
+   spatialIndex.queryFrustum(viewFrustum, ALL_MODES_MASK, visibleModels);
+   objectsTested += spatialIndex.getLastTestCount();
+   objectsRejected += spatialIndex.getNumObjects() - visibleModels.size();
+
+   // find the depths on every thread, then fill the queue on this one
+   visibleDepths.resize(visibleModels.size());
+   if (jobs)
+      jobs->parallelFor(viewDepthJob, this, visibleModels.size(), DEPTH_GRAIN_SIZE);
+   else
+      viewDepthJob(this, 0, visibleModels.size());
+
+   renderQueue.clear();
+   for (int index = 0; index < visibleModels.size(); index++)
+   {
+      int storeIndex = sceneStore.getIndex(visibleModels[index]->getStoreId());
+      renderQueue.addModel(visibleModels[index], sceneStore.isLitAt(storeIndex),
+         sceneStore.getTextureIdAt(storeIndex), sceneStore.getMaterialIdAt(storeIndex),
+         visibleDepths[index]);
+   }
+
+   // sort the draws by state and depth, then display the geometry
+   renderQueue.sort();
+   beginLightingPass();
+   for (int index = 0; index < renderQueue.getSize(); index++)
+      drawModel(renderQueue.getModel(index));
+   endLightingPass();
+   drawProjectiles();
+
+   // Draw the shadows, the scheduler sizes the casters with the camera's
+   // view and projection
+   if (drawShadowsFlag)
+   {
+      float projection[16];
+      int viewport[4];
+      glGetFloatv(GL_PROJECTION_MATRIX, projection);
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      shadowScheduler.beginFrame(viewMatrix, projection[5] * viewport[3] * 0.5);
+      drawShadows();
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Start a simulation tick, the models' positions now are where the frames
+  drawn during the tick are interpolated from
+*/
+void ShadowableScene::beginTick()
+{
+   sceneStore.beginTick();
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Set how far between the last two simulation ticks the next frame is drawn
+
+  @param alpha 0 for the tick before last, 1 for the last tick
+*/
+void ShadowableScene::setInterpolation(float alpha)
+{
+   interpolation = alpha;
+   if (!snapshot)
+      sceneStore.setInterpolation(alpha);
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Copy the moving parts of the scene for the render thread.  Call this on
+  the simulation thread between ticks.
+
+  @param target The snapshot to fill in
+*/
+void ShadowableScene::captureSnapshot(SceneSnapshot &target) const
+{
+   target.capture(sceneStore, projectiles);
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Draw the scene from a snapshot of the simulation instead of from the
+  models themselves, so the simulation can run on another thread while the
+  scene is drawn.  The snapshot must stay unchanged until the next call.
+
+  @param source The snapshot to draw (0 to draw from the models again)
+  @param isNew true if the snapshot changed since the last frame
+*/
+void ShadowableScene::setSnapshot(const SceneSnapshot *source, bool isNew)
+{
+   if (source != snapshot)
+      isNew = true;
+   snapshot = source;
+   snapshotIsNew = snapshotIsNew || isNew;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Find the projectile arrays to draw from this frame
+*/
+void ShadowableScene::findProjectileFrame()
+{
+   projectileFrame.count = 0;
+   if (!projectiles)
+      return;
+
+   if (snapshot)
+   {
+      projectileFrame.count = snapshot->numProjectiles;
+      if (projectileFrame.count == 0)
+         return;
+      projectileFrame.x = &snapshot->projectileX[0];
+      projectileFrame.y = &snapshot->projectileY[0];
+      projectileFrame.z = &snapshot->projectileZ[0];
+      projectileFrame.previousX = &snapshot->previousX[0];
+      projectileFrame.previousY = &snapshot->previousY[0];
+      projectileFrame.previousZ = &snapshot->previousZ[0];
+      projectileFrame.radii = &snapshot->projectileRadii[0];
+      return;
+   }
+
+   projectileFrame.count = projectiles->getNumActive();
+   projectileFrame.x = projectiles->getPositionsX();
+   projectileFrame.y = projectiles->getPositionsY();
+   projectileFrame.z = projectiles->getPositionsZ();
+   projectileFrame.previousX = projectiles->getPreviousPositionsX();
+   projectileFrame.previousY = projectiles->getPreviousPositionsY();
+   projectileFrame.previousZ = projectiles->getPreviousPositionsZ();
+   projectileFrame.radii = projectiles->getRadii();
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Find the edge mesh of a model, it is built the first time its display list
+  is seen (models that share a display list share the mesh)
+
+  @param aModel The model
+  @return The mesh, empty if the model has no mesh data
+*/
+EdgeMesh* ShadowableScene::findEdgeMesh(Model3D *aModel)
+{
+   int meshId = sceneStore.getMeshIdAt(sceneStore.getIndex(aModel->getStoreId()));
+   map<int, EdgeMesh*>::iterator found = edgeMeshes.find(meshId);
+   if (found != edgeMeshes.end())
+      return found->second;
+
+   EdgeMesh *mesh = new EdgeMesh();
+   mesh->build(aModel);
+   edgeMeshes[meshId] = mesh;
+   return mesh;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Find the convex hull standing in for a caster's mesh when its shadow is
+  drawn.  The hull is made once for each mesh (from its edge mesh, so it
+  matches the display list) and kept if it is close to the mesh: the points
+  its vertex budget left out are near it and the mesh fills most of it.
+
+  @param aModel The caster
+  @return The hull, 0 if the model opted out or its mesh has no close hull
+*/
+ConvexHull* ShadowableScene::findShadowProxy(Model3D *aModel)
+{
+   if (!aModel->isShadowProxyAllowed())
+      return 0;
+
+   int meshId = sceneStore.getMeshIdAt(sceneStore.getIndex(aModel->getStoreId()));
+   map<int, ConvexHull*>::iterator found = shadowProxies.find(meshId);
+   if (found != shadowProxies.end())
+      return found->second;
+
+   EdgeMesh *mesh = findEdgeMesh(aModel);
+   ConvexHull *hull = new ConvexHull();
+   BoundingVolume bounds = aModel->getBounds();
+   float extent[3] =
+   {
+      bounds.maximum.x - bounds.minimum.x,
+      bounds.maximum.y - bounds.minimum.y,
+      bounds.maximum.z - bounds.minimum.z
+   };
+   float size = (float)sqrt(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]) * 0.5;
+   if (!mesh->isClosed() ||
+       !hull->build(mesh->getVertices(), mesh->getNumVertices(), SHADOW_PROXY_VERTICES) ||
+       hull->getError() > size * SHADOW_PROXY_MAX_ERROR ||
+       mesh->getVolume() < hull->getVolume() * SHADOW_PROXY_MIN_FILL)
+   {
+      delete hull;
+      hull = 0;
+   }
+   shadowProxies[meshId] = hull;
+   return hull;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Add casters whose shadows may be drawn this frame to the shadow
+  scheduler, call ShadowScheduler::selectUpdates after the last
+
+  @param casters The casters
+*/
+void ShadowableScene::scheduleShadows(const vector<Model3D*> &casters)
+{
+   for (int index = 0; index < casters.size(); index++)
+   {
+      int storeId = casters[index]->getStoreId();
+      shadowScheduler.addCandidate(storeId, sceneStore.getWorldSphereAt(sceneStore.getIndex(storeId)));
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Move a point from the world into a model's space.  The model's world
+  matrix is a rotation and a translation, its inverse is the transpose of
+  the rotation.
+
+  @param storeIndex The model's index in the scene store
+  @param point The point in the world
+  @param modelPoint Set to the point in model space (3 floats)
+*/
+void ShadowableScene::toModelSpace(int storeIndex, const Vector3D &point, float *modelPoint) const
+{
+   const float *world = sceneStore.getWorldMatrixAt(storeIndex);
+   float offset[3] = {point.x - world[12], point.y - world[13], point.z - world[14]};
+   for (int axis = 0; axis < 3; axis++)
+      modelPoint[axis] = world[axis * 4] * offset[0] + world[axis * 4 + 1] * offset[1] + world[axis * 4 + 2] * offset[2];
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Find the part of the screen a set of points covers, a pixel wider all
+  round and kept on the screen.  The points are put through the camera's
+  view (as it was when the frame started) and the projection given.
+
+  @param projection The camera's projection
+  @param viewport The viewport (x, y, width and height)
+  @param points The points in the world, 3 floats each
+  @param rectangle Set to the x, y, width and height of the part in pixels
+  @return false if a point is behind the camera, the part can't be found
+*/
+bool ShadowableScene::findScreenRectangle(const float *projection, const int *viewport,
+                                          const vector<float> &points, int *rectangle) const
+{
+   float minX = viewport[0] + viewport[2];
+   float minY = viewport[1] + viewport[3];
+   float maxX = viewport[0];
+   float maxY = viewport[1];
+   for (int index = 0; index < points.size(); index += 3)
+   {
+      const float *point = &points[index];
+      float eye[4];
+      int row;
+      for (row = 0; row < 4; row++)
+      {
+         eye[row] = viewMatrix[row] * point[0] + viewMatrix[4 + row] * point[1] +
+            viewMatrix[8 + row] * point[2] + viewMatrix[12 + row];
+      }
+      float clip[4];
+      for (row = 0; row < 4; row++)
+      {
+         clip[row] = projection[row] * eye[0] + projection[4 + row] * eye[1] +
+            projection[8 + row] * eye[2] + projection[12 + row] * eye[3];
+      }
+      if (clip[3] <= 0.0)
+         return false;
+
+      float x = viewport[0] + (clip[0] / clip[3] + 1.0) * 0.5 * viewport[2];
+      float y = viewport[1] + (clip[1] / clip[3] + 1.0) * 0.5 * viewport[3];
+      if (x < minX) minX = x;
+      if (y < minY) minY = y;
+      if (x > maxX) maxX = x;
+      if (y > maxY) maxY = y;
+   }
+
+   if (minX < viewport[0] + 1) minX = viewport[0] + 1;
+   if (minY < viewport[1] + 1) minY = viewport[1] + 1;
+   if (maxX > viewport[0] + viewport[2] - 1) maxX = viewport[0] + viewport[2] - 1;
+   if (maxY > viewport[1] + viewport[3] - 1) maxY = viewport[1] + viewport[3] - 1;
+   rectangle[0] = (int)minX - 1;
+   rectangle[1] = (int)minY - 1;
+   rectangle[2] = maxX > minX ? (int)maxX - rectangle[0] + 1 : 0;
+   rectangle[3] = maxY > minY ? (int)maxY - rectangle[1] + 1 : 0;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Find the shadow casters whose shadows from a point light may be seen
+
+  @param lightPosition The position of the light
+  @param visibleList The casters found are added to this list
+*/
+void ShadowableScene::findVisibleCasters(const Vector3D &lightPosition, vector<Model3D*> &visibleList)
+{
+   findCasters(viewFrustum.getCasterFrustum(lightPosition), visibleList);
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Find the shadow casters whose bounds overlap a volume
+
+  @param volume The volume to search (a light's view)
+  @param casterList The casters found are added to this list
+*/
+void ShadowableScene::findCasters(const Frustum &volume, vector<Model3D*> &casterList)
+{
+   int numFound = casterList.size();
+   spatialIndex.queryFrustum(volume, getModeMask(CASTS_SHADOWS), casterList);
+   numFound = casterList.size() - numFound;
+   castersTested += spatialIndex.getLastTestCount();
+   castersRejected += shadowCasterList.size() - numFound;
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Find how far in front of the camera a model is
+
+  @param storeIndex The index of the model in the scene store
+  @return The view space depth of the model's origin
+*/
+float ShadowableScene::getViewDepth(int storeIndex)
+{
+   // the model origin in the world is the translation of its world matrix
+   const float *world = sceneStore.getWorldMatrixAt(storeIndex);
+   float x = world[12];
+   float y = world[13];
+   float z = world[14];
+
+   // the camera looks down -z
+   return -(viewMatrix[2] * x + viewMatrix[6] * y + viewMatrix[10] * z + viewMatrix[14]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+  A job that finds the view depth of a range of the visible models
+  (data is the scene)
+*/
+void ShadowableScene::viewDepthJob(void *data, int begin, int end)
+{
+   ShadowableScene *scene = (ShadowableScene*)data;
+   for (int index = begin; index < end; index++)
+   {
+      int storeIndex = scene->sceneStore.getIndex(scene->visibleModels[index]->getStoreId());
+      scene->visibleDepths[index] = scene->getViewDepth(storeIndex);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+  A job that finds where a range of the projectiles are drawn this frame
+  and tests them against the view frustum (data is the scene)
+*/
+void ShadowableScene::cullProjectilesJob(void *data, int begin, int end)
+{
+   ShadowableScene *scene = (ShadowableScene*)data;
+   const ProjectileFrame &frame = scene->projectileFrame;
+   float alpha = scene->interpolation;
+   float *x = &scene->projectileRenderX[0];
+   float *y = &scene->projectileRenderY[0];
+   float *z = &scene->projectileRenderZ[0];
+   for (int index = begin; index < end; index++)
+   {
+      x[index] = frame.previousX[index] + (frame.x[index] - frame.previousX[index]) * alpha;
+      y[index] = frame.previousY[index] + (frame.y[index] - frame.previousY[index]) * alpha;
+      z[index] = frame.previousZ[index] + (frame.z[index] - frame.previousZ[index]) * alpha;
+   }
+   scene->viewFrustum.cullSpheres(x + begin, y + begin, z + begin, frame.radii + begin, end - begin,
+      &scene->projectileVisible[begin]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Render a model to the screen
+*/
+void ShadowableScene::drawModel(Model3D *aModel)
+{
+   int storeIndex = sceneStore.getIndex(aModel->getStoreId());
+
+   // Position and orient the model
+   glPushMatrix();
+   glMultMatrixf(sceneStore.getWorldMatrixAt(storeIndex));
+
+   if (!sceneStore.isLitAt(storeIndex))
+   {
+      // Set the color (for non lit scenes)
+      const float *color = sceneStore.getColorAt(storeIndex);
+      renderState.setColor(color[0], color[1], color[2]);
+      renderState.setLighting(false);
+   }
+   else
+   {
+      // Set the material props (for lit scenes)
+      renderState.setMaterial(sceneStore.getSharedMaterial(sceneStore.getMaterialIdAt(storeIndex)));
+      renderState.setLighting(true);
+   }
+
+   // bind the model's texture (or turn texturing off)
+   renderState.setTexture(sceneStore.getTextureIdAt(storeIndex));
+   setModelShading(sceneStore.isLitAt(storeIndex), sceneStore.getTextureIdAt(storeIndex) != 0);
+
+   // draw the model
+   glCallList(sceneStore.getMeshIdAt(storeIndex));
+   
+   glPopMatrix();
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Render the projectiles that can be seen.  They are culled in one batch
+  straight from the projectile position arrays and drawn as glowing camera
+  facing billboards in one draw.
+*/
+void ShadowableScene::drawProjectiles()
+{
+   if (projectileFrame.count == 0)
+      return;
+
+   int numActive = projectileFrame.count;
+   if (projectileVisible.size() < numActive)
+   {
+      projectileVisible.resize(projectiles->getCapacity());
+      projectileRenderX.resize(projectiles->getCapacity());
+      projectileRenderY.resize(projectiles->getCapacity());
+      projectileRenderZ.resize(projectiles->getCapacity());
+   }
+   if (jobs)
+      jobs->parallelFor(cullProjectilesJob, this, numActive, CULL_GRAIN_SIZE);
+   else
+      cullProjectilesJob(this, 0, numActive);
+
+   // add the fireballs onto the scene, they don't hide each other
+   renderState.setLighting(false);
+   renderState.setTexture(projectiles->getTextureId());
+   renderState.setColor(1.0, 1.0, 1.0);
+   renderState.setBlend(true);
+   renderState.setBlendFunc(GL_ONE, GL_ONE);
+   glDepthMask(GL_FALSE);
+
+   projectilesDrawn += projectileRenderer.drawBillboards(&projectileRenderX[0],
+      &projectileRenderY[0], &projectileRenderZ[0], projectileFrame.radii,
+      &projectileVisible[0], numActive, viewMatrix);
+
+   glDepthMask(GL_TRUE);
+   renderState.setBlend(false);
+}
+
+//-----------------------------------------------------------------------------
+/**
+  Render a blob shadow for every projectile onto a receiver plane.  Called
+  by the shadow pass of the specializing classes with the shadow color
+  already set.
+
+  @param plane The receiver plane (a,b,c,d)
+  @param lightPosition The light throwing the shadows
+*/
+void ShadowableScene::drawProjectileShadows(const float *plane, const Vector3D &lightPosition)
+{
+   if (projectileFrame.count == 0)
+      return;
+
+   renderState.setTexture(projectileRenderer.getBlobTexture(renderState));
+   renderState.setBlend(true);
+   renderState.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+   projectileRenderer.drawBlobShadows(&projectileRenderX[0], &projectileRenderY[0],
+      &projectileRenderZ[0], projectileFrame.radii, projectileFrame.count,
+      plane, lightPosition);
+
+   renderState.setBlend(false);
+   renderState.setTexture(0);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a point light source to the scene.
+
+  @param x The x position of the light
+  @param y The y position of the light
+  @param z The z position of the light
+  @param radius How far the light reaches
+  @param red The red of the light's color
+  @param green The green of the light's color
+  @param blue The blue of the light's color
+*/
+void ShadowableScene::addPointLightSource(float x, float y, float z, float radius,
+                                          float red, float green, float blue)
+{
+   if (pointLightX.size() == MAX_POINT_LIGHTS)
+   {
+      cout << "ERROR: a scene can have " << MAX_POINT_LIGHTS << " point lights" << endl;
+      return;
+   }
+   if (radius <= 0.0)
+   {
+      cout << "ERROR: a point light needs a radius" << endl;
+      return;
+   }
+
+   // add the light to our list of lights, it is given an openGL light
+   // when it is shadowed
+   pointLightX.push_back(x);
+   pointLightY.push_back(y);
+   pointLightZ.push_back(z);
+   pointLightRadii.push_back(radius);
+   pointLightColors.push_back(red);
+   pointLightColors.push_back(green);
+   pointLightColors.push_back(blue);
+   pointLightIntensities.push_back(red + green + blue);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Set how many of the most significant lights in each cluster are
+   shadowed, no more than MAX_LIGHTS are shadowed in all
+
+  @param count The lights for each cluster (at least 1)
+*/
+void ShadowableScene::setShadowLightsPerCluster(int count)
+{
+   if (count < 1)
+   {
+      cout << "ERROR: at least one light in each cluster is shadowed, not " << count << endl;
+      return;
+   }
+   shadowLightsPerCluster = count;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Sort the point lights into the view's clusters and pick the ones that are
+   shadowed this frame, the most significant in the clusters.  With no more
+   lights than there are openGL lights for them every light is shadowed.
+   A light that stays shadowed keeps its openGL light, when the shadowed
+   lights change the shadows built for the old ones are dropped.  A slot no
+   new light fills stays in the point light list with its openGL light
+   off, so the lights after it keep their places.
+*/
+void ShadowableScene::assignLights()
+{
+   int numLights = pointLightX.size();
+   significantLights.clear();
+   int index;
+   if (numLights <= MAX_LIGHTS)
+   {
+      for (index = 0; index < numLights; index++)
+         significantLights.push_back(index);
+   }
+   else
+   {
+      float projection[16];
+      glGetFloatv(GL_PROJECTION_MATRIX, projection);
+      lightClusters.build(viewMatrix, projection, &pointLightX[0], &pointLightY[0], &pointLightZ[0],
+         &pointLightRadii[0], numLights, jobs);
+      lightClusters.findSignificantLights(shadowLightsPerCluster, &pointLightIntensities[0], significantLights);
+      if (significantLights.size() > MAX_LIGHTS)
+         significantLights.resize(MAX_LIGHTS);
+   }
+
+   // the lights that are no longer shadowed leave gaps the new ones fill,
+   // only the empty slots at the end are let go
+   lightSlots = shadowLightIndices;
+   for (index = 0; index < lightSlots.size(); index++)
+   {
+      if (std::find(significantLights.begin(), significantLights.end(), lightSlots[index]) == significantLights.end())
+         lightSlots[index] = -1;
+   }
+   for (index = 0; index < significantLights.size(); index++)
+   {
+      int light = significantLights[index];
+      if (std::find(lightSlots.begin(), lightSlots.end(), light) != lightSlots.end())
+         continue;
+      vector<int>::iterator gap = std::find(lightSlots.begin(), lightSlots.end(), -1);
+      if (gap != lightSlots.end())
+         *gap = light;
+      else
+         lightSlots.push_back(light);
+   }
+   while (!lightSlots.empty() && lightSlots.back() == -1)
+      lightSlots.pop_back();
+   if (lightSlots == shadowLightIndices)
+      return;
+
+   // only the slots given another light, or emptied, lose the shadows built
+   // from them
+   int numSlots = lightSlots.size() > shadowLightIndices.size() ? lightSlots.size() : shadowLightIndices.size();
+   for (index = 0; index < numSlots; index++)
+   {
+      if (index >= lightSlots.size() || index >= shadowLightIndices.size() ||
+          lightSlots[index] != shadowLightIndices[index])
+         shadowScheduler.forgetShadows(index);
+   }
+   shadowLightIndices = lightSlots;
+   pointLightList.clear();
+   for (index = 0; index < MAX_LIGHTS; index++)
+   {
+      GLenum light = GL_LIGHT0 + index;
+      if (index >= shadowLightIndices.size())
+      {
+         glDisable(light);
+         continue;
+      }
+
+      // an empty slot adds no light, the shaders that read every light
+      // see it black.  The first light still carries the scene's ambient.
+      int pointLight = shadowLightIndices[index];
+      float ambient = index == 0 ? LIGHT_AMBIENT : 0.0;
+      float lightAmbient[] = { ambient, ambient, ambient, 1.0};
+      glLightfv(light, GL_AMBIENT, lightAmbient);
+      float lightDiffuse[] = { 0.0, 0.0, 0.0, 1.0};
+      float lightSpecular[] = { 0.0, 0.0, 0.0, 1.0};
+      if (pointLight == -1)
+      {
+         pointLightList.push_back(Vector3D(0.0, 0.0, 0.0));
+      }
+      else
+      {
+         pointLightList.push_back(Vector3D(pointLightX[pointLight], pointLightY[pointLight], pointLightZ[pointLight]));
+         const float *color = &pointLightColors[pointLight * 3];
+         lightDiffuse[0] = color[0];
+         lightDiffuse[1] = color[1];
+         lightDiffuse[2] = color[2];
+         lightSpecular[0] = lightSpecular[1] = lightSpecular[2] = 1.0;
+      }
+      glLightfv(light, GL_DIFFUSE, lightDiffuse);
+      glLightfv(light, GL_SPECULAR, lightSpecular);
+      if (pointLight != -1 || ambient > 0.0)
+         glEnable(light);
+      else
+         glDisable(light);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Count the point lights shadowed this frame, the empty slots in the point
+   light list left out
+
+  @return The shadowed lights
+*/
+int ShadowableScene::getNumShadowedLights() const
+{
+   int count = 0;
+   for (int index = 0; index < shadowLightIndices.size(); index++)
+   {
+      if (shadowLightIndices[index] != -1)
+         count++;
+   }
+   return count;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add a directional light source (the sun) to the scene.  Directional
+   lights take the openGL lights after the point lights'.
+
+  @param x The x component of the dircetion vector
+  @param y The y component of the dircetion vector
+  @param z The z component of the dircetion vector
+*/
+void ShadowableScene::addDirectionalLightSource(float x, float y, float z)
+{
+   if (directionalLightList.size() == MAX_DIRECTIONAL_LIGHTS)
+      return;
+   float length = (float)sqrt(x * x + y * y + z * z);
+   if (length == 0.0)
+   {
+      cout << "ERROR: a directional light needs a direction" << endl;
+      return;
+   }
+
+   GLenum light = GL_LIGHT0 + MAX_LIGHTS + directionalLightList.size();
+   float lightAmbient[] = { 0.2, 0.2, 0.2, 1.0};
+   glLightfv(light, GL_AMBIENT, lightAmbient);
+   float lightDiffuse[] = { 0.7, 0.7, 0.6, 1.0};
+   glLightfv(light, GL_DIFFUSE, lightDiffuse);
+
+   // the direction the light shines in
+   directionalLightList.push_back(Vector3D(x / length, y / length, z / length));
+   glEnable(light);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Goto through all the light lists and set the light properties.
+*/
+void ShadowableScene::updateLights()
+{
+   int lightIndex;
+   for (lightIndex=0; lightIndex<pointLightList.size(); lightIndex++)
+   {
+      if (isEmptyLightSlot(lightIndex))
+         continue;
+      Vector3D tempPosition = pointLightList[lightIndex];
+      float pos[] = {tempPosition.x, tempPosition.y, tempPosition.z, 1.0};
+      glLightfv(GL_LIGHT0 + lightIndex, GL_POSITION, pos);
+
+      // this draws a small yellow sphere at the light source
+      if (drawLightsFlag)
+      {
+         glPushMatrix();
+         renderState.setColor(1.0,1.0,0.0);
+         renderState.setLighting(false);
+         renderState.setTexture(0);
+         glLineWidth(2.0);
+         glBegin(GL_LINES);
+           glVertex3f(tempPosition.x, tempPosition.y, tempPosition.z);
+           glVertex3f(tempPosition.x, 0.0, tempPosition.z);
+         glEnd();
+         glLineWidth(1.0);
+         glTranslatef(tempPosition.x, tempPosition.y, tempPosition.z);
+         renderState.setColor(1.0,1.0,0.0,0.75);
+         glutSolidSphere (1.0, 20, 16);
+         glPopMatrix();
+      }
+   }
+
+   // openGL wants the direction towards a directional light, with a w of 0
+   for (lightIndex = 0; lightIndex < directionalLightList.size(); lightIndex++)
+   {
+      const Vector3D &direction = directionalLightList[lightIndex];
+      float pos[] = {-direction.x, -direction.y, -direction.z, 0.0};
+      glLightfv(GL_LIGHT0 + MAX_LIGHTS + lightIndex, GL_POSITION, pos);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Called before the visible models are drawn.  Specializing classes that
+   shade the models themselves (with a shader) set that up here, by default
+   the models are lit by openGL.
+*/
+void ShadowableScene::beginLightingPass() {}
+
+//-----------------------------------------------------------------------------
+/**
+   Called after the visible models are drawn, undoes beginLightingPass
+*/
+void ShadowableScene::endLightingPass() {}
+
+//-----------------------------------------------------------------------------
+/**
+   Called for each model of the lighting pass once its state is set, for
+   specializing classes whose shading can't read the lighting and texture
+   enables from openGL.
+
+  @param lit true if the model is lit, false if it is drawn in its color
+  @param textured true if the model's texture is bound
+*/
+void ShadowableScene::setModelShading(bool /*lit*/, bool /*textured*/) {}
+
+//-----------------------------------------------------------------------------
+/**
+   Routine that draws the models in the caster list onto the receiver list
+   using a shadow projection algorithm.  Pure virtual and must be overridden
+   in derrived classes.
+*/
+void ShadowableScene::drawShadows() {}
 }
\ No newline at end of file
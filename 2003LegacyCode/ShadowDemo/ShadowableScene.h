@@ -1,61 +1,203 @@
-#ifndef SHADOWABLESCENE_H
-#define SHADOWABLESCENE_H
-//-----------------------------------------------------------------------------
-#include <vector>
-#include <string>
-#include "Vector3D.h"
-#include "FTM.h"
-
-namespace SML_CORE
-{
-// forward declarations
-class Model3D;
-
-/**
-  This class is the base class for rendering shadowed scenes.  It provdies 
-  common functionality that can be utilized by specalizing classes.
-  Defined casting models will render shadows onto defined receiver models.
-
-  @author Jason Dudash
-*/
-class ShadowableScene  
-{
-protected:
-   static const int MAX_LIGHTS;
-   bool drawLightsFlag;
-   bool drawShadowsFlag;
-   std::vector<Model3D*> shadowCasterList;
-   std::vector<Model3D*> shadowReceiverList;
-   std::vector<Model3D*> normalList;
-   std::vector<Vector3D> pointLightList;
-
-   bool removeModelFromList(std::string modelName, std::vector<Model3D*> &list);
-   void renderModelList(const std::vector<Model3D*> &modelList);
-   virtual void drawShadows() = 0;
-   void updateLights();
-
-public:
-	ShadowableScene();
-	virtual ~ShadowableScene();
-   void addModel(Model3D *model, int shadowMode);
-   bool removeModel(std::string modelName);
-   void addPointLightSource(float x, float y, float z);
-   void addDirectionalLightSource(float x, float y, float z);
-   void render();
-   void drawLights(bool mode) {drawLightsFlag = mode;};
-   void turnOnShadows() {drawShadowsFlag = true;};
-   void turnOffShadows() {drawShadowsFlag = false;};
-   bool isDrawLightsOn() {return drawLightsFlag;};
-
-   /** Every object added to the scene must have a ModelShadowMode,
-       it determines which model list it is a part of.
-   */
-   enum ModelShadowMode
-   {
-      RECEIVES_SHADOWS,
-      CASTS_SHADOWS,
-      NONE
-   };
-};
-}
-#endif
+#ifndef SHADOWABLESCENE_H
+#define SHADOWABLESCENE_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <map>
+#include <string>
+#include "Vector3D.h"
+#include "FTM.h"
+#include "RenderStateCache.h"
+#include "RenderQueue.h"
+#include "Frustum.h"
+#include "LooseOctree.h"
+#include "ModelRegistry.h"
+#include "SceneStore.h"
+#include "BillboardRenderer.h"
+#include "LinearArena.h"
+#include "ShadowScheduler.h"
+#include "LightClusters.h"
+
+namespace SML_CORE
+{
+// forward declarations
+class Model3D;
+class Camera;
+class ProjectileSystem;
+class JobSystem;
+class SceneSnapshot;
+class StreamBuffer;
+class EdgeMesh;
+class ConvexHull;
+
+/**
+  This class is the base class for rendering shadowed scenes.  It provdies 
+  common functionality that can be utilized by specalizing classes.
+  Defined casting models will render shadows onto defined receiver models.
+
+  There can be many point lights.  Each frame they are sorted into the
+  clusters of the view and the few that matter most to some cluster are
+  shadowed, each with an openGL light of its own (MAX_LIGHTS of them).
+  Scenes that shade the models themselves can light them with the rest
+  too, from the clusters' lists, the other scenes leave the rest out.
+
+  @author Jason Dudash
+*/
+class ShadowableScene  
+{
+protected:
+   /** Where the projectiles drawn this frame are read from: the projectile
+       system itself, or the snapshot of it when the simulation runs on
+       another thread */
+   class ProjectileFrame
+   {
+   public:
+      int count;
+      const float *x;
+      const float *y;
+      const float *z;
+      const float *previousX;
+      const float *previousY;
+      const float *previousZ;
+      const float *radii;
+   };
+
+   static const int MAX_LIGHTS;
+   static const int MAX_POINT_LIGHTS;
+   static const int MAX_DIRECTIONAL_LIGHTS;
+   bool drawLightsFlag;
+   bool drawShadowsFlag;
+   ModelRegistry modelRegistry;
+   const std::vector<Model3D*> &shadowCasterList;
+   const std::vector<Model3D*> &shadowReceiverList;
+   const std::vector<Model3D*> &normalList;
+   std::vector<Vector3D> pointLightList;
+   std::vector<float> pointLightX;
+   std::vector<float> pointLightY;
+   std::vector<float> pointLightZ;
+   std::vector<float> pointLightRadii;
+   std::vector<float> pointLightColors;
+   std::vector<float> pointLightIntensities;
+   std::vector<int> shadowLightIndices;
+   std::vector<int> significantLights;
+   std::vector<int> lightSlots;
+   LightClusters lightClusters;
+   int shadowLightsPerCluster;
+   std::vector<Vector3D> directionalLightList;
+   RenderStateCache renderState;
+   RenderQueue renderQueue;
+   LinearArena frameArena;
+   float viewMatrix[16];
+   Camera *sceneCamera;
+   Frustum viewFrustum;
+   int objectsTested;
+   int objectsRejected;
+   int castersTested;
+   int castersRejected;
+   int shadowPairsTested;
+   int shadowPairsRejected;
+   SceneStore sceneStore;
+   LooseOctree spatialIndex;
+   std::vector<Model3D*> visibleModels;
+   std::vector<float> visibleDepths;
+   ProjectileSystem *projectiles;
+   BillboardRenderer projectileRenderer;
+   std::vector<unsigned char> projectileVisible;
+   ProjectileFrame projectileFrame;
+   std::vector<float> projectileRenderX;
+   std::vector<float> projectileRenderY;
+   std::vector<float> projectileRenderZ;
+   int projectilesDrawn;
+   JobSystem *jobs;
+   float interpolation;
+   const SceneSnapshot *snapshot;
+   bool snapshotIsNew;
+   std::map<int, EdgeMesh*> edgeMeshes;
+   std::map<int, ConvexHull*> shadowProxies;
+   int modelsRemoved;
+   ShadowScheduler shadowScheduler;
+
+   void insertIntoSpatialIndex(Model3D *model, int mode);
+   void updateSpatialIndex();
+   void findVisibleCasters(const Vector3D &lightPosition, std::vector<Model3D*> &visibleList);
+   void findCasters(const Frustum &volume, std::vector<Model3D*> &casterList);
+   void findProjectileFrame();
+   void drawModel(Model3D *aModel);
+   void drawProjectiles();
+   void drawProjectileShadows(const float *plane, const Vector3D &lightPosition);
+   float getViewDepth(int storeIndex);
+   EdgeMesh* findEdgeMesh(Model3D *aModel);
+   ConvexHull* findShadowProxy(Model3D *aModel);
+   void scheduleShadows(const std::vector<Model3D*> &casters);
+   void toModelSpace(int storeIndex, const Vector3D &point, float *modelPoint) const;
+   bool findScreenRectangle(const float *projection, const int *viewport, const std::vector<float> &points, int *rectangle) const;
+   static void viewDepthJob(void *data, int begin, int end);
+   static void cullProjectilesJob(void *data, int begin, int end);
+   virtual void drawShadows() = 0;
+   virtual void beginLightingPass();
+   virtual void endLightingPass();
+   virtual void setModelShading(bool lit, bool textured);
+   void assignLights();
+   void updateLights();
+   bool isEmptyLightSlot(int lightIndex) const {return shadowLightIndices[lightIndex] == -1;};
+
+public:
+   /** how far a point light reaches when it isn't given */
+   enum {DEFAULT_LIGHT_RADIUS = 400};
+
+	ShadowableScene();
+	virtual ~ShadowableScene();
+   ModelHandle addModel(Model3D *model, int shadowMode);
+   Model3D* removeModel(ModelHandle handle);
+   Model3D* getModel(ModelHandle handle) const {return modelRegistry.getModel(handle);};
+   ModelHandle findModel(std::string modelName) const {return modelRegistry.findByName(modelName);};
+   int getNumModels() const {return modelRegistry.getNumModels();};
+   void addPointLightSource(float x, float y, float z, float radius=DEFAULT_LIGHT_RADIUS,
+                            float red=0.7, float green=0.5, float blue=0.5);
+   void addDirectionalLightSource(float x, float y, float z);
+   void render();
+   void beginTick();
+   void setInterpolation(float alpha);
+   void captureSnapshot(SceneSnapshot &target) const;
+   void setSnapshot(const SceneSnapshot *source, bool isNew);
+   void setCamera(Camera *camera) {sceneCamera = camera;};
+   void setProjectiles(ProjectileSystem *system) {projectiles = system;};
+   void setJobSystem(JobSystem *system) {jobs = system;};
+   void setStreamBuffer(StreamBuffer *buffer) {projectileRenderer.setStreamBuffer(buffer);};
+   void setWorldBounds(Vector3D center, float halfSize, int maxDepth);
+   void findModelsInSphere(Vector3D center, float radius, std::vector<Model3D*> &results);
+   void findModelsAlongRay(Vector3D origin, Vector3D direction, float maxDistance, std::vector<Model3D*> &results);
+   void drawLights(bool mode) {drawLightsFlag = mode;};
+   void turnOnShadows() {drawShadowsFlag = true;};
+   void turnOffShadows() {drawShadowsFlag = false;};
+   bool isDrawLightsOn() {return drawLightsFlag;};
+   int getNumDraws() const {return renderQueue.getSize();};
+   int getObjectsTested() const {return objectsTested;};
+   int getObjectsRejected() const {return objectsRejected;};
+   int getCastersTested() const {return castersTested;};
+   int getCastersRejected() const {return castersRejected;};
+   int getShadowPairsTested() const {return shadowPairsTested;};
+   int getShadowPairsRejected() const {return shadowPairsRejected;};
+   int getProjectilesDrawn() const {return projectilesDrawn;};
+   int getStateChangesIssued() const {return renderState.getChangesIssued();};
+   int getStateChangesAvoided() const {return renderState.getChangesAvoided();};
+   void invalidateRenderState() {renderState.invalidate();};
+   ShadowScheduler& getShadowScheduler() {return shadowScheduler;};
+   void setShadowLightsPerCluster(int count);
+   int getShadowLightsPerCluster() const {return shadowLightsPerCluster;};
+   int getNumPointLights() const {return pointLightX.size();};
+   int getNumShadowedLights() const;
+   const LightClusters& getLightClusters() const {return lightClusters;};
+
+   /** Every object added to the scene must have a ModelShadowMode,
+       it determines which model list it is a part of.
+   */
+   enum ModelShadowMode
+   {
+      RECEIVES_SHADOWS,
+      CASTS_SHADOWS,
+      NONE,
+      NUM_SHADOW_MODES  //this must be the last element
+   };
+};
+}
+#endif
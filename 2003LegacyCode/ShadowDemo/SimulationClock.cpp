@@ -0,0 +1,131 @@
+#include "SimulationClock.h"
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+
+  @param ticksPerSecond How often the simulation is stepped
+  @param framesPerSecond The most frames to draw a second (0 for no cap)
+  */
+SimulationClock::SimulationClock(int ticksPerSecond, int framesPerSecond) :
+tickRate(ticksPerSecond > 0 ? ticksPerSecond : 1),
+frameCap(framesPerSecond > 0 ? framesPerSecond : 0),
+lastTime(0),
+lastFrameTime(0),
+started(false),
+accumulator(0),
+tickCount(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+SimulationClock::~SimulationClock()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add the time since the last call and find how many ticks to run.  The
+   first call only starts the clock.
+
+  @param currentTime The time now in milliseconds
+  @return The number of ticks to run now
+  */
+int SimulationClock::advance(int currentTime)
+{
+   if (!started)
+   {
+      started = true;
+      lastTime = currentTime;
+      return 0;
+   }
+
+   int elapsed = currentTime - lastTime;
+   lastTime = currentTime;
+   if (elapsed < 0)
+      elapsed = 0;
+
+   // a stall longer than a second counts as a second
+   if (elapsed > 1000)
+      elapsed = 1000;
+   accumulator += elapsed * tickRate;
+
+   int numTicks = accumulator / 1000;
+   if (numTicks > MAX_TICKS_PER_FRAME)
+   {
+      numTicks = MAX_TICKS_PER_FRAME;
+      accumulator = 0;
+   }
+   else
+   {
+      accumulator -= numTicks * 1000;
+   }
+   tickCount += numTicks;
+   return numTicks;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Forget the time gathered so far, the next advance restarts the clock
+  */
+void SimulationClock::reset()
+{
+   started = false;
+   accumulator = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Change the tick rate.  The part of a tick gathered so far is kept.
+
+  @param ticksPerSecond How often the simulation is stepped
+  */
+void SimulationClock::setTickRate(int ticksPerSecond)
+{
+   if (ticksPerSecond < 1)
+      ticksPerSecond = 1;
+   accumulator = accumulator * ticksPerSecond / tickRate;
+   tickRate = ticksPerSecond;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find how long to wait before the next tick is due, so a thread that only
+   runs the simulation can sleep until then.
+
+  @param currentTime The time now in milliseconds
+  @return Milliseconds to wait (0 when a tick is already due)
+  */
+int SimulationClock::getTickDelay(int currentTime) const
+{
+   int elapsed = currentTime - lastTime;
+   if (elapsed < 0)
+      elapsed = 0;
+   int remaining = 1000 - accumulator - elapsed * tickRate;
+   if (remaining <= 0)
+      return 0;
+   return (remaining + tickRate - 1) / tickRate;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find how long to wait before the next frame so the frame cap is kept.
+
+  @param currentTime The time now in milliseconds
+  @return Milliseconds to wait (0 when there is no cap or the frame is late)
+  */
+int SimulationClock::getFrameDelay(int currentTime) const
+{
+   if (frameCap == 0)
+      return 0;
+   int delay = lastFrameTime + 1000 / frameCap - currentTime;
+   return delay > 0 ? delay : 0;
+}
+}
@@ -0,0 +1,59 @@
+#ifndef SIMULATIONCLOCK_H
+#define SIMULATIONCLOCK_H
+//-----------------------------------------------------------------------------
+
+namespace SML_CORE
+{
+/**
+  This class steps a simulation at a fixed rate, however fast the frames
+  are drawn.  Each frame the real time that has passed is added to an
+  accumulator and the simulation is run for as many whole ticks as fit in
+  it.  What's left over (a fraction of a tick) is used to interpolate the
+  transforms that are drawn between the last two ticks.
+
+  The accumulator counts milliseconds times the tick rate, so the tick
+  boundaries are exact and the same real times always give the same ticks.
+  After a long stall (a breakpoint, dragging the window) at most
+  MAX_TICKS_PER_FRAME ticks are run and the rest of the time is dropped.
+
+  A frame cap can also be set, getFrameDelay says how long to wait before
+  starting the next frame so the CPU can sleep instead of spinning.
+
+  The simulation and the frames can run on different threads.  The tick
+  members (advance, getTickTime, getTickDelay) belong to the simulation
+  thread and the frame members (beginFrame, setFrameCap, getFrameDelay) to
+  the render thread, the tick rate is set before the threads start.
+*/
+class SimulationClock
+{
+private:
+   int tickRate;
+   int frameCap;
+   int lastTime;
+   int lastFrameTime;
+   bool started;
+   int accumulator;
+   unsigned long tickCount;
+
+public:
+   /** the most ticks run to catch up in one frame */
+   enum {MAX_TICKS_PER_FRAME = 8};
+
+   SimulationClock(int ticksPerSecond=60, int framesPerSecond=0);
+   virtual ~SimulationClock();
+   int advance(int currentTime);
+   void beginFrame(int currentTime) {lastFrameTime = currentTime;};
+   void reset();
+   void setTickRate(int ticksPerSecond);
+   void setFrameCap(int framesPerSecond) {frameCap = framesPerSecond > 0 ? framesPerSecond : 0;};
+   int getTickRate() const {return tickRate;};
+   int getFrameCap() const {return frameCap;};
+   float getTickSeconds() const {return 1.0f / tickRate;};
+   float getInterpolation() const {return accumulator / 1000.0f;};
+   unsigned long getTickCount() const {return tickCount;};
+   int getTickTime() const {return lastTime - accumulator / tickRate;};
+   int getTickDelay(int currentTime) const;
+   int getFrameDelay(int currentTime) const;
+};
+}
+#endif
@@ -0,0 +1,135 @@
+#include "StreamBuffer.h"
+#include "GLExtensions.h"
+
+namespace SML_CORE
+{
+// allocations start on this boundary
+static const int STREAM_ALIGNMENT = 16;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor, the buffer is made by create
+  */
+StreamBuffer::StreamBuffer() :
+bufferId(0),
+mappedData(0),
+numRegions(0),
+regionSize(0),
+regionStart(0),
+bytesUsed(0),
+highWater(0),
+numOverflows(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+StreamBuffer::~StreamBuffer()
+{
+   destroy();
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Make and map the buffer.  There must be a current context.  Anything
+   made before is destroyed first, so the GPU must be done with it.
+
+  @param regions The number of frames in flight
+  @param bytesPerRegion The most a frame can write
+  @return false if the driver can't map a buffer persistently
+  */
+bool StreamBuffer::create(int regions, int bytesPerRegion)
+{
+   destroy();
+   GLExtensions::load();
+   if (!GLExtensions::hasPersistentMapping || regions < 1 || bytesPerRegion < 1)
+      return false;
+
+   numRegions = regions;
+   regionSize = (bytesPerRegion + STREAM_ALIGNMENT - 1) / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+   GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+   GLbufferSize size = (GLbufferSize)numRegions * regionSize;
+
+   GLExtensions::genBuffers(1, &bufferId);
+   GLExtensions::bindBuffer(GL_ARRAY_BUFFER, bufferId);
+   GLExtensions::bufferStorage(GL_ARRAY_BUFFER, size, 0, flags);
+   mappedData = (char*)GLExtensions::mapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+   GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+   if (!mappedData)
+   {
+      destroy();
+      return false;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Unmap and delete the buffer
+  */
+void StreamBuffer::destroy()
+{
+   if (bufferId)
+   {
+      if (mappedData)
+      {
+         GLExtensions::bindBuffer(GL_ARRAY_BUFFER, bufferId);
+         GLExtensions::unmapBuffer(GL_ARRAY_BUFFER);
+         GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+      }
+      GLExtensions::deleteBuffers(1, &bufferId);
+   }
+   bufferId = 0;
+   mappedData = 0;
+   numRegions = 0;
+   regionStart = 0;
+   bytesUsed = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Start writing into a frame's region.  The GPU must be done with what the
+   region held (see FramePacer::beginFrame).
+
+  @param region The frame's slot
+  */
+void StreamBuffer::beginFrame(int region)
+{
+   if (numRegions == 0)
+      return;
+   regionStart = (region % numRegions) * regionSize;
+   bytesUsed = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Take space from this frame's region
+
+  @param bytes The size needed
+  @param offset Set to where the space starts in the buffer (for
+                glVertexPointer and friends while the buffer is bound)
+  @return Where to write, 0 if the region is full or the buffer isn't mapped
+  */
+void* StreamBuffer::allocate(int bytes, int &offset)
+{
+   if (!mappedData)
+      return 0;
+
+   int aligned = (bytes + STREAM_ALIGNMENT - 1) / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+   if (bytesUsed + aligned > regionSize)
+   {
+      numOverflows++;
+      return 0;
+   }
+
+   offset = regionStart + bytesUsed;
+   bytesUsed += aligned;
+   if (bytesUsed > highWater)
+      highWater = bytesUsed;
+   return mappedData + offset;
+}
+}
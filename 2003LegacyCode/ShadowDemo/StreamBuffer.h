@@ -0,0 +1,45 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+//-----------------------------------------------------------------------------
+
+namespace SML_CORE
+{
+/**
+  This class is a vertex buffer for data written fresh every frame
+  (billboards, blob shadows).  The buffer is mapped once, persistently, and
+  split into one region per frame in flight.  Each frame writes straight
+  into its own region, which the FramePacer has made sure the GPU is done
+  reading, so writing never waits on the GPU and never copies.
+
+  A frame that needs more than its region gets 0 back from allocate and
+  should draw from its own memory instead.  The same goes for drivers
+  without persistent mapping (isMapped is false).
+*/
+class StreamBuffer
+{
+private:
+   unsigned int bufferId;
+   char *mappedData;
+   int numRegions;
+   int regionSize;
+   int regionStart;
+   int bytesUsed;
+   int highWater;
+   int numOverflows;
+
+public:
+   StreamBuffer();
+   virtual ~StreamBuffer();
+   bool create(int regions, int bytesPerRegion);
+   void destroy();
+   void beginFrame(int region);
+   void* allocate(int bytes, int &offset);
+   bool isMapped() const {return mappedData != 0;};
+   unsigned int getBufferId() const {return bufferId;};
+   int getRegionSize() const {return regionSize;};
+   int getBytesUsed() const {return bytesUsed;};
+   int getHighWater() const {return highWater;};
+   int getNumOverflows() const {return numOverflows;};
+};
+}
+#endif
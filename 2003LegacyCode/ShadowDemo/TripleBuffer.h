@@ -0,0 +1,68 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+//-----------------------------------------------------------------------------
+#include "Platform.h"
+
+namespace SML_CORE
+{
+/**
+  This class hands the latest copy of something from one thread to another
+  without either of them ever waiting.  There are three copies: the writer
+  owns one, the reader owns one and the third is the one most recently
+  published.  Publishing swaps the writer's copy with the shared one,
+  acquiring swaps the reader's copy with the shared one if it is newer.
+
+  The shared slot's index and a "new" bit live in a single word that is
+  only ever changed with atomicExchange, so the swaps need no locks.  The
+  reader always gets the newest finished copy and the writer never has to
+  wait for the reader to finish with a copy (a copy the reader doesn't get
+  to is just written over).
+
+  One thread may write and one thread may read.
+*/
+template <class T> class TripleBuffer
+{
+private:
+   /** set in the shared word when it holds a copy the reader hasn't had */
+   enum {NEW_BIT = 4, INDEX_MASK = 3};
+
+   T buffers[3];
+   volatile long shared;
+   int writeIndex;
+   int readIndex;
+
+public:
+   TripleBuffer() : shared(1), writeIndex(0), readIndex(2) {};
+   virtual ~TripleBuffer() {};
+
+   /** @return The copy the writer fills in, until it calls publish */
+   T& getWriteBuffer() {return buffers[writeIndex];};
+
+   /**
+      Hand the write buffer to the reader and take the old shared copy as
+      the next write buffer.  Call this on the writing thread.
+     */
+   void publish()
+   {
+      writeIndex = atomicExchange(&shared, writeIndex | NEW_BIT) & INDEX_MASK;
+   };
+
+   /**
+      Take the newest published copy, if there is one the reader hasn't
+      had.  Call this on the reading thread.
+
+     @return true if the read buffer changed
+     */
+   bool acquire()
+   {
+      if ((shared & NEW_BIT) == 0)
+         return false;
+      readIndex = atomicExchange(&shared, readIndex) & INDEX_MASK;
+      return true;
+   };
+
+   /** @return The reader's copy, it doesn't change until acquire */
+   const T& getReadBuffer() const {return buffers[readIndex];};
+};
+}
+#endif
@@ -1,11 +1,11 @@
-#include "UV.h"
-
-UV::UV()
-{
-
-}
-
-UV::~UV()
-{
-
-}
+#include "UV.h"
+
+UV::UV()
+{
+
+}
+
+UV::~UV()
+{
+
+}
@@ -1,16 +1,16 @@
-#ifndef UV_H
-#define UV_H
-//-----------------------------------------------------------------------------
-
-namespace SML_CORE
-{
-/**
-   This class holds UV data for mapping a texture to a mesh.
-  */
-class UV  
-{
-public:
-   float u,v;
-};
-}
-#endif
+#ifndef UV_H
+#define UV_H
+//-----------------------------------------------------------------------------
+
+namespace SML_CORE
+{
+/**
+   This class holds UV data for mapping a texture to a mesh.
+  */
+class UV  
+{
+public:
+   float u,v;
+};
+}
+#endif
@@ -1,23 +1,23 @@
-#include "Vector3D.h"
-
-namespace SML_CORE
-{
-//-----------------------------------------------------------------------------
-/**
-      Constructor
-  */
-Vector3D::Vector3D() {}
-
-//-----------------------------------------------------------------------------
-/**
-      Constructor
-  */
-Vector3D::Vector3D(float x_, float y_, float z_) :
-x(x_), y(y_), z(z_) {}
-
-//-----------------------------------------------------------------------------
-/**
-   Destructor
-  */
-Vector3D::~Vector3D() {}
+#include "Vector3D.h"
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+      Constructor
+  */
+Vector3D::Vector3D() {}
+
+//-----------------------------------------------------------------------------
+/**
+      Constructor
+  */
+Vector3D::Vector3D(float x_, float y_, float z_) :
+x(x_), y(y_), z(z_) {}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+Vector3D::~Vector3D() {}
 }
\ No newline at end of file
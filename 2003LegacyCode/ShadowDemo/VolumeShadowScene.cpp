@@ -0,0 +1,380 @@
+#include <GL/glut.h>
+#include <iostream>
+#include "VolumeShadowScene.h"
+#include "GLExtensions.h"
+#include "Model3D.h"
+#include "EdgeMesh.h"
+
+using std::vector;
+using std::cout;
+using std::endl;
+
+namespace SML_CORE
+{
+// how dark a shadowed pixel is made (the alpha of the black laid over it)
+static const float SHADOW_ALPHA = 0.6;
+
+// the far plane is pulled in this much short of infinity so the volumes'
+// far caps don't round past the edge of the depth range
+static const float INFINITE_PROJECTION_EPSILON = 2.4e-7;
+
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+  */
+VolumeShadowScene::VolumeShadowScene() : ShadowableScene(),
+initialized(false),
+supported(false),
+projectionChanged(false),
+silhouetteEdges(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+  */
+VolumeShadowScene::~VolumeShadowScene()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Check there is a stencil buffer to count the volumes in, the first time
+   the scene is drawn
+  */
+void VolumeShadowScene::initialize()
+{
+   initialized = true;
+   GLExtensions::load();
+
+   GLint stencilBits = 0;
+   glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+   if (stencilBits == 0)
+   {
+      cout << "ERROR: shadow volumes need a stencil buffer, drawing without shadows" << endl;
+      return;
+   }
+   supported = true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Add one vertex of a volume, as it is or pushed to infinity away from the
+   light (w of 0)
+
+  @param vertices The volume vertices to add to
+  @param point The vertex in model space
+  @param light The light in model space
+  @param atInfinity true to push the vertex to infinity
+  */
+void VolumeShadowScene::addVolumeVertex(vector<float> &vertices, const float *point, const float *light, bool atInfinity)
+{
+   if (atInfinity)
+   {
+      vertices.push_back(point[0] - light[0]);
+      vertices.push_back(point[1] - light[1]);
+      vertices.push_back(point[2] - light[2]);
+      vertices.push_back(0.0);
+   }
+   else
+   {
+      vertices.push_back(point[0]);
+      vertices.push_back(point[1]);
+      vertices.push_back(point[2]);
+      vertices.push_back(1.0);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Build the shadow volume of a mesh as triangles.  The triangles facing the
+   light cap the volume at the mesh and the ones facing away from it cap it
+   at infinity, the silhouette edges are extruded into its sides.
+
+  @param mesh The caster's mesh
+  @param light The light in the caster's model space
+  @param volume Set to the volume's vertices, in the caster's model space
+  */
+void VolumeShadowScene::buildVolume(EdgeMesh &mesh, const float *light, vector<float> &volume)
+{
+   silhouetteEdges += mesh.findSilhouette(light, silhouette);
+
+   volume.clear();
+   const float *vertices = mesh.getVertices();
+   const int *triangles = mesh.getTriangles();
+   const unsigned char *facing = mesh.getFacing();
+   int index;
+   for (index = 0; index < mesh.getNumTriangles(); index++)
+   {
+      bool atInfinity = facing[index] == 0;
+      addVolumeVertex(volume, vertices + triangles[index * 3] * 3, light, atInfinity);
+      addVolumeVertex(volume, vertices + triangles[index * 3 + 1] * 3, light, atInfinity);
+      addVolumeVertex(volume, vertices + triangles[index * 3 + 2] * 3, light, atInfinity);
+   }
+
+   // the sides are wound the other way to the lit triangles' edges so they
+   // face out of the volume
+   for (index = 0; index < silhouette.size(); index += 2)
+   {
+      const float *from = vertices + silhouette[index] * 3;
+      const float *to = vertices + silhouette[index + 1] * 3;
+      addVolumeVertex(volume, to, light, false);
+      addVolumeVertex(volume, from, light, false);
+      addVolumeVertex(volume, from, light, true);
+      addVolumeVertex(volume, to, light, false);
+      addVolumeVertex(volume, from, light, true);
+      addVolumeVertex(volume, to, light, true);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Draw the volumes found for a light, each through its caster's world
+   matrix
+  */
+void VolumeShadowScene::drawVolumes()
+{
+   for (int index = 0; index < volumeRanges.size(); index++)
+   {
+      const VolumeRange &range = volumeRanges[index];
+      glVertexPointer(4, GL_FLOAT, 0, range.vertices);
+      glPushMatrix();
+      glMultMatrixf(sceneStore.getWorldMatrixAt(range.storeIndex));
+      glDrawArrays(GL_TRIANGLES, 0, range.count);
+      glPopMatrix();
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the part of the screen a light's shadows can fall on.  Nothing is
+   lower than the lowest model in the scene, so the shadows are inside the
+   casters' bounds and the bounds pushed away from the light down to that
+   height.
+
+  @param lightPosition The light
+  @param rectangle Set to the x, y, width and height of the part in pixels
+  @return false if the shadows may cover the whole screen
+  */
+bool VolumeShadowScene::findScissor(const Vector3D &lightPosition, int *rectangle)
+{
+   float floor = lightPosition.y;
+   int index;
+   for (index = 0; index < sceneStore.getSize(); index++)
+   {
+      const float *sphere = sceneStore.getWorldSphereAt(index);
+      if (sphere[1] - sphere[3] < floor)
+         floor = sphere[1] - sphere[3];
+   }
+
+   scissorPoints.clear();
+   for (index = 0; index < volumeRanges.size(); index++)
+   {
+      const float *sphere = sceneStore.getWorldSphereAt(volumeRanges[index].storeIndex);
+      for (int corner = 0; corner < 16; corner++)
+      {
+         float point[3] =
+         {
+            sphere[0] + (corner & 1 ? sphere[3] : -sphere[3]),
+            sphere[1] + (corner & 2 ? sphere[3] : -sphere[3]),
+            sphere[2] + (corner & 4 ? sphere[3] : -sphere[3])
+         };
+
+         // the second eight corners are where the first eight's shadows land
+         if (corner >= 8)
+         {
+            float height = lightPosition.y - point[1];
+            if (height <= 0.0)
+               return false;
+            float scale = (lightPosition.y - floor) / height;
+            point[0] = lightPosition.x + (point[0] - lightPosition.x) * scale;
+            point[1] = floor;
+            point[2] = lightPosition.z + (point[2] - lightPosition.z) * scale;
+         }
+         scissorPoints.insert(scissorPoints.end(), point, point + 3);
+      }
+   }
+   return findScreenRectangle(cameraProjection, viewport, scissorPoints, rectangle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Lay black over the pixels the volumes left a count on
+  */
+void VolumeShadowScene::darkenShadows()
+{
+   renderState.setStencilFunc(GL_NOTEQUAL, 0, 0xffffffff);
+   renderState.setStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+   renderState.setBlend(true);
+   renderState.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   renderState.setColor(0.0, 0.0, 0.0, SHADOW_ALPHA);
+   glDisable(GL_DEPTH_TEST);
+
+   // a quad over the whole screen
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+   glRectf(-1.0, -1.0, 1.0, 1.0);
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+
+   glEnable(GL_DEPTH_TEST);
+   renderState.setBlend(false);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Move the camera's far plane to infinity before anything is drawn, the
+   volumes reach there and the depths of the scene must match theirs
+  */
+void VolumeShadowScene::beginLightingPass()
+{
+   projectionChanged = false;
+   silhouetteEdges = 0;
+   if (!drawShadowsFlag)
+      return;
+   if (!initialized)
+      initialize();
+   if (!supported)
+      return;
+
+   glGetFloatv(GL_PROJECTION_MATRIX, cameraProjection);
+   glGetIntegerv(GL_VIEWPORT, viewport);
+
+   // only a perspective projection has a far plane to move
+   if (cameraProjection[11] != -1.0)
+      return;
+   float nearPlane = cameraProjection[14] / (cameraProjection[10] - 1.0);
+   float infinite[16];
+   for (int index = 0; index < 16; index++)
+      infinite[index] = cameraProjection[index];
+   infinite[10] = INFINITE_PROJECTION_EPSILON - 1.0;
+   infinite[14] = nearPlane * (INFINITE_PROJECTION_EPSILON - 2.0);
+
+   glMatrixMode(GL_PROJECTION);
+   glLoadMatrixf(infinite);
+   glMatrixMode(GL_MODELVIEW);
+   projectionChanged = true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   A implmentation of drawShadows that counts the shadow volumes of each
+   light into the stencil buffer and darkens the pixels inside them.
+*/
+void VolumeShadowScene::drawShadows()
+{
+   if (!projectionChanged)
+      return;
+
+   renderState.setLighting(false);
+   renderState.setTexture(0);
+   renderState.setStencilTest(true);
+   glEnableClientState(GL_VERTEX_ARRAY);
+
+   // find the casters whose shadows can be seen for each light, and pick
+   // the ones whose volumes are built again this frame
+   visibleCasters.resize(pointLightList.size());
+   int lightIndex;
+   for (lightIndex = 0; lightIndex < pointLightList.size(); lightIndex++)
+   {
+      visibleCasters[lightIndex].clear();
+      if (isEmptyLightSlot(lightIndex))
+         continue;
+      findVisibleCasters(pointLightList[lightIndex], visibleCasters[lightIndex]);
+      scheduleShadows(visibleCasters[lightIndex]);
+   }
+   shadowScheduler.selectUpdates();
+
+   for (lightIndex = 0; lightIndex < pointLightList.size(); lightIndex++)
+   {
+      const Vector3D &lightPosition = pointLightList[lightIndex];
+      const vector<Model3D*> &casters = visibleCasters[lightIndex];
+
+      // the volumes of the casters whose shadows can be seen, the ones that
+      // aren't due keep the volume built last time
+      volumeRanges.clear();
+      for (int index = 0; index < casters.size(); index++)
+      {
+         EdgeMesh *mesh = findEdgeMesh(casters[index]);
+         if (mesh->getNumTriangles() == 0)
+            continue;
+
+         VolumeRange range;
+         range.storeIndex = sceneStore.getIndex(casters[index]->getStoreId());
+         ShadowScheduler::ShadowResult &volume = shadowScheduler.findShadow(casters[index]->getStoreId(), lightIndex);
+         if (volume.refresh)
+         {
+            shadowScheduler.startRefresh();
+            float light[3];
+            toModelSpace(range.storeIndex, lightPosition, light);
+            buildVolume(*mesh, light, volume.vertices);
+            shadowScheduler.finishRefresh(volume);
+         }
+         if (volume.vertices.empty())
+            continue;
+         range.vertices = &volume.vertices[0];
+         range.count = volume.vertices.size() / 4;
+         volumeRanges.push_back(range);
+      }
+      if (volumeRanges.empty())
+         continue;
+
+      int rectangle[4];
+      if (findScissor(lightPosition, rectangle))
+      {
+         if (rectangle[2] == 0 || rectangle[3] == 0)
+            continue;
+         glEnable(GL_SCISSOR_TEST);
+         glScissor(rectangle[0], rectangle[1], rectangle[2], rectangle[3]);
+      }
+      glClear(GL_STENCIL_BUFFER_BIT);
+
+      // count the volume faces behind the scene, up for back faces and down
+      // for front faces, into the stencil buffer only
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      glDepthMask(GL_FALSE);
+      renderState.setStencilFunc(GL_ALWAYS, 0, 0xffffffff);
+      if (GLExtensions::hasSeparateStencil && GLExtensions::hasStencilWrap)
+      {
+         renderState.setStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+         renderState.setStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+         drawVolumes();
+      }
+      else
+      {
+         // without two-sided stencil each side takes a pass, back faces first
+         // so the count can't go below zero
+         glEnable(GL_CULL_FACE);
+         glCullFace(GL_FRONT);
+         renderState.setStencilOp(GL_KEEP, GL_INCR, GL_KEEP);
+         drawVolumes();
+         glCullFace(GL_BACK);
+         renderState.setStencilOp(GL_KEEP, GL_DECR, GL_KEEP);
+         drawVolumes();
+         glDisable(GL_CULL_FACE);
+      }
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      glDepthMask(GL_TRUE);
+
+      darkenShadows();
+      glDisable(GL_SCISSOR_TEST);
+   }
+
+   glDisableClientState(GL_VERTEX_ARRAY);
+   renderState.setStencilTest(false);
+
+   // the camera's own projection goes back for the next frame
+   glMatrixMode(GL_PROJECTION);
+   glLoadMatrixf(cameraProjection);
+   glMatrixMode(GL_MODELVIEW);
+}
+}
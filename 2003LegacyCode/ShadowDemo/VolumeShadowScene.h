@@ -0,0 +1,73 @@
+#ifndef VOLUMESHADOWSCENE_H
+#define VOLUMESHADOWSCENE_H
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "ShadowableScene.h"
+
+namespace SML_CORE
+{
+// forward declare
+class Model3D;
+class EdgeMesh;
+
+/**
+  This class is a specalized ShadowableScene class that shadows the scene
+  with stencil shadow volumes.  For each light the silhouette of every
+  caster is found and extruded away from the light to infinity, capped at
+  the caster (the faces towards the light) and at infinity (the faces away
+  from it).  The volumes are counted into the stencil buffer with the z-fail
+  test, so the camera may be inside a shadow, using two-sided stencil so
+  both sides are counted in one pass.  The pixels left with a count are
+  darkened.
+
+  Drawing volumes to infinity needs a projection without a far plane, the
+  camera's projection has its far plane moved to infinity while the scene
+  is drawn.  The stencil work for a light is kept to a scissor rectangle
+  around where its casters' shadows can fall.
+
+  The volumes are built in each caster's model space and kept, the shadow
+  scheduler decides which are built again each frame (distant and slow
+  casters keep theirs for a few frames, see ShadowScheduler).
+
+  Casters need mesh data (loaded from a file), display lists built by hand
+  don't cast shadows.  The meshes should be closed.
+*/
+class VolumeShadowScene : public ShadowableScene
+{
+private:
+   /** A caster's volume, in its model space, to draw this frame */
+   class VolumeRange
+   {
+   public:
+      int storeIndex;
+      const float *vertices;
+      int count;
+   };
+
+   bool initialized;
+   bool supported;
+   float cameraProjection[16];
+   int viewport[4];
+   bool projectionChanged;
+   std::vector< std::vector<Model3D*> > visibleCasters;
+   std::vector<int> silhouette;
+   std::vector<VolumeRange> volumeRanges;
+   std::vector<float> scissorPoints;
+   int silhouetteEdges;
+
+   void initialize();
+   void buildVolume(EdgeMesh &mesh, const float *light, std::vector<float> &volume);
+   static void addVolumeVertex(std::vector<float> &vertices, const float *point, const float *light, bool atInfinity);
+   void drawVolumes();
+   bool findScissor(const Vector3D &lightPosition, int *rectangle);
+   void darkenShadows();
+   void beginLightingPass();
+   void drawShadows();
+
+public:
+	VolumeShadowScene();
+	virtual ~VolumeShadowScene();
+   int getSilhouetteEdges() const {return silhouetteEdges;};
+};
+}
+#endif
@@ -1,746 +1,586 @@
-#include <sstream>
-#include <GL/glut.h>
-#include "XFileLoader.h"
-#include "Model3D.h"
-
-using namespace std;
-
-namespace SML_CORE
-{
-//-----------------------------------------------------------------------------
-/**
-   Constructor
-*/
-XFileLoader::XFileLoader() :
-fileLoaded(false),
-faceList(0),
-vertList(0),
-normalList(0),
-uvList(0)
-{
-
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Destructor
-*/
-XFileLoader::~XFileLoader()
-{
-
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Handle section data of type header that is passed in as an argument
-
-  @param headerData The data that we are dealing with
-*/
-void XFileLoader::handleHeader(string &headerData)
-{
-   string temp = "";
-   temp = readTo(headerData,';');
-   istringstream isX(temp);
-   isX >> ourAxis.upX;
- 
-   temp = readTo(headerData,';');
-   istringstream isY(temp);
-   isY >> ourAxis.upY;
- 
-   temp = readTo(headerData,';');
-   istringstream isZ(temp);
-   isZ >> ourAxis.upZ;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Handle section data of type frame that is passed in as an argument
-
-  @param dataFrame The data frame that we are dealing with
-*/
-void XFileLoader::handleFrame(string &dataFrame)
-{
-   // A frame usually contains nested templates so read the next section
-   while(!dataFrame.empty())
-   {
-      XFileLoader::XFileDataSection dataSection = readDataSection(dataFrame);
-
-      // recursive call to this function to handle nested frames
-      if (dataSection.identifier == "Frame")
-      {
-         cout << "XFileLoader - handling Frame \"" << dataSection.name << "\"" << endl;
-         handleFrame(dataSection.dataBuffer);
-      }
-      // transform this mesh and all child meshes
-      else if (dataSection.identifier == "FrameTransformMatrix")
-      {
-         cout << "XFileLoader - handling FrameTransformMatrix \"" << dataSection.name << "\"" << endl;
-         FTM tempFtm = readTransformMatrix(dataSection.dataBuffer);
-         tempFtm.multMatrix(frameTransform);
-         frameTransform = tempFtm;
-      }
-      // handle the mesh
-      else if (dataSection.identifier == "Mesh")
-      {
-         cout << "XFileLoader - handling Mesh \"" << dataSection.name << "\"" << endl;
-         handleMesh(dataSection.dataBuffer);
-      }
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Handle the argument Mesh section.  The mesh section consists of 
-   an array of verticies and an array of faces, it also has subsections
-
-  @param meshData a reference to the data string we are readin from
-*/
-void XFileLoader::handleMesh(string &meshData)
-{
-   vertList = readVertexData(meshData);
-   faceList = readFaceData(meshData);
-
-   // A mesh usually contains nested templates so read the next section
-   while(!meshData.empty())
-   {
-      XFileLoader::XFileDataSection dataSection = readDataSection(meshData);
-
-      // handle mesh normal data
-      if (dataSection.identifier == "MeshNormals")
-      {
-         cout << "XFileLoader - handling MeshNormals \"" << dataSection.name << "\"" << endl;
-         handleMeshNormals(dataSection.dataBuffer);
-      }
-      // handle mesh material list
-      else if (dataSection.identifier == "MeshMaterialList")
-      {
-         cout << "XFileLoader - cannot handle MeshMaterialList \"" << dataSection.name << "\"" << endl;
-         /// \todo handle meshMaterialList (contains Material section)
-      }
-      // handle mesh texture coordinates
-      else if (dataSection.identifier == "MeshTextureCoords")
-      {
-         cout << "XFileLoader - handling MeshTextureCoords \"" << dataSection.name << "\"" << endl;
-         handleMeshUVs(dataSection.dataBuffer);
-      }
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Read and handle the UV texture mapping coordinates for the argument
-   mesh data.
-
-   @param uvData Reference to the string of UV data
-*/
-void XFileLoader::handleMeshUVs(string &uvData)
-{
-   string numUVsStr = "";
-   int c = readChar(uvData, true);
-   while(c != ';' && c != -1)
-   {
-      numUVsStr +=(char)c;
-      c = readChar(uvData);
-   }
-
-   istringstream is(numUVsStr);
-   int numUVs = 0;
-   is >> numUVs;
-
-   string temp;
-   UV tempUV;
-
-   // read the verts
-   for(int i = 0;i<numUVs;i++)
-   {
-      // read u
-      temp = readTo(uvData,';');
-      istringstream isU(temp);
-      isU >> tempUV.u;
-
-      // read v
-      temp = readTo(uvData,';');
-      istringstream isV(temp);
-      isV >> tempUV.v;
-
-      if(i != numUVs-1)
-      {
-         // read trailing ','
-         temp = readTo(uvData,',');
-      }
-      else
-      {
-         // read a trailing ; at the very end
-         temp = readTo(uvData,';');
-      }
-      uvList.push_back(tempUV);
-   }
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Handle the normals processing for the argument mesh data
-
-  @param normalData A reference to the data we are reading from
-*/
-void XFileLoader::handleMeshNormals(string &normalData)
-{
-   normalList = readVertexData(normalData);
-   faceNormalsList = readFaceData(normalData);
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Read in a data section from the loaded .x file file stream.
-
-   Note: for efficency this should probably not return by value 
-
-   @return The next data section in the file
-*/
-XFileLoader::XFileDataSection XFileLoader::readDataSection()
-{ 
-   XFileDataSection tempSection;
-   tempSection.identifier = "";
-   tempSection.name = "";
-   tempSection.dataBuffer = "";
-
-   int c = inFile.get();
-   bool found = false;
-   while((!found || c != ' ') && !inFile.eof())
-   {
-      if(c != ' ' && c != '\n' && c != 13)
-      {
-         found = true;
-         tempSection.identifier += (char)c;
-      }
-      c = inFile.get();
-   }
-
-   // read the section name
-   while(c != '{' && !inFile.eof())
-   {
-      if(c != ' ' && c != '\n' && c != 13)
-      {
-         tempSection.name += (char)c;
-      }
-      c = inFile.get();
-   }
-
-   // read the section data between the {}'s
-   int bracecount = 1;
-   c = inFile.get();
-   while(bracecount > 0 && !inFile.eof())
-   {
-      // handle counting brace depth
-      if(c == '{') bracecount += 1;
-      else if(c == '}') bracecount -= 1;
-
-      // ignore last brace
-      if(bracecount > 0)
-      {
-         tempSection.dataBuffer += (char)c;
-         c = inFile.get();
-      }
-   }
-
-   return tempSection;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Read the argument data section into its parts
-
-   Note: for efficency this should probably not return by value
-
-  @param dataFrame The data section to read
-  @return The next data section from the given frame
-*/
-XFileLoader::XFileDataSection XFileLoader::readDataSection(string& dataFrame)
-{ 
-   XFileDataSection tempSection;
-   tempSection.identifier = "";
-   tempSection.name = "";
-   tempSection.dataBuffer = "";
-
-   int c = readChar(dataFrame);
-   bool found = false;
-   while((!found || c != ' ') && !dataFrame.empty())
-   {
-      if(c != ' ' && c != '\n' && c != 13)
-      {
-         found = true;
-         tempSection.identifier += (char)c;
-      }
-      c = readChar(dataFrame);
-   }
-
-   // read the section name
-   while(c != '{' && !dataFrame.empty())
-   {
-      if(c != ' ' && c != '\n' && c != 13)
-      {
-         tempSection.name += (char)c;
-      }
-      c = readChar(dataFrame);
-   }
-
-   // read the section data between the {}'s
-   int bracecount = 1;
-   c = readChar(dataFrame);
-   while(bracecount > 0 && !dataFrame.empty())
-   {
-      // handle counting brace depth
-      if(c == '{') bracecount += 1;
-      else if(c == '}') bracecount -= 1;
-
-      // ignore last brace
-      if(bracecount > 0)
-      {
-         tempSection.dataBuffer += (char)c;
-         c = readChar(dataFrame);
-      }
-   }
-   return tempSection;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Read the vert list from the argument string data.  The vector data is assumed
-   to be the first section of the string, and in the format: number of points
-   followed by array of points (p1;p2;p3,p1;p2;p3,p1;p2...etc).
-
-   Note: for efficency this should probably not return a vector by value
-
-  @param theString a reference to the string to read
-  @return The list of verts
-*/
-vector<Vector3D> XFileLoader::readVertexData(string& vertexData)
-{
-   string numVertsStr = "";
-   int c = readChar(vertexData, true);
-   while(c != ';' && c != -1)
-   {
-      numVertsStr += (char)c;
-      c = readChar(vertexData);
-   }
-
-   istringstream is(numVertsStr);
-   int numVerts = 0;
-   is >> numVerts;
-   vector<Vector3D> tempVertList;
-   string temp;
-   Vector3D tempVector;
-
-   // read the verts
-   for(int i = 0;i<numVerts;i++)
-   {
-      // read x
-      temp = readTo(vertexData,';');
-      istringstream isx(temp);
-      isx >> tempVector.x;
-
-      // read y
-      temp = readTo(vertexData,';');
-      istringstream isy(temp);
-      isy >> tempVector.y;
-
-      // read z
-      temp = readTo(vertexData,';');
-      istringstream isz(temp);
-      isz >> tempVector.z;
-
-      if(i != numVerts-1)
-      {
-         // read trailing ','
-         temp = readTo(vertexData,',');
-      }
-      else
-      {
-         // read a trailing ; at the very end
-         temp = readTo(vertexData,';');
-      }
-      tempVertList.push_back(tempVector);
-   }
-
-   return tempVertList;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Read the vert list from the argument string data.  The face data is assumed
-   to be the first section of the string, and in the format: number of faces
-   followed by array of faces (f1;f2;f3,f1;f2;f3,f1;f2...etc).
-
-   Note: for efficency this should probably not return a vector by value
-
-  @param theString pointer to the string to read
-  @return A List of faces (indices into the vert list)
-*/
-vector<Face> XFileLoader::readFaceData(std::string& faceData)
-{
-   string numFacesStr = "";
-   int c = readChar(faceData, true);
-   while(c != ';' && c != -1)
-   {
-      numFacesStr += (char)c;
-      c = readChar(faceData);
-   }
-
-   int numFaces = 0;
-   istringstream is(numFacesStr);
-   is >> numFaces;
-   vector<Face> tempFaceList;
-   string temp;
-   Face tempFace;
-
-   // read the faces
-   for(int i = 0;i<numFaces;i++)
-   {
-      // read index count
-      temp = readTo(faceData,';');
-      istringstream isNum(temp);
-      isNum >> tempFace.numIndices;
-      if(tempFace.numIndices != 3 && tempFace.numIndices != 4)
-      {
-         cout << "XFileLoader - ERROR! reader doesn't support file (too face faces in mesh)" << endl;
-         /// \todo add exception handling and throw error
-      }
-
-      // read indices
-      temp = readTo(faceData,',');
-      istringstream isOne(temp);
-      isOne >> tempFace.one;
-
-      temp = readTo(faceData,',');
-      istringstream isTwo(temp);
-      isTwo >> tempFace.two;
-
-      // 3rd vert index might be capped with a ','  or a ';'
-      if(tempFace.numIndices == 4)
-      {
-         temp = readTo(faceData,',');
-      }
-      else
-      {
-         temp = readTo(faceData,';');
-      }
-      istringstream isThree(temp);
-      isThree >> tempFace.three;
-
-      // optional 4th vert capped with a ;
-      if(tempFace.numIndices == 4)
-      {
-         temp = readTo(faceData,';');
-         istringstream isFour(temp);
-         isFour >> tempFace.four;
-      }
-
-      if(i != numFaces-1)
-      {
-         // read a trailing ','
-         temp = readTo(faceData,',');
-      }
-      else
-      {
-         // read a trailing ';' at the very end
-         temp = readTo(faceData,';');
-      }
-
-      tempFaceList.push_back(tempFace);
-   }
-
-   return tempFaceList;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Read a FTM from the argument string data.  The FTM data is assumed
-   to be the first section of the string.
-
-   Note: for efficency this should probably not return a vector by value
-
-  @param dataBuffer The reference to the data to read from
-  @return The frame transformation matrix read in
-*/
-FTM XFileLoader::readTransformMatrix(std::string& dataBuffer)
-{
-   FTM tempFTM;
-   string temp = "";
-
-   temp = readTo(dataBuffer,',');
-   istringstream is1(temp);
-   is1 >> frameTransform._00;
-   temp = readTo(dataBuffer,',');
-   istringstream is2(temp);
-   is2 >> frameTransform._01;
-   temp = readTo(dataBuffer,',');
-   istringstream is3(temp);
-   is3 >> frameTransform._02;
-   temp = readTo(dataBuffer,',');
-   istringstream is4(temp);
-   is4 >> frameTransform._03;
-
-   temp = readTo(dataBuffer,',');
-   istringstream is5(temp);
-   is5 >> frameTransform._10;
-   temp = readTo(dataBuffer,',');
-   istringstream is6(temp);
-   is6 >> frameTransform._11;
-   temp = readTo(dataBuffer,',');
-   istringstream is7(temp);
-   is7 >> frameTransform._12;
-   temp = readTo(dataBuffer,',');
-   istringstream is8(temp);
-   is8 >> frameTransform._13;
-
-   temp = readTo(dataBuffer,',');
-   istringstream is9(temp);
-   is9 >> frameTransform._20;
-   temp = readTo(dataBuffer,',');
-   istringstream is10(temp);
-   is10 >> frameTransform._21;
-   temp = readTo(dataBuffer,',');
-   istringstream is11(temp);
-   is11 >> frameTransform._22;
-   temp = readTo(dataBuffer,',');
-   istringstream is12(temp);
-   is12 >> frameTransform._23;
-
-   temp = readTo(dataBuffer,',');
-   istringstream is13(temp);
-   is13 >> frameTransform._30;
-   temp = readTo(dataBuffer,',');
-   istringstream is14(temp);
-   is14 >> frameTransform._31;
-   temp = readTo(dataBuffer,',');
-   istringstream is15(temp);
-   is15 >> frameTransform._32;
-   temp = readTo(dataBuffer,';');
-   istringstream is16(temp);
-   is16 >> frameTransform._33;
-
-   return tempFTM;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   Remove and return the first character of the string.  returns -1 if the
-   string is empty.  The optional skip whitespace argument allows us to 
-   read until a non-white char is found.
-
-  @param theString Pointer to the string to read
-  @param skipWhitespace if true skip all whitespace (default=false)
-  @return The first character in the string
-*/
-char XFileLoader::readChar(string& theString, bool skipWhitespace)
-{ 
-   if (theString.empty())
-      return -1;
-   char c = theString[0];
-   theString.erase(0, 1);
-
-   // recursively call this function until we get a non-white char
-   while ((c == ' ' || c == '\n' || c == 13)&&skipWhitespace)
-   {
-      c = readChar(theString, true);
-   }
-   return c;
-}
-
-//-----------------------------------------------------------------------------
-/**
-  Read through a string until we find the argument char, then return the
-  string that we read.
-
-  @param theString Pointer to the string to read
-  @param target What to read to
-  @param skipWhitespace if true skip all whitespace (default=true)
-  @return The string we have read in
-*/
-string XFileLoader::readTo(string& theString, char target, bool skipWhitespace)
-{ 
-   int c = readChar(theString);
-   string buffer = "";
-   while(c != target && c != -1)
-   {
-      if(!skipWhitespace || (c!= ' ' && c != '\n' && c != 13))
-      {
-         buffer+=(char)c;
-      }
-      c = readChar(theString);
-   }   
-   return buffer;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   This is the main operation of the class.  It is called with an argument
-   string XFile filename to open/load/and store in the class.
-
-  @param filename The location of the .x file to load
-  @return true if successful, false otherwise
-*/
-bool XFileLoader::loadXFile(string filename)
-{
-   // clean out the member data in case this is another load
-   //fileLoaded = false;
-   //faceList.clear();
-   //vertList.clear();
-   //normalList.clear();
-   //uvList.clear();
-   //frameTransform.loadIdentity();
-
-   inFile.open(filename.c_str(), ifstream::in);
-   if (!inFile)
-   {
-      cout << "XFileLoader - could not open file \"" << filename << "\"" << endl;
-      return false;
-   }
-
-   // check the header to see if it is a supported file
-   char* header = new char[17];
-   string validHeader = "xof 0302txt 0032";
-   inFile.getline(header, 17);
-   if (header!=validHeader)
-   {
-      cout << "XFileLoader - invalid xfile header" << endl;
-      return false;
-   }
-   cout << "XFileLoader - file is valid" << endl;
-
-   while(!inFile.eof())
-   {
-      // load in a data section of the file
-      XFileLoader::XFileDataSection dataSection = readDataSection();
-
-      // handle a header section
-      if (dataSection.identifier == "Header")
-      {
-         cout << "XFileLoader - handling top level Header \"" << dataSection.name << "\"" << endl;
-         handleHeader(dataSection.dataBuffer);
-      }
-
-      // handle a frame section
-      else if (dataSection.identifier == "Frame")
-      {
-         cout << "XFileLoader - handling top level Frame \"" << dataSection.name << "\"" << endl;
-         handleFrame(dataSection.dataBuffer);
-      }
-   }
-   inFile.close();
-   fileLoaded = true;
-   cout << "XFileLoader - sucessfully loaded \"" << filename << "\"" << endl << endl;;
-   return fileLoaded;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   This operation loads the x file data into an openGL display list.
-   If there hasn't been a successful load then it returns false.
-
-  @param listId The id of the display list being created
-  @return true if display list creation successful, false otherwise
-*/
-bool XFileLoader::createOpenGLDisplayList(int listId)
-{
-   if (!fileLoaded) return false;
-   
- 	glNewList(listId, GL_COMPILE);
-      glPushMatrix();
-		glPushAttrib(GL_ALL_ATTRIB_BITS);
-
-      // apply our local transformation matrix
-      float tempMatrix[] = 
-      { 
-         frameTransform._00,frameTransform._01,frameTransform._02,frameTransform._03,
-         frameTransform._10,frameTransform._11,frameTransform._12,frameTransform._13,
-         frameTransform._20,frameTransform._21,frameTransform._22,frameTransform._23,
-         frameTransform._30,frameTransform._31,frameTransform._32,frameTransform._33,
-      };
-      glMultMatrixf(tempMatrix);
-
-      //KLUDGE - Align the axis here to fit with my hardcoded "Y is up" world
-      /// \todo replace this with a dynamic method of orienting the model to my world.
-      // Assuming 1x-0y-1z model, since thats all I have right now
-      //translate to center the model
-      glTranslatef(0,1.5,-7);
-      // rotate axis
-      glRotatef(-90,0,1,0);
-      glRotatef(-90,1,0,0);
-      // END KLUDGE
-
-      // test to see if normals match up with the verts
-      if (faceList.size() == faceNormalsList.size())
-      {
-         for (int faceIndex=0; faceIndex<faceList.size(); faceIndex++)
-         {
-            Face currentFace = faceList[faceIndex];
-            Face normalFace = faceNormalsList[faceIndex];
-            glBegin(GL_POLYGON);
-               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
-               {
-                  glNormal3f(normalList[normalFace.one].x, normalList[normalFace.one].y, normalList[normalFace.one].z);
-                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
-                  glNormal3f(normalList[normalFace.two].x, normalList[normalFace.two].y, normalList[normalFace.two].z);
-                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
-                  glNormal3f(normalList[normalFace.three].x, normalList[normalFace.three].y, normalList[normalFace.three].z);
-                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
-                  if (currentFace.numIndices == 4)
-                  {
-                     glNormal3f(normalList[normalFace.four].x, normalList[normalFace.four].y, normalList[normalFace.four].z);
-                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
-                  }
-               }
-		      glEnd();
-         }
-      }
-      // else we have an invalid set of normals
-      else
-      {
-         cout << "XFileLoader - Face normals do not match the verts! "
-              << "Faces="<<faceList.size()<<", Normals="<<faceNormalsList.size()
-              << ". Ignoring normal data." << endl;
-         for (int faceIndex=0; faceIndex<faceList.size(); faceIndex++)
-         {
-            Face currentFace = faceList[faceIndex];
-            glBegin(GL_POLYGON);
-               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
-               {
-                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
-                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
-                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
-                  if (currentFace.numIndices == 4)
-                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
-               }
-		      glEnd();
-         }
-      }
-
-		glPopAttrib();
-		glPopMatrix();
-	glEndList();  
-   return true;
-}
-
-//-----------------------------------------------------------------------------
-/**
-   This operation loads the x file data into a Model3D object.
-   If there hasn't been a successful load then it returns false
-
-  @param theModel A reference to the model we are loading
-  @return true if display list creation successful, false otherwise
-*/
-bool XFileLoader::createModel3D(Model3D* theModel)
-{
-   if (!fileLoaded) return false;
-   
-   theModel->setInitialTransform(frameTransform);
-   theModel->setVertList(vertList);
-   theModel->setNormalList(normalList);
-   theModel->setVertexFaceList(faceList);
-   theModel->setNormalFaceList(faceNormalsList);
-   theModel->setUVsList(uvList);
-
-   return true;
-}
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glut.h>
+#include "XFileLoader.h"
+#include "Model3D.h"
+
+using namespace std;
+
+namespace SML_CORE
+{
+//-----------------------------------------------------------------------------
+/**
+   Constructor
+*/
+XFileLoader::XFileLoader() :
+fileLoaded(false),
+faceList(0),
+vertList(0),
+normalList(0),
+uvList(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Destructor
+*/
+XFileLoader::~XFileLoader()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Handle section data of type header that is passed in as an argument
+
+  @param cursor The start of the header data
+  @param end The end of the header data
+*/
+void XFileLoader::handleHeader(const char *cursor, const char *end)
+{
+   readNumber(cursor, end, ';', ourAxis.upX);
+   readNumber(cursor, end, ';', ourAxis.upY);
+   readNumber(cursor, end, ';', ourAxis.upZ);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Handle section data of type frame that is passed in as an argument
+
+  @param cursor The start of the frame data
+  @param end The end of the frame data
+*/
+void XFileLoader::handleFrame(const char *cursor, const char *end)
+{
+   // A frame usually contains nested templates so read the next section
+   XFileDataSection dataSection;
+   while(readDataSection(cursor, end, dataSection))
+   {
+      // recursive call to this function to handle nested frames
+      if (strcmp(dataSection.identifier, "Frame") == 0)
+      {
+         cout << "XFileLoader - handling Frame \"" << dataSection.name << "\"" << endl;
+         handleFrame(dataSection.dataBegin, dataSection.dataEnd);
+      }
+      // transform this mesh and all child meshes
+      else if (strcmp(dataSection.identifier, "FrameTransformMatrix") == 0)
+      {
+         cout << "XFileLoader - handling FrameTransformMatrix \"" << dataSection.name << "\"" << endl;
+         const char *data = dataSection.dataBegin;
+         FTM tempFtm = readTransformMatrix(data, dataSection.dataEnd);
+         tempFtm.multMatrix(frameTransform);
+         frameTransform = tempFtm;
+      }
+      // handle the mesh
+      else if (strcmp(dataSection.identifier, "Mesh") == 0)
+      {
+         cout << "XFileLoader - handling Mesh \"" << dataSection.name << "\"" << endl;
+         handleMesh(dataSection.dataBegin, dataSection.dataEnd);
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Handle the argument Mesh section.  The mesh section consists of 
+   an array of verticies and an array of faces, it also has subsections
+
+  @param cursor The start of the mesh data
+  @param end The end of the mesh data
+*/
+void XFileLoader::handleMesh(const char *cursor, const char *end)
+{
+   readVertexData(cursor, end, vertList);
+   readFaceData(cursor, end, faceList);
+
+   // A mesh usually contains nested templates so read the next section
+   XFileDataSection dataSection;
+   while(readDataSection(cursor, end, dataSection))
+   {
+      // handle mesh normal data
+      if (strcmp(dataSection.identifier, "MeshNormals") == 0)
+      {
+         cout << "XFileLoader - handling MeshNormals \"" << dataSection.name << "\"" << endl;
+         handleMeshNormals(dataSection.dataBegin, dataSection.dataEnd);
+      }
+      // handle mesh material list
+      else if (strcmp(dataSection.identifier, "MeshMaterialList") == 0)
+      {
+         cout << "XFileLoader - cannot handle MeshMaterialList \"" << dataSection.name << "\"" << endl;
+         /// \todo handle meshMaterialList (contains Material section)
+      }
+      // handle mesh texture coordinates
+      else if (strcmp(dataSection.identifier, "MeshTextureCoords") == 0)
+      {
+         cout << "XFileLoader - handling MeshTextureCoords \"" << dataSection.name << "\"" << endl;
+         handleMeshUVs(dataSection.dataBegin, dataSection.dataEnd);
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read and handle the UV texture mapping coordinates for the argument
+   mesh data.
+
+  @param cursor The start of the UV data
+  @param end The end of the UV data
+*/
+void XFileLoader::handleMeshUVs(const char *cursor, const char *end)
+{
+   int numUVs = 0;
+   readNumber(cursor, end, ';', numUVs);
+
+   UV tempUV;
+   uvList.reserve(uvList.size() + numUVs);
+
+   // read the verts
+   for(int i = 0;i<numUVs;i++)
+   {
+      readNumber(cursor, end, ';', tempUV.u);
+      readNumber(cursor, end, ';', tempUV.v);
+
+      // read a trailing ',' (or a trailing ; at the very end)
+      skipTo(cursor, end, (i != numUVs-1) ? ',' : ';');
+      uvList.push_back(tempUV);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Handle the normals processing for the argument mesh data
+
+  @param cursor The start of the normal data
+  @param end The end of the normal data
+*/
+void XFileLoader::handleMeshNormals(const char *cursor, const char *end)
+{
+   readVertexData(cursor, end, normalList);
+   readFaceData(cursor, end, faceNormalsList);
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read the next data section: an identifier, an optional name and the data
+   between a pair of {}'s.  The identifier and name are copied into the
+   load arena, the data is left where it is.
+
+  @param cursor The text to read from, moved past the section
+  @param end The end of the text
+  @param section Set to the section read
+  @return false if there are no more sections
+*/
+bool XFileLoader::readDataSection(const char *&cursor, const char *end, XFileDataSection &section)
+{ 
+   // read the section identifier
+   while(cursor < end && isWhitespace(*cursor))
+      cursor++;
+   if (cursor == end)
+      return false;
+   const char *identifierBegin = cursor;
+   while(cursor < end && !isWhitespace(*cursor) && *cursor != '{')
+      cursor++;
+   section.identifier = loadArena.copyString(identifierBegin, cursor);
+
+   // read the section name (without any whitespace in it)
+   const char *nameBegin = cursor;
+   while(cursor < end && *cursor != '{')
+      cursor++;
+   char *name = loadArena.copyString(nameBegin, cursor);
+   char *nameEnd = name;
+   for (char *c = name; *c; c++)
+   {
+      if (!isWhitespace(*c))
+         *nameEnd++ = *c;
+   }
+   *nameEnd = 0;
+   section.name = name;
+
+   // read the section data between the {}'s
+   if (cursor < end)
+      cursor++;
+   section.dataBegin = cursor;
+   int bracecount = 1;
+   while(cursor < end)
+   {
+      // handle counting brace depth
+      if(*cursor == '{') bracecount += 1;
+      else if(*cursor == '}') bracecount -= 1;
+      if (bracecount == 0)
+         break;
+      cursor++;
+   }
+   section.dataEnd = cursor;
+
+   // skip the closing brace
+   if (cursor < end)
+      cursor++;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read a vert list from the argument data.  The vector data is assumed
+   to be the first section of the data, and in the format: number of points
+   followed by array of points (p1;p2;p3,p1;p2;p3,p1;p2...etc).
+
+  @param cursor The text to read from, moved past the vert list
+  @param end The end of the text
+  @param vertices Set to the list of verts
+*/
+void XFileLoader::readVertexData(const char *&cursor, const char *end, vector<Vector3D> &vertices)
+{
+   int numVerts = 0;
+   readNumber(cursor, end, ';', numVerts);
+
+   Vector3D tempVector;
+   vertices.clear();
+   vertices.reserve(numVerts);
+
+   // read the verts
+   for(int i = 0;i<numVerts;i++)
+   {
+      readNumber(cursor, end, ';', tempVector.x);
+      readNumber(cursor, end, ';', tempVector.y);
+      readNumber(cursor, end, ';', tempVector.z);
+
+      // read a trailing ',' (or a trailing ; at the very end)
+      skipTo(cursor, end, (i != numVerts-1) ? ',' : ';');
+      vertices.push_back(tempVector);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read a face list from the argument data.  The face data is assumed
+   to be the first section of the data, and in the format: number of faces
+   followed by array of faces (f1;f2;f3,f1;f2;f3,f1;f2...etc).
+
+  @param cursor The text to read from, moved past the face list
+  @param end The end of the text
+  @param faces Set to the list of faces (indices into the vert list)
+*/
+void XFileLoader::readFaceData(const char *&cursor, const char *end, vector<Face> &faces)
+{
+   int numFaces = 0;
+   readNumber(cursor, end, ';', numFaces);
+
+   Face tempFace;
+   faces.clear();
+   faces.reserve(numFaces);
+
+   // read the faces
+   for(int i = 0;i<numFaces;i++)
+   {
+      // read index count
+      readNumber(cursor, end, ';', tempFace.numIndices);
+      if(tempFace.numIndices != 3 && tempFace.numIndices != 4)
+      {
+         cout << "XFileLoader - ERROR! reader doesn't support file (too face faces in mesh)" << endl;
+         /// \todo add exception handling and throw error
+      }
+
+      // read indices
+      readNumber(cursor, end, ',', tempFace.one);
+      readNumber(cursor, end, ',', tempFace.two);
+
+      // 3rd vert index might be capped with a ','  or a ';'
+      readNumber(cursor, end, (tempFace.numIndices == 4) ? ',' : ';', tempFace.three);
+
+      // optional 4th vert capped with a ;
+      if(tempFace.numIndices == 4)
+         readNumber(cursor, end, ';', tempFace.four);
+
+      // read a trailing ',' (or a trailing ';' at the very end)
+      skipTo(cursor, end, (i != numFaces-1) ? ',' : ';');
+      faces.push_back(tempFace);
+   }
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read a FTM from the argument data.  The FTM data is assumed to be the
+   first section of the data.
+
+  @param cursor The text to read from, moved past the matrix
+  @param end The end of the text
+  @return The frame transformation matrix read in
+*/
+FTM XFileLoader::readTransformMatrix(const char *&cursor, const char *end)
+{
+   FTM tempFTM;
+
+   readNumber(cursor, end, ',', frameTransform._00);
+   readNumber(cursor, end, ',', frameTransform._01);
+   readNumber(cursor, end, ',', frameTransform._02);
+   readNumber(cursor, end, ',', frameTransform._03);
+
+   readNumber(cursor, end, ',', frameTransform._10);
+   readNumber(cursor, end, ',', frameTransform._11);
+   readNumber(cursor, end, ',', frameTransform._12);
+   readNumber(cursor, end, ',', frameTransform._13);
+
+   readNumber(cursor, end, ',', frameTransform._20);
+   readNumber(cursor, end, ',', frameTransform._21);
+   readNumber(cursor, end, ',', frameTransform._22);
+   readNumber(cursor, end, ',', frameTransform._23);
+
+   readNumber(cursor, end, ',', frameTransform._30);
+   readNumber(cursor, end, ',', frameTransform._31);
+   readNumber(cursor, end, ',', frameTransform._32);
+   readNumber(cursor, end, ';', frameTransform._33);
+
+   return tempFTM;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read a number that ends with the target character.  The number is parsed
+   in place, nothing is copied.  If there is no number before the target
+   the value is left alone.
+
+  @param cursor The text to read from, moved past the target
+  @param end The end of the text
+  @param target The character after the number
+  @param value Set to the number read
+*/
+void XFileLoader::readNumber(const char *&cursor, const char *end, char target, float &value)
+{
+   const char *targetPosition = findChar(cursor, end, target);
+   char *parseEnd;
+   double number = strtod(cursor, &parseEnd);
+   if (parseEnd != cursor && parseEnd <= targetPosition)
+      value = (float)number;
+   cursor = targetPosition < end ? targetPosition + 1 : end;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Read a whole number that ends with the target character (see the float
+   version).
+*/
+void XFileLoader::readNumber(const char *&cursor, const char *end, char target, int &value)
+{
+   const char *targetPosition = findChar(cursor, end, target);
+   char *parseEnd;
+   long number = strtol(cursor, &parseEnd, 10);
+   if (parseEnd != cursor && parseEnd <= targetPosition)
+      value = (int)number;
+   cursor = targetPosition < end ? targetPosition + 1 : end;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Move past the next target character
+
+  @param cursor The text to read from, moved past the target
+  @param end The end of the text
+  @param target What to skip to
+*/
+void XFileLoader::skipTo(const char *&cursor, const char *end, char target)
+{
+   const char *targetPosition = findChar(cursor, end, target);
+   cursor = targetPosition < end ? targetPosition + 1 : end;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   Find the next target character
+
+  @return The position of the target, end if there isn't one
+*/
+const char* XFileLoader::findChar(const char *cursor, const char *end, char target)
+{
+   while (cursor < end && *cursor != target)
+      cursor++;
+   return cursor;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   This is the main operation of the class.  It is called with an argument
+   string XFile filename to open/load/and store in the class.
+
+   The whole file is read into the load arena and parsed in place, the
+   section names are the only other things put there.  The arena is reset
+   at the end of the load, its memory is reused by the next one.
+
+  @param filename The location of the .x file to load
+  @return true if successful, false otherwise
+*/
+bool XFileLoader::loadXFile(string filename)
+{
+   // clean out the member data in case this is another load
+   //fileLoaded = false;
+   //faceList.clear();
+   //vertList.clear();
+   //normalList.clear();
+   //uvList.clear();
+   //frameTransform.loadIdentity();
+
+   ifstream inFile(filename.c_str(), ios::in | ios::binary);
+   if (!inFile)
+   {
+      cout << "XFileLoader - could not open file \"" << filename << "\"" << endl;
+      return false;
+   }
+
+   // read the whole file into the arena
+   loadArena.reset();
+   inFile.seekg(0, ios::end);
+   int fileSize = inFile.tellg();
+   inFile.seekg(0, ios::beg);
+   char *fileData = (char*)loadArena.allocate(fileSize + 1);
+   inFile.read(fileData, fileSize);
+   fileData[fileSize] = 0;
+   inFile.close();
+   const char *cursor = fileData;
+   const char *end = fileData + fileSize;
+
+   // check the header to see if it is a supported file
+   const char validHeader[] = "xof 0302txt 0032";
+   int headerLength = sizeof(validHeader) - 1;
+   if (fileSize < headerLength || strncmp(fileData, validHeader, headerLength) != 0)
+   {
+      cout << "XFileLoader - invalid xfile header" << endl;
+      loadArena.reset();
+      return false;
+   }
+   cout << "XFileLoader - file is valid" << endl;
+   skipTo(cursor, end, '\n');
+
+   XFileDataSection dataSection;
+   while(readDataSection(cursor, end, dataSection))
+   {
+      // handle a header section
+      if (strcmp(dataSection.identifier, "Header") == 0)
+      {
+         cout << "XFileLoader - handling top level Header \"" << dataSection.name << "\"" << endl;
+         handleHeader(dataSection.dataBegin, dataSection.dataEnd);
+      }
+
+      // handle a frame section
+      else if (strcmp(dataSection.identifier, "Frame") == 0)
+      {
+         cout << "XFileLoader - handling top level Frame \"" << dataSection.name << "\"" << endl;
+         handleFrame(dataSection.dataBegin, dataSection.dataEnd);
+      }
+   }
+   loadArena.reset();
+   fileLoaded = true;
+   cout << "XFileLoader - sucessfully loaded \"" << filename << "\"" << endl << endl;;
+   return fileLoaded;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   This operation loads the x file data into an openGL display list.
+   If there hasn't been a successful load then it returns false.
+
+  @param listId The id of the display list being created
+  @return true if display list creation successful, false otherwise
+*/
+bool XFileLoader::createOpenGLDisplayList(int listId)
+{
+   if (!fileLoaded) return false;
+   
+ 	glNewList(listId, GL_COMPILE);
+      glPushMatrix();
+
+      // apply our local transformation matrix
+      float tempMatrix[] = 
+      { 
+         frameTransform._00,frameTransform._01,frameTransform._02,frameTransform._03,
+         frameTransform._10,frameTransform._11,frameTransform._12,frameTransform._13,
+         frameTransform._20,frameTransform._21,frameTransform._22,frameTransform._23,
+         frameTransform._30,frameTransform._31,frameTransform._32,frameTransform._33,
+      };
+      glMultMatrixf(tempMatrix);
+
+      //KLUDGE - Align the axis here to fit with my hardcoded "Y is up" world
+      /// \todo replace this with a dynamic method of orienting the model to my world.
+      // Assuming 1x-0y-1z model, since thats all I have right now
+      //translate to center the model
+      glTranslatef(0,1.5,-7);
+      // rotate axis
+      glRotatef(-90,0,1,0);
+      glRotatef(-90,1,0,0);
+      // END KLUDGE
+
+      // test to see if normals match up with the verts
+      if (faceList.size() == faceNormalsList.size())
+      {
+         for (int faceIndex=0; faceIndex<faceList.size(); faceIndex++)
+         {
+            Face currentFace = faceList[faceIndex];
+            Face normalFace = faceNormalsList[faceIndex];
+            glBegin(GL_POLYGON);
+               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
+               {
+                  glNormal3f(normalList[normalFace.one].x, normalList[normalFace.one].y, normalList[normalFace.one].z);
+                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
+                  glNormal3f(normalList[normalFace.two].x, normalList[normalFace.two].y, normalList[normalFace.two].z);
+                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
+                  glNormal3f(normalList[normalFace.three].x, normalList[normalFace.three].y, normalList[normalFace.three].z);
+                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
+                  if (currentFace.numIndices == 4)
+                  {
+                     glNormal3f(normalList[normalFace.four].x, normalList[normalFace.four].y, normalList[normalFace.four].z);
+                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
+                  }
+               }
+		      glEnd();
+         }
+      }
+      // else we have an invalid set of normals
+      else
+      {
+         cout << "XFileLoader - Face normals do not match the verts! "
+              << "Faces="<<faceList.size()<<", Normals="<<faceNormalsList.size()
+              << ". Ignoring normal data." << endl;
+         for (int faceIndex=0; faceIndex<faceList.size(); faceIndex++)
+         {
+            Face currentFace = faceList[faceIndex];
+            glBegin(GL_POLYGON);
+               if (currentFace.numIndices == 3 || currentFace.numIndices == 4)
+               {
+                  glVertex3f(vertList[currentFace.one].x, vertList[currentFace.one].y, vertList[currentFace.one].z);
+                  glVertex3f(vertList[currentFace.two].x, vertList[currentFace.two].y, vertList[currentFace.two].z);
+                  glVertex3f(vertList[currentFace.three].x, vertList[currentFace.three].y, vertList[currentFace.three].z);
+                  if (currentFace.numIndices == 4)
+                     glVertex3f(vertList[currentFace.four].x, vertList[currentFace.four].y, vertList[currentFace.four].z);
+               }
+		      glEnd();
+         }
+      }
+
+		glPopMatrix();
+	glEndList();  
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+   This operation loads the x file data into a Model3D object.
+   If there hasn't been a successful load then it returns false
+
+  @param theModel A reference to the model we are loading
+  @return true if display list creation successful, false otherwise
+*/
+bool XFileLoader::createModel3D(Model3D* theModel)
+{
+   if (!fileLoaded) return false;
+   
+   theModel->setInitialTransform(frameTransform);
+   theModel->setVertList(vertList);
+   theModel->setNormalList(normalList);
+   theModel->setVertexFaceList(faceList);
+   theModel->setNormalFaceList(faceNormalsList);
+   theModel->setUVsList(uvList);
+   theModel->computeBounds();
+
+   return true;
+}
 }
\ No newline at end of file